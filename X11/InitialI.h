@@ -325,6 +325,7 @@ typedef struct _XtPerDisplayStruct {
     XrmDatabase *per_screen_db;        /* per screen resource databases */
     XrmDatabase cmd_db;		       /* db from command line, if needed */
     XrmDatabase server_db;	       /* resource property else .Xdefaults */
+    struct _ResourceCacheRec **resource_cache; /* for GetResources */
     XtEventDispatchProc* dispatcher_list;
     ExtSelectRec* ext_select_list;
     int ext_select_count;
@@ -419,6 +420,10 @@ extern void _XtFreeWWTable(
     XtPerDisplay pd
 );
 
+extern void _XtFreeResourceCache(
+    XtPerDisplay pd
+);
+
 extern String _XtGetUserName(String dest, int len);
 extern XrmDatabase _XtPreparseCommandLine(XrmOptionDescRec *urlist,
 			Cardinal num_urs, int argc, String *argv,
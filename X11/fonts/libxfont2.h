@@ -118,6 +118,26 @@ xfont2_add_font_names_name(FontNamesPtr names,
 			   char *name,
 			   int length);
 
+_X_EXPORT int
+xfont2_write_font_dir_index(const char *directory);
+
+typedef struct _xfont2_glyph_cache_stats {
+	unsigned long	lookups;
+	unsigned long	hits;
+	unsigned long	misses;
+	unsigned long	insertions;
+	unsigned long	evictions;
+	unsigned long	entries;
+	unsigned long	bytes;
+	unsigned long	limit;
+} xfont2_glyph_cache_stats_rec;
+
+_X_EXPORT void
+xfont2_set_glyph_cache_limit(unsigned long limit);
+
+_X_EXPORT void
+xfont2_get_glyph_cache_stats(xfont2_glyph_cache_stats_rec *stats);
+
 typedef struct _xfont2_pattern_cache    *xfont2_pattern_cache_ptr;
 
 _X_EXPORT xfont2_pattern_cache_ptr
@@ -446,6 +446,14 @@ FcConfigGetRescanInterval (FcConfig *config);
 FcPublic FcBool
 FcConfigSetRescanInterval (FcConfig *config, int rescanInterval);
 
+FcPublic FcBool
+FcConfigGetMatchCacheStats (FcConfig		*config,
+			    unsigned long	*hits,
+			    unsigned long	*misses);
+
+FcPublic FcBool
+FcConfigSetMatchCacheSize (FcConfig *config, int size);
+
 FcPublic FcFontSet *
 FcConfigGetFonts (FcConfig	*config,
 		  FcSetName	set);
@@ -213,6 +213,9 @@ FcConfigCreate (void)
     config->maxObjects = 0;
     for (set = FcSetSystem; set <= FcSetApplication; set++)
 	config->fonts[set] = 0;
+    config->matchIndex = NULL;
+    /* matching just isn't cached if this fails */
+    config->matchCache = FcMatchCacheCreate ();
 
     config->rescanTime = time(0);
     config->rescanInterval = 30;
@@ -227,11 +230,18 @@ FcConfigCreate (void)
     config->availConfigFiles = FcStrSetCreate ();
     if (!config->availConfigFiles)
 	goto bail10;
+    config->missingConfigFiles = FcStrSetCreate ();
+    if (!config->missingConfigFiles)
+	goto bail11;
+    config->relativeDirs = FcFalse;
+    config->uncacheable = FcFalse;
 
     FcRefInit (&config->ref, 1);
 
     return config;
 
+bail11:
+    FcStrSetDestroy (config->availConfigFiles);
 bail10:
     FcPtrListDestroy (config->rulesetList);
 bail9:
@@ -313,6 +323,7 @@ FcConfigUptoDate (FcConfig *config)
 	}
 	else
 	{
+	    FcConfigInvalidateMatchCache (config);
 	    ret = FcFalse;
 	    goto bail;
 	}
@@ -403,9 +414,12 @@ FcConfigDestroy (FcConfig *config)
 	FcPtrListDestroy (config->subst[k]);
     FcPtrListDestroy (config->rulesetList);
     FcStrSetDestroy (config->availConfigFiles);
+    FcStrSetDestroy (config->missingConfigFiles);
     for (set = FcSetSystem; set <= FcSetApplication; set++)
 	if (config->fonts[set])
 	    FcFontSetDestroy (config->fonts[set]);
+    FcMatchIndexDestroy (config->matchIndex);
+    FcMatchCacheDestroy (config->matchCache);
 
     page = config->expr_pool;
     while (page)
@@ -571,6 +585,7 @@ FcConfigBuildFonts (FcConfig *config)
 	ret = FcFalse;
 	goto bail;
     }
+    FcConfigBuildMatchIndex (config);
     if (FcDebug () & FC_DBG_FONTSET)
 	FcFontSetPrint (fonts);
 bail:
@@ -619,10 +634,24 @@ FcConfigGetCurrent (void)
     return FcConfigEnsure ();
 }
 
+/*
+ * Relative directory names are made absolute against the current
+ * directory, so a cached configuration using them is only good for
+ * that directory
+ */
+static void
+FcConfigCheckRelativeDir (FcConfig	*config,
+			  const FcChar8	*d)
+{
+    if (d && !FcStrIsAbsoluteFilename (d) && d[0] != '~')
+	config->relativeDirs = FcTrue;
+}
+
 FcBool
 FcConfigAddConfigDir (FcConfig	    *config,
 		      const FcChar8 *d)
 {
+    FcConfigCheckRelativeDir (config, d);
     return FcStrSetAddFilename (config->configDirs, d);
 }
 
@@ -657,6 +686,8 @@ FcConfigAddFontDir (FcConfig	    *config,
 	    printf ("%s%s%s%s\n", d, salt ? " (salt: " : "", salt ? (const char *)salt : "", salt ? ")" : "");
 	}
     }
+    FcConfigCheckRelativeDir (config, d);
+    FcConfigCheckRelativeDir (config, m);
     return FcStrSetAddFilenamePairWithSalt (config->fontDirs, d, m, salt);
 }
 
@@ -762,6 +793,7 @@ FcBool
 FcConfigAddCacheDir (FcConfig	    *config,
 		     const FcChar8  *d)
 {
+    FcConfigCheckRelativeDir (config, d);
     return FcStrSetAddFilename (config->cacheDirs, d);
 }
 
@@ -835,6 +867,12 @@ FcConfigSetFonts (FcConfig	*config,
     if (config->fonts[set])
 	FcFontSetDestroy (config->fonts[set]);
     config->fonts[set] = fonts;
+    FcConfigInvalidateMatchCache (config);
+    if (set == FcSetSystem && config->matchIndex)
+    {
+	FcMatchIndexDestroy (config->matchIndex);
+	config->matchIndex = NULL;
+    }
 }
 
 
@@ -2781,10 +2819,11 @@ FcConfigAppFontAddFile (FcConfig    *config,
 	FcConfigSetFonts (config, set, FcSetApplication);
     }
 	
-    if (!FcFileScanConfig (set, subdirs, file, config))
+    ret = FcFileScanConfig (set, subdirs, file, config);
+    FcConfigInvalidateMatchCache (config);
+    if (!ret)
     {
 	FcStrSetDestroy (subdirs);
-	ret = FcFalse;
 	goto bail;
     }
     if ((sublist = FcStrListCreate (subdirs)))
@@ -2836,12 +2875,8 @@ FcConfigAppFontAddDir (FcConfig	    *config,
 
     FcStrSetAddFilename (dirs, dir);
 
-    if (!FcConfigAddDirList (config, FcSetApplication, dirs))
-    {
-	FcStrSetDestroy (dirs);
-	ret = FcFalse;
-	goto bail;
-    }
+    ret = FcConfigAddDirList (config, FcSetApplication, dirs);
+    FcConfigInvalidateMatchCache (config);
     FcStrSetDestroy (dirs);
 bail:
     FcConfigDestroy (config);
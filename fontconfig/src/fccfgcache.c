@@ -0,0 +1,1594 @@
+/*
+ * fontconfig/src/fccfgcache.c
+ *
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the author(s) not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  The authors make no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * THE AUTHOR(S) DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The configuration cache.
+ *
+ * Loading the configuration means an XML parse of fonts.conf and every
+ * file it includes, and building the expression trees of all their
+ * rules, in every process.  Once that is done, FcInitLoadOwnConfig
+ * writes the resulting state -- the directory and file lists, the
+ * selectfont globs and patterns and the rule sets with their tests,
+ * edits and expressions -- to a cache file, as a flat stream of
+ * integers and strings that needs no relocation.  Later processes
+ * rebuild the same state from it without looking at the XML at all.
+ * Objects are recorded by name, so objects unknown to fontconfig get
+ * whatever id this process hands out.
+ *
+ * The cache file is named after the MD5 of everything that decides
+ * which configuration files are found and how they are read: the main
+ * configuration file, the sysroot and the home and XDG directories.
+ * The file keeps that key too and is only used when it matches.  It is
+ * looked for next to the font caches, in the default system and user
+ * cache directories.
+ *
+ * It is only used while every configuration file and directory that
+ * went into it still has the size and modification time it had then.
+ * A file with a new time but the old size is compared by the MD5 of
+ * its contents, so just touching it doesn't throw the cache away.
+ * Includes that were missing must still be missing.  When relative
+ * directory names were made absolute, the current directory is part
+ * of the key as well.
+ */
+
+#include "fcint.h"
+#include "fcarch.h"
+#include "fcmd5.h"
+#include <fcntl.h>
+#if defined(HAVE_MMAP) || defined(__CYGWIN__)
+#  include <unistd.h>
+#  include <sys/mman.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define FC_CONFIG_CACHE_MAGIC	0xfc0c0f16
+#define FC_CONFIG_CACHE_VERSION	1
+#define FC_CONFIG_CACHE_SUFFIX	".conf-cache-1"
+#define FC_CONFIG_CACHE_BASE_LEN    (32 + sizeof ("-" FC_ARCHITECTURE FC_CONFIG_CACHE_SUFFIX))
+
+/* bounds the recursion when reading back expressions */
+#define FC_CONFIG_CACHE_MAX_DEPTH   256
+
+typedef enum _FcConfigCacheDep {
+    FcConfigCacheDepFile,
+    FcConfigCacheDepDir,
+    FcConfigCacheDepMissing
+} FcConfigCacheDep;
+
+typedef struct _FcConfigCacheReader {
+    const FcChar8   *p;
+    const FcChar8   *end;
+    FcBool	    failed;
+} FcConfigCacheReader;
+
+/*
+ * Writing
+ */
+
+static void
+FcConfigCachePutInt (FcStrBuf *buf, int i)
+{
+    FcStrBufData (buf, (const FcChar8 *) &i, sizeof (i));
+}
+
+static void
+FcConfigCachePutInt64 (FcStrBuf *buf, int64_t i)
+{
+    FcStrBufData (buf, (const FcChar8 *) &i, sizeof (i));
+}
+
+static void
+FcConfigCachePutDouble (FcStrBuf *buf, double d)
+{
+    FcStrBufData (buf, (const FcChar8 *) &d, sizeof (d));
+}
+
+/* Strings are stored with their terminator so they can be used in place */
+static void
+FcConfigCachePutString (FcStrBuf *buf, const FcChar8 *s)
+{
+    int len;
+
+    if (!s)
+    {
+	FcConfigCachePutInt (buf, -1);
+	return;
+    }
+    len = strlen ((const char *) s);
+    FcConfigCachePutInt (buf, len);
+    FcStrBufData (buf, s, len + 1);
+}
+
+static void
+FcConfigCachePutObject (FcStrBuf *buf, FcObject object)
+{
+    FcConfigCachePutString (buf, (const FcChar8 *) FcObjectName (object));
+}
+
+static void
+FcConfigCachePutStrSet (FcStrBuf *buf, FcStrSet *set)
+{
+    int i;
+
+    FcConfigCachePutInt (buf, set->num);
+    for (i = 0; i < set->num; i++)
+	FcConfigCachePutString (buf, set->strs[i]);
+}
+
+static void
+FcConfigCachePutCharSet (FcStrBuf *buf, const FcCharSet *c)
+{
+    int i;
+
+    FcConfigCachePutInt (buf, c->num);
+    for (i = 0; i < c->num; i++)
+    {
+	FcConfigCachePutInt (buf, FcCharSetNumbers (c)[i]);
+	FcStrBufData (buf, (const FcChar8 *) FcCharSetLeaf (c, i)->map,
+		      sizeof (FcCharLeaf));
+    }
+}
+
+static void
+FcConfigCachePutLangSet (FcStrBuf *buf, const FcLangSet *l)
+{
+    FcStrSet *langs = FcLangSetGetLangs (l);
+
+    if (!langs)
+    {
+	buf->failed = FcTrue;
+	return;
+    }
+    FcConfigCachePutStrSet (buf, langs);
+    FcStrSetDestroy (langs);
+}
+
+static FcBool
+FcConfigCachePutValue (FcStrBuf *buf, FcValue v)
+{
+    double begin, end;
+
+    FcConfigCachePutInt (buf, v.type);
+    switch ((int) v.type) {
+    case FcTypeInteger:
+	FcConfigCachePutInt (buf, v.u.i);
+	break;
+    case FcTypeDouble:
+	FcConfigCachePutDouble (buf, v.u.d);
+	break;
+    case FcTypeString:
+	FcConfigCachePutString (buf, v.u.s);
+	break;
+    case FcTypeBool:
+	FcConfigCachePutInt (buf, v.u.b);
+	break;
+    case FcTypeMatrix:
+	FcConfigCachePutDouble (buf, v.u.m->xx);
+	FcConfigCachePutDouble (buf, v.u.m->xy);
+	FcConfigCachePutDouble (buf, v.u.m->yx);
+	FcConfigCachePutDouble (buf, v.u.m->yy);
+	break;
+    case FcTypeCharSet:
+	FcConfigCachePutCharSet (buf, v.u.c);
+	break;
+    case FcTypeLangSet:
+	FcConfigCachePutLangSet (buf, v.u.l);
+	break;
+    case FcTypeRange:
+	FcRangeGetDouble (v.u.r, &begin, &end);
+	FcConfigCachePutDouble (buf, begin);
+	FcConfigCachePutDouble (buf, end);
+	break;
+    default:
+	return FcFalse;
+    }
+    return !buf->failed;
+}
+
+static FcBool
+FcConfigCachePutPattern (FcStrBuf *buf, const FcPattern *p)
+{
+    FcPatternElt    *e = FcPatternElts (p);
+    FcValueListPtr  l;
+    int		    i, n;
+
+    FcConfigCachePutInt (buf, p->num);
+    for (i = 0; i < p->num; i++)
+    {
+	FcConfigCachePutObject (buf, e[i].object);
+	n = 0;
+	for (l = FcPatternEltValues (&e[i]); l; l = FcValueListNext (l))
+	    n++;
+	FcConfigCachePutInt (buf, n);
+	for (l = FcPatternEltValues (&e[i]); l; l = FcValueListNext (l))
+	{
+	    FcConfigCachePutInt (buf, l->binding);
+	    if (!FcConfigCachePutValue (buf, FcValueCanonicalize (&l->value)))
+		return FcFalse;
+	}
+    }
+    return !buf->failed;
+}
+
+static FcBool
+FcConfigCachePutExpr (FcStrBuf *buf, const FcExpr *e)
+{
+    double begin, end;
+
+    if (!e)
+    {
+	FcConfigCachePutInt (buf, -1);
+	return !buf->failed;
+    }
+    FcConfigCachePutInt (buf, e->op);
+    switch (FC_OP_GET_OP (e->op)) {
+    case FcOpInteger:
+	FcConfigCachePutInt (buf, e->u.ival);
+	break;
+    case FcOpDouble:
+	FcConfigCachePutDouble (buf, e->u.dval);
+	break;
+    case FcOpString:
+	FcConfigCachePutString (buf, e->u.sval);
+	break;
+    case FcOpMatrix:
+	return FcConfigCachePutExpr (buf, e->u.mexpr->xx) &&
+	       FcConfigCachePutExpr (buf, e->u.mexpr->xy) &&
+	       FcConfigCachePutExpr (buf, e->u.mexpr->yx) &&
+	       FcConfigCachePutExpr (buf, e->u.mexpr->yy);
+    case FcOpRange:
+	FcRangeGetDouble (e->u.rval, &begin, &end);
+	FcConfigCachePutDouble (buf, begin);
+	FcConfigCachePutDouble (buf, end);
+	break;
+    case FcOpBool:
+	FcConfigCachePutInt (buf, e->u.bval);
+	break;
+    case FcOpCharSet:
+	FcConfigCachePutCharSet (buf, e->u.cval);
+	break;
+    case FcOpLangSet:
+	FcConfigCachePutLangSet (buf, e->u.lval);
+	break;
+    case FcOpField:
+	FcConfigCachePutObject (buf, e->u.name.object);
+	FcConfigCachePutInt (buf, e->u.name.kind);
+	break;
+    case FcOpConst:
+	FcConfigCachePutString (buf, e->u.constant);
+	break;
+    case FcOpAssign:
+    case FcOpAssignReplace:
+    case FcOpPrepend:
+    case FcOpPrependFirst:
+    case FcOpAppend:
+    case FcOpAppendLast:
+    case FcOpDelete:
+    case FcOpDeleteAll:
+    case FcOpNil:
+    case FcOpInvalid:
+	break;
+    case FcOpOr:
+    case FcOpAnd:
+    case FcOpEqual:
+    case FcOpNotEqual:
+    case FcOpLess:
+    case FcOpLessEqual:
+    case FcOpMore:
+    case FcOpMoreEqual:
+    case FcOpContains:
+    case FcOpListing:
+    case FcOpNotContains:
+    case FcOpPlus:
+    case FcOpMinus:
+    case FcOpTimes:
+    case FcOpDivide:
+    case FcOpQuest:
+    case FcOpComma:
+	return FcConfigCachePutExpr (buf, e->u.tree.left) &&
+	       FcConfigCachePutExpr (buf, e->u.tree.right);
+    case FcOpNot:
+    case FcOpFloor:
+    case FcOpCeil:
+    case FcOpRound:
+    case FcOpTrunc:
+	return FcConfigCachePutExpr (buf, e->u.tree.left);
+    default:
+	return FcFalse;
+    }
+    return !buf->failed;
+}
+
+static FcBool
+FcConfigCachePutRules (FcStrBuf *buf, const FcRule *rules)
+{
+    const FcRule    *r;
+    int		    n = 0;
+
+    for (r = rules; r; r = r->next)
+	n++;
+    FcConfigCachePutInt (buf, n);
+    for (r = rules; r; r = r->next)
+    {
+	FcConfigCachePutInt (buf, r->type);
+	switch (r->type) {
+	case FcRuleTest:
+	    FcConfigCachePutInt (buf, r->u.test->kind);
+	    FcConfigCachePutInt (buf, r->u.test->qual);
+	    FcConfigCachePutObject (buf, r->u.test->object);
+	    FcConfigCachePutInt (buf, r->u.test->op);
+	    if (!FcConfigCachePutExpr (buf, r->u.test->expr))
+		return FcFalse;
+	    break;
+	case FcRuleEdit:
+	    FcConfigCachePutObject (buf, r->u.edit->object);
+	    FcConfigCachePutInt (buf, r->u.edit->op);
+	    FcConfigCachePutInt (buf, r->u.edit->binding);
+	    if (!FcConfigCachePutExpr (buf, r->u.edit->expr))
+		return FcFalse;
+	    break;
+	default:
+	    return FcFalse;
+	}
+    }
+    return !buf->failed;
+}
+
+static int
+FcConfigCachePtrListCount (const FcPtrList *list)
+{
+    FcPtrListIter   iter;
+    int		    n = 0;
+
+    for (FcPtrListIterInit (list, &iter);
+	 FcPtrListIterIsValid (list, &iter);
+	 FcPtrListIterNext (list, &iter))
+	n++;
+    return n;
+}
+
+static FcBool
+FcConfigCachePutRuleSet (FcStrBuf *buf, const FcRuleSet *rs)
+{
+    FcPtrListIter   iter;
+    FcMatchKind	    k;
+
+    FcConfigCachePutString (buf, rs->name);
+    FcConfigCachePutString (buf, rs->description);
+    FcConfigCachePutString (buf, rs->domain);
+    FcConfigCachePutInt (buf, rs->enabled);
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+    {
+	FcConfigCachePutInt (buf, FcConfigCachePtrListCount (rs->subst[k]));
+	for (FcPtrListIterInit (rs->subst[k], &iter);
+	     FcPtrListIterIsValid (rs->subst[k], &iter);
+	     FcPtrListIterNext (rs->subst[k], &iter))
+	{
+	    if (!FcConfigCachePutRules (buf, FcPtrListIterGetValue (rs->subst[k], &iter)))
+		return FcFalse;
+	}
+    }
+    return !buf->failed;
+}
+
+/*
+ * The rule sets in config->subst are not necessarily all in
+ * config->rulesetList (an <include> starts a new one), so collect both
+ * and refer to them by index.
+ */
+static int
+FcConfigCacheRuleSetIndex (FcRuleSet ***sets, int *nsets, FcRuleSet *rs)
+{
+    FcRuleSet	**s;
+    int		i;
+
+    for (i = 0; i < *nsets; i++)
+	if ((*sets)[i] == rs)
+	    return i;
+    s = realloc (*sets, (*nsets + 1) * sizeof (FcRuleSet *));
+    if (!s)
+	return -1;
+    s[*nsets] = rs;
+    *sets = s;
+    return (*nsets)++;
+}
+
+static FcBool
+FcConfigCachePutRuleSetList (FcStrBuf *buf, const FcPtrList *list,
+			     FcRuleSet ***sets, int *nsets)
+{
+    FcPtrListIter   iter;
+    int		    i;
+
+    FcConfigCachePutInt (buf, FcConfigCachePtrListCount (list));
+    for (FcPtrListIterInit (list, &iter);
+	 FcPtrListIterIsValid (list, &iter);
+	 FcPtrListIterNext (list, &iter))
+    {
+	i = FcConfigCacheRuleSetIndex (sets, nsets, FcPtrListIterGetValue (list, &iter));
+	if (i < 0)
+	    return FcFalse;
+	FcConfigCachePutInt (buf, i);
+    }
+    return !buf->failed;
+}
+
+static FcBool
+FcConfigCachePutState (FcStrBuf *buf, FcConfig *config)
+{
+    FcRuleSet	**sets = NULL;
+    int		nsets = 0;
+    FcMatchKind	k;
+    FcStrBuf	lists;
+    FcBool	ret = FcFalse;
+    int		i;
+
+    FcConfigCachePutStrSet (buf, config->configDirs);
+    FcConfigCachePutStrSet (buf, config->configMapDirs);
+    FcConfigCachePutInt (buf, config->fontDirs->num);
+    for (i = 0; i < config->fontDirs->num; i++)
+    {
+	FcConfigCachePutString (buf, config->fontDirs->strs[i]);
+	FcConfigCachePutString (buf, FcStrTripleSecond (config->fontDirs->strs[i]));
+	FcConfigCachePutString (buf, FcStrTripleThird (config->fontDirs->strs[i]));
+    }
+    FcConfigCachePutStrSet (buf, config->cacheDirs);
+    FcConfigCachePutStrSet (buf, config->configFiles);
+    FcConfigCachePutStrSet (buf, config->availConfigFiles);
+    FcConfigCachePutStrSet (buf, config->acceptGlobs);
+    FcConfigCachePutStrSet (buf, config->rejectGlobs);
+    FcConfigCachePutInt (buf, config->acceptPatterns->nfont);
+    for (i = 0; i < config->acceptPatterns->nfont; i++)
+	if (!FcConfigCachePutPattern (buf, config->acceptPatterns->fonts[i]))
+	    return FcFalse;
+    FcConfigCachePutInt (buf, config->rejectPatterns->nfont);
+    for (i = 0; i < config->rejectPatterns->nfont; i++)
+	if (!FcConfigCachePutPattern (buf, config->rejectPatterns->fonts[i]))
+	    return FcFalse;
+    FcConfigCachePutInt (buf, config->rescanInterval);
+
+    /* The lists go after the rule sets they refer to */
+    FcStrBufInit (&lists, NULL, 0);
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+	if (!FcConfigCachePutRuleSetList (&lists, config->subst[k], &sets, &nsets))
+	    goto bail;
+    if (!FcConfigCachePutRuleSetList (&lists, config->rulesetList, &sets, &nsets))
+	goto bail;
+
+    FcConfigCachePutInt (buf, nsets);
+    for (i = 0; i < nsets; i++)
+	if (!FcConfigCachePutRuleSet (buf, sets[i]))
+	    goto bail;
+    FcStrBufData (buf, lists.buf, lists.len);
+    ret = !buf->failed && !lists.failed;
+bail:
+    FcStrBufDestroy (&lists);
+    free (sets);
+    return ret;
+}
+
+static FcBool
+FcConfigCacheHashFile (const FcChar8 *file, unsigned char digest[16])
+{
+    struct MD5Context	ctx;
+    char		buf[BUFSIZ];
+    int			fd, len;
+
+    fd = FcOpen ((const char *) file, O_RDONLY | O_BINARY);
+    if (fd == -1)
+	return FcFalse;
+    MD5Init (&ctx);
+    while ((len = read (fd, buf, sizeof (buf))) > 0)
+	MD5Update (&ctx, (const unsigned char *) buf, len);
+    close (fd);
+    MD5Final (digest, &ctx);
+    return len == 0;
+}
+
+static int64_t
+FcConfigCacheMtimeNano (const struct stat *statb)
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return statb->st_mtim.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static FcBool
+FcConfigCachePutDeps (FcStrBuf *buf, FcConfig *config)
+{
+    unsigned char   digest[16];
+    struct stat	    statb;
+    FcChar8	    *file;
+    int		    i;
+
+    FcConfigCachePutInt (buf, config->availConfigFiles->num +
+			 config->missingConfigFiles->num);
+    for (i = 0; i < config->availConfigFiles->num; i++)
+    {
+	file = config->availConfigFiles->strs[i];
+	if (FcStat (file, &statb) < 0)
+	    return FcFalse;
+	memset (digest, 0, sizeof (digest));
+	if (!S_ISDIR (statb.st_mode) && !FcConfigCacheHashFile (file, digest))
+	    return FcFalse;
+	FcConfigCachePutInt (buf, S_ISDIR (statb.st_mode) ? FcConfigCacheDepDir :
+						       FcConfigCacheDepFile);
+	FcConfigCachePutString (buf, file);
+	FcConfigCachePutInt64 (buf, statb.st_size);
+	FcConfigCachePutInt64 (buf, statb.st_mtime);
+	FcConfigCachePutInt64 (buf, FcConfigCacheMtimeNano (&statb));
+	FcStrBufData (buf, digest, sizeof (digest));
+    }
+    for (i = 0; i < config->missingConfigFiles->num; i++)
+    {
+	FcConfigCachePutInt (buf, FcConfigCacheDepMissing);
+	FcConfigCachePutString (buf, config->missingConfigFiles->strs[i]);
+    }
+    return !buf->failed;
+}
+
+/*
+ * Reading
+ */
+
+static FcBool
+FcConfigCacheGet (FcConfigCacheReader *r, void *data, size_t len)
+{
+    if (r->failed || (size_t) (r->end - r->p) < len)
+    {
+	r->failed = FcTrue;
+	memset (data, 0, len);
+	return FcFalse;
+    }
+    memcpy (data, r->p, len);
+    r->p += len;
+    return FcTrue;
+}
+
+static int
+FcConfigCacheGetInt (FcConfigCacheReader *r)
+{
+    int i;
+
+    FcConfigCacheGet (r, &i, sizeof (i));
+    return i;
+}
+
+static int64_t
+FcConfigCacheGetInt64 (FcConfigCacheReader *r)
+{
+    int64_t i;
+
+    FcConfigCacheGet (r, &i, sizeof (i));
+    return i;
+}
+
+static double
+FcConfigCacheGetDouble (FcConfigCacheReader *r)
+{
+    double d;
+
+    FcConfigCacheGet (r, &d, sizeof (d));
+    return d;
+}
+
+/* A count of things taking at least size bytes each */
+static int
+FcConfigCacheGetCount (FcConfigCacheReader *r, size_t size)
+{
+    int n = FcConfigCacheGetInt (r);
+
+    if (n < 0 || (size_t) n > (size_t) (r->end - r->p) / size)
+    {
+	r->failed = FcTrue;
+	return 0;
+    }
+    return n;
+}
+
+/* Points into the cache data; NULL means either NULL or failure */
+static const FcChar8 *
+FcConfigCacheGetString (FcConfigCacheReader *r)
+{
+    const FcChar8   *s;
+    int		    len = FcConfigCacheGetInt (r);
+
+    if (r->failed || len == -1)
+	return NULL;
+    if (len < 0 || (size_t) len >= (size_t) (r->end - r->p) || r->p[len] != '\0')
+    {
+	r->failed = FcTrue;
+	return NULL;
+    }
+    s = r->p;
+    r->p += len + 1;
+    return s;
+}
+
+static FcObject
+FcConfigCacheGetObject (FcConfigCacheReader *r)
+{
+    const FcChar8 *name = FcConfigCacheGetString (r);
+
+    if (!name)
+	return FC_INVALID_OBJECT;
+    return FcObjectFromName ((const char *) name);
+}
+
+static FcBool
+FcConfigCacheGetStrSet (FcConfigCacheReader *r, FcStrSet *set)
+{
+    const FcChar8   *s;
+    int		    n = FcConfigCacheGetCount (r, sizeof (int));
+
+    while (n-- > 0)
+    {
+	s = FcConfigCacheGetString (r);
+	if (!s || !FcStrSetAdd (set, s))
+	    return FcFalse;
+    }
+    return !r->failed;
+}
+
+static FcCharSet *
+FcConfigCacheGetCharSet (FcConfigCacheReader *r)
+{
+    FcCharSet	*c = FcCharSetCreate ();
+    FcCharLeaf	*leaf;
+    int		n = FcConfigCacheGetCount (r, sizeof (int) + sizeof (FcCharLeaf));
+    int		page;
+
+    if (!c)
+	return NULL;
+    while (n-- > 0)
+    {
+	page = FcConfigCacheGetInt (r);
+	if (page < 0 || page > 0xffff ||
+	    !(leaf = FcCharSetFindLeafCreate (c, (FcChar32) page << 8)) ||
+	    !FcConfigCacheGet (r, leaf->map, sizeof (FcCharLeaf)))
+	{
+	    FcCharSetDestroy (c);
+	    return NULL;
+	}
+    }
+    if (r->failed)
+    {
+	FcCharSetDestroy (c);
+	return NULL;
+    }
+    return c;
+}
+
+static FcLangSet *
+FcConfigCacheGetLangSet (FcConfigCacheReader *r)
+{
+    FcLangSet	    *l = FcLangSetCreate ();
+    const FcChar8   *s;
+    int		    n = FcConfigCacheGetCount (r, sizeof (int));
+
+    if (!l)
+	return NULL;
+    while (n-- > 0)
+    {
+	s = FcConfigCacheGetString (r);
+	if (!s || !FcLangSetAdd (l, s))
+	{
+	    FcLangSetDestroy (l);
+	    return NULL;
+	}
+    }
+    if (r->failed)
+    {
+	FcLangSetDestroy (l);
+	return NULL;
+    }
+    return l;
+}
+
+static FcBool
+FcConfigCacheGetValue (FcConfigCacheReader *r, FcPattern *p,
+		       FcObject object, FcValueBinding binding)
+{
+    FcValue	v;
+    FcMatrix	m;
+    FcBool	ret;
+    double	begin, end;
+
+    v.type = FcConfigCacheGetInt (r);
+    switch ((int) v.type) {
+    case FcTypeInteger:
+	v.u.i = FcConfigCacheGetInt (r);
+	break;
+    case FcTypeDouble:
+	v.u.d = FcConfigCacheGetDouble (r);
+	break;
+    case FcTypeString:
+	v.u.s = FcConfigCacheGetString (r);
+	if (!v.u.s)
+	    return FcFalse;
+	break;
+    case FcTypeBool:
+	v.u.b = FcConfigCacheGetInt (r);
+	break;
+    case FcTypeMatrix:
+	m.xx = FcConfigCacheGetDouble (r);
+	m.xy = FcConfigCacheGetDouble (r);
+	m.yx = FcConfigCacheGetDouble (r);
+	m.yy = FcConfigCacheGetDouble (r);
+	v.u.m = &m;
+	break;
+    case FcTypeCharSet:
+	v.u.c = FcConfigCacheGetCharSet (r);
+	if (!v.u.c)
+	    return FcFalse;
+	break;
+    case FcTypeLangSet:
+	v.u.l = FcConfigCacheGetLangSet (r);
+	if (!v.u.l)
+	    return FcFalse;
+	break;
+    case FcTypeRange:
+	begin = FcConfigCacheGetDouble (r);
+	end = FcConfigCacheGetDouble (r);
+	v.u.r = FcRangeCreateDouble (begin, end);
+	if (!v.u.r)
+	    return FcFalse;
+	break;
+    default:
+	return FcFalse;
+    }
+    ret = !r->failed &&
+	  FcPatternObjectAddWithBinding (p, object, v, binding, FcTrue);
+    /* the pattern has its own copy */
+    switch ((int) v.type) {
+    case FcTypeCharSet:
+	FcCharSetDestroy ((FcCharSet *) v.u.c);
+	break;
+    case FcTypeLangSet:
+	FcLangSetDestroy ((FcLangSet *) v.u.l);
+	break;
+    case FcTypeRange:
+	FcRangeDestroy ((FcRange *) v.u.r);
+	break;
+    default:
+	break;
+    }
+    return ret;
+}
+
+static FcPattern *
+FcConfigCacheGetPattern (FcConfigCacheReader *r)
+{
+    FcPattern	    *p = FcPatternCreate ();
+    FcObject	    object;
+    FcValueBinding  binding;
+    int		    nelt, nvalue;
+
+    if (!p)
+	return NULL;
+    nelt = FcConfigCacheGetCount (r, 2 * sizeof (int));
+    while (nelt-- > 0)
+    {
+	object = FcConfigCacheGetObject (r);
+	nvalue = FcConfigCacheGetCount (r, 2 * sizeof (int));
+	if (object == FC_INVALID_OBJECT)
+	    goto bail;
+	while (nvalue-- > 0)
+	{
+	    binding = FcConfigCacheGetInt (r);
+	    if (!FcConfigCacheGetValue (r, p, object, binding))
+		goto bail;
+	}
+    }
+    if (!r->failed)
+	return p;
+bail:
+    FcPatternDestroy (p);
+    return NULL;
+}
+
+static FcExpr *
+FcConfigCacheGetExpr (FcConfigCacheReader *r, FcConfig *config, int depth)
+{
+    FcExpr	    *e, *left = NULL, *right = NULL;
+    FcExprMatrix    *m;
+    const FcChar8   *s;
+    double	    begin, end;
+    int		    op;
+
+    op = FcConfigCacheGetInt (r);
+    if (r->failed || op == -1)
+	return NULL;
+    if (depth > FC_CONFIG_CACHE_MAX_DEPTH || !(e = FcConfigAllocExpr (config)))
+    {
+	r->failed = FcTrue;
+	return NULL;
+    }
+    /* expressions live in the pool, only what they point to is freed */
+    e->op = FcOpNil;
+    switch (FC_OP_GET_OP (op)) {
+    case FcOpInteger:
+	e->u.ival = FcConfigCacheGetInt (r);
+	break;
+    case FcOpDouble:
+	e->u.dval = FcConfigCacheGetDouble (r);
+	break;
+    case FcOpString:
+    case FcOpConst:
+	s = FcConfigCacheGetString (r);
+	if (!s || !(s = FcStrdup (s)))
+	    goto bail;
+	if (FC_OP_GET_OP (op) == FcOpString)
+	    e->u.sval = s;
+	else
+	    e->u.constant = s;
+	break;
+    case FcOpMatrix:
+	m = calloc (1, sizeof (FcExprMatrix));
+	if (!m)
+	    goto bail;
+	m->xx = FcConfigCacheGetExpr (r, config, depth + 1);
+	m->xy = FcConfigCacheGetExpr (r, config, depth + 1);
+	m->yx = FcConfigCacheGetExpr (r, config, depth + 1);
+	m->yy = FcConfigCacheGetExpr (r, config, depth + 1);
+	e->u.mexpr = m;
+	break;
+    case FcOpRange:
+	begin = FcConfigCacheGetDouble (r);
+	end = FcConfigCacheGetDouble (r);
+	e->u.rval = FcRangeCreateDouble (begin, end);
+	if (!e->u.rval)
+	    goto bail;
+	break;
+    case FcOpBool:
+	e->u.bval = FcConfigCacheGetInt (r);
+	break;
+    case FcOpCharSet:
+	e->u.cval = FcConfigCacheGetCharSet (r);
+	if (!e->u.cval)
+	    goto bail;
+	break;
+    case FcOpLangSet:
+	e->u.lval = FcConfigCacheGetLangSet (r);
+	if (!e->u.lval)
+	    goto bail;
+	break;
+    case FcOpField:
+	e->u.name.object = FcConfigCacheGetObject (r);
+	e->u.name.kind = FcConfigCacheGetInt (r);
+	break;
+    case FcOpAssign:
+    case FcOpAssignReplace:
+    case FcOpPrepend:
+    case FcOpPrependFirst:
+    case FcOpAppend:
+    case FcOpAppendLast:
+    case FcOpDelete:
+    case FcOpDeleteAll:
+    case FcOpNil:
+    case FcOpInvalid:
+	break;
+    case FcOpOr:
+    case FcOpAnd:
+    case FcOpEqual:
+    case FcOpNotEqual:
+    case FcOpLess:
+    case FcOpLessEqual:
+    case FcOpMore:
+    case FcOpMoreEqual:
+    case FcOpContains:
+    case FcOpListing:
+    case FcOpNotContains:
+    case FcOpPlus:
+    case FcOpMinus:
+    case FcOpTimes:
+    case FcOpDivide:
+    case FcOpQuest:
+    case FcOpComma:
+	left = FcConfigCacheGetExpr (r, config, depth + 1);
+	right = FcConfigCacheGetExpr (r, config, depth + 1);
+	e->u.tree.left = left;
+	e->u.tree.right = right;
+	break;
+    case FcOpNot:
+    case FcOpFloor:
+    case FcOpCeil:
+    case FcOpRound:
+    case FcOpTrunc:
+	left = FcConfigCacheGetExpr (r, config, depth + 1);
+	e->u.tree.left = left;
+	e->u.tree.right = NULL;
+	break;
+    default:
+	goto bail;
+    }
+    e->op = op;
+    if (!r->failed)
+	return e;
+    FcExprDestroy (e);
+bail:
+    r->failed = FcTrue;
+    return NULL;
+}
+
+static FcRule *
+FcConfigCacheGetRules (FcConfigCacheReader *r, FcConfig *config)
+{
+    FcRule  *rules = NULL, **prev = &rules, *rule;
+    FcTest  *test;
+    FcEdit  *edit;
+    int	    n = FcConfigCacheGetCount (r, 2 * sizeof (int));
+
+    while (n-- > 0)
+    {
+	rule = malloc (sizeof (FcRule));
+	if (!rule)
+	    goto bail;
+	rule->next = NULL;
+	rule->type = FcRuleUnknown;
+	*prev = rule;
+	prev = &rule->next;
+
+	switch (FcConfigCacheGetInt (r)) {
+	case FcRuleTest:
+	    test = malloc (sizeof (FcTest));
+	    if (!test)
+		goto bail;
+	    test->kind = FcConfigCacheGetInt (r);
+	    test->qual = FcConfigCacheGetInt (r);
+	    test->object = FcConfigCacheGetObject (r);
+	    test->op = FcConfigCacheGetInt (r);
+	    test->expr = FcConfigCacheGetExpr (r, config, 0);
+	    rule->type = FcRuleTest;
+	    rule->u.test = test;
+	    break;
+	case FcRuleEdit:
+	    edit = malloc (sizeof (FcEdit));
+	    if (!edit)
+		goto bail;
+	    edit->object = FcConfigCacheGetObject (r);
+	    edit->op = FcConfigCacheGetInt (r);
+	    edit->binding = FcConfigCacheGetInt (r);
+	    edit->expr = FcConfigCacheGetExpr (r, config, 0);
+	    rule->type = FcRuleEdit;
+	    rule->u.edit = edit;
+	    break;
+	default:
+	    goto bail;
+	}
+	if (r->failed)
+	    goto bail;
+    }
+    if (!r->failed && rules)
+	return rules;
+bail:
+    r->failed = FcTrue;
+    if (rules)
+	FcRuleDestroy (rules);
+    return NULL;
+}
+
+static FcRuleSet *
+FcConfigCacheGetRuleSet (FcConfigCacheReader *r, FcConfig *config)
+{
+    FcRuleSet	    *rs;
+    FcRule	    *rules;
+    const FcChar8   *name, *description, *domain;
+    FcMatchKind	    k;
+    int		    n, max;
+
+    name = FcConfigCacheGetString (r);
+    description = FcConfigCacheGetString (r);
+    domain = FcConfigCacheGetString (r);
+    if (r->failed)
+	return NULL;
+    rs = FcRuleSetCreate (name);
+    if (!rs)
+	return NULL;
+    FcRuleSetEnable (rs, FcConfigCacheGetInt (r));
+    FcRuleSetAddDescription (rs, domain, description);
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+    {
+	n = FcConfigCacheGetCount (r, sizeof (int));
+	while (n-- > 0)
+	{
+	    rules = FcConfigCacheGetRules (r, config);
+	    if (!rules)
+		goto bail;
+	    if ((max = FcRuleSetAdd (rs, rules, k)) == -1)
+	    {
+		FcRuleDestroy (rules);
+		goto bail;
+	    }
+	    if (config->maxObjects < max)
+		config->maxObjects = max;
+	}
+    }
+    if (!r->failed)
+	return rs;
+bail:
+    FcRuleSetDestroy (rs);
+    return NULL;
+}
+
+static FcBool
+FcConfigCacheGetRuleSetList (FcConfigCacheReader *r, FcPtrList *list,
+			     FcRuleSet **sets, int nsets)
+{
+    FcPtrListIter   iter;
+    int		    n = FcConfigCacheGetCount (r, sizeof (int));
+    int		    i;
+
+    while (n-- > 0)
+    {
+	i = FcConfigCacheGetInt (r);
+	if (r->failed || i < 0 || i >= nsets)
+	    return FcFalse;
+	FcPtrListIterInitAtLast (list, &iter);
+	FcRuleSetReference (sets[i]);
+	if (!FcPtrListIterAdd (list, &iter, sets[i]))
+	{
+	    FcRuleSetDestroy (sets[i]);
+	    return FcFalse;
+	}
+    }
+    return !r->failed;
+}
+
+static FcBool
+FcConfigCacheGetState (FcConfigCacheReader *r, FcConfig *config)
+{
+    FcRuleSet	    **sets;
+    FcPattern	    *p;
+    const FcChar8   *dir, *map, *salt;
+    FcMatchKind	    k;
+    FcBool	    ret = FcFalse;
+    int		    i, n, nsets;
+
+    if (!FcConfigCacheGetStrSet (r, config->configDirs) ||
+	!FcConfigCacheGetStrSet (r, config->configMapDirs))
+	return FcFalse;
+    n = FcConfigCacheGetCount (r, 3 * sizeof (int));
+    while (n-- > 0)
+    {
+	dir = FcConfigCacheGetString (r);
+	map = FcConfigCacheGetString (r);
+	salt = FcConfigCacheGetString (r);
+	if (!dir || !FcStrSetAddTriple (config->fontDirs, dir, map, salt))
+	    return FcFalse;
+    }
+    if (!FcConfigCacheGetStrSet (r, config->cacheDirs) ||
+	!FcConfigCacheGetStrSet (r, config->configFiles) ||
+	!FcConfigCacheGetStrSet (r, config->availConfigFiles) ||
+	!FcConfigCacheGetStrSet (r, config->acceptGlobs) ||
+	!FcConfigCacheGetStrSet (r, config->rejectGlobs))
+	return FcFalse;
+    n = FcConfigCacheGetCount (r, sizeof (int));
+    while (n-- > 0)
+	if (!(p = FcConfigCacheGetPattern (r)) ||
+	    !FcFontSetAdd (config->acceptPatterns, p))
+	    return FcFalse;
+    n = FcConfigCacheGetCount (r, sizeof (int));
+    while (n-- > 0)
+	if (!(p = FcConfigCacheGetPattern (r)) ||
+	    !FcFontSetAdd (config->rejectPatterns, p))
+	    return FcFalse;
+    config->rescanInterval = FcConfigCacheGetInt (r);
+
+    nsets = FcConfigCacheGetCount (r, 4 * sizeof (int));
+    sets = calloc (nsets + 1, sizeof (FcRuleSet *));
+    if (!sets)
+	return FcFalse;
+    for (i = 0; i < nsets; i++)
+	if (!(sets[i] = FcConfigCacheGetRuleSet (r, config)))
+	    goto bail;
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+	if (!FcConfigCacheGetRuleSetList (r, config->subst[k], sets, nsets))
+	    goto bail;
+    if (!FcConfigCacheGetRuleSetList (r, config->rulesetList, sets, nsets))
+	goto bail;
+    ret = !r->failed;
+bail:
+    for (i = 0; i < nsets; i++)
+	FcRuleSetDestroy (sets[i]);
+    free (sets);
+    return ret;
+}
+
+static FcBool
+FcConfigCacheDepsValid (FcConfigCacheReader *r, FcConfig *config)
+{
+    unsigned char   digest[16], cached[16];
+    struct stat	    statb;
+    const FcChar8   *file;
+    FcChar8	    *found;
+    int64_t	    size, mtime, mtime_nano;
+    int		    dep, n;
+
+    n = FcConfigCacheGetCount (r, 2 * sizeof (int));
+    while (n-- > 0)
+    {
+	dep = FcConfigCacheGetInt (r);
+	file = FcConfigCacheGetString (r);
+	if (!file)
+	    return FcFalse;
+	if (dep == FcConfigCacheDepMissing)
+	{
+	    found = FcConfigGetFilename (config, file);
+	    if (found)
+	    {
+		if (FcDebug () & FC_DBG_CONFIG)
+		    printf ("\tConfig cache: %s appeared\n", found);
+		FcStrFree (found);
+		return FcFalse;
+	    }
+	    continue;
+	}
+	size = FcConfigCacheGetInt64 (r);
+	mtime = FcConfigCacheGetInt64 (r);
+	mtime_nano = FcConfigCacheGetInt64 (r);
+	FcConfigCacheGet (r, cached, sizeof (cached));
+	if (r->failed || FcStat (file, &statb) < 0 ||
+	    (dep == FcConfigCacheDepDir) != !!S_ISDIR (statb.st_mode))
+	    return FcFalse;
+	if (statb.st_size == size && statb.st_mtime == mtime &&
+	    FcConfigCacheMtimeNano (&statb) == mtime_nano)
+	    continue;
+	if (dep == FcConfigCacheDepDir || statb.st_size != size ||
+	    !FcConfigCacheHashFile (file, digest) ||
+	    memcmp (digest, cached, sizeof (digest)) != 0)
+	{
+	    if (FcDebug () & FC_DBG_CONFIG)
+		printf ("\tConfig cache: %s changed\n", file);
+	    return FcFalse;
+	}
+    }
+    return !r->failed;
+}
+
+/*
+ * Naming and placing the cache file
+ */
+
+static void
+FcConfigCacheKeyAdd (FcStrBuf *key, const char *name, const FcChar8 *value)
+{
+    FcStrBufString (key, (const FcChar8 *) name);
+    if (value)
+    {
+	FcStrBufChar (key, '=');
+	FcStrBufString (key, value);
+    }
+    FcStrBufChar (key, '\n');
+}
+
+static FcChar8 *
+FcConfigCacheKey (FcConfig *config, FcBool cwd)
+{
+    FcStrBuf	key;
+    FcChar8	*s;
+
+    s = FcConfigGetFilename (config, NULL);
+    if (!s)
+	return NULL;
+    FcStrBufInit (&key, NULL, 0);
+    FcConfigCacheKeyAdd (&key, "file", s);
+    FcStrFree (s);
+    FcConfigCacheKeyAdd (&key, "sysroot", FcConfigGetSysRoot (config));
+    FcConfigCacheKeyAdd (&key, "path", (const FcChar8 *) getenv ("FONTCONFIG_PATH"));
+    FcConfigCacheKeyAdd (&key, "home", FcConfigHome ());
+    s = FcConfigXdgConfigHome ();
+    FcConfigCacheKeyAdd (&key, "config", s);
+    FcStrFree (s);
+    s = FcConfigXdgDataHome ();
+    FcConfigCacheKeyAdd (&key, "data", s);
+    FcStrFree (s);
+    s = FcConfigXdgCacheHome ();
+    FcConfigCacheKeyAdd (&key, "cache", s);
+    FcStrFree (s);
+#ifdef _WIN32
+    {
+	char buf[MAX_PATH + 1];
+
+	/* CUSTOMFONTDIR and friends, and the temporary cache directory */
+	if (GetModuleFileName (NULL, buf, sizeof (buf)))
+	    FcConfigCacheKeyAdd (&key, "module", (const FcChar8 *) buf);
+	if (GetTempPath (sizeof (buf), buf))
+	    FcConfigCacheKeyAdd (&key, "temp", (const FcChar8 *) buf);
+	FcConfigCacheKeyAdd (&key, "appdata", (const FcChar8 *) getenv ("LOCALAPPDATA"));
+    }
+#endif
+    if (cwd)
+    {
+	s = FcStrCopyFilename ((const FcChar8 *) ".");
+	if (!s)
+	{
+	    FcStrBufDestroy (&key);
+	    return NULL;
+	}
+	FcConfigCacheKeyAdd (&key, "cwd", s);
+	FcStrFree (s);
+    }
+    return FcStrBufDone (&key);
+}
+
+static void
+FcConfigCacheBasename (const FcChar8 *key, FcChar8 base[FC_CONFIG_CACHE_BASE_LEN])
+{
+    static const char	bin2hex[] = "0123456789abcdef";
+    struct MD5Context	ctx;
+    unsigned char	hash[16];
+    int			i;
+
+    MD5Init (&ctx);
+    MD5Update (&ctx, key, strlen ((const char *) key));
+    MD5Final (hash, &ctx);
+    for (i = 0; i < 16; i++)
+    {
+	base[2 * i] = bin2hex[hash[i] >> 4];
+	base[2 * i + 1] = bin2hex[hash[i] & 0xf];
+    }
+    base[2 * i] = 0;
+    strcat ((char *) base, "-" FC_ARCHITECTURE FC_CONFIG_CACHE_SUFFIX);
+}
+
+/*
+ * The cache directories of the configuration aren't known before it is
+ * loaded, so use the ones it gets by default: the system one, then the
+ * user one.
+ */
+static FcStrSet *
+FcConfigCacheDirs (FcConfig *config)
+{
+    const FcChar8   *sysroot = FcConfigGetSysRoot (config);
+    const char	    *system = FC_CACHEDIR;
+    FcStrSet	    *dirs = FcStrSetCreate ();
+    FcChar8	    *home, *d;
+
+    if (!dirs)
+	return NULL;
+    if (system)
+    {
+	if (sysroot)
+	{
+	    d = FcStrBuildFilename (sysroot, (const FcChar8 *) system, NULL);
+	    if (d)
+	    {
+		FcStrSetAddFilename (dirs, d);
+		FcStrFree (d);
+	    }
+	}
+	else
+	    FcStrSetAddFilename (dirs, (const FcChar8 *) system);
+    }
+    home = FcConfigXdgCacheHome ();
+    if (home)
+    {
+	if (sysroot)
+	    d = FcStrBuildFilename (sysroot, home, (const FcChar8 *) "fontconfig", NULL);
+	else
+	    d = FcStrBuildFilename (home, (const FcChar8 *) "fontconfig", NULL);
+	if (d)
+	{
+	    FcStrSetAddFilename (dirs, d);
+	    FcStrFree (d);
+	}
+	FcStrFree (home);
+    }
+    return dirs;
+}
+
+/*
+ * The state is only what parsing the configuration files into an empty
+ * configuration produces.
+ */
+static FcBool
+FcConfigCacheIsEmpty (FcConfig *config)
+{
+    FcPtrListIter   iter;
+    FcMatchKind	    k;
+
+    for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+    {
+	FcPtrListIterInit (config->subst[k], &iter);
+	if (FcPtrListIterIsValid (config->subst[k], &iter))
+	    return FcFalse;
+    }
+    FcPtrListIterInit (config->rulesetList, &iter);
+    return !FcPtrListIterIsValid (config->rulesetList, &iter) &&
+	   config->configDirs->num == 0 &&
+	   config->configMapDirs->num == 0 &&
+	   config->fontDirs->num == 0 &&
+	   config->cacheDirs->num == 0 &&
+	   config->configFiles->num == 0 &&
+	   config->availConfigFiles->num == 0 &&
+	   config->acceptGlobs->num == 0 &&
+	   config->rejectGlobs->num == 0 &&
+	   config->acceptPatterns->nfont == 0 &&
+	   config->rejectPatterns->nfont == 0;
+}
+
+static void
+FcConfigCacheSwapStrSet (FcStrSet **a, FcStrSet **b)
+{
+    FcStrSet *t = *a;
+
+    *a = *b;
+    *b = t;
+}
+
+static void
+FcConfigCacheSwapFontSet (FcFontSet **a, FcFontSet **b)
+{
+    FcFontSet *t = *a;
+
+    *a = *b;
+    *b = t;
+}
+
+static void
+FcConfigCacheSwapPtrList (FcPtrList **a, FcPtrList **b)
+{
+    FcPtrList *t = *a;
+
+    *a = *b;
+    *b = t;
+}
+
+static void
+FcConfigCacheSwapExprPool (FcExprPage **a, FcExprPage **b)
+{
+    FcExprPage *t = *a;
+
+    *a = *b;
+    *b = t;
+}
+
+static FcBool
+FcConfigCacheLoadFile (FcConfig *config, const FcChar8 *file, const FcChar8 *key)
+{
+    FcConfigCacheReader	r;
+    FcConfig		*loaded;
+    struct stat		statb;
+    FcMatchKind		k;
+    void		*data = NULL;
+    FcBool		ret = FcFalse;
+#if defined(HAVE_MMAP) || defined(__CYGWIN__)
+    FcBool		mapped = FcFalse;
+#endif
+    int			fd;
+
+    fd = FcOpen ((const char *) file, O_RDONLY | O_BINARY);
+    if (fd == -1)
+	return FcFalse;
+    if (fstat (fd, &statb) < 0 || statb.st_size < 3 * sizeof (int) ||
+	statb.st_size > INT_MAX)
+    {
+	close (fd);
+	return FcFalse;
+    }
+#if defined(HAVE_MMAP) || defined(__CYGWIN__)
+    data = mmap (NULL, statb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+	data = NULL;
+    else
+	mapped = FcTrue;
+#endif
+    if (!data)
+    {
+	data = malloc (statb.st_size);
+	if (data && read (fd, data, statb.st_size) != statb.st_size)
+	{
+	    free (data);
+	    data = NULL;
+	}
+    }
+    close (fd);
+    if (!data)
+	return FcFalse;
+
+    r.p = data;
+    r.end = r.p + statb.st_size;
+    r.failed = FcFalse;
+    if (FcConfigCacheGetInt (&r) != FC_CONFIG_CACHE_MAGIC ||
+	FcConfigCacheGetInt (&r) != FC_CONFIG_CACHE_VERSION ||
+	FcConfigCacheGetInt (&r) != FC_VERSION ||
+	FcStrCmp (FcConfigCacheGetString (&r), key) != 0 ||
+	!FcConfigCacheDepsValid (&r, config))
+	goto bail;
+
+    /* Build it up on the side so a bad file leaves config alone */
+    loaded = FcConfigCreate ();
+    if (!loaded)
+	goto bail;
+    if (FcConfigCacheGetState (&r, loaded) && r.p == r.end)
+    {
+	FcConfigCacheSwapStrSet (&config->configDirs, &loaded->configDirs);
+	FcConfigCacheSwapStrSet (&config->configMapDirs, &loaded->configMapDirs);
+	FcConfigCacheSwapStrSet (&config->fontDirs, &loaded->fontDirs);
+	FcConfigCacheSwapStrSet (&config->cacheDirs, &loaded->cacheDirs);
+	FcConfigCacheSwapStrSet (&config->configFiles, &loaded->configFiles);
+	FcConfigCacheSwapStrSet (&config->availConfigFiles, &loaded->availConfigFiles);
+	FcConfigCacheSwapStrSet (&config->acceptGlobs, &loaded->acceptGlobs);
+	FcConfigCacheSwapStrSet (&config->rejectGlobs, &loaded->rejectGlobs);
+	FcConfigCacheSwapFontSet (&config->acceptPatterns, &loaded->acceptPatterns);
+	FcConfigCacheSwapFontSet (&config->rejectPatterns, &loaded->rejectPatterns);
+	for (k = FcMatchKindBegin; k < FcMatchKindEnd; k++)
+	    FcConfigCacheSwapPtrList (&config->subst[k], &loaded->subst[k]);
+	FcConfigCacheSwapPtrList (&config->rulesetList, &loaded->rulesetList);
+	FcConfigCacheSwapExprPool (&config->expr_pool, &loaded->expr_pool);
+	config->maxObjects = loaded->maxObjects;
+	config->rescanInterval = loaded->rescanInterval;
+	FcConfigInvalidateMatchCache (config);
+	ret = FcTrue;
+    }
+    FcConfigDestroy (loaded);
+bail:
+#if defined(HAVE_MMAP) || defined(__CYGWIN__)
+    if (mapped)
+	munmap (data, statb.st_size);
+    else
+#endif
+	free (data);
+    return ret;
+}
+
+/*
+ * Load the configuration of an empty config from the cache, if there is
+ * an up to date cache of it.
+ */
+FcBool
+FcConfigCacheLoad (FcConfig *config)
+{
+    FcChar8	base[FC_CONFIG_CACHE_BASE_LEN];
+    FcStrSet	*dirs;
+    FcChar8	*key, *file;
+    FcBool	ret = FcFalse;
+    int		i, cwd;
+
+    if (!FcConfigCacheIsEmpty (config))
+    {
+	config->uncacheable = FcTrue;
+	return FcFalse;
+    }
+    dirs = FcConfigCacheDirs (config);
+    if (!dirs)
+	return FcFalse;
+    for (cwd = 0; !ret && cwd <= 1; cwd++)
+    {
+	key = FcConfigCacheKey (config, cwd);
+	if (!key)
+	    break;
+	FcConfigCacheBasename (key, base);
+	for (i = 0; !ret && i < dirs->num; i++)
+	{
+	    file = FcStrBuildFilename (dirs->strs[i], base, NULL);
+	    if (!file)
+		continue;
+	    ret = FcConfigCacheLoadFile (config, file, key);
+	    if (ret && (FcDebug () & FC_DBG_CONFIG))
+		printf ("\tLoaded config cache %s\n", file);
+	    FcStrFree (file);
+	}
+	FcStrFree (key);
+    }
+    FcStrSetDestroy (dirs);
+    return ret;
+}
+
+/* Write it to the first of the directories which is writable */
+static FcChar8 *
+FcConfigCacheWritableDir (FcConfig *config)
+{
+    FcStrSet	*dirs = FcConfigCacheDirs (config);
+    FcChar8	*d, *ret = NULL;
+    int		i;
+
+    if (!dirs)
+	return NULL;
+    for (i = 0; !ret && i < dirs->num; i++)
+    {
+	d = dirs->strs[i];
+	if (access ((char *) d, W_OK) == 0)
+	    ret = FcStrCopyFilename (d);
+	else if (access ((char *) d, F_OK) == -1 && FcMakeDirectory (d))
+	{
+	    ret = FcStrCopyFilename (d);
+	    FcDirCacheCreateTagFile (d);
+	}
+    }
+    FcStrSetDestroy (dirs);
+    return ret;
+}
+
+/*
+ * Save the state of a configuration that has just been loaded from the
+ * configuration files, for FcConfigCacheLoad to find.  Failing to write
+ * it is not an error.
+ */
+void
+FcConfigCacheSave (FcConfig *config)
+{
+    FcChar8	base[FC_CONFIG_CACHE_BASE_LEN];
+    FcStrBuf	buf;
+    FcChar8	*key, *dir, *file = NULL;
+    FcAtomic	*atomic;
+    int		fd;
+
+    if (config->uncacheable)
+	return;
+    key = FcConfigCacheKey (config, config->relativeDirs);
+    if (!key)
+	return;
+    FcStrBufInit (&buf, NULL, 0);
+    FcConfigCachePutInt (&buf, FC_CONFIG_CACHE_MAGIC);
+    FcConfigCachePutInt (&buf, FC_CONFIG_CACHE_VERSION);
+    FcConfigCachePutInt (&buf, FC_VERSION);
+    FcConfigCachePutString (&buf, key);
+    if (!FcConfigCachePutDeps (&buf, config) ||
+	!FcConfigCachePutState (&buf, config) ||
+	buf.failed)
+	goto bail;
+
+    dir = FcConfigCacheWritableDir (config);
+    if (!dir)
+	goto bail;
+    FcConfigCacheBasename (key, base);
+    file = FcStrBuildFilename (dir, base, NULL);
+    FcStrFree (dir);
+    if (!file)
+	goto bail;
+    if (FcDebug () & FC_DBG_CONFIG)
+	printf ("\tSaving config cache %s\n", file);
+
+    atomic = FcAtomicCreate (file);
+    if (!atomic)
+	goto bail;
+    if (!FcAtomicLock (atomic))
+	goto bail1;
+    fd = FcOpen ((char *) FcAtomicNewFile (atomic), O_RDWR | O_CREAT | O_BINARY, 0666);
+    if (fd == -1)
+	goto bail2;
+    if (write (fd, buf.buf, buf.len) != buf.len)
+    {
+	close (fd);
+	goto bail2;
+    }
+    close (fd);
+    FcAtomicReplaceOrig (atomic);
+bail2:
+    FcAtomicUnlock (atomic);
+bail1:
+    FcAtomicDestroy (atomic);
+bail:
+    if (file)
+	FcStrFree (file);
+    FcStrBufDestroy (&buf);
+    FcStrFree (key);
+}
@@ -396,7 +396,23 @@ FcCharSetAddLeaf (FcCharSet	*fcs,
 		  FcChar32	ucs4,
 		  FcCharLeaf	*leaf)
 {
-    FcCharLeaf   *new = FcCharSetFindLeafCreate (fcs, ucs4);
+    FcCharLeaf   *new;
+
+    /* Set operations add leaves in order, skip looking for the spot */
+    if (!fcs->num || FcCharSetNumbers(fcs)[fcs->num - 1] < (ucs4 >> 8))
+    {
+	new = malloc (sizeof (FcCharLeaf));
+	if (!new)
+	    return FcFalse;
+	*new = *leaf;
+	if (!FcCharSetPutLeaf (fcs, ucs4, new, fcs->num))
+	{
+	    free (new);
+	    return FcFalse;
+	}
+	return FcTrue;
+    }
+    new = FcCharSetFindLeafCreate (fcs, ucs4);
     if (!new)
 	return FcFalse;
     *new = *leaf;
@@ -472,18 +488,233 @@ bail0:
     return 0;
 }
 
+/*
+ * Operations on a single leaf.  Leaves are 256 bits, which is two SSE2
+ * registers or one AVX2 register, so the vector code is selected at
+ * build time; dispatching at run time would cost more than it saves.
+ * Without a hardware popcount, bits are counted a byte at a time in
+ * the vector registers and summed with psadbw.
+ */
+#if defined(__AVX2__)
+#define FC_CHARSET_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FC_CHARSET_SSE2
+#include <emmintrin.h>
+#if defined(__POPCNT__) && defined(__x86_64__)
+#define FC_CHARSET_POPCNT
+#include <nmmintrin.h>
+#endif
+#endif
+
+#if defined(FC_CHARSET_AVX2)
+
+typedef __m256i FcLeafVec;
+
+#define FcLeafLoad(m)		_mm256_loadu_si256 ((const __m256i *) (m))
+#define FcLeafStore(m,v)	_mm256_storeu_si256 ((__m256i *) (m), (v))
+#define FcLeafAnd(a,b)		_mm256_and_si256 ((a), (b))
+#define FcLeafOr(a,b)		_mm256_or_si256 ((a), (b))
+#define FcLeafAndNot(a,b)	_mm256_andnot_si256 ((b), (a))	/* a & ~b */
+#define FcLeafIsZero(v)		_mm256_testz_si256 ((v), (v))
+
+static inline FcChar32
+FcLeafPopCount (FcLeafVec v)
+{
+    const __m256i   lut = _mm256_setr_epi8 (0, 1, 1, 2, 1, 2, 2, 3,
+					    1, 2, 2, 3, 2, 3, 3, 4,
+					    0, 1, 1, 2, 1, 2, 2, 3,
+					    1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i   low = _mm256_set1_epi8 (0x0f);
+    __m256i	    n;
+    __m128i	    s;
+
+    n = _mm256_add_epi8 (_mm256_shuffle_epi8 (lut, _mm256_and_si256 (v, low)),
+			 _mm256_shuffle_epi8 (lut, _mm256_and_si256 (_mm256_srli_epi16 (v, 4), low)));
+    n = _mm256_sad_epu8 (n, _mm256_setzero_si256 ());
+    s = _mm_add_epi64 (_mm256_castsi256_si128 (n), _mm256_extracti128_si256 (n, 1));
+    s = _mm_add_epi64 (s, _mm_srli_si128 (s, 8));
+    return _mm_cvtsi128_si32 (s);
+}
+
+#elif defined(FC_CHARSET_SSE2)
+
+typedef struct { __m128i lo, hi; } FcLeafVec;
+
+static inline FcLeafVec
+FcLeafLoad (const FcChar32 *m)
+{
+    FcLeafVec v;
+
+    v.lo = _mm_loadu_si128 ((const __m128i *) m);
+    v.hi = _mm_loadu_si128 ((const __m128i *) (m + 4));
+    return v;
+}
+
+static inline void
+FcLeafStore (FcChar32 *m, FcLeafVec v)
+{
+    _mm_storeu_si128 ((__m128i *) m, v.lo);
+    _mm_storeu_si128 ((__m128i *) (m + 4), v.hi);
+}
+
+static inline FcLeafVec
+FcLeafAnd (FcLeafVec a, FcLeafVec b)
+{
+    a.lo = _mm_and_si128 (a.lo, b.lo);
+    a.hi = _mm_and_si128 (a.hi, b.hi);
+    return a;
+}
+
+static inline FcLeafVec
+FcLeafOr (FcLeafVec a, FcLeafVec b)
+{
+    a.lo = _mm_or_si128 (a.lo, b.lo);
+    a.hi = _mm_or_si128 (a.hi, b.hi);
+    return a;
+}
+
+/* a & ~b */
+static inline FcLeafVec
+FcLeafAndNot (FcLeafVec a, FcLeafVec b)
+{
+    a.lo = _mm_andnot_si128 (b.lo, a.lo);
+    a.hi = _mm_andnot_si128 (b.hi, a.hi);
+    return a;
+}
+
+static inline FcBool
+FcLeafIsZero (FcLeafVec v)
+{
+    __m128i x = _mm_or_si128 (v.lo, v.hi);
+
+    return _mm_movemask_epi8 (_mm_cmpeq_epi8 (x, _mm_setzero_si128 ())) == 0xffff;
+}
+
+#if !defined(FC_CHARSET_POPCNT)
+static inline __m128i
+FcLeafByteCount (__m128i x)
+{
+    const __m128i m1 = _mm_set1_epi8 (0x55);
+    const __m128i m2 = _mm_set1_epi8 (0x33);
+    const __m128i m4 = _mm_set1_epi8 (0x0f);
+
+    x = _mm_sub_epi8 (x, _mm_and_si128 (_mm_srli_epi64 (x, 1), m1));
+    x = _mm_add_epi8 (_mm_and_si128 (x, m2), _mm_and_si128 (_mm_srli_epi64 (x, 2), m2));
+    return _mm_and_si128 (_mm_add_epi8 (x, _mm_srli_epi64 (x, 4)), m4);
+}
+#endif
+
+static inline FcChar32
+FcLeafPopCount (FcLeafVec v)
+{
+#if defined(FC_CHARSET_POPCNT)
+    return _mm_popcnt_u64 (_mm_cvtsi128_si64 (v.lo)) +
+	   _mm_popcnt_u64 (_mm_cvtsi128_si64 (_mm_srli_si128 (v.lo, 8))) +
+	   _mm_popcnt_u64 (_mm_cvtsi128_si64 (v.hi)) +
+	   _mm_popcnt_u64 (_mm_cvtsi128_si64 (_mm_srli_si128 (v.hi, 8)));
+#else
+    __m128i s;
+
+    /* each byte counts at most 8 + 8 bits */
+    s = _mm_add_epi8 (FcLeafByteCount (v.lo), FcLeafByteCount (v.hi));
+    s = _mm_sad_epu8 (s, _mm_setzero_si128 ());
+    s = _mm_add_epi64 (s, _mm_srli_si128 (s, 8));
+    return _mm_cvtsi128_si32 (s);
+#endif
+}
+
+#else
+
+static FcChar32
+FcCharSetPopCount (FcChar32 c1)
+{
+#if __GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4)
+    return __builtin_popcount (c1);
+#else
+    /* hackmem 169 */
+    FcChar32	c2 = (c1 >> 1) & 033333333333;
+    c2 = c1 - c2 - ((c2 >> 1) & 033333333333);
+    return (((c2 + (c2 >> 3)) & 030707070707) % 077);
+#endif
+}
+
+typedef FcCharLeaf FcLeafVec;
+
+static inline FcLeafVec
+FcLeafLoad (const FcChar32 *m)
+{
+    FcLeafVec v;
+
+    memcpy (v.map, m, sizeof (v.map));
+    return v;
+}
+
+#define FcLeafStore(m,v)	memcpy ((m), (v).map, sizeof ((v).map))
+
+static inline FcLeafVec
+FcLeafAnd (FcLeafVec a, FcLeafVec b)
+{
+    int i;
+
+    for (i = 0; i < 256/32; i++)
+	a.map[i] &= b.map[i];
+    return a;
+}
+
+static inline FcLeafVec
+FcLeafOr (FcLeafVec a, FcLeafVec b)
+{
+    int i;
+
+    for (i = 0; i < 256/32; i++)
+	a.map[i] |= b.map[i];
+    return a;
+}
+
+static inline FcLeafVec
+FcLeafAndNot (FcLeafVec a, FcLeafVec b)
+{
+    int i;
+
+    for (i = 0; i < 256/32; i++)
+	a.map[i] &= ~b.map[i];
+    return a;
+}
+
+static inline FcBool
+FcLeafIsZero (FcLeafVec v)
+{
+    int i;
+
+    for (i = 0; i < 256/32; i++)
+	if (v.map[i])
+	    return FcFalse;
+    return FcTrue;
+}
+
+static inline FcChar32
+FcLeafPopCount (FcLeafVec v)
+{
+    FcChar32	count = 0;
+    int		i;
+
+    for (i = 0; i < 256/32; i++)
+	count += FcCharSetPopCount (v.map[i]);
+    return count;
+}
+
+#endif
+
 static FcBool
 FcCharSetIntersectLeaf (FcCharLeaf *result,
 			const FcCharLeaf *al,
 			const FcCharLeaf *bl)
 {
-    int	    i;
-    FcBool  nonempty = FcFalse;
+    FcLeafVec r = FcLeafAnd (FcLeafLoad (al->map), FcLeafLoad (bl->map));
 
-    for (i = 0; i < 256/32; i++)
-	if ((result->map[i] = al->map[i] & bl->map[i]))
-	    nonempty = FcTrue;
-    return nonempty;
+    FcLeafStore (result->map, r);
+    return !FcLeafIsZero (r);
 }
 
 FcCharSet *
@@ -497,10 +728,7 @@ FcCharSetUnionLeaf (FcCharLeaf *result,
 		    const FcCharLeaf *al,
 		    const FcCharLeaf *bl)
 {
-    int	i;
-
-    for (i = 0; i < 256/32; i++)
-	result->map[i] = al->map[i] | bl->map[i];
+    FcLeafStore (result->map, FcLeafOr (FcLeafLoad (al->map), FcLeafLoad (bl->map)));
     return FcTrue;
 }
 
@@ -515,6 +743,7 @@ FcCharSetMerge (FcCharSet *a, const FcCharSet *b, FcBool *changed)
 {
     int		ai = 0, bi = 0;
     FcChar16	an, bn;
+    FcBool	added = FcFalse;
 
     if (!a || !b)
 	return FcFalse;
@@ -525,12 +754,10 @@ FcCharSetMerge (FcCharSet *a, const FcCharSet *b, FcBool *changed)
 	return FcFalse;
     }
 
-    if (changed) {
-	*changed = !FcCharSetIsSubset(b, a);
-	if (!*changed)
-	    return FcTrue;
-    }
-
+    /*
+     * Whether anything was added is worked out along the way instead of
+     * checking FcCharSetIsSubset first, which walks both sets once more
+     */
     while (bi < b->num)
     {
 	an = ai < a->num ? FcCharSetNumbers(a)[ai] : ~0;
@@ -549,11 +776,23 @@ FcCharSetMerge (FcCharSet *a, const FcCharSet *b, FcBool *changed)
 	    {
 		if (!FcCharSetAddLeaf (a, bn << 8, bl))
 		    return FcFalse;
+		added = FcTrue;
 	    }
 	    else
 	    {
 		FcCharLeaf *al = FcCharSetLeaf(a, ai);
-		FcCharSetUnionLeaf (al, al, bl);
+
+		if (al != bl)
+		{
+		    FcLeafVec av = FcLeafLoad (al->map);
+		    FcLeafVec bv = FcLeafLoad (bl->map);
+
+		    if (!FcLeafIsZero (FcLeafAndNot (bv, av)))
+		    {
+			FcLeafStore (al->map, FcLeafOr (av, bv));
+			added = FcTrue;
+		    }
+		}
 	    }
 
 	    ai++;
@@ -561,6 +800,8 @@ FcCharSetMerge (FcCharSet *a, const FcCharSet *b, FcBool *changed)
 	}
     }
 
+    if (changed)
+	*changed = added;
     return FcTrue;
 }
 
@@ -569,13 +810,10 @@ FcCharSetSubtractLeaf (FcCharLeaf *result,
 		       const FcCharLeaf *al,
 		       const FcCharLeaf *bl)
 {
-    int	    i;
-    FcBool  nonempty = FcFalse;
+    FcLeafVec r = FcLeafAndNot (FcLeafLoad (al->map), FcLeafLoad (bl->map));
 
-    for (i = 0; i < 256/32; i++)
-	if ((result->map[i] = al->map[i] & ~bl->map[i]))
-	    nonempty = FcTrue;
-    return nonempty;
+    FcLeafStore (result->map, r);
+    return !FcLeafIsZero (r);
 }
 
 FcCharSet *
@@ -597,50 +835,50 @@ FcCharSetHasChar (const FcCharSet *fcs, FcChar32 ucs4)
     return (leaf->map[(ucs4 & 0xff) >> 5] & (1U << (ucs4 & 0x1f))) != 0;
 }
 
-static FcChar32
-FcCharSetPopCount (FcChar32 c1)
-{
-#if __GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4)
-    return __builtin_popcount (c1);
-#else
-    /* hackmem 169 */
-    FcChar32	c2 = (c1 >> 1) & 033333333333;
-    c2 = c1 - c2 - ((c2 >> 1) & 033333333333);
-    return (((c2 + (c2 >> 3)) & 030707070707) % 077);
-#endif
-}
-
+/*
+ * The counting functions below walk the page numbers directly, jumping
+ * ahead with a binary search, as matching typically compares the small
+ * charset of a pattern with the large ones of the fonts.  Charsets from
+ * the same cache file share identical leaves, so leaves are compared
+ * only when they are not the same.
+ */
 FcChar32
 FcCharSetIntersectCount (const FcCharSet *a, const FcCharSet *b)
 {
-    FcCharSetIter   ai, bi;
+    int		    ai = 0, bi = 0;
+    FcChar16	    an, bn;
     FcChar32	    count = 0;
 
-    if (a && b)
+    if (!a || !b)
+	return 0;
+    while (ai < a->num && bi < b->num)
     {
-	FcCharSetIterStart (a, &ai);
-	FcCharSetIterStart (b, &bi);
-	while (ai.leaf && bi.leaf)
+	an = FcCharSetNumbers(a)[ai];
+	bn = FcCharSetNumbers(b)[bi];
+	if (an == bn)
 	{
-	    if (ai.ucs4 == bi.ucs4)
-	    {
-		FcChar32	*am = ai.leaf->map;
-		FcChar32	*bm = bi.leaf->map;
-		int		i = 256/32;
-		while (i--)
-		    count += FcCharSetPopCount (*am++ & *bm++);
-		FcCharSetIterNext (a, &ai);
-	    }
-	    else if (ai.ucs4 < bi.ucs4)
-	    {
-		ai.ucs4 = bi.ucs4;
-		FcCharSetIterSet (a, &ai);
-	    }
-	    if (bi.ucs4 < ai.ucs4)
-	    {
-		bi.ucs4 = ai.ucs4;
-		FcCharSetIterSet (b, &bi);
-	    }
+	    FcCharLeaf	*al = FcCharSetLeaf(a, ai);
+	    FcCharLeaf	*bl = FcCharSetLeaf(b, bi);
+
+	    if (al == bl)
+		count += FcLeafPopCount (FcLeafLoad (al->map));
+	    else
+		count += FcLeafPopCount (FcLeafAnd (FcLeafLoad (al->map),
+						    FcLeafLoad (bl->map)));
+	    ai++;
+	    bi++;
+	}
+	else if (an < bn)
+	{
+	    ai = FcCharSetFindLeafForward (a, ai + 1, bn);
+	    if (ai < 0)
+		ai = -ai - 1;
+	}
+	else
+	{
+	    bi = FcCharSetFindLeafForward (b, bi + 1, an);
+	    if (bi < 0)
+		bi = -bi - 1;
 	}
     }
     return count;
@@ -649,19 +887,13 @@ FcCharSetIntersectCount (const FcCharSet *a, const FcCharSet *b)
 FcChar32
 FcCharSetCount (const FcCharSet *a)
 {
-    FcCharSetIter   ai;
     FcChar32	    count = 0;
+    int		    ai;
 
     if (a)
     {
-	for (FcCharSetIterStart (a, &ai); ai.leaf; FcCharSetIterNext (a, &ai))
-	{
-	    int		    i = 256/32;
-	    FcChar32	    *am = ai.leaf->map;
-
-	    while (i--)
-		count += FcCharSetPopCount (*am++);
-	}
+	for (ai = 0; ai < a->num; ai++)
+	    count += FcLeafPopCount (FcLeafLoad (FcCharSetLeaf(a, ai)->map));
     }
     return count;
 }
@@ -669,38 +901,37 @@ FcCharSetCount (const FcCharSet *a)
 FcChar32
 FcCharSetSubtractCount (const FcCharSet *a, const FcCharSet *b)
 {
-    FcCharSetIter   ai, bi;
+    int		    ai, bi = 0;
+    FcChar16	    an;
     FcChar32	    count = 0;
 
-    if (a && b)
+    if (!a || !b)
+	return 0;
+    for (ai = 0; ai < a->num; ai++)
     {
-	FcCharSetIterStart (a, &ai);
-	FcCharSetIterStart (b, &bi);
-	while (ai.leaf)
+	FcCharLeaf  *al = FcCharSetLeaf(a, ai);
+
+	an = FcCharSetNumbers(a)[ai];
+	if (bi < b->num && FcCharSetNumbers(b)[bi] < an)
 	{
-	    if (ai.ucs4 <= bi.ucs4)
-	    {
-		FcChar32	*am = ai.leaf->map;
-		int		i = 256/32;
-		if (ai.ucs4 == bi.ucs4)
-		{
-		    FcChar32	*bm = bi.leaf->map;
-		    while (i--)
-			count += FcCharSetPopCount (*am++ & ~*bm++);
-		}
-		else
-		{
-		    while (i--)
-			count += FcCharSetPopCount (*am++);
-		}
-		FcCharSetIterNext (a, &ai);
-	    }
-	    else if (bi.leaf)
+	    /* usually the very next page */
+	    if (++bi < b->num && FcCharSetNumbers(b)[bi] < an)
 	    {
-		bi.ucs4 = ai.ucs4;
-		FcCharSetIterSet (b, &bi);
+		bi = FcCharSetFindLeafForward (b, bi + 1, an);
+		if (bi < 0)
+		    bi = -bi - 1;
 	    }
 	}
+	if (bi < b->num && FcCharSetNumbers(b)[bi] == an)
+	{
+	    FcCharLeaf	*bl = FcCharSetLeaf(b, bi);
+
+	    if (al != bl)
+		count += FcLeafPopCount (FcLeafAndNot (FcLeafLoad (al->map),
+						       FcLeafLoad (bl->map)));
+	}
+	else
+	    count += FcLeafPopCount (FcLeafLoad (al->map));
     }
     return count;
 }
@@ -729,19 +960,16 @@ FcCharSetIsSubset (const FcCharSet *a, const FcCharSet *b)
 	 */
 	if (an == bn)
 	{
-	    FcChar32	*am = FcCharSetLeaf(a, ai)->map;
-	    FcChar32	*bm = FcCharSetLeaf(b, bi)->map;
-	
-	    if (am != bm)
-	    {
-		int	i = 256/32;
-		/*
-		 * Does am have any bits not in bm?
-		 */
-		while (i--)
-		    if (*am++ & ~*bm++)
-			return FcFalse;
-	    }
+	    FcCharLeaf	*al = FcCharSetLeaf(a, ai);
+	    FcCharLeaf	*bl = FcCharSetLeaf(b, bi);
+
+	    /*
+	     * Does al have any bits not in bl?
+	     */
+	    if (al != bl &&
+		!FcLeafIsZero (FcLeafAndNot (FcLeafLoad (al->map),
+					     FcLeafLoad (bl->map))))
+		return FcFalse;
 	    ai++;
 	    bi++;
 	}
@@ -28,6 +28,16 @@
 #include <dirent.h>
 #endif
 
+#if !defined(FC_NO_MT) && defined(_WIN32)
+#include <process.h>
+#define FC_SCAN_THREADS 1
+#elif !defined(FC_NO_MT) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#define FC_SCAN_THREADS 1
+#endif
+
+#define FC_SCAN_MAX_THREADS	32
+
 FcBool
 FcFileIsDir (const FcChar8 *file)
 {
@@ -62,28 +72,18 @@ FcFileIsFile (const FcChar8 *file)
     return S_ISREG (statb.st_mode);
 }
 
+/*
+ * Apply sysroot and scan rules to the fonts just added to set
+ */
 static FcBool
-FcFileScanFontConfig (FcFontSet		*set,
-		      const FcChar8	*file,
-		      FcConfig		*config)
+FcFileScanFontEdit (FcFontSet		*set,
+		    int			old_nfont,
+		    FcConfig		*config)
 {
     int		i;
     FcBool	ret = FcTrue;
-    int		old_nfont = set->nfont;
     const FcChar8 *sysroot = FcConfigGetSysRoot (config);
 
-    if (FcDebug () & FC_DBG_SCAN)
-    {
-	printf ("\tScanning file %s...", file);
-	fflush (stdout);
-    }
-
-    if (!FcFreeTypeQueryAll (file, -1, NULL, NULL, set))
-	return FcFalse;
-
-    if (FcDebug () & FC_DBG_SCAN)
-	printf ("done\n");
-
     for (i = old_nfont; i < set->nfont; i++)
     {
 	FcPattern *font = set->fonts[i];
@@ -130,6 +130,28 @@ FcFileScanFontConfig (FcFontSet		*set,
     return ret;
 }
 
+static FcBool
+FcFileScanFontConfig (FcFontSet		*set,
+		      const FcChar8	*file,
+		      FcConfig		*config)
+{
+    int		old_nfont = set->nfont;
+
+    if (FcDebug () & FC_DBG_SCAN)
+    {
+	printf ("\tScanning file %s...", file);
+	fflush (stdout);
+    }
+
+    if (!FcFreeTypeQueryAll (file, -1, NULL, NULL, set))
+	return FcFalse;
+
+    if (FcDebug () & FC_DBG_SCAN)
+	printf ("done\n");
+
+    return FcFileScanFontEdit (set, old_nfont, config);
+}
+
 FcBool
 FcFileScanConfig (FcFontSet	*set,
 		  FcStrSet	*dirs,
@@ -194,6 +216,171 @@ cmpstringp(const void *p1, const void *p2)
     return strcmp(* (char **) p1, * (char **) p2);
 }
 
+#ifdef FC_SCAN_THREADS
+/*
+ * Querying font files with FreeType dominates the time it takes to scan a
+ * directory and the files are independent of each other, so large
+ * directories are queried by a pool of threads.  Each file gets its own
+ * font set and the sets are merged back in file order afterwards, on the
+ * calling thread, which also applies the scan rules.  That way the result
+ * is the same as scanning the files one after another.
+ */
+typedef struct _FcDirScanJob {
+    FcChar8	    **files;
+    int		    nfiles;
+    FcFontSet	    **sets;	/* NULL for directories */
+    unsigned int    *queried;	/* FcFreeTypeQueryAll result */
+    fc_atomic_int_t next;
+} FcDirScanJob;
+
+static int
+FcDirScanThreads (int nfiles)
+{
+    const char *env = getenv ("FONTCONFIG_SCAN_THREADS");
+    int n = 0;
+
+    if (env)
+	n = atoi (env);
+    if (n <= 0)
+    {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+
+	GetSystemInfo (&info);
+	n = info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	n = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    if (n > FC_SCAN_MAX_THREADS)
+	n = FC_SCAN_MAX_THREADS;
+    if (n > nfiles / 2)
+	n = nfiles / 2;
+    return n;
+}
+
+static void
+FcDirScanWork (FcDirScanJob *job)
+{
+    int i;
+
+    while ((i = fc_atomic_int_add (job->next, 1)) < job->nfiles)
+    {
+	if (FcFileIsDir (job->files[i]))
+	    continue;
+	job->sets[i] = FcFontSetCreate ();
+	if (job->sets[i])
+	    job->queried[i] = FcFreeTypeQueryAll (job->files[i], -1, NULL, NULL,
+						  job->sets[i]);
+    }
+}
+
+#ifdef _WIN32
+static unsigned __stdcall
+FcDirScanThread (void *closure)
+{
+    FcDirScanWork (closure);
+    return 0;
+}
+#else
+static void *
+FcDirScanThread (void *closure)
+{
+    FcDirScanWork (closure);
+    return NULL;
+}
+#endif
+
+/*
+ * Scan files with nthreads threads, the calling one included.  Returns
+ * FcFalse if that could not be set up, in which case nothing was done.
+ */
+static FcBool
+FcDirScanParallel (FcFontSet	*set,
+		   FcStrSet	*dirs,
+		   FcStrSet	*files,
+		   int		nthreads,
+		   FcConfig	*config)
+{
+    FcDirScanJob    job;
+#ifdef _WIN32
+    HANDLE	    threads[FC_SCAN_MAX_THREADS];
+#else
+    pthread_t	    threads[FC_SCAN_MAX_THREADS];
+#endif
+    int		    started = 0;
+    int		    i, j;
+
+    job.files = files->strs;
+    job.nfiles = files->num;
+    job.next = 0;
+    job.sets = calloc (files->num, sizeof (FcFontSet *));
+    job.queried = calloc (files->num, sizeof (unsigned int));
+    if (!job.sets || !job.queried)
+    {
+	free (job.sets);
+	free (job.queried);
+	return FcFalse;
+    }
+
+    /* Workers only look at the debug flags, make sure they are set up */
+    FcInitDebug ();
+
+    for (i = 1; i < nthreads; i++)
+    {
+#ifdef _WIN32
+	threads[started] = (HANDLE) _beginthreadex (NULL, 0, FcDirScanThread,
+						    &job, 0, NULL);
+	if (!threads[started])
+	    break;
+#else
+	if (pthread_create (&threads[started], NULL, FcDirScanThread, &job) != 0)
+	    break;
+#endif
+	started++;
+    }
+    FcDirScanWork (&job);
+    for (i = 0; i < started; i++)
+    {
+#ifdef _WIN32
+	WaitForSingleObject (threads[i], INFINITE);
+	CloseHandle (threads[i]);
+#else
+	pthread_join (threads[i], NULL);
+#endif
+    }
+
+    for (i = 0; i < files->num; i++)
+    {
+	FcFontSet *s = job.sets[i];
+	int old_nfont = set->nfont;
+
+	if (!s)
+	{
+	    /* A directory, or out of memory; do it the usual way */
+	    FcFileScanConfig (set, dirs, files->strs[i], config);
+	    continue;
+	}
+	if (FcDebug () & FC_DBG_SCAN)
+	    printf ("\tScanning file %s...%s\n", files->strs[i],
+		    job.queried[i] ? "done" : "");
+	for (j = 0; j < s->nfont; j++)
+	{
+	    if (!FcFontSetAdd (set, s->fonts[j]))
+		FcPatternDestroy (s->fonts[j]);
+	}
+	s->nfont = 0;
+	FcFontSetDestroy (s);
+	if (job.queried[i])
+	    FcFileScanFontEdit (set, old_nfont, config);
+    }
+
+    free (job.sets);
+    free (job.queried);
+    return FcTrue;
+}
+#endif
+
 FcBool
 FcDirScanConfig (FcFontSet	*set,
 		 FcStrSet	*dirs,
@@ -273,6 +460,16 @@ FcDirScanConfig (FcFontSet	*set,
     /*
      * Scan file files to build font patterns
      */
+#ifdef FC_SCAN_THREADS
+    if (set)
+    {
+	int nthreads = FcDirScanThreads (files->num);
+
+	if (nthreads > 1 &&
+	    FcDirScanParallel (set, dirs, files, nthreads, config))
+	    goto bail2;
+    }
+#endif
     for (i = 0; i < files->num; i++)
 	FcFileScanConfig (set, dirs, files->strs[i], config);
 
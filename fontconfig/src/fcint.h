@@ -516,6 +516,9 @@ struct _FcAtomic {
     FcChar8	*tmp;		/* tmpfile name (used for locking) */
 };
 
+typedef struct _FcMatchIndex FcMatchIndex;
+typedef struct _FcMatchCache FcMatchCache;
+
 struct _FcConfig {
     /*
      * File names loaded from the configuration -- saved here as the
@@ -564,6 +567,16 @@ struct _FcConfig {
      * match preferrentially
      */
     FcFontSet	*fonts[FcSetApplication + 1];
+    /*
+     * Lookup structures built from fonts[FcSetSystem] to speed up
+     * matching and sorting against it, see fcmatch.c
+     */
+    FcMatchIndex *matchIndex;
+    /*
+     * Recent results of FcFontMatch and FcFontSort, dropped whenever
+     * the fonts or the rules change
+     */
+    FcMatchCache *matchCache;
     /*
      * Fontconfig can periodically rescan the system configuration
      * and font directories.  This rescanning occurs when font
@@ -580,6 +593,13 @@ struct _FcConfig {
     FcChar8     *sysRoot;	    /* override the system root directory */
     FcStrSet	*availConfigFiles;  /* config files available */
     FcPtrList	*rulesetList;	    /* List of rulesets being installed */
+    /*
+     * What the configuration cache needs to know about how the
+     * configuration was loaded, see fccfgcache.c
+     */
+    FcStrSet	*missingConfigFiles; /* included but not found */
+    FcBool	relativeDirs;	    /* resolved against the current directory */
+    FcBool	uncacheable;	    /* not to be saved to the cache */
 };
 
 typedef struct _FcFileTime {
@@ -763,6 +783,13 @@ FcRuleSetAdd (FcRuleSet		*rs,
 	      FcRule		*rule,
 	      FcMatchKind	kind);
 
+/* fccfgcache.c */
+FcPrivate FcBool
+FcConfigCacheLoad (FcConfig *config);
+
+FcPrivate void
+FcConfigCacheSave (FcConfig *config);
+
 /* fcserialize.c */
 FcPrivate intptr_t
 FcAlignSize (intptr_t size);
@@ -997,6 +1024,9 @@ FcTestDestroy (FcTest *test);
 FcPrivate void
 FcEditDestroy (FcEdit *e);
 
+FcPrivate void
+FcExprDestroy (FcExpr *e);
+
 void
 FcRuleDestroy (FcRule *rule);
 
@@ -1037,6 +1067,21 @@ FcListPatternMatchAny (const FcPattern *p,
 
 /* fcmatch.c */
 
+FcPrivate void
+FcConfigBuildMatchIndex (FcConfig *config);
+
+FcPrivate void
+FcMatchIndexDestroy (FcMatchIndex *index);
+
+FcPrivate FcMatchCache *
+FcMatchCacheCreate (void);
+
+FcPrivate void
+FcMatchCacheDestroy (FcMatchCache *cache);
+
+FcPrivate void
+FcConfigInvalidateMatchCache (FcConfig *config);
+
 /* fcname.c */
 
 enum {
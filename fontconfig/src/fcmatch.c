@@ -498,12 +498,23 @@ typedef struct
 typedef struct
 {
     FcHashTable *family_hash;
+    /*
+     * When comparing against the fonts of an indexed set, family
+     * scores are looked up per family id and font is the index of
+     * the font being compared, or -1 otherwise
+     */
+    const FcMatchIndex *index;
+    double	*family_strong;
+    double	*family_weak;
+    int		font;
 } FcCompareData;
 
 static void
 FcCompareDataClear (FcCompareData *data)
 {
     FcHashTableDestroy (data->family_hash);
+    if (data->family_strong)
+	free (data->family_strong);
 }
 
 static void
@@ -551,6 +562,10 @@ FcCompareDataInit (FcPattern     *pat,
     }
 
     data->family_hash = table;
+    data->index = NULL;
+    data->family_strong = NULL;
+    data->family_weak = NULL;
+    data->font = -1;
 }
 
 static FcBool
@@ -591,6 +606,527 @@ FcCompareFamilies (FcPattern       *pat,
     return FcTrue;
 }
 
+/*
+ * The match index speeds up matching against the system font set, the
+ * largest one by far, which doesn't change once the configuration has
+ * been loaded.
+ *
+ * Every family name in the set gets an id, and the index records the
+ * family ids of each font and the fonts with each family id.  Family
+ * scores are then computed once per family id instead of hashing every
+ * family name of every font, and FcFontSetMatchInternal uses the per
+ * family lists to narrow down the fonts that need a full comparison.
+ * Narrowing goes one priority at a time, keeping only the fonts with
+ * the best score for that priority.  As scores are compared in priority
+ * order the best match is always kept, and as the remaining fonts stay
+ * in set order, ties still go to the earliest font.  Fonts dropped this
+ * way are not compared on later priorities at all.
+ *
+ * Setting up the per family scores costs about as much as comparing a
+ * handful of fonts directly, so small sets are not indexed.
+ */
+#define FC_MATCH_INDEX_MIN_FONTS    16
+
+struct _FcMatchIndex {
+    FcFontSet	    *set;	    /* the indexed set, and its size then */
+    int		    nfont;
+    int		    nfamily;
+    const FcChar8   **family;	    /* name of each family id */
+    int		    *font_start;    /* families of font f are font_family */
+    int		    *font_family;   /* [font_start[f]] .. [font_start[f+1]-1] */
+    int		    *family_start;  /* fonts of family id i are family_font */
+    int		    *family_font;   /* [family_start[i]] .. [family_start[i+1]-1] */
+    int		    nnofamily;	    /* fonts without any family */
+    int		    *nofamily;
+    int		    hash_mask;	    /* family ids by name, -1 if empty */
+    int		    *hash;
+    /* objects with the same values in all fonts, which never narrow */
+    FcBool	    uniform[FC_MAX_BASE_OBJECT + 1];
+};
+
+void
+FcMatchIndexDestroy (FcMatchIndex *index)
+{
+    if (!index)
+	return;
+    free (index->family);
+    free (index->font_start);
+    free (index->font_family);
+    free (index->family_start);
+    free (index->family_font);
+    free (index->nofamily);
+    free (index->hash);
+    free (index);
+}
+
+/* Strings must match exactly here, as some matchers tell case apart */
+static FcBool
+FcMatchIndexValuesEqual (FcPatternElt *ea, FcPatternElt *eb)
+{
+    FcValueListPtr la, lb;
+    FcValue va, vb;
+
+    if (!ea || !eb)
+	return !ea && !eb;
+    for (la = FcPatternEltValues (ea), lb = FcPatternEltValues (eb);
+	 la && lb;
+	 la = FcValueListNext (la), lb = FcValueListNext (lb))
+    {
+	va = FcValueCanonicalize (&la->value);
+	vb = FcValueCanonicalize (&lb->value);
+	if (va.type == FcTypeString && vb.type == FcTypeString ?
+	    FcStrCmp (va.u.s, vb.u.s) != 0 : !FcValueEqual (va, vb))
+	    return FcFalse;
+    }
+    return !la && !lb;
+}
+
+static int
+FcMatchIndexFamilyId (const FcMatchIndex *index, const FcChar8 *name)
+{
+    int i = FcStrHashIgnoreBlanksAndCase (name) & index->hash_mask;
+
+    while (index->hash[i] >= 0)
+    {
+	if (!FcStrCmpIgnoreBlanksAndCase (index->family[index->hash[i]], name))
+	    return index->hash[i];
+	i = (i + 1) & index->hash_mask;
+    }
+    return -1;
+}
+
+void
+FcConfigBuildMatchIndex (FcConfig *config)
+{
+    FcFontSet	    *set = config->fonts[FcSetSystem];
+    FcMatchIndex    *index;
+    FcPatternElt    *elt;
+    FcValueListPtr  l;
+    int		    nvalue, size, f, i, j, id;
+    int		    *next;
+
+    FcMatchIndexDestroy (config->matchIndex);
+    config->matchIndex = NULL;
+    if (!set || set->nfont < FC_MATCH_INDEX_MIN_FONTS)
+	return;
+
+    nvalue = 0;
+    for (f = 0; f < set->nfont; f++)
+    {
+	elt = FcPatternObjectFindElt (set->fonts[f], FC_FAMILY_OBJECT);
+	if (elt)
+	    for (l = FcPatternEltValues (elt); l; l = FcValueListNext (l))
+		nvalue++;
+    }
+    for (size = 16; size < nvalue * 2; size *= 2)
+	;
+
+    index = calloc (1, sizeof (FcMatchIndex));
+    if (!index)
+	return;
+    index->set = set;
+    index->nfont = set->nfont;
+    index->hash_mask = size - 1;
+    index->hash = malloc (size * sizeof (int));
+    index->family = malloc ((nvalue + 1) * sizeof (FcChar8 *));
+    index->font_start = malloc ((set->nfont + 1) * sizeof (int));
+    index->font_family = malloc ((nvalue + 1) * sizeof (int));
+    if (!index->hash || !index->family || !index->font_start ||
+	!index->font_family)
+	goto bail;
+    memset (index->hash, 0xff, size * sizeof (int));
+
+    nvalue = 0;
+    for (f = 0; f < set->nfont; f++)
+    {
+	index->font_start[f] = nvalue;
+	elt = FcPatternObjectFindElt (set->fonts[f], FC_FAMILY_OBJECT);
+	if (!elt)
+	    continue;
+	for (l = FcPatternEltValues (elt); l; l = FcValueListNext (l))
+	{
+	    const FcChar8 *name = FcValueString (&l->value);
+
+	    id = FcMatchIndexFamilyId (index, name);
+	    if (id < 0)
+	    {
+		id = index->nfamily++;
+		index->family[id] = name;
+		i = FcStrHashIgnoreBlanksAndCase (name) & index->hash_mask;
+		while (index->hash[i] >= 0)
+		    i = (i + 1) & index->hash_mask;
+		index->hash[i] = id;
+	    }
+	    /* The same name may be listed in several languages */
+	    for (i = index->font_start[f]; i < nvalue; i++)
+		if (index->font_family[i] == id)
+		    break;
+	    if (i == nvalue)
+		index->font_family[nvalue++] = id;
+	}
+	if (index->font_start[f] == nvalue)
+	    index->nnofamily++;
+    }
+    index->font_start[set->nfont] = nvalue;
+
+    index->family_start = calloc (index->nfamily + 1, sizeof (int));
+    index->family_font = malloc ((nvalue + 1) * sizeof (int));
+    index->nofamily = malloc ((index->nnofamily + 1) * sizeof (int));
+    next = malloc ((index->nfamily + 1) * sizeof (int));
+    if (!index->family_start || !index->family_font || !index->nofamily || !next)
+    {
+	free (next);
+	goto bail;
+    }
+    for (i = 0; i < nvalue; i++)
+	index->family_start[index->font_family[i] + 1]++;
+    for (id = 0; id < index->nfamily; id++)
+    {
+	index->family_start[id + 1] += index->family_start[id];
+	next[id] = index->family_start[id];
+    }
+    j = 0;
+    for (f = 0; f < set->nfont; f++)
+    {
+	if (index->font_start[f] == index->font_start[f + 1])
+	    index->nofamily[j++] = f;
+	for (i = index->font_start[f]; i < index->font_start[f + 1]; i++)
+	    index->family_font[next[index->font_family[i]]++] = f;
+    }
+    free (next);
+
+    for (i = 1; i <= FC_MAX_BASE_OBJECT; i++)
+    {
+	if (i == FC_FAMILY_OBJECT || !FcObjectToMatcher (i, FcFalse))
+	    continue;
+	elt = FcPatternObjectFindElt (set->fonts[0], i);
+	for (f = 1; f < set->nfont; f++)
+	    if (!FcMatchIndexValuesEqual (elt, FcPatternObjectFindElt (set->fonts[f], i)))
+		break;
+	index->uniform[i] = f == set->nfont;
+    }
+
+    config->matchIndex = index;
+    return;
+
+bail:
+    FcMatchIndexDestroy (index);
+}
+
+/*
+ * Use the index of config, if any, to compare against the fonts in s.
+ * The family scores for the pattern are computed the first time.
+ */
+static FcBool
+FcCompareDataUseIndex (FcCompareData	    *data,
+		       const FcMatchIndex   *index,
+		       FcPattern	    *pat,
+		       FcFontSet	    *s)
+{
+    FcPatternElt    *elt;
+    FcValueListPtr  l;
+    FamilyEntry	    *e;
+    int		    id;
+
+    if (!index || index->set != s || index->nfont != s->nfont ||
+	!data->family_hash || (FcDebug () & FC_DBG_MATCHV))
+	return FcFalse;
+    if (data->index == index)
+	return FcTrue;
+
+    elt = FcPatternObjectFindElt (pat, FC_FAMILY_OBJECT);
+    if (elt)
+    {
+	data->family_strong = malloc (2 * (index->nfamily + 1) * sizeof (double));
+	if (!data->family_strong)
+	    return FcFalse;
+	data->family_weak = data->family_strong + index->nfamily + 1;
+	for (id = 0; id < index->nfamily; id++)
+	    data->family_strong[id] = data->family_weak[id] = 1e99;
+	for (l = FcPatternEltValues (elt); l; l = FcValueListNext (l))
+	{
+	    const FcChar8 *key = FcValueString (&l->value);
+
+	    id = FcMatchIndexFamilyId (index, key);
+	    if (id >= 0 && FcHashTableFind (data->family_hash, key, (void **)&e))
+	    {
+		data->family_strong[id] = e->strong_value;
+		data->family_weak[id] = e->weak_value;
+	    }
+	}
+    }
+    data->index = index;
+    return FcTrue;
+}
+
+/* Same as FcCompareFamilies for font f of the indexed set */
+static void
+FcMatchIndexFamilyScore (FcCompareData *data, int f, double *value)
+{
+    const FcMatchIndex *index = data->index;
+    double strong_value = 1e99;
+    double weak_value = 1e99;
+    int i, id;
+
+    for (i = index->font_start[f]; i < index->font_start[f + 1]; i++)
+    {
+	id = index->font_family[i];
+	if (data->family_strong[id] < strong_value)
+	    strong_value = data->family_strong[id];
+	if (data->family_weak[id] < weak_value)
+	    weak_value = data->family_weak[id];
+    }
+    value[PRI_FAMILY_STRONG] = strong_value;
+    value[PRI_FAMILY_WEAK] = weak_value;
+}
+
+static int
+FcMatchIndexIntCompare (const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+/*
+ * Find the fonts of the indexed set with the best family score of
+ * pri, in set order.  Returns -1 if they all score the same.
+ */
+static int
+FcMatchIndexFamilyFonts (FcPattern	*pat,
+			 FcCompareData	*data,
+			 int		pri,
+			 int		**candp)
+{
+    const FcMatchIndex *index = data->index;
+    double	    *family = pri == PRI_FAMILY_STRONG ? data->family_strong : data->family_weak;
+    double	    best;
+    FcPatternElt    *elt;
+    FcValueListPtr  l;
+    int		    *cand;
+    int		    ncand, id, i, k;
+
+    /* Fonts without a family aren't compared on it and score 0 */
+    best = index->nnofamily ? 0 : 1e99;
+    elt = FcPatternObjectFindElt (pat, FC_FAMILY_OBJECT);
+    for (l = FcPatternEltValues (elt); l; l = FcValueListNext (l))
+    {
+	id = FcMatchIndexFamilyId (index, FcValueString (&l->value));
+	if (id >= 0 && family[id] < best)
+	    best = family[id];
+    }
+    if (best >= 1e99)
+	return -1;
+
+    ncand = best == 0 ? index->nnofamily : 0;
+    for (id = 0; id < index->nfamily; id++)
+	if (family[id] == best)
+	    ncand += index->family_start[id + 1] - index->family_start[id];
+    cand = malloc ((ncand + 1) * sizeof (int));
+    if (!cand)
+	return -1;
+
+    k = 0;
+    if (best == 0)
+	for (i = 0; i < index->nnofamily; i++)
+	    cand[k++] = index->nofamily[i];
+    for (id = 0; id < index->nfamily; id++)
+	if (family[id] == best)
+	    for (i = index->family_start[id]; i < index->family_start[id + 1]; i++)
+		cand[k++] = index->family_font[i];
+
+    /* Fonts with several matching families are listed more than once */
+    qsort (cand, ncand, sizeof (int), FcMatchIndexIntCompare);
+    for (i = 0, k = 0; i < ncand; i++)
+	if (k == 0 || cand[k - 1] != cand[i])
+	    cand[k++] = cand[i];
+
+    *candp = cand;
+    return k;
+}
+
+/*
+ * Score of font for priority pri alone, as FcCompare would compute it
+ * from the pattern elements elts[0] .. elts[nelt-1]
+ */
+static FcBool
+FcMatchIndexScore (FcPattern	*pat,
+		   const int	*elts,
+		   int		nelt,
+		   FcPattern	*font,
+		   int		pri,
+		   double	*score,
+		   FcResult	*result)
+{
+    double	    value[PRI_END];
+    int		    i;
+
+    *score = 0;
+    for (i = 0; i < nelt; i++)
+    {
+	FcPatternElt	*pe = &FcPatternElts(pat)[elts[i]];
+	const FcMatcher *match = FcObjectToMatcher (pe->object, FcFalse);
+	FcPatternElt	*fe;
+
+	fe = FcPatternObjectFindElt (font, pe->object);
+	if (!fe)
+	    continue;
+	value[match->strong] = 0;
+	value[match->weak] = 0;
+	if (!FcCompareValueList (pe->object, match,
+				 FcPatternEltValues(pe),
+				 FcPatternEltValues(fe),
+				 NULL, value, NULL, result))
+	    return FcFalse;
+	*score += value[pri];
+    }
+    return FcTrue;
+}
+
+static const FcMatcher *
+FcMatchIndexMatcher (const FcMatchIndex *index, FcObject object)
+{
+    if (object == FC_FAMILY_OBJECT ||
+	(object <= FC_MAX_BASE_OBJECT && index->uniform[object]))
+	return NULL;
+    return FcObjectToMatcher (object, FcFalse);
+}
+
+/*
+ * Narrow the fonts of the indexed set down to those with the best score
+ * for each priority in turn, until one is left or all priorities have
+ * been looked at.  Comparing a font one priority at a time costs more
+ * than comparing it in one go, so this also stops once a priority fails
+ * to drop at least half of the fonts left.  Returns the number of fonts
+ * left, listed in set order in *candp, or -1 if all fonts have to be
+ * compared.
+ */
+static int
+FcMatchIndexCandidates (FcPattern	*pat,
+			FcCompareData	*data,
+			int		**candp,
+			FcResult	*result)
+{
+    const FcMatchIndex *index = data->index;
+    FcFontSet	*s = index->set;
+    int		*cand = NULL;
+    double	*scores = NULL;
+    double	best;
+    int		ncand = index->nfont;
+    int		pri, i, k;
+    int		start[PRI_END + 1];
+    int		*elts;
+
+    /*
+     * The pattern elements to compare for each priority, leaving out
+     * family and the objects on which all fonts score the same
+     */
+    elts = malloc ((2 * pat->num + 1) * sizeof (int));
+    if (!elts)
+	return -1;
+    memset (start, 0, sizeof (start));
+    for (i = 0; i < pat->num; i++)
+    {
+	const FcMatcher *match = FcMatchIndexMatcher (index, FcPatternElts(pat)[i].object);
+
+	if (match)
+	{
+	    start[match->strong + 1]++;
+	    if (match->weak != match->strong)
+		start[match->weak + 1]++;
+	}
+    }
+    for (pri = 0; pri < PRI_END; pri++)
+	start[pri + 1] += start[pri];
+    {
+	int next[PRI_END];
+
+	memcpy (next, start, sizeof (next));
+	for (i = 0; i < pat->num; i++)
+	{
+	    const FcMatcher *match = FcMatchIndexMatcher (index, FcPatternElts(pat)[i].object);
+
+	    if (match)
+	    {
+		elts[next[match->strong]++] = i;
+		if (match->weak != match->strong)
+		    elts[next[match->weak]++] = i;
+	    }
+	}
+    }
+
+    for (pri = 0; pri < PRI_END && ncand > 1; pri++)
+    {
+	if (pri == PRI_FAMILY_STRONG || pri == PRI_FAMILY_WEAK)
+	{
+	    if (!data->family_strong)
+		continue;
+	    if (!cand)
+	    {
+		k = FcMatchIndexFamilyFonts (pat, data, pri, &cand);
+		if (k >= 0)
+		    ncand = k;
+		continue;
+	    }
+	}
+	else if (start[pri] == start[pri + 1])
+	    continue;
+
+	if (!cand)
+	{
+	    cand = malloc (ncand * sizeof (int));
+	    if (!cand)
+		goto bail;
+	    for (i = 0; i < ncand; i++)
+		cand[i] = i;
+	}
+	if (!scores)
+	{
+	    scores = malloc (ncand * sizeof (double));
+	    if (!scores)
+		goto bail;
+	}
+
+	best = 1e99;
+	for (i = 0; i < ncand; i++)
+	{
+	    if (pri == PRI_FAMILY_STRONG || pri == PRI_FAMILY_WEAK)
+	    {
+		double value[PRI_END];
+
+		if (index->font_start[cand[i]] == index->font_start[cand[i] + 1])
+		    value[pri] = 0;
+		else
+		    FcMatchIndexFamilyScore (data, cand[i], value);
+		scores[i] = value[pri];
+	    }
+	    else if (!FcMatchIndexScore (pat, elts + start[pri],
+					 start[pri + 1] - start[pri],
+					 s->fonts[cand[i]], pri,
+					 &scores[i], result))
+		goto bail;
+	    if (scores[i] < best)
+		best = scores[i];
+	}
+	for (i = 0, k = 0; i < ncand; i++)
+	    if (scores[i] == best)
+		cand[k++] = cand[i];
+	if (k > ncand / 2)
+	    pri = PRI_END;
+	ncand = k;
+    }
+
+    free (elts);
+    free (scores);
+    *candp = cand;
+    return cand ? ncand : -1;
+
+bail:
+    /* Let the full comparison report any trouble */
+    free (elts);
+    free (scores);
+    free (cand);
+    return -1;
+}
+
 /*
  * Return a value indicating the distance between the two lists of
  * values
@@ -620,6 +1156,12 @@ FcCompare (FcPattern	*pat,
 	    i2++;
 	else if (i < 0)
 	    i1++;
+	else if (elt_i1->object == FC_FAMILY_OBJECT && data->font >= 0)
+	{
+	    FcMatchIndexFamilyScore (data, data->font, value);
+	    i1++;
+	    i2++;
+	}
 	else if (elt_i1->object == FC_FAMILY_OBJECT && data->family_hash)
         {
             if (!FcCompareFamilies (pat, FcPatternEltValues(elt_i1),
@@ -844,14 +1386,363 @@ FcFontRenderPrepare (FcConfig	    *config,
     return new;
 }
 
+/*
+ * Applications match the same few patterns over and over, so the
+ * results of FcFontMatch and FcFontSort are kept in a small LRU cache
+ * keyed by the exact contents of the pattern.  Entries are tagged with
+ * the cache generation, which changes whenever fonts or rules are added
+ * to the configuration, and are dropped when found to be out of date.
+ */
+#define FC_MATCH_CACHE_SIZE	128
+#define FC_MATCH_CACHE_BUCKETS	251
+
+typedef struct _FcMatchCacheEntry FcMatchCacheEntry;
+
+struct _FcMatchCacheEntry {
+    FcMatchCacheEntry	*prev, *next;	/* LRU list, most recent first */
+    FcMatchCacheEntry	*hnext;
+    FcChar32		hash;
+    FcChar8		*key;
+    unsigned int	generation;
+    FcResult		result;
+    FcPattern		*match;		/* FcFontMatch */
+    FcFontSet		*fonts;		/* FcFontSort */
+    FcCharSet		*cs;
+};
+
+struct _FcMatchCache {
+    FcMutex		lock;
+    unsigned int	generation;
+    int			size;
+    int			nentry;
+    unsigned long	hits;
+    unsigned long	misses;
+    FcMatchCacheEntry	lru;
+    FcMatchCacheEntry	*buckets[FC_MATCH_CACHE_BUCKETS];
+};
+
+FcMatchCache *
+FcMatchCacheCreate (void)
+{
+    FcMatchCache *cache = calloc (1, sizeof (FcMatchCache));
+
+    if (!cache)
+	return NULL;
+    FcMutexInit (&cache->lock);
+    cache->size = FC_MATCH_CACHE_SIZE;
+    cache->lru.prev = cache->lru.next = &cache->lru;
+    return cache;
+}
+
+static void
+FcMatchCacheRemove (FcMatchCache *cache, FcMatchCacheEntry *e)
+{
+    FcMatchCacheEntry **prev;
+
+    for (prev = &cache->buckets[e->hash % FC_MATCH_CACHE_BUCKETS];
+	 *prev != e;
+	 prev = &(*prev)->hnext)
+	;
+    *prev = e->hnext;
+    e->prev->next = e->next;
+    e->next->prev = e->prev;
+    cache->nentry--;
+
+    free (e->key);
+    if (e->match)
+	FcPatternDestroy (e->match);
+    if (e->fonts)
+	FcFontSetDestroy (e->fonts);
+    if (e->cs)
+	FcCharSetDestroy (e->cs);
+    free (e);
+}
+
+void
+FcMatchCacheDestroy (FcMatchCache *cache)
+{
+    if (!cache)
+	return;
+    while (cache->lru.next != &cache->lru)
+	FcMatchCacheRemove (cache, cache->lru.next);
+    FcMutexFinish (&cache->lock);
+    free (cache);
+}
+
+void
+FcConfigInvalidateMatchCache (FcConfig *config)
+{
+    FcMatchCache *cache = config->matchCache;
+
+    if (!cache)
+	return;
+    FcMutexLock (&cache->lock);
+    cache->generation++;
+    FcMutexUnlock (&cache->lock);
+}
+
+/*
+ * Unlike FcNameUnparse, the key has to tell apart every two patterns
+ * which may match differently, so it includes the value bindings and
+ * types and prints numbers at full precision.
+ */
+static FcBool
+FcMatchCacheKeyValue (FcStrBuf *buf, FcValueListPtr l)
+{
+    FcChar8 temp[128];
+    FcValue v = FcValueCanonicalize (&l->value);
+
+    sprintf ((char *) temp, "%d%d", l->binding, v.type);
+    FcStrBufString (buf, temp);
+    switch (v.type) {
+    case FcTypeDouble:
+	sprintf ((char *) temp, "%.17g", v.u.d);
+	break;
+    case FcTypeMatrix:
+	sprintf ((char *) temp, "%.17g %.17g %.17g %.17g",
+		 v.u.m->xx, v.u.m->xy, v.u.m->yx, v.u.m->yy);
+	break;
+    case FcTypeRange:
+	sprintf ((char *) temp, "%.17g %.17g", v.u.r->begin, v.u.r->end);
+	break;
+    case FcTypeInteger:
+    case FcTypeString:
+    case FcTypeBool:
+    case FcTypeCharSet:
+    case FcTypeLangSet:
+	return FcNameUnparseValue (buf, &v, (FcChar8 *) "\\:=,");
+    default:
+	/* FT_Face values can't be told apart by contents */
+	return FcFalse;
+    }
+    FcStrBufString (buf, temp);
+    return FcTrue;
+}
+
+/* Returns NULL if the pattern can't be cached, or caching is off */
+static FcChar8 *
+FcMatchCacheKey (FcConfig *config, FcPattern *p, const char *kind)
+{
+    FcMatchCache    *cache = config->matchCache;
+    FcStrBuf	    buf;
+    FcChar8	    buf_static[1024];
+    FcPatternElt    *e;
+    FcValueListPtr  l;
+    int		    i, size;
+
+    if (!cache)
+	return NULL;
+    FcMutexLock (&cache->lock);
+    size = cache->size;
+    FcMutexUnlock (&cache->lock);
+    if (!size)
+	return NULL;
+
+    FcStrBufInit (&buf, buf_static, sizeof (buf_static));
+    FcStrBufString (&buf, (const FcChar8 *) kind);
+    for (i = 0; i < p->num; i++)
+    {
+	e = &FcPatternElts(p)[i];
+	FcStrBufChar (&buf, ':');
+	FcStrBufString (&buf, (const FcChar8 *) FcObjectName (e->object));
+	for (l = FcPatternEltValues (e); l; l = FcValueListNext (l))
+	{
+	    FcStrBufChar (&buf, l == FcPatternEltValues (e) ? '=' : ',');
+	    if (!FcMatchCacheKeyValue (&buf, l))
+	    {
+		FcStrBufDestroy (&buf);
+		return NULL;
+	    }
+	}
+    }
+    return FcStrBufDone (&buf);
+}
+
+static FcFontSet *
+FcMatchCacheCopyFonts (FcFontSet *s)
+{
+    FcFontSet	*new = FcFontSetCreate ();
+    int		i;
+
+    for (i = 0; new && i < s->nfont; i++)
+    {
+	FcPatternReference (s->fonts[i]);
+	if (!FcFontSetAdd (new, s->fonts[i]))
+	{
+	    FcPatternDestroy (s->fonts[i]);
+	    FcFontSetDestroy (new);
+	    new = NULL;
+	}
+    }
+    return new;
+}
+
+/*
+ * Look up key and, if found, copy the result out while still holding
+ * the lock, as the entry may be evicted as soon as it is released.
+ */
+static FcBool
+FcMatchCacheLookup (FcConfig	*config,
+		    FcChar8	*key,
+		    FcPattern	**match,
+		    FcFontSet	**fonts,
+		    FcCharSet	**csp,
+		    FcResult	*result)
+{
+    FcMatchCache	*cache = config->matchCache;
+    FcMatchCacheEntry	*e;
+    FcChar32		hash;
+    FcBool		ret = FcFalse;
+
+    if (!cache || !key)
+	return FcFalse;
+    hash = FcStrHashIgnoreCase (key);
+
+    FcMutexLock (&cache->lock);
+    for (e = cache->buckets[hash % FC_MATCH_CACHE_BUCKETS]; e; e = e->hnext)
+	if (e->hash == hash && !strcmp ((const char *) e->key, (const char *) key))
+	    break;
+    if (e && e->generation != cache->generation)
+    {
+	FcMatchCacheRemove (cache, e);
+	e = NULL;
+    }
+    if (e)
+    {
+	if (match)
+	{
+	    *match = e->match ? FcPatternDuplicate (e->match) : NULL;
+	    ret = !e->match || *match;
+	}
+	if (fonts)
+	{
+	    *fonts = FcMatchCacheCopyFonts (e->fonts);
+	    ret = *fonts != NULL;
+	    if (ret && csp)
+		*csp = e->cs ? FcCharSetCopy (e->cs) : NULL;
+	}
+    }
+    if (ret)
+    {
+	*result = e->result;
+	e->prev->next = e->next;
+	e->next->prev = e->prev;
+	e->prev = &cache->lru;
+	e->next = cache->lru.next;
+	cache->lru.next->prev = e;
+	cache->lru.next = e;
+	cache->hits++;
+    }
+    else
+	cache->misses++;
+    FcMutexUnlock (&cache->lock);
+    return ret;
+}
+
+/* Remember a result; key and the references passed in are taken over */
+static void
+FcMatchCacheInsert (FcConfig	*config,
+		    FcChar8	*key,
+		    FcPattern	*match,
+		    FcFontSet	*fonts,
+		    FcCharSet	*cs,
+		    FcResult	result)
+{
+    FcMatchCache	*cache = config->matchCache;
+    FcMatchCacheEntry	*e;
+    int			b;
+
+    e = cache && key && cache->size > 0 ? malloc (sizeof (FcMatchCacheEntry)) : NULL;
+    if (!e)
+    {
+	free (key);
+	if (match)
+	    FcPatternDestroy (match);
+	if (fonts)
+	    FcFontSetDestroy (fonts);
+	if (cs)
+	    FcCharSetDestroy (cs);
+	return;
+    }
+    e->hash = FcStrHashIgnoreCase (key);
+    e->key = key;
+    e->result = result;
+    e->match = match;
+    e->fonts = fonts;
+    e->cs = cs;
+    b = e->hash % FC_MATCH_CACHE_BUCKETS;
+
+    FcMutexLock (&cache->lock);
+    e->generation = cache->generation;
+    e->hnext = cache->buckets[b];
+    cache->buckets[b] = e;
+    e->prev = &cache->lru;
+    e->next = cache->lru.next;
+    cache->lru.next->prev = e;
+    cache->lru.next = e;
+    cache->nentry++;
+    while (cache->nentry > cache->size)
+	FcMatchCacheRemove (cache, cache->lru.prev);
+    FcMutexUnlock (&cache->lock);
+}
+
+FcBool
+FcConfigGetMatchCacheStats (FcConfig		*config,
+			    unsigned long	*hits,
+			    unsigned long	*misses)
+{
+    FcMatchCache *cache;
+
+    config = FcConfigReference (config);
+    if (!config)
+	return FcFalse;
+    cache = config->matchCache;
+    if (cache)
+    {
+	FcMutexLock (&cache->lock);
+	if (hits)
+	    *hits = cache->hits;
+	if (misses)
+	    *misses = cache->misses;
+	FcMutexUnlock (&cache->lock);
+    }
+    FcConfigDestroy (config);
+
+    return cache != NULL;
+}
+
+FcBool
+FcConfigSetMatchCacheSize (FcConfig *config, int size)
+{
+    FcMatchCache *cache;
+
+    config = FcConfigReference (config);
+    if (!config)
+	return FcFalse;
+    cache = config->matchCache;
+    if (cache)
+    {
+	FcMutexLock (&cache->lock);
+	cache->size = size > 0 ? size : 0;
+	while (cache->nentry > cache->size)
+	    FcMatchCacheRemove (cache, cache->lru.prev);
+	FcMutexUnlock (&cache->lock);
+    }
+    FcConfigDestroy (config);
+
+    return cache != NULL;
+}
+
 static FcPattern *
-FcFontSetMatchInternal (FcFontSet   **sets,
-			int	    nsets,
-			FcPattern   *p,
-			FcResult    *result)
+FcFontSetMatchInternal (FcFontSet	    **sets,
+			int		    nsets,
+			FcPattern	    *p,
+			const FcMatchIndex  *index,
+			FcResult	    *result)
 {
     double    	    score[PRI_END], bestscore[PRI_END];
-    int		    f;
+    int		    f, k, nfont;
+    int		    *cand;
     FcFontSet	    *s;
     FcPattern	    *best;
     int		    i;
@@ -874,8 +1765,20 @@ FcFontSetMatchInternal (FcFontSet   **sets,
 	s = sets[set];
 	if (!s)
 	    continue;
-	for (f = 0; f < s->nfont; f++)
+	cand = NULL;
+	nfont = s->nfont;
+	data.font = -1;
+	if (FcCompareDataUseIndex (&data, index, p, s))
+	{
+	    nfont = FcMatchIndexCandidates (p, &data, &cand, result);
+	    if (nfont < 0)
+		nfont = s->nfont;
+	}
+	for (k = 0; k < nfont; k++)
 	{
+	    f = cand ? cand[k] : k;
+	    if (data.index && s == data.index->set)
+		data.font = f;
 	    if (FcDebug () & FC_DBG_MATCHV)
 	    {
 		printf ("Font %d ", f);
@@ -883,6 +1786,7 @@ FcFontSetMatchInternal (FcFontSet   **sets,
 	    }
 	    if (!FcCompare (p, s->fonts[f], score, result, &data))
             {
+		free (cand);
                 FcCompareDataClear (&data);
 		return 0;
             }
@@ -908,7 +1812,9 @@ FcFontSetMatchInternal (FcFontSet   **sets,
 		}
 	    }
 	}
+	free (cand);
     }
+    data.font = -1;
 
     FcCompareDataClear (&data);
 
@@ -989,7 +1895,7 @@ FcFontSetMatch (FcConfig    *config,
     config = FcConfigReference (config);
     if (!config)
 	    return NULL;
-    best = FcFontSetMatchInternal (sets, nsets, p, result);
+    best = FcFontSetMatchInternal (sets, nsets, p, config->matchIndex, result);
     if (best)
 	ret = FcFontRenderPrepare (config, p, best);
 
@@ -1005,7 +1911,8 @@ FcFontMatch (FcConfig	*config,
 {
     FcFontSet	*sets[2];
     int		nsets;
-    FcPattern   *best, *ret = NULL;
+    FcPattern   *best, *ret = NULL, *copy;
+    FcChar8	*key;
 
     assert (p != NULL);
     assert (result != NULL);
@@ -1015,15 +1922,28 @@ FcFontMatch (FcConfig	*config,
     config = FcConfigReference (config);
     if (!config)
 	return NULL;
+    key = FcMatchCacheKey (config, p, "m");
+    if (FcMatchCacheLookup (config, key, &ret, NULL, NULL, result))
+    {
+	free (key);
+	FcConfigDestroy (config);
+	return ret;
+    }
     nsets = 0;
     if (config->fonts[FcSetSystem])
 	sets[nsets++] = config->fonts[FcSetSystem];
     if (config->fonts[FcSetApplication])
 	sets[nsets++] = config->fonts[FcSetApplication];
 
-    best = FcFontSetMatchInternal (sets, nsets, p, result);
+    best = FcFontSetMatchInternal (sets, nsets, p, config->matchIndex, result);
     if (best)
 	ret = FcFontRenderPrepare (config, p, best);
+    if (!best)
+	FcMatchCacheInsert (config, key, NULL, NULL, NULL, *result);
+    else if (key && ret && (copy = FcPatternDuplicate (ret)))
+	FcMatchCacheInsert (config, key, copy, NULL, NULL, *result);
+    else
+	free (key);
 
     FcConfigDestroy (config);
 
@@ -1127,7 +2047,7 @@ FcFontSetSortDestroy (FcFontSet *fs)
 }
 
 FcFontSet *
-FcFontSetSort (FcConfig	    *config FC_UNUSED,
+FcFontSetSort (FcConfig	    *config,
 	       FcFontSet    **sets,
 	       int	    nsets,
 	       FcPattern    *p,
@@ -1201,8 +2121,12 @@ FcFontSetSort (FcConfig	    *config FC_UNUSED,
 	s = sets[set];
 	if (!s)
 	    continue;
+	data.font = -1;
+	FcCompareDataUseIndex (&data, config ? config->matchIndex : NULL, p, s);
 	for (f = 0; f < s->nfont; f++)
 	{
+	    if (data.index && s == data.index->set)
+		data.font = f;
 	    if (FcDebug () & FC_DBG_MATCHV)
 	    {
 		printf ("Font %d ", f);
@@ -1210,7 +2134,10 @@ FcFontSetSort (FcConfig	    *config FC_UNUSED,
 	    }
 	    new->pattern = s->fonts[f];
 	    if (!FcCompare (p, new->pattern, new->score, result, &data))
+	    {
+		FcCompareDataClear (&data);
 		goto bail1;
+	    }
 	    if (FcDebug () & FC_DBG_MATCHV)
 	    {
 		printf ("Score");
@@ -1319,8 +2246,9 @@ FcFontSort (FcConfig	*config,
 	    FcCharSet	**csp,
 	    FcResult	*result)
 {
-    FcFontSet	*sets[2], *ret;
+    FcFontSet	*sets[2], *ret, *copy;
     int		nsets;
+    FcChar8	*key;
 
     assert (p != NULL);
     assert (result != NULL);
@@ -1330,12 +2258,24 @@ FcFontSort (FcConfig	*config,
     config = FcConfigReference (config);
     if (!config)
 	return NULL;
+    key = FcMatchCacheKey (config, p, trim ? (csp ? "sTC" : "sT") : (csp ? "sC" : "s"));
+    if (FcMatchCacheLookup (config, key, NULL, &ret, csp, result))
+    {
+	free (key);
+	FcConfigDestroy (config);
+	return ret;
+    }
     nsets = 0;
     if (config->fonts[FcSetSystem])
 	sets[nsets++] = config->fonts[FcSetSystem];
     if (config->fonts[FcSetApplication])
 	sets[nsets++] = config->fonts[FcSetApplication];
     ret = FcFontSetSort (config, sets, nsets, p, trim, csp, result);
+    if (key && ret && (copy = FcMatchCacheCopyFonts (ret)))
+	FcMatchCacheInsert (config, key, NULL, copy,
+			    csp && *csp ? FcCharSetCopy (*csp) : NULL, *result);
+    else
+	free (key);
     FcConfigDestroy (config);
 
     return ret;
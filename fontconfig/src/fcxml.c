@@ -64,8 +64,6 @@ extern FcChar8 fontconfig_instprefix[];
 static FcChar8  *__fc_userdir = NULL;
 static FcChar8  *__fc_userconf = NULL;
 
-static void
-FcExprDestroy (FcExpr *e);
 static FcBool
 _FcConfigParse (FcConfig	*config,
 		const FcChar8	*name,
@@ -267,7 +265,7 @@ FcExprCreateOp (FcConfig *config, FcExpr *left, FcOp op, FcExpr *right)
     return e;
 }
 
-static void
+void
 FcExprDestroy (FcExpr *e)
 {
     if (!e)
@@ -2535,6 +2533,7 @@ FcParseInclude (FcConfigParse *parse)
 	    FcPtrListIterInitAtLast (parse->config->subst[k], &iter);
 	    FcRuleSetReference (ruleset);
 	    FcPtrListIterAdd (parse->config->subst[k], &iter, ruleset);
+	    FcConfigInvalidateMatchCache (parse->config);
 	}
     }
     FcRuleSetDestroy (ruleset);
@@ -3504,6 +3503,7 @@ FcConfigParseAndLoadFromMemoryInternal (FcConfig       *config,
 		FcPtrListIterInitAtLast (parse.config->subst[k], &iter);
 		FcRuleSetReference (parse.ruleset);
 		FcPtrListIterAdd (parse.config->subst[k], &iter, parse.ruleset);
+		FcConfigInvalidateMatchCache (parse.config);
 	    }
 	}
     }
@@ -3559,6 +3559,9 @@ _FcConfigParse (FcConfig	*config,
     filename = FcConfigGetFilename (config, name);
     if (!filename)
     {
+	/* the cached configuration is stale once it shows up */
+	if (name && !FcStrSetAdd (config->missingConfigFiles, name))
+	    config->uncacheable = FcTrue;
 	FcStrBufString (&reason, (FcChar8 *)"No such file: ");
 	FcStrBufString (&reason, name ? name : (FcChar8 *)"(null)");
 	goto bail0;
@@ -464,6 +464,22 @@ unset temp_HOME
 
 fi # if [ "x$EXEEXT" = "x" ]
 
+dotest "Parallel scan generates the same cache"
+prep
+for i in 1 2 3 4; do
+    cp "$FONT1" "$FONTDIR"/a$i.pcf
+    cp "$FONT2" "$FONTDIR"/b$i.pcf
+done
+FONTCONFIG_SCAN_THREADS=1 $FCCACHE -f "$FONTDIR"
+cp "$CACHEDIR"/*cache-* serial.cache
+FONTCONFIG_SCAN_THREADS=4 $FCCACHE -f "$FONTDIR"
+if cmp serial.cache "$CACHEDIR"/*cache-* > /dev/null ; then : ; else
+  echo "*** Test failed: $TEST"
+  echo "cache files differ"
+  exit 1
+fi
+rm -f serial.cache
+
 rm -rf "$FONTDIR" "$CACHEFILE" "$CACHEDIR" "$BASEDIR" "$FONTCONFIG_FILE" out
 
 TEST=""
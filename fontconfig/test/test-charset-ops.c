@@ -0,0 +1,232 @@
+/*
+ * fontconfig/test/test-charset-ops.c
+ *
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the author(s) not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  The authors make no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * THE AUTHOR(S) DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Check the charset set operations against a plain bitmap, on charsets
+ * ranging from a few Latin characters to CJK fonts.
+ *
+ * Usage: test-charset-ops [iterations]
+ *
+ * With a number of iterations, it also reports how long each operation
+ * takes between a CJK-sized charset and a few others.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fontconfig/fontconfig.h>
+
+#define MAX_CHAR    0x30000
+
+typedef struct {
+    FcCharSet	    *cs;
+    unsigned char   *map;
+} charset_t;
+
+static unsigned int seed = 1;
+
+static unsigned int
+rnd (void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+static int
+has (const charset_t *c, FcChar32 ucs4)
+{
+    return (c->map[ucs4 >> 3] >> (ucs4 & 7)) & 1;
+}
+
+static void
+add (charset_t *c, FcChar32 ucs4)
+{
+    FcCharSetAddChar (c->cs, ucs4);
+    c->map[ucs4 >> 3] |= 1 << (ucs4 & 7);
+}
+
+/* Characters from first to last, each present with probability density/32 */
+static void
+add_range (charset_t *c, FcChar32 first, FcChar32 last, unsigned int density)
+{
+    FcChar32 ucs4;
+
+    for (ucs4 = first; ucs4 <= last; ucs4++)
+	if (rnd () % 32 < density)
+	    add (c, ucs4);
+}
+
+static charset_t *
+make (void)
+{
+    charset_t *c = malloc (sizeof (charset_t));
+
+    c->cs = FcCharSetCreate ();
+    c->map = calloc (MAX_CHAR / 8, 1);
+    return c;
+}
+
+static void
+destroy (charset_t *c)
+{
+    FcCharSetDestroy (c->cs);
+    free (c->map);
+    free (c);
+}
+
+static int
+check (const char *name, const charset_t *a, const charset_t *b)
+{
+    FcChar32	count = 0, isect = 0, sub = 0, ucs4;
+    FcBool	subset = FcTrue, changed;
+    FcCharSet	*u, *m;
+    int		ret = 0;
+
+    for (ucs4 = 0; ucs4 < MAX_CHAR; ucs4++)
+    {
+	count += has (a, ucs4);
+	isect += has (a, ucs4) && has (b, ucs4);
+	sub += has (a, ucs4) && !has (b, ucs4);
+	if (has (a, ucs4) && !has (b, ucs4))
+	    subset = FcFalse;
+    }
+
+    if (FcCharSetCount (a->cs) != count ||
+	FcCharSetIntersectCount (a->cs, b->cs) != isect ||
+	FcCharSetSubtractCount (a->cs, b->cs) != sub ||
+	FcCharSetIsSubset (a->cs, b->cs) != subset)
+    {
+	fprintf (stderr, "%s: counts differ\n", name);
+	ret = 1;
+    }
+
+    u = FcCharSetUnion (a->cs, b->cs);
+    m = FcCharSetCopy (b->cs);
+    m = FcCharSetUnion (m, m);	/* a modifiable copy */
+    if (!FcCharSetMerge (m, a->cs, &changed) || changed != !subset ||
+	!FcCharSetEqual (u, m) ||
+	FcCharSetCount (u) != FcCharSetCount (b->cs) + sub)
+    {
+	fprintf (stderr, "%s: union differs\n", name);
+	ret = 1;
+    }
+    FcCharSetDestroy (u);
+    FcCharSetDestroy (m);
+    return ret;
+}
+
+static double
+elapsed (clock_t start, int iterations)
+{
+    return (double) (clock () - start) / CLOCKS_PER_SEC * 1e9 / iterations;
+}
+
+static void
+bench (const char *name, const charset_t *a, const charset_t *b, int iterations)
+{
+    volatile FcChar32 sink = 0;
+    FcBool changed;
+    clock_t start;
+    int i;
+
+    start = clock ();
+    for (i = 0; i < iterations; i++)
+	sink += FcCharSetIntersectCount (a->cs, b->cs);
+    printf ("%-14s intersect-count %8.0fns", name, elapsed (start, iterations));
+    start = clock ();
+    for (i = 0; i < iterations; i++)
+	sink += FcCharSetSubtractCount (a->cs, b->cs);
+    printf ("  subtract-count %8.0fns", elapsed (start, iterations));
+    start = clock ();
+    for (i = 0; i < iterations; i++)
+	sink += FcCharSetIsSubset (a->cs, b->cs);
+    printf ("  is-subset %8.0fns", elapsed (start, iterations));
+    start = clock ();
+    for (i = 0; i < iterations / 10; i++)
+    {
+	FcCharSet *u = FcCharSetUnion (a->cs, b->cs);
+
+	FcCharSetMerge (u, b->cs, &changed);
+	FcCharSetDestroy (u);
+    }
+    printf ("  union+merge %8.0fns\n", elapsed (start, iterations / 10));
+}
+
+int
+main (int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi (argv[1]) : 0;
+    charset_t *latin, *cjk, *cjk2, *sparse, *empty;
+    int ret = 0;
+
+    latin = make ();
+    add_range (latin, 0x20, 0x24f, 28);
+
+    /* CJK unified ideographs, extension A and B, hangul, kana */
+    cjk = make ();
+    add_range (cjk, 0x20, 0x7e, 32);
+    add_range (cjk, 0x3040, 0x30ff, 30);
+    add_range (cjk, 0x3400, 0x4dbf, 24);
+    add_range (cjk, 0x4e00, 0x9fff, 31);
+    add_range (cjk, 0xac00, 0xd7a3, 30);
+    add_range (cjk, 0x20000, 0x2a6df, 8);
+
+    cjk2 = make ();
+    add_range (cjk2, 0x20, 0x7e, 32);
+    add_range (cjk2, 0x4e00, 0x9fff, 31);
+
+    sparse = make ();
+    add_range (sparse, 0, MAX_CHAR - 1, 1);
+
+    empty = make ();
+
+    ret |= check ("latin/cjk", latin, cjk);
+    ret |= check ("cjk/latin", cjk, latin);
+    ret |= check ("cjk/cjk2", cjk, cjk2);
+    ret |= check ("cjk2/cjk", cjk2, cjk);
+    ret |= check ("cjk/cjk", cjk, cjk);
+    ret |= check ("sparse/cjk", sparse, cjk);
+    ret |= check ("cjk/sparse", cjk, sparse);
+    ret |= check ("empty/cjk", empty, cjk);
+    ret |= check ("cjk/empty", cjk, empty);
+
+    if (iterations > 0)
+    {
+	printf ("cjk: %u chars, cjk2: %u chars, latin: %u chars\n",
+		FcCharSetCount (cjk->cs), FcCharSetCount (cjk2->cs),
+		FcCharSetCount (latin->cs));
+	bench ("latin/cjk", latin, cjk, iterations);
+	bench ("cjk/latin", cjk, latin, iterations);
+	bench ("cjk2/cjk", cjk2, cjk, iterations);
+	bench ("cjk/cjk2", cjk, cjk2, iterations);
+    }
+
+    destroy (latin);
+    destroy (cjk);
+    destroy (cjk2);
+    destroy (sparse);
+    destroy (empty);
+
+    return ret;
+}
@@ -0,0 +1,316 @@
+/*
+ * fontconfig/test/test-conf-cache.c
+ *
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the author(s) not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  The authors make no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * THE AUTHOR(S) DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Check that a configuration loaded from the configuration cache is the
+ * same as the parsed one, and that the cache is dropped when one of the
+ * files it was made of changes.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <errno.h>
+#include <time.h>
+#include <utime.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fontconfig/fontconfig.h>
+
+#ifdef HAVE_MKDTEMP
+#define fc_mkdtemp	mkdtemp
+#else
+char *
+fc_mkdtemp (char *template)
+{
+    if (!mktemp (template) || mkdir (template, 0700))
+	return NULL;
+
+    return template;
+}
+#endif
+
+static const char *conf =
+    "<fontconfig>\n"
+    "  <dir>/fonts</dir>\n"
+    "  <cachedir>/cache</cachedir>\n"
+    "  <include ignore_missing=\"yes\">/conf.d</include>\n"
+    "  <include ignore_missing=\"yes\">/extra.conf</include>\n"
+    "  <selectfont>\n"
+    "    <rejectfont>\n"
+    "      <glob>*.bdf</glob>\n"
+    "      <pattern><patelt name=\"family\"><string>Nope</string></patelt></pattern>\n"
+    "    </rejectfont>\n"
+    "  </selectfont>\n"
+    "  <match target=\"pattern\">\n"
+    "    <test name=\"family\"><string>foo</string></test>\n"
+    "    <edit name=\"family\" mode=\"assign\" binding=\"strong\"><string>bar</string></edit>\n"
+    "    <edit name=\"pixelsize\"><times><name>pixelsize</name><double>2</double></times></edit>\n"
+    "    <edit name=\"lang\"><langset><string>en</string><string>ja</string></langset></edit>\n"
+    "  </match>\n"
+    "</fontconfig>\n";
+
+static const char *rescan =
+    "<fontconfig>\n"
+    "  <description>rescan %d</description>\n"
+    "  <config><rescan><int>%d</int></rescan></config>\n"
+    "</fontconfig>\n";
+
+static char *sysroot;
+static time_t base_time;
+
+static void
+write_file (const char *name, time_t mtime, const char *fmt, int n)
+{
+    char path[1024];
+    struct utimbuf times;
+    FILE *fp;
+
+    snprintf (path, sizeof (path), "%s%s", sysroot, name);
+    fp = fopen (path, "wb");
+    if (!fp)
+    {
+	fprintf (stderr, "E: %s: %s\n", path, strerror (errno));
+	exit (1);
+    }
+    fprintf (fp, fmt, n, n);
+    fclose (fp);
+    /* whole seconds, which can be set back exactly */
+    times.actime = times.modtime = mtime;
+    utime (path, &times);
+}
+
+static void
+set_time (const char *name, time_t mtime)
+{
+    char path[1024];
+    struct utimbuf times;
+
+    snprintf (path, sizeof (path), "%s%s", sysroot, name);
+    times.actime = times.modtime = mtime;
+    utime (path, &times);
+}
+
+static int
+same_strlist (const char *what, FcStrList *l1, FcStrList *l2)
+{
+    FcChar8 *s1, *s2;
+    int ret = 0;
+
+    do
+    {
+	s1 = FcStrListNext (l1);
+	s2 = FcStrListNext (l2);
+	if (!s1 != !s2 || (s1 && strcmp ((const char *) s1, (const char *) s2) != 0))
+	{
+	    fprintf (stderr, "%s differ: %s %s\n", what,
+		     s1 ? (const char *) s1 : "(none)",
+		     s2 ? (const char *) s2 : "(none)");
+	    ret = 1;
+	    break;
+	}
+    } while (s1);
+    FcStrListDone (l1);
+    FcStrListDone (l2);
+    return ret;
+}
+
+static int
+same_config (FcConfig *c1, FcConfig *c2)
+{
+    FcConfigFileInfoIter i1, i2;
+    FcChar8 *n1, *d1, *n2, *d2;
+    FcBool e1, e2, v1, v2;
+    FcPattern *p1, *p2;
+    int ret = 0;
+
+    ret |= same_strlist ("config files", FcConfigGetConfigFiles (c1), FcConfigGetConfigFiles (c2));
+    ret |= same_strlist ("font dirs", FcConfigGetFontDirs (c1), FcConfigGetFontDirs (c2));
+    ret |= same_strlist ("config dirs", FcConfigGetConfigDirs (c1), FcConfigGetConfigDirs (c2));
+    ret |= same_strlist ("cache dirs", FcConfigGetCacheDirs (c1), FcConfigGetCacheDirs (c2));
+    if (FcConfigGetRescanInterval (c1) != FcConfigGetRescanInterval (c2))
+    {
+	fprintf (stderr, "rescan intervals differ\n");
+	ret = 1;
+    }
+
+    FcConfigFileInfoIterInit (c1, &i1);
+    FcConfigFileInfoIterInit (c2, &i2);
+    do
+    {
+	v1 = FcConfigFileInfoIterGet (c1, &i1, &n1, &d1, &e1);
+	v2 = FcConfigFileInfoIterGet (c2, &i2, &n2, &d2, &e2);
+	if (v1 != v2 ||
+	    (v1 && (strcmp ((const char *) n1, (const char *) n2) != 0 ||
+		    strcmp ((const char *) d1, (const char *) d2) != 0 ||
+		    e1 != e2)))
+	{
+	    fprintf (stderr, "config file info differs: %s %s\n",
+		     v1 ? (const char *) n1 : "(none)",
+		     v2 ? (const char *) n2 : "(none)");
+	    ret = 1;
+	    v1 = FcFalse;
+	}
+	if (v1)
+	{
+	    FcStrFree (n1);
+	    FcStrFree (d1);
+	    FcStrFree (n2);
+	    FcStrFree (d2);
+	}
+    } while (v1 && FcConfigFileInfoIterNext (c1, &i1) && FcConfigFileInfoIterNext (c2, &i2));
+
+    p1 = FcNameParse ((const FcChar8 *) "foo:pixelsize=12");
+    p2 = FcPatternDuplicate (p1);
+    FcConfigSubstitute (c1, p1, FcMatchPattern);
+    FcConfigSubstitute (c2, p2, FcMatchPattern);
+    if (!FcPatternEqual (p1, p2))
+    {
+	fprintf (stderr, "substitutions differ\n");
+	FcPatternPrint (p1);
+	FcPatternPrint (p2);
+	ret = 1;
+    }
+    FcPatternDestroy (p1);
+    FcPatternDestroy (p2);
+
+    return ret;
+}
+
+static int
+check_rescan (const char *what, FcConfig *config, int expected)
+{
+    int interval = FcConfigGetRescanInterval (config);
+
+    if (interval != expected)
+    {
+	fprintf (stderr, "%s: rescan interval %d, expected %d\n",
+		 what, interval, expected);
+	return 1;
+    }
+    return 0;
+}
+
+static int
+unlink_dirs (const char *dir)
+{
+    DIR *d = opendir (dir);
+    struct dirent *e;
+    struct stat statb;
+    char path[1024];
+
+    if (!d)
+	return 1;
+    while ((e = readdir (d)) != NULL)
+    {
+	if (strcmp (e->d_name, ".") == 0 || strcmp (e->d_name, "..") == 0)
+	    continue;
+	snprintf (path, sizeof (path), "%s/%s", dir, e->d_name);
+	if (lstat (path, &statb) == 0 && S_ISDIR (statb.st_mode))
+	    unlink_dirs (path);
+	else
+	    unlink (path);
+    }
+    closedir (d);
+    return rmdir (dir);
+}
+
+int
+main (void)
+{
+    char template[512] = "/tmp/fccfgcache-XXXXXX";
+    char path[1024];
+    FcConfig *parsed, *cached;
+    int ret = 0;
+
+    sysroot = fc_mkdtemp (template);
+    if (!sysroot)
+    {
+	fprintf (stderr, "%s: %s\n", template, strerror (errno));
+	return 1;
+    }
+    setenv ("FONTCONFIG_SYSROOT", sysroot, 1);
+    setenv ("FONTCONFIG_FILE", "/fonts.conf", 1);
+    setenv ("HOME", "/home", 1);
+    setenv ("XDG_CACHE_HOME", "/home/.cache", 1);
+    setenv ("XDG_CONFIG_HOME", "/home/.config", 1);
+    setenv ("XDG_DATA_HOME", "/home/.local/share", 1);
+
+    base_time = time (NULL) - 1000;
+    snprintf (path, sizeof (path), "%s/conf.d", sysroot);
+    mkdir (path, 0755);
+    write_file ("/fonts.conf", base_time, conf, 0);
+    write_file ("/conf.d/10-rescan.conf", base_time, rescan, 42);
+    set_time ("/conf.d", base_time);
+
+    /* The first load writes the cache, the second one reads it */
+    parsed = FcInitLoadConfig ();
+    cached = FcInitLoadConfig ();
+    ret |= check_rescan ("parsed", parsed, 42);
+    ret |= same_config (parsed, cached);
+    FcConfigDestroy (parsed);
+    FcConfigDestroy (cached);
+
+    /* Changing a file behind its size and time keeps the cache... */
+    write_file ("/conf.d/10-rescan.conf", base_time, rescan, 43);
+    /* ... as does touching a file */
+    set_time ("/fonts.conf", base_time + 10);
+    cached = FcInitLoadConfig ();
+    ret |= check_rescan ("touched", cached, 42);
+    FcConfigDestroy (cached);
+
+    /* Now with its time changed it is read again */
+    set_time ("/conf.d/10-rescan.conf", base_time + 20);
+    parsed = FcInitLoadConfig ();
+    cached = FcInitLoadConfig ();
+    ret |= check_rescan ("changed", parsed, 43);
+    ret |= same_config (parsed, cached);
+    FcConfigDestroy (parsed);
+    FcConfigDestroy (cached);
+
+    /* A new file in an included directory */
+    write_file ("/conf.d/20-rescan.conf", base_time + 30, rescan, 44);
+    cached = FcInitLoadConfig ();
+    ret |= check_rescan ("added", cached, 44);
+    FcConfigDestroy (cached);
+
+    /* An include which was missing */
+    write_file ("/extra.conf", base_time + 40, rescan, 45);
+    parsed = FcInitLoadConfig ();
+    cached = FcInitLoadConfig ();
+    ret |= check_rescan ("appeared", parsed, 45);
+    ret |= same_config (parsed, cached);
+    FcConfigDestroy (parsed);
+    FcConfigDestroy (cached);
+
+    unlink_dirs (sysroot);
+
+    return ret;
+}
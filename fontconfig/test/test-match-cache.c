@@ -0,0 +1,169 @@
+/*
+ * fontconfig/test/test-match-cache.c
+ *
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the author(s) not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  The authors make no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * THE AUTHOR(S) DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <fontconfig/fontconfig.h>
+
+static const char rule[] =
+    "<fontconfig>"
+    "  <match target=\"font\">"
+    "    <edit name=\"style\" mode=\"assign\"><string>CHANGED</string></edit>"
+    "  </match>"
+    "</fontconfig>";
+
+static int
+check_stats (FcConfig *config, unsigned long hits, unsigned long misses)
+{
+    unsigned long h, m;
+
+    if (!FcConfigGetMatchCacheStats (config, &h, &m))
+    {
+	fprintf (stderr, "no match cache\n");
+	return 1;
+    }
+    if (h != hits || m != misses)
+    {
+	fprintf (stderr, "expected %lu hits and %lu misses, got %lu and %lu\n",
+		 hits, misses, h, m);
+	return 1;
+    }
+    return 0;
+}
+
+static int
+match_twice (FcConfig *config, FcPattern *pat)
+{
+    FcPattern *m1, *m2;
+    FcResult r1, r2;
+    int ret = 0;
+
+    m1 = FcFontMatch (config, pat, &r1);
+    m2 = FcFontMatch (config, pat, &r2);
+    if (r1 != r2 || !m1 || !m2 || m1 == m2 || !FcPatternEqual (m1, m2))
+    {
+	fprintf (stderr, "cached match differs\n");
+	ret = 1;
+    }
+    if (m1)
+	FcPatternDestroy (m1);
+    if (m2)
+	FcPatternDestroy (m2);
+    return ret;
+}
+
+static int
+sort_twice (FcConfig *config, FcPattern *pat)
+{
+    FcFontSet *s1, *s2;
+    FcCharSet *c1, *c2;
+    FcResult r1, r2;
+    int i, ret = 0;
+
+    s1 = FcFontSort (config, pat, FcTrue, &c1, &r1);
+    s2 = FcFontSort (config, pat, FcTrue, &c2, &r2);
+    if (r1 != r2 || !s1 || !s2 || s1->nfont != s2->nfont ||
+	!c1 || !c2 || !FcCharSetEqual (c1, c2))
+	ret = 1;
+    for (i = 0; !ret && i < s1->nfont; i++)
+	if (s1->fonts[i] != s2->fonts[i])
+	    ret = 1;
+    if (ret)
+	fprintf (stderr, "cached sort differs\n");
+    if (s1)
+	FcFontSetDestroy (s1);
+    if (s2)
+	FcFontSetDestroy (s2);
+    if (c1)
+	FcCharSetDestroy (c1);
+    if (c2)
+	FcCharSetDestroy (c2);
+    return ret;
+}
+
+int
+main (void)
+{
+    FcConfig *config = FcConfigCreate ();
+    FcPattern *pat, *pat2, *match;
+    FcResult result;
+    FcChar8 *style;
+    FcValue v;
+    int ret = 0;
+
+    if (!FcConfigAppFontAddFile (config, (const FcChar8 *)SRCDIR "/4x6.pcf"))
+	return 1;
+
+    pat = FcNameParse ((const FcChar8 *) "Fixed:pixelsize=6");
+    FcConfigSubstitute (config, pat, FcMatchPattern);
+    FcDefaultSubstitute (pat);
+
+    /* The second of each pair comes from the cache */
+    ret |= match_twice (config, pat);
+    ret |= check_stats (config, 1, 1);
+    ret |= sort_twice (config, pat);
+    ret |= check_stats (config, 2, 2);
+
+    /* Bindings count: a weak family is not the same pattern */
+    pat2 = FcPatternDuplicate (pat);
+    FcPatternDel (pat2, FC_FAMILY);
+    v.type = FcTypeString;
+    v.u.s = (const FcChar8 *) "Fixed";
+    FcPatternAddWeak (pat2, FC_FAMILY, v, FcFalse);
+    ret |= match_twice (config, pat2);
+    ret |= check_stats (config, 3, 3);
+    FcPatternDestroy (pat2);
+
+    /* Adding fonts invalidates the cache */
+    if (!FcConfigAppFontAddFile (config, (const FcChar8 *)SRCDIR "/8x16.pcf"))
+	return 1;
+    ret |= match_twice (config, pat);
+    ret |= check_stats (config, 4, 4);
+
+    /* So does loading rules */
+    if (!FcConfigParseAndLoadFromMemory (config, (const FcChar8 *) rule, FcTrue))
+	return 1;
+    ret |= match_twice (config, pat);
+    ret |= check_stats (config, 5, 5);
+    match = FcFontMatch (config, pat, &result);
+    if (!match ||
+	FcPatternGetString (match, FC_STYLE, 0, &style) != FcResultMatch ||
+	strcmp ((const char *) style, "CHANGED") != 0)
+    {
+	fprintf (stderr, "match from before the rule was loaded\n");
+	ret = 1;
+    }
+    if (match)
+	FcPatternDestroy (match);
+    ret |= check_stats (config, 6, 5);
+
+    /* And a size of zero disables it, without even counting lookups */
+    FcConfigSetMatchCacheSize (config, 0);
+    ret |= match_twice (config, pat);
+    ret |= check_stats (config, 6, 5);
+
+    FcPatternDestroy (pat);
+    FcConfigDestroy (config);
+
+    return ret;
+}
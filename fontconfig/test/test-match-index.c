@@ -0,0 +1,240 @@
+/*
+ * fontconfig/test/test-match-index.c
+ *
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of the author(s) not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  The authors make no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * THE AUTHOR(S) DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Check that matching and sorting against the indexed system font set
+ * gives the same results as against an unindexed copy of it.
+ *
+ * Usage: test-match-index [fontdir [iterations]]
+ *
+ * With a font directory, which may hold thousands of fonts, it also
+ * reports how long the matches take both ways.  Without one, it uses
+ * enough links to the fonts in the source directory for the set to be
+ * indexed.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fontconfig/fontconfig.h>
+
+#define COPIES 16
+
+static const char *srcfonts[] = { "4x6.pcf", "8x16.pcf" };
+
+static const char *names[] = {
+    "",
+    "fixed",
+    "Fixed:pixelsize=16",
+    "Fixed:weight=bold",
+    "monospace",
+    "sans-serif:bold:italic",
+    "serif:lang=ja",
+    ":lang=zh-cn",
+    ":spacing=mono:pixelsize=6",
+    "NoSuchFamily",
+    "NoSuchFamily,Fixed",
+    "Misc Fixed:style=Regular",
+};
+
+static FcPattern *
+prepare (FcConfig *config, FcPattern *pat)
+{
+    FcConfigSubstitute (config, pat, FcMatchPattern);
+    FcDefaultSubstitute (pat);
+    return pat;
+}
+
+static int
+check_pattern (FcConfig *config, FcFontSet *copy, FcPattern *pat)
+{
+    FcPattern *m1, *m2;
+    FcFontSet *s1, *s2;
+    FcResult r1 = FcResultNoMatch, r2 = FcResultNoMatch;
+    FcBool trim, differs;
+    int i, ret = 0;
+
+    m1 = FcFontMatch (config, pat, &r1);
+    m2 = FcFontSetMatch (config, &copy, 1, pat, &r2);
+    if (r1 != r2 || !m1 != !m2 || (m1 && !FcPatternEqual (m1, m2)))
+    {
+	FcChar8 *name = FcNameUnparse (pat);
+
+	fprintf (stderr, "match differs for %s\n", name);
+	FcStrFree (name);
+	ret = 1;
+    }
+    if (m1)
+	FcPatternDestroy (m1);
+    if (m2)
+	FcPatternDestroy (m2);
+
+    for (trim = FcFalse; trim <= FcTrue; trim++)
+    {
+	s1 = FcFontSort (config, pat, trim, NULL, &r1);
+	s2 = FcFontSetSort (config, &copy, 1, pat, trim, NULL, &r2);
+	differs = r1 != r2 || s1->nfont != s2->nfont;
+	for (i = 0; !differs && i < s1->nfont; i++)
+	    differs = !FcPatternEqual (s1->fonts[i], s2->fonts[i]);
+	if (differs)
+	{
+	    FcChar8 *name = FcNameUnparse (pat);
+
+	    fprintf (stderr, "sort differs for %s\n", name);
+	    FcStrFree (name);
+	    ret = 1;
+	}
+	FcFontSetDestroy (s1);
+	FcFontSetDestroy (s2);
+    }
+    return ret;
+}
+
+static void
+links (const char *dir, FcBool create)
+{
+    char src[1024], dst[1024];
+    int i, j;
+
+    for (i = 0; i < COPIES; i++)
+	for (j = 0; j < sizeof (srcfonts) / sizeof (srcfonts[0]); j++)
+	{
+	    snprintf (src, sizeof (src), "%s/%s", SRCDIR, srcfonts[j]);
+	    snprintf (dst, sizeof (dst), "%s/%d-%s", dir, i, srcfonts[j]);
+	    if (!create)
+		unlink (dst);
+	    else if (symlink (src, dst) != 0)
+	    {
+		fprintf (stderr, "unable to link %s\n", dst);
+		exit (1);
+	    }
+	}
+}
+
+static double
+elapsed (clock_t start)
+{
+    return (double) (clock () - start) / CLOCKS_PER_SEC;
+}
+
+int
+main (int argc, char **argv)
+{
+    char template[] = "/tmp/fcXXXXXX";
+    const char *dir = argc > 1 ? argv[1] : mkdtemp (template);
+    int iterations = argc > 2 ? atoi (argv[2]) : 1000;
+    FcConfig *config = FcConfigCreate ();
+    FcFontSet *fonts, *copy;
+    FcStrSet *families;
+    FcPattern **pats;
+    FcResult result;
+    FcChar8 *conf;
+    FcChar8 *family;
+    clock_t start;
+    int npats, i, n, ret = 0;
+    size_t len;
+
+    if (!dir)
+    {
+	fprintf (stderr, "unable to create a font directory\n");
+	return 1;
+    }
+    if (argc <= 1)
+	links (dir, FcTrue);
+
+    len = strlen (dir) + 64;
+    conf = malloc (len);
+    snprintf ((char *) conf, len, "<fontconfig><dir>%s</dir></fontconfig>", dir);
+    if (!FcConfigParseAndLoadFromMemory (config, conf, FcTrue) ||
+	!FcConfigBuildFonts (config))
+    {
+	fprintf (stderr, "unable to load %s\n", dir);
+	return 1;
+    }
+    free (conf);
+
+    fonts = FcConfigGetFonts (config, FcSetSystem);
+    copy = FcFontSetCreate ();
+    for (i = 0; i < fonts->nfont; i++)
+    {
+	FcPatternReference (fonts->fonts[i]);
+	FcFontSetAdd (copy, fonts->fonts[i]);
+    }
+
+    /* The fixed names above and each family of the set, bold */
+    npats = sizeof (names) / sizeof (names[0]) + fonts->nfont;
+    pats = malloc (npats * sizeof (FcPattern *));
+    families = FcStrSetCreate ();
+    n = 0;
+    for (i = 0; i < sizeof (names) / sizeof (names[0]); i++)
+	pats[n++] = prepare (config, FcNameParse ((const FcChar8 *) names[i]));
+    for (i = 0; i < fonts->nfont; i++)
+	if (FcPatternGetString (fonts->fonts[i], FC_FAMILY, 0, &family) == FcResultMatch &&
+	    !FcStrSetMember (families, family))
+	{
+	    FcStrSetAdd (families, family);
+	    pats[n++] = prepare (config,
+				 FcPatternBuild (NULL,
+						 FC_FAMILY, FcTypeString, family,
+						 FC_WEIGHT, FcTypeInteger, FC_WEIGHT_BOLD,
+						 NULL));
+	}
+    FcStrSetDestroy (families);
+
+    for (i = 0; i < n; i++)
+	ret |= check_pattern (config, copy, pats[i]);
+
+    if (argc > 1)
+    {
+	/* Time the matching itself, not the result cache */
+	FcConfigSetMatchCacheSize (config, 0);
+	printf ("%d fonts, %d patterns, %d iterations\n",
+		fonts->nfont, n, iterations);
+	start = clock ();
+	for (i = 0; i < iterations; i++)
+	    FcPatternDestroy (FcFontMatch (config, pats[i % n], &result));
+	printf ("indexed:   %.3fs\n", elapsed (start));
+	start = clock ();
+	for (i = 0; i < iterations; i++)
+	    FcPatternDestroy (FcFontSetMatch (config, &copy, 1, pats[i % n], &result));
+	printf ("unindexed: %.3fs\n", elapsed (start));
+    }
+
+    for (i = 0; i < n; i++)
+	FcPatternDestroy (pats[i]);
+    free (pats);
+    FcFontSetDestroy (copy);
+    FcConfigDestroy (config);
+    if (argc <= 1)
+    {
+	links (dir, FcFalse);
+	rmdir (dir);
+    }
+
+    return ret;
+}
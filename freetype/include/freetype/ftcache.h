@@ -1031,6 +1031,153 @@ FT_BEGIN_HEADER
                               FTC_SBit      *sbit,
                               FTC_Node      *anode );
 
+
+  /*************************************************************************/
+  /*                                                                       */
+  /* <Type>                                                                */
+  /*    FTC_SBitRun                                                        */
+  /*                                                                       */
+  /* <Description>                                                         */
+  /*    A handle to the small bitmaps of a run of glyphs.  See the         */
+  /*    @FTC_SBitRunRec structure for details.                             */
+  /*                                                                       */
+  typedef struct FTC_SBitRunRec_*  FTC_SBitRun;
+
+
+  /*************************************************************************/
+  /*                                                                       */
+  /* <Struct>                                                              */
+  /*    FTC_SBitRunRec                                                     */
+  /*                                                                       */
+  /* <Description>                                                         */
+  /*    The small bitmaps of a run of glyphs, as returned by               */
+  /*    @FTC_SBitCache_LookupRun.                                          */
+  /*                                                                       */
+  /* <Fields>                                                              */
+  /*    num_glyphs :: The number of glyphs in the run.                     */
+  /*                                                                       */
+  /*    sbits      :: An array of `num_glyphs' small bitmap descriptors,   */
+  /*                  one per glyph, in run order.                         */
+  /*                                                                       */
+  /*    x_advance  :: The sum of the horizontal advances of the glyphs.    */
+  /*                                                                       */
+  /*    y_advance  :: The sum of the vertical advances of the glyphs.      */
+  /*                                                                       */
+  /*    strip      :: If requested, the coverage of the whole run drawn    */
+  /*                  into one 8-bit gray bitmap, with the glyphs placed   */
+  /*                  at their advances and overlapping pixels added up    */
+  /*                  (saturated).  Its `buffer' is NULL if no strip was   */
+  /*                  requested, the run has no pixels, or a glyph bitmap  */
+  /*                  is neither monochrome nor 8-bit gray.                */
+  /*                                                                       */
+  /*    strip_left :: The horizontal distance from the pen position of the */
+  /*                  first glyph to the left border of the strip.         */
+  /*                                                                       */
+  /*    strip_top  :: The vertical distance from the pen position of the   */
+  /*                  first glyph to the upper border of the strip,        */
+  /*                  positive upwards.                                    */
+  /*                                                                       */
+  /*    manager    :: Private.                                             */
+  /*                                                                       */
+  /*    nodes      :: Private.                                             */
+  /*                                                                       */
+  /*    num_nodes  :: Private.                                             */
+  /*                                                                       */
+  typedef struct  FTC_SBitRunRec_
+  {
+    FT_UInt      num_glyphs;
+    FTC_SBit     sbits;
+    FT_Pos       x_advance;
+    FT_Pos       y_advance;
+
+    FT_Bitmap    strip;
+    FT_Int       strip_left;
+    FT_Int       strip_top;
+
+    FTC_Manager  manager;
+    FTC_Node*    nodes;
+    FT_UInt      num_nodes;
+
+  } FTC_SBitRunRec;
+
+
+  /*************************************************************************/
+  /*                                                                       */
+  /* <Constant>                                                            */
+  /*    FTC_SBIT_RUN_FLAG_STRIP                                            */
+  /*                                                                       */
+  /* <Description>                                                         */
+  /*    A bit flag for @FTC_SBitCache_LookupRun to also draw the run into  */
+  /*    the `strip' bitmap of the @FTC_SBitRunRec.                         */
+  /*                                                                       */
+#define FTC_SBIT_RUN_FLAG_STRIP  0x1
+
+
+  /*************************************************************************/
+  /*                                                                       */
+  /* <Function>                                                            */
+  /*    FTC_SBitCache_LookupRun                                            */
+  /*                                                                       */
+  /* <Description>                                                         */
+  /*    Look up the small bitmaps of a whole run of glyphs, e.g., a shaped */
+  /*    string, in one call.  This is faster than one call to              */
+  /*    @FTC_SBitCache_Lookup per glyph, since glyphs sharing a cache node */
+  /*    are found without probing the cache again, and each node is moved  */
+  /*    to the front of the cache's LRU list only once per run.            */
+  /*                                                                       */
+  /* <Input>                                                               */
+  /*    cache      :: A handle to the source sbit cache.                   */
+  /*                                                                       */
+  /*    scaler     :: A pointer to the scaler descriptor.                  */
+  /*                                                                       */
+  /*    load_flags :: The corresponding load flags.                        */
+  /*                                                                       */
+  /*    gindices   :: An array of `num_glyphs' glyph indices.              */
+  /*                                                                       */
+  /*    num_glyphs :: The number of glyphs in the run.                     */
+  /*                                                                       */
+  /*    flags      :: A combination of `FTC_SBIT_RUN_FLAG_XXX' bits.       */
+  /*                                                                       */
+  /* <Output>                                                              */
+  /*    arun       :: A handle to the run.                                 */
+  /*                                                                       */
+  /* <Return>                                                              */
+  /*    FreeType error code.  0~means success.                             */
+  /*                                                                       */
+  /* <Note>                                                                */
+  /*    The run keeps references to the cache nodes holding its bitmaps,   */
+  /*    so its descriptors and their buffers stay valid until the run is   */
+  /*    released with @FTC_SBitRun_Done, which must be called before the   */
+  /*    cache manager is destroyed.                                        */
+  /*                                                                       */
+  /*    As with @FTC_SBitCache_Lookup, a descriptor's `buffer' field is    */
+  /*    set to~0 for a missing glyph bitmap.                               */
+  /*                                                                       */
+  FT_EXPORT( FT_Error )
+  FTC_SBitCache_LookupRun( FTC_SBitCache   cache,
+                           FTC_Scaler      scaler,
+                           FT_ULong        load_flags,
+                           const FT_UInt*  gindices,
+                           FT_UInt         num_glyphs,
+                           FT_UInt         flags,
+                           FTC_SBitRun    *arun );
+
+
+  /*************************************************************************/
+  /*                                                                       */
+  /* <Function>                                                            */
+  /*    FTC_SBitRun_Done                                                   */
+  /*                                                                       */
+  /* <Description>                                                         */
+  /*    Release a run returned by @FTC_SBitCache_LookupRun, together with  */
+  /*    its references to cache nodes.                                     */
+  /*                                                                       */
+  /* <Input>                                                               */
+  /*    run :: A handle to the run.  Can be NULL.                          */
+  /*                                                                       */
+  FT_EXPORT( void )
+  FTC_SBitRun_Done( FTC_SBitRun  run );
+
   /* */
 
 
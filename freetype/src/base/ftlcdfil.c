@@ -32,6 +32,370 @@
 #define FT_SHIFTCLAMP( x )  ( x >>= 8, (FT_Byte)( x > 255 ? 255 : x ) )
 
 
+  /*************************************************************************/
+  /*                                                                       */
+  /* SIMD kernels for the FIR filter.                                      */
+  /*                                                                       */
+  /* A product of a weight and a pixel value is at most 0xFF * 0xFF and    */
+  /* thus fits into 16 bits.  Since all products are positive, adding up   */
+  /* the five of them in 16-bit lanes with unsigned saturation yields      */
+  /* `min(sum, 0xFFFF)', which shifts and clamps to the very same byte as  */
+  /* the 32-bit sum of the scalar code, whatever the weights.              */
+  /*                                                                       */
+  /* SSE2 is used if the compiler targets it; AVX2 is selected at run time */
+  /* if the CPU supports it.                                               */
+  /*                                                                       */
+#if defined( __SSE2__ ) || defined( _M_X64 )               || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define FT_LCD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined( FT_LCD_SSE2 )                                      && \
+    ( defined( __clang__ )                                   || \
+      ( defined( __GNUC__ ) && ( __GNUC__ > 4              || \
+                                 ( __GNUC__ == 4         && \
+                                   __GNUC_MINOR__ >= 9 ) ) ) || \
+      ( defined( _MSC_VER ) && _MSC_VER >= 1800 )            )
+#define FT_LCD_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define FT_LCD_AVX2_TARGET  /* nothing */
+#else
+#define FT_LCD_AVX2_TARGET  __attribute__(( target( "avx2" ) ))
+#endif
+#endif
+
+
+#ifdef FT_LCD_SSE2
+
+  /* Compute `n' (a multiple of 16) horizontally filtered pixels; */
+  /* `src[i]' is the original value of `dst[i - 2]'.               */
+  typedef void
+  (*FT_LCD_HRunFunc)( FT_Byte*        dst,
+                      const FT_Byte*  src,
+                      FT_UInt         n,
+                      const FT_Byte*  weights );
+
+  /* Vertically filter 16 columns of `height' rows starting at `col'. */
+  typedef void
+  (*FT_LCD_VBlockFunc)( FT_Byte*        col,
+                        FT_UInt         height,
+                        FT_Int          pitch,
+                        const FT_Byte*  weights );
+
+
+  /* Filter 16 pixels: `v[0]' is weighted with `w[0]', and so on. */
+  static __m128i
+  ft_lcd_fir_sse2( const __m128i*  w,
+                   const __m128i*  v )
+  {
+    const __m128i  zero = _mm_setzero_si128();
+
+    __m128i  lo, hi;
+    int      i;
+
+
+    lo = _mm_mullo_epi16( _mm_unpacklo_epi8( v[0], zero ), w[0] );
+    hi = _mm_mullo_epi16( _mm_unpackhi_epi8( v[0], zero ), w[0] );
+
+    for ( i = 1; i < 5; i++ )
+    {
+      lo = _mm_adds_epu16( lo, _mm_mullo_epi16(
+                                 _mm_unpacklo_epi8( v[i], zero ), w[i] ) );
+      hi = _mm_adds_epu16( hi, _mm_mullo_epi16(
+                                 _mm_unpackhi_epi8( v[i], zero ), w[i] ) );
+    }
+
+    return _mm_packus_epi16( _mm_srli_epi16( lo, 8 ),
+                             _mm_srli_epi16( hi, 8 ) );
+  }
+
+
+  static void
+  ft_lcd_hrun_sse2( FT_Byte*        dst,
+                    const FT_Byte*  src,
+                    FT_UInt         n,
+                    const FT_Byte*  weights )
+  {
+    __m128i  w[5];
+    int      i;
+
+
+    for ( i = 0; i < 5; i++ )
+      w[i] = _mm_set1_epi16( weights[i] );
+
+    for ( ; n > 0; n -= 16, src += 16, dst += 16 )
+    {
+      __m128i  v[5];
+
+
+      /* `dst[2]' is weighted with `weights[0]', etc. */
+      for ( i = 0; i < 5; i++ )
+        v[i] = _mm_loadu_si128( (const __m128i*)( src + 4 - i ) );
+
+      _mm_storeu_si128( (__m128i*)dst, ft_lcd_fir_sse2( w, v ) );
+    }
+  }
+
+
+  static void
+  ft_lcd_vblock_sse2( FT_Byte*        col,
+                      FT_UInt         height,
+                      FT_Int          pitch,
+                      const FT_Byte*  weights )
+  {
+    __m128i  w[5];
+    __m128i  v[5];  /* the original rows yy, yy-1, ..., yy-4 */
+    FT_UInt  yy;
+    int      i;
+
+
+    for ( i = 0; i < 5; i++ )
+    {
+      w[i] = _mm_set1_epi16( weights[i] );
+      v[i] = _mm_setzero_si128();
+    }
+
+    for ( yy = 0; yy < height + 2; yy++, col -= pitch )
+    {
+      v[0] = yy < height ? _mm_loadu_si128( (const __m128i*)col )
+                         : _mm_setzero_si128();
+
+      if ( yy >= 2 )
+        _mm_storeu_si128( (__m128i*)( col + pitch * 2 ),
+                          ft_lcd_fir_sse2( w, v ) );
+
+      v[4] = v[3];
+      v[3] = v[2];
+      v[2] = v[1];
+      v[1] = v[0];
+    }
+  }
+
+
+#ifdef FT_LCD_AVX2
+
+  /* Filter 16 pixels: `v[0]' is weighted with `w[0]', and so on. */
+  FT_LCD_AVX2_TARGET static __m128i
+  ft_lcd_fir_avx2( const __m256i*  w,
+                   const __m128i*  v )
+  {
+    __m256i  s;
+    int      i;
+
+
+    s = _mm256_mullo_epi16( _mm256_cvtepu8_epi16( v[0] ), w[0] );
+
+    for ( i = 1; i < 5; i++ )
+      s = _mm256_adds_epu16( s, _mm256_mullo_epi16(
+                                  _mm256_cvtepu8_epi16( v[i] ), w[i] ) );
+
+    s = _mm256_srli_epi16( s, 8 );
+
+    return _mm_packus_epi16( _mm256_castsi256_si128( s ),
+                             _mm256_extracti128_si256( s, 1 ) );
+  }
+
+
+  FT_LCD_AVX2_TARGET static void
+  ft_lcd_hrun_avx2( FT_Byte*        dst,
+                    const FT_Byte*  src,
+                    FT_UInt         n,
+                    const FT_Byte*  weights )
+  {
+    __m256i  w[5];
+    int      i;
+
+
+    for ( i = 0; i < 5; i++ )
+      w[i] = _mm256_set1_epi16( weights[i] );
+
+    for ( ; n > 0; n -= 16, src += 16, dst += 16 )
+    {
+      __m128i  v[5];
+
+
+      for ( i = 0; i < 5; i++ )
+        v[i] = _mm_loadu_si128( (const __m128i*)( src + 4 - i ) );
+
+      _mm_storeu_si128( (__m128i*)dst, ft_lcd_fir_avx2( w, v ) );
+    }
+  }
+
+
+  FT_LCD_AVX2_TARGET static void
+  ft_lcd_vblock_avx2( FT_Byte*        col,
+                      FT_UInt         height,
+                      FT_Int          pitch,
+                      const FT_Byte*  weights )
+  {
+    __m256i  w[5];
+    __m128i  v[5];
+    FT_UInt  yy;
+    int      i;
+
+
+    for ( i = 0; i < 5; i++ )
+    {
+      w[i] = _mm256_set1_epi16( weights[i] );
+      v[i] = _mm_setzero_si128();
+    }
+
+    for ( yy = 0; yy < height + 2; yy++, col -= pitch )
+    {
+      v[0] = yy < height ? _mm_loadu_si128( (const __m128i*)col )
+                         : _mm_setzero_si128();
+
+      if ( yy >= 2 )
+        _mm_storeu_si128( (__m128i*)( col + pitch * 2 ),
+                          ft_lcd_fir_avx2( w, v ) );
+
+      v[4] = v[3];
+      v[3] = v[2];
+      v[2] = v[1];
+      v[1] = v[0];
+    }
+  }
+
+
+  static int  ft_lcd_avx2 = -1;  /* not known yet */
+
+
+  static int
+  ft_lcd_have_avx2( void )
+  {
+    /* a race here is harmless: all threads store the same value */
+    if ( ft_lcd_avx2 < 0 )
+    {
+#ifdef _MSC_VER
+
+      int  info[4];
+
+
+      ft_lcd_avx2 = 0;
+
+      __cpuid( info, 0 );
+      if ( info[0] >= 7 )
+      {
+        __cpuid( info, 1 );
+
+        /* AVX, and the OS saves the upper halves of the YMM registers */
+        if ( ( info[2] & ( 1 << 27 ) )  &&
+             ( info[2] & ( 1 << 28 ) )  &&
+             ( _xgetbv( 0 ) & 6 ) == 6  )
+        {
+          __cpuidex( info, 7, 0 );
+          ft_lcd_avx2 = ( info[1] & ( 1 << 5 ) ) != 0;
+        }
+      }
+
+#else /* !_MSC_VER */
+
+      __builtin_cpu_init();
+      ft_lcd_avx2 = __builtin_cpu_supports( "avx2" ) != 0;
+
+#endif /* !_MSC_VER */
+    }
+
+    return ft_lcd_avx2;
+  }
+
+#endif /* FT_LCD_AVX2 */
+
+
+  /* The horizontal filter works on a copy of up to FT_LCD_SEGMENT bytes */
+  /* of a row, padded with the two original bytes on each side.          */
+#define FT_LCD_SEGMENT  512
+
+
+  static void
+  ft_lcd_fir_horizontal( FT_Byte*             origin,
+                         FT_UInt              width,
+                         FT_UInt              height,
+                         FT_Int               pitch,
+                         FT_LcdFiveTapFilter  weights )
+  {
+    FT_LCD_HRunFunc  run  = ft_lcd_hrun_sse2;
+    FT_Byte*         line = origin;
+
+    /* `seg[i]' holds the original value of `line[x + i - 2]' */
+    FT_Byte  seg[FT_LCD_SEGMENT + 4 + 16];
+
+
+#ifdef FT_LCD_AVX2
+    if ( ft_lcd_have_avx2() )
+      run = ft_lcd_hrun_avx2;
+#endif
+
+    for ( ; height > 0; height--, line -= pitch )
+    {
+      FT_UInt  x, n;
+
+
+      seg[0] = 0;
+      seg[1] = 0;
+
+      for ( x = 0; x < width; x += n )
+      {
+        FT_UInt  copy, full;
+
+
+        n    = FT_MIN( width - x, FT_LCD_SEGMENT );
+        copy = FT_MIN( width - x, n + 2 );
+        full = n & ~15U;
+
+        ft_memcpy( seg + 2, line + x, copy );
+        ft_memset( seg + 2 + copy, 0, sizeof ( seg ) - 2 - copy );
+
+        if ( full )
+          run( line + x, seg, full, weights );
+
+        if ( n > full )
+        {
+          FT_Byte  tail[16];
+
+
+          run( tail, seg + full, 16, weights );
+          ft_memcpy( line + x + full, tail, n - full );
+        }
+
+        /* the next segment starts with the two last original bytes */
+        seg[0] = seg[n];
+        seg[1] = seg[n + 1];
+      }
+    }
+  }
+
+
+  /* Vertically filter the columns of a bitmap in blocks of 16; */
+  /* return the number of columns done.                         */
+  static FT_UInt
+  ft_lcd_fir_vertical( FT_Byte*             origin,
+                       FT_UInt              width,
+                       FT_UInt              height,
+                       FT_Int               pitch,
+                       FT_LcdFiveTapFilter  weights )
+  {
+    FT_LCD_VBlockFunc  block = ft_lcd_vblock_sse2;
+    FT_UInt            xx;
+
+
+#ifdef FT_LCD_AVX2
+    if ( ft_lcd_have_avx2() )
+      block = ft_lcd_vblock_avx2;
+#endif
+
+    for ( xx = 0; xx + 16 <= width; xx += 16 )
+      block( origin + xx, height, pitch, weights );
+
+    return xx;
+  }
+
+#endif /* FT_LCD_SSE2 */
+
+
   /* add padding according to filter weights */
   FT_BASE_DEF (void)
   ft_lcd_padding( FT_Pos*       Min,
@@ -86,6 +450,14 @@
       FT_Byte*  line = origin;
 
 
+#ifdef FT_LCD_SSE2
+      if ( width >= 16 )
+      {
+        ft_lcd_fir_horizontal( origin, width, height, pitch, weights );
+        return;
+      }
+#endif
+
       /* `fir' must be at least 32 bit wide, since the sum of */
       /* the values in `weights' can exceed 0xFF              */
 
@@ -129,6 +501,17 @@
       FT_Byte*  column = origin;
 
 
+#ifdef FT_LCD_SSE2
+      {
+        FT_UInt  done = ft_lcd_fir_vertical( origin, width, height,
+                                             pitch, weights );
+
+
+        column += done;
+        width  -= done;
+      }
+#endif
+
       for ( ; width > 0; width--, column++ )
       {
         FT_Byte*  col = column;
@@ -629,4 +629,266 @@
   }
 
 
+  /*
+   *
+   * runs of small bitmaps
+   *
+   */
+
+  /* the number of recently used nodes a run lookup tries first */
+#define FTC_SBIT_RUN_SLOTS  16
+
+
+  /* add the coverage of `sbit' at (x,y) of the strip; y grows downwards */
+  static void
+  ftc_sbit_run_blit( FT_Bitmap*  strip,
+                     FTC_SBit    sbit,
+                     FT_Int      x,
+                     FT_Int      y )
+  {
+    FT_Int    pitch = sbit->pitch;
+    FT_UInt   row, col;
+    FT_Byte*  src;
+    FT_Byte*  dst;
+
+
+    for ( row = 0; row < sbit->height; row++ )
+    {
+      if ( pitch >= 0 )
+        src = sbit->buffer + row * pitch;
+      else
+        src = sbit->buffer + ( sbit->height - 1 - row ) * -pitch;
+
+      dst = strip->buffer + ( y + (FT_Int)row ) * strip->pitch + x;
+
+      if ( sbit->format == FT_PIXEL_MODE_MONO )
+      {
+        for ( col = 0; col < sbit->width; col++ )
+          if ( src[col >> 3] & ( 0x80 >> ( col & 7 ) ) )
+            dst[col] = 0xFF;
+      }
+      else
+      {
+        for ( col = 0; col < sbit->width; col++ )
+        {
+          FT_UInt  v = dst[col] + src[col];
+
+
+          dst[col] = (FT_Byte)( v > 0xFF ? 0xFF : v );
+        }
+      }
+    }
+  }
+
+
+  /* draw the glyphs of a run into one gray bitmap */
+  static FT_Error
+  ftc_sbit_run_strip( FTC_SBitRun  run,
+                      FT_Memory    memory )
+  {
+    FT_Error  error = FT_Err_Ok;
+    FT_Pos    x_min = 0, x_max = 0, y_min = 0, y_max = 0;
+    FT_Pos    x, y;
+    FT_Bool   empty = TRUE;
+    FT_UInt   i;
+    FTC_SBit  sbit;
+
+
+    x = 0;
+    y = 0;
+    for ( i = 0; i < run->num_glyphs; i++ )
+    {
+      sbit = run->sbits + i;
+
+      if ( sbit->buffer && sbit->width && sbit->height )
+      {
+        if ( sbit->format != FT_PIXEL_MODE_MONO                    &&
+             !( sbit->format    == FT_PIXEL_MODE_GRAY &&
+                sbit->max_grays == 255                )            )
+          goto Exit;
+
+        if ( empty || x + sbit->left < x_min )
+          x_min = x + sbit->left;
+        if ( empty || x + sbit->left + sbit->width > x_max )
+          x_max = x + sbit->left + sbit->width;
+        if ( empty || y + sbit->top > y_max )
+          y_max = y + sbit->top;
+        if ( empty || y + sbit->top - sbit->height < y_min )
+          y_min = y + sbit->top - sbit->height;
+        empty = FALSE;
+      }
+
+      x += sbit->xadvance;
+      y += sbit->yadvance;
+    }
+
+    if ( empty                                      ||
+         x_max - x_min > 0x7FFF || y_max - y_min > 0x7FFF )
+      goto Exit;
+
+    run->strip.width      = (unsigned int)( x_max - x_min );
+    run->strip.rows       = (unsigned int)( y_max - y_min );
+    run->strip.pitch      = (int)run->strip.width;
+    run->strip.num_grays  = 256;
+    run->strip.pixel_mode = FT_PIXEL_MODE_GRAY;
+    run->strip_left       = (FT_Int)x_min;
+    run->strip_top        = (FT_Int)y_max;
+
+    if ( FT_ALLOC_MULT( run->strip.buffer,
+                        run->strip.rows, run->strip.width ) )
+      goto Exit;
+
+    x = 0;
+    y = 0;
+    for ( i = 0; i < run->num_glyphs; i++ )
+    {
+      sbit = run->sbits + i;
+
+      if ( sbit->buffer && sbit->width && sbit->height )
+        ftc_sbit_run_blit( &run->strip, sbit,
+                           (FT_Int)( x + sbit->left - x_min ),
+                           (FT_Int)( y_max - ( y + sbit->top ) ) );
+
+      x += sbit->xadvance;
+      y += sbit->yadvance;
+    }
+
+  Exit:
+    return error;
+  }
+
+
+  /* documentation is in ftcache.h */
+
+  FT_EXPORT_DEF( FT_Error )
+  FTC_SBitCache_LookupRun( FTC_SBitCache   cache,
+                           FTC_Scaler      scaler,
+                           FT_ULong        load_flags,
+                           const FT_UInt*  gindices,
+                           FT_UInt         num_glyphs,
+                           FT_UInt         flags,
+                           FTC_SBitRun    *arun )
+  {
+    FT_Error           error;
+    FT_Memory          memory;
+    FTC_BasicQueryRec  query;
+    FTC_SBitRun        run = NULL;
+    FTC_Node           slots[FTC_SBIT_RUN_SLOTS];
+    FTC_Node           node;
+    FT_Offset          attrs_hash, hash, block;
+    FT_UInt            i, gindex;
+
+
+    if ( !arun )
+      return FT_THROW( Invalid_Argument );
+
+    *arun = NULL;
+
+    if ( !cache || !scaler || ( !gindices && num_glyphs ) )
+      return FT_THROW( Invalid_Argument );
+
+    memory = FTC_CACHE( cache )->memory;
+
+    if ( FT_NEW( run ) )
+      goto Exit;
+
+    run->manager    = FTC_CACHE( cache )->manager;
+    run->num_glyphs = num_glyphs;
+
+    if ( FT_NEW_ARRAY( run->sbits, num_glyphs ) ||
+         FT_NEW_ARRAY( run->nodes, num_glyphs ) )
+      goto Fail;
+
+    query.attrs.scaler     = scaler[0];
+    query.attrs.load_flags = (FT_UInt)load_flags;
+
+    attrs_hash = FTC_BASIC_ATTR_HASH( &query.attrs );
+
+    FT_MEM_ZERO( slots, sizeof ( slots ) );
+
+    for ( i = 0; i < num_glyphs; i++ )
+    {
+      gindex = gindices[i];
+      block  = gindex / FTC_SBIT_ITEMS_PER_NODE;
+      node   = slots[block % FTC_SBIT_RUN_SLOTS];
+
+      /*
+       * Glyphs of a node the run already holds don't need another
+       * cache lookup; the node is locked by the run and was moved up
+       * in the LRU list when it was first looked up.  The comparison
+       * still loads the glyph's bitmap if necessary.
+       */
+      query.gquery.gindex = gindex;
+      if ( !node                                            ||
+           !ftc_snode_compare( node, FTC_GQUERY( &query ),
+                               FTC_CACHE( cache ), NULL )   )
+      {
+        /* beware, the hash must be the same for all glyph ranges! */
+        hash = attrs_hash + block;
+
+        FTC_GCACHE_LOOKUP_CMP( cache,
+                               ftc_basic_family_compare,
+                               FTC_SNode_Compare,
+                               hash, gindex,
+                               &query,
+                               node,
+                               error );
+        if ( error )
+          goto Fail;
+
+        node->ref_count++;
+        run->nodes[run->num_nodes++] = node;
+
+        slots[block % FTC_SBIT_RUN_SLOTS] = node;
+      }
+
+      run->sbits[i] = FTC_SNODE( node )->sbits[gindex -
+                                               FTC_GNODE( node )->gindex];
+
+      run->x_advance += run->sbits[i].xadvance;
+      run->y_advance += run->sbits[i].yadvance;
+    }
+
+    if ( flags & FTC_SBIT_RUN_FLAG_STRIP )
+    {
+      error = ftc_sbit_run_strip( run, memory );
+      if ( error )
+        goto Fail;
+    }
+
+    *arun = run;
+    return FT_Err_Ok;
+
+  Fail:
+    FTC_SBitRun_Done( run );
+
+  Exit:
+    return error;
+  }
+
+
+  /* documentation is in ftcache.h */
+
+  FT_EXPORT_DEF( void )
+  FTC_SBitRun_Done( FTC_SBitRun  run )
+  {
+    FT_Memory  memory;
+    FT_UInt    i;
+
+
+    if ( !run )
+      return;
+
+    memory = run->manager->memory;
+
+    for ( i = 0; i < run->num_nodes; i++ )
+      FTC_Node_Unref( run->nodes[i], run->manager );
+
+    FT_FREE( run->strip.buffer );
+    FT_FREE( run->nodes );
+    FT_FREE( run->sbits );
+    FT_FREE( run );
+  }
+
+
 /* END */
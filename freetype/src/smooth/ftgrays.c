@@ -434,6 +434,37 @@ typedef ptrdiff_t  FT_PtrDist;
 #define FT_MAX_GRAY_POOL  ( 2048 / sizeof ( TCell ) )
 #endif
 
+  /* Outlines whose clipped bounding box covers at least                  */
+  /* FT_GRAY_DENSE_MIN_AREA pixels are not scan-converted into sorted     */
+  /* cell lists but accumulated into a dense cover/area buffer, which is  */
+  /* then turned into coverage values row by row with a prefix sum.  The  */
+  /* buffer is kept by the raster object and never exceeds                */
+  /* FT_GRAY_DENSE_BAND_SIZE bytes; taller outlines are processed in      */
+  /* bands.  Both modes compute exactly the same coverage values.         */
+  /*                                                                      */
+  /* Define FT_GRAY_DENSE_MIN_AREA to 0 to disable the dense mode.        */
+#ifndef FT_GRAY_DENSE_MIN_AREA
+#define FT_GRAY_DENSE_MIN_AREA   ( 256 * 256 )
+#endif
+#ifndef FT_GRAY_DENSE_BAND_SIZE
+#define FT_GRAY_DENSE_BAND_SIZE  ( 512 * 1024L )
+#endif
+
+#if !defined( STANDALONE_ ) && FT_GRAY_DENSE_MIN_AREA > 0
+#define GRAY_DENSE
+
+  /* Each bit of the `touched' masks stands for four columns; this is */
+  /* the number of mask words per row.                                */
+#define GRAY_DENSE_WORDS( pitch )  ( ( (pitch) + 127 ) >> 7 )
+#endif
+
+#if defined( GRAY_DENSE )                                     && \
+    ( defined( __SSE2__ ) || defined( _M_X64 )                || \
+      ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )            )
+#define GRAY_DENSE_SSE2
+#include <emmintrin.h>
+#endif
+
 
 #if defined( _MSC_VER )      /* Visual C++ (and Intel C++) */
   /* We disable the warning `structure was padded due to   */
@@ -460,6 +491,12 @@ typedef ptrdiff_t  FT_PtrDist;
     FT_PtrDist  max_cells;
     FT_PtrDist  num_cells;
 
+#ifdef GRAY_DENSE
+    TArea*      dense;          /* non-NULL in dense accumulation mode */
+    FT_PtrDist  dense_pitch;    /* cover and area row length           */
+    FT_UInt32*  dense_touched;  /* column groups with recorded cells   */
+#endif
+
     TPos    x,  y;
 
     FT_Outline  outline;
@@ -486,6 +523,11 @@ typedef ptrdiff_t  FT_PtrDist;
   {
     void*         memory;
 
+#ifdef GRAY_DENSE
+    void*         dense;       /* accumulation buffer, kept zeroed */
+    FT_ULong      dense_size;
+#endif
+
   } gray_TRaster, *gray_PRaster;
 
 
@@ -527,6 +569,26 @@ typedef ptrdiff_t  FT_PtrDist;
     TCoord  x = ras.ex;
 
 
+#ifdef GRAY_DENSE
+    if ( ras.dense )
+    {
+      /* a cover row followed by an area row for each scanline; column 0 */
+      /* collects everything left of the clipping box                    */
+      FT_PtrDist  pitch = ras.dense_pitch;
+      FT_PtrDist  row   = ras.ey - ras.min_ey;
+      FT_PtrDist  col   = x - ras.min_ex + 1;
+      TArea*      p     = ras.dense + row * 2 * pitch + col;
+
+
+      p[0]     += ras.cover;
+      p[pitch] += ras.area;
+
+      ras.dense_touched[row * GRAY_DENSE_WORDS( pitch ) + ( col >> 7 )] |=
+        (FT_UInt32)1 << ( ( col >> 2 ) & 31 );
+      return;
+    }
+#endif
+
     pcell = &ras.ycells[ras.ey - ras.min_ey];
     for (;;)
     {
@@ -1328,6 +1390,178 @@ typedef ptrdiff_t  FT_PtrDist;
   }
 
 
+#ifdef GRAY_DENSE
+
+  /* Emit the pixels of columns `start'..`end'-1 of the dense buffer, */
+  /* which all have coverage `value'.  Column 0 is left of the        */
+  /* clipping box, and the last ones may be row padding.              */
+  static void
+  gray_dense_span( RAS_ARG_ TCoord      y,
+                            FT_PtrDist  start,
+                            FT_PtrDist  end,
+                            TArea       value )
+  {
+    FT_PtrDist  width = ras.max_ex - ras.min_ex;
+
+
+    if ( value == 0 )
+      return;
+
+    if ( start < 1 )
+      start = 1;
+    if ( end > width + 1 )
+      end = width + 1;
+
+    if ( end > start )
+      gray_hline( RAS_VAR_ ras.min_ex + (TCoord)start - 1, y,
+                           value, (TCoord)( end - start ) );
+  }
+
+
+  /* The dense counterpart of `gray_sweep'.  The coverage value of a  */
+  /* pixel is the running sum of the covers up to and including the   */
+  /* pixel, minus its area; runs of equal values are emitted as one   */
+  /* span.  Only the column groups flagged in the `touched' masks are */
+  /* looked at: the covers and areas of all others are zero.  The     */
+  /* buffer is cleared on the way for the next band or outline.       */
+  static void
+  gray_sweep_dense( RAS_ARG )
+  {
+    FT_PtrDist  pitch   = ras.dense_pitch;
+    FT_PtrDist  words   = GRAY_DENSE_WORDS( pitch );
+    TArea*      cover   = ras.dense;
+    FT_UInt32*  touched = ras.dense_touched;
+    int         y;
+
+
+    for ( y = ras.min_ey; y < ras.max_ey; y++, cover += 2 * pitch,
+                                               touched += words )
+    {
+      TArea*      area  = cover + pitch;
+      TArea       sum   = 0;  /* running sum of the covers */
+      TArea       value = 0;  /* value of the current run  */
+      FT_PtrDist  start = 0;  /* and its first column      */
+      FT_PtrDist  i     = 0;  /* next column to look at    */
+      FT_PtrDist  w;
+
+
+      for ( w = 0; w < words; w++ )
+      {
+        FT_UInt32   bits = touched[w];
+        FT_PtrDist  k    = w << 7;
+
+
+        touched[w] = 0;
+
+        for ( ; bits; bits >>= 1, k += 4 )
+        {
+          TArea  v[4];
+          int    j;
+
+
+          /* skip to the next flagged group */
+          if ( !( bits & 0xFFFF ) )
+          {
+            bits >>= 16;
+            k     += 64;
+          }
+          if ( !( bits & 0xFF ) )
+          {
+            bits >>= 8;
+            k     += 32;
+          }
+          if ( !( bits & 0xF ) )
+          {
+            bits >>= 4;
+            k     += 16;
+          }
+          if ( !( bits & 0x3 ) )
+          {
+            bits >>= 2;
+            k     += 8;
+          }
+          if ( !( bits & 0x1 ) )
+          {
+            bits >>= 1;
+            k     += 4;
+          }
+
+          /* columns i..k-1 are untouched */
+          if ( k > i && sum * ( ONE_PIXEL * 2 ) != value )
+          {
+            gray_dense_span( RAS_VAR_ y, start, i, value );
+
+            start = i;
+            value = sum * ( ONE_PIXEL * 2 );
+          }
+
+#ifdef GRAY_DENSE_SSE2
+
+          {
+            const __m128i  zero = _mm_setzero_si128();
+
+            __m128i  c = _mm_loadu_si128( (const __m128i*)( cover + k ) );
+            __m128i  a = _mm_loadu_si128( (const __m128i*)( area + k ) );
+
+
+            _mm_storeu_si128( (__m128i*)( cover + k ), zero );
+            _mm_storeu_si128( (__m128i*)( area + k ), zero );
+
+            /* in-register prefix sum, plus the previous pixels */
+            c = _mm_add_epi32( c, _mm_slli_si128( c, 4 ) );
+            c = _mm_add_epi32( c, _mm_slli_si128( c, 8 ) );
+            c = _mm_add_epi32( c, _mm_set1_epi32( sum ) );
+
+            sum = _mm_cvtsi128_si32(
+                    _mm_shuffle_epi32( c, _MM_SHUFFLE( 3, 3, 3, 3 ) ) );
+
+            c = _mm_sub_epi32( _mm_slli_epi32( c, PIXEL_BITS + 1 ), a );
+
+            _mm_storeu_si128( (__m128i*)v, c );
+          }
+
+#else /* !GRAY_DENSE_SSE2 */
+
+          for ( j = 0; j < 4; j++ )
+          {
+            sum         += cover[k + j];
+            v[j]         = sum * ( ONE_PIXEL * 2 ) - area[k + j];
+            cover[k + j] = 0;
+            area[k + j]  = 0;
+          }
+
+#endif /* !GRAY_DENSE_SSE2 */
+
+          for ( j = 0; j < 4; j++ )
+          {
+            if ( v[j] != value )
+            {
+              gray_dense_span( RAS_VAR_ y, start, k + j, value );
+
+              start = k + j;
+              value = v[j];
+            }
+          }
+
+          i = k + 4;
+        }
+      }
+
+      if ( pitch > i && sum * ( ONE_PIXEL * 2 ) != value )
+      {
+        gray_dense_span( RAS_VAR_ y, start, i, value );
+
+        start = i;
+        value = sum * ( ONE_PIXEL * 2 );
+      }
+
+      gray_dense_span( RAS_VAR_ y, start, pitch, value );
+    }
+  }
+
+#endif /* GRAY_DENSE */
+
+
 #ifdef STANDALONE_
 
   /*************************************************************************/
@@ -1821,6 +2055,77 @@ typedef ptrdiff_t  FT_PtrDist;
   }
 
 
+#ifdef GRAY_DENSE
+
+  /* Render the outline in dense accumulation mode.  Returns          */
+  /* ErrRaster_Memory_Overflow if the buffer can't be set up, in which */
+  /* case the caller falls back to `gray_convert_glyph'.               */
+  static int
+  gray_convert_glyph_dense( RAS_ARG_ gray_PRaster  raster )
+  {
+    FT_Memory  memory = (FT_Memory)raster->memory;
+    FT_Error   error;
+
+    const TCoord  yMin = ras.min_ey;
+    const TCoord  yMax = ras.max_ey;
+
+    /* one extra column for the cells left of the clipping box, */
+    /* and a multiple of 4 for `gray_sweep_dense'                */
+    FT_PtrDist  pitch = ( ras.max_ex - ras.min_ex + 1 + 3 ) & ~3;
+    FT_ULong    row   = 2 * (FT_ULong)pitch * sizeof ( TArea ) +
+                        GRAY_DENSE_WORDS( pitch ) * sizeof ( FT_UInt32 );
+    FT_ULong    height;
+    TCoord      y;
+
+
+    height = FT_GRAY_DENSE_BAND_SIZE / row;
+    if ( height == 0 )
+      return ErrRaster_Memory_Overflow;
+    if ( height > (FT_ULong)( yMax - yMin ) )
+      height = (FT_ULong)( yMax - yMin );
+
+    if ( raster->dense_size < height * row )
+    {
+      FT_FREE( raster->dense );
+      raster->dense_size = 0;
+
+      /* FT_ALLOC zeroes the block */
+      if ( FT_ALLOC( raster->dense, height * row ) )
+        return ErrRaster_Memory_Overflow;
+
+      raster->dense_size = height * row;
+    }
+
+    ras.dense         = (TArea*)raster->dense;
+    ras.dense_pitch   = pitch;
+    ras.dense_touched = (FT_UInt32*)( ras.dense + height * 2 * pitch );
+
+    for ( y = yMin; y < yMax; )
+    {
+      ras.min_ey = y;
+      y         += (TCoord)height;
+      ras.max_ey = FT_MIN( y, yMax );
+
+      ras.num_cells = 0;
+      ras.invalid   = 1;
+
+      if ( gray_convert_glyph_inner( RAS_VAR ) )
+      {
+        FT_MEM_ZERO( raster->dense, raster->dense_size );
+        ras.dense = NULL;
+        return 1;
+      }
+
+      gray_sweep_dense( RAS_VAR );
+    }
+
+    ras.dense = NULL;
+    return 0;
+  }
+
+#endif /* GRAY_DENSE */
+
+
   static int
   gray_raster_render( FT_Raster                raster,
                       const FT_Raster_Params*  params )
@@ -1931,6 +2236,20 @@ typedef ptrdiff_t  FT_PtrDist;
     if ( ras.max_ex <= ras.min_ex || ras.max_ey <= ras.min_ey )
       return 0;
 
+#ifdef GRAY_DENSE
+    ras.dense = NULL;
+
+    if ( (FT_ULong)( ras.max_ex - ras.min_ex ) *
+           (FT_ULong)( ras.max_ey - ras.min_ey ) >= FT_GRAY_DENSE_MIN_AREA )
+    {
+      int  error = gray_convert_glyph_dense( RAS_VAR_ (gray_PRaster)raster );
+
+
+      if ( error != ErrRaster_Memory_Overflow )
+        return error;
+    }
+#endif
+
     return gray_convert_glyph( RAS_VAR );
   }
 
@@ -1990,6 +2309,9 @@ typedef ptrdiff_t  FT_PtrDist;
     FT_Memory  memory = (FT_Memory)((gray_PRaster)raster)->memory;
 
 
+#ifdef GRAY_DENSE
+    FT_FREE( ((gray_PRaster)raster)->dense );
+#endif
     FT_FREE( raster );
   }
 
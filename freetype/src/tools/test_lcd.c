@@ -0,0 +1,186 @@
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_LCD_FILTER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#include <time.h>    /* for clock() */
+
+/* SunOS 4.1.* does not define CLOCKS_PER_SEC, so include <sys/param.h> */
+/* to get the HZ macro which is the equivalent.                         */
+#if defined(__sun__) && !defined(SVR4) && !defined(__SVR4)
+#include <sys/param.h>
+#define CLOCKS_PER_SEC HZ
+#endif
+
+  static long
+  get_time( void )
+  {
+    return clock() * 10000L / CLOCKS_PER_SEC;
+  }
+
+
+
+
+  /* time subpixel rendering with the LCD filters;                   */
+  /* the checksums must not depend on how FreeType has been compiled */
+
+  /* Latin, then CJK Unified Ideographs */
+  static const FT_ULong  ranges[][2] =
+  {
+    { 0x0020, 0x007E },
+    { 0x00A0, 0x024F },
+    { 0x4E00, 0x9FFF }
+  };
+
+  static FT_UInt*  glyphs;
+  static FT_UInt   num_glyphs;
+
+
+  static void
+  collect_glyphs( FT_Face  face )
+  {
+    size_t    r;
+    FT_ULong  code;
+
+
+    glyphs = (FT_UInt*)malloc( 0x6000 * sizeof ( FT_UInt ) );
+    if ( !glyphs )
+    {
+      fprintf( stderr, "not enough memory\n" );
+      exit( 1 );
+    }
+
+    for ( r = 0; r < sizeof ( ranges ) / sizeof ( ranges[0] ); r++ )
+      for ( code = ranges[r][0]; code <= ranges[r][1]; code++ )
+      {
+        FT_UInt  gindex = FT_Get_Char_Index( face, code );
+
+
+        if ( gindex )
+          glyphs[num_glyphs++] = gindex;
+      }
+  }
+
+
+  static void
+  profile_filter( FT_Face         face,
+                  FT_Render_Mode  mode,
+                  const char*     name,
+                  long            repeat )
+  {
+    unsigned long  checksum = 0;
+    unsigned long  bytes    = 0;
+    long           count;
+    long           time0;
+    FT_UInt        n;
+
+
+    time0 = get_time();
+    for ( count = repeat; count > 0; count-- )
+      for ( n = 0; n < num_glyphs; n++ )
+      {
+        FT_Bitmap*    bitmap;
+        unsigned int  y, x;
+
+
+        if ( FT_Load_Glyph( face, glyphs[n], FT_LOAD_TARGET_LCD ) ||
+             FT_Render_Glyph( face->glyph, mode )                  )
+          continue;
+
+        if ( count > 1 )
+          continue;
+
+        bitmap = &face->glyph->bitmap;
+        bytes += bitmap->rows * bitmap->width;
+
+        for ( y = 0; y < bitmap->rows; y++ )
+          for ( x = 0; x < bitmap->width; x++ )
+            checksum = checksum * 31 +
+                       bitmap->buffer[y * bitmap->pitch + x];
+      }
+
+    time0 = get_time() - time0;
+    printf( "  %-8s time = %7.3f  %8.1f glyphs/s  %6.1f MB/s  sum = %08lX\n",
+            name,
+            (double)time0 / 10000.0,
+            time0 ? (double)num_glyphs * repeat * 10000.0 / time0 : 0.0,
+            time0 ? (double)bytes * repeat * 10000.0 / time0 / 1e6 : 0.0,
+            checksum & 0xFFFFFFFFUL );
+  }
+
+
+#define REPEAT  10L
+
+  int  main( int  argc, char**  argv )
+  {
+    static const int  default_sizes[] = { 12, 16, 24, 32, 48, 0 };
+
+    /* large weights, to check the clamping */
+    static unsigned char  heavy_weights[5] = { 0x40, 0x80, 0xC0, 0x80, 0x40 };
+
+    FT_Library  library;
+    FT_Face     face;
+    int         i;
+
+
+    if ( argc < 2 )
+    {
+      fprintf( stderr, "usage: test_lcd font [size ...]\n" );
+      return 1;
+    }
+
+    if ( FT_Init_FreeType( &library )               ||
+         FT_New_Face( library, argv[1], 0, &face ) )
+    {
+      fprintf( stderr, "could not open `%s'\n", argv[1] );
+      return 1;
+    }
+
+    if ( FT_Library_SetLcdFilter( library, FT_LCD_FILTER_DEFAULT ) )
+    {
+      fprintf( stderr, "FreeType was compiled without LCD filtering\n" );
+      return 1;
+    }
+
+    collect_glyphs( face );
+    printf( "%u glyphs\n", num_glyphs );
+
+    for ( i = 0; argc > 2 ? i < argc - 2 : default_sizes[i] != 0; i++ )
+    {
+      int  size = argc > 2 ? atoi( argv[i + 2] ) : default_sizes[i];
+      int  m;
+
+
+      FT_Set_Pixel_Sizes( face, 0, (FT_UInt)size );
+
+      for ( m = 0; m < 2; m++ )
+      {
+        FT_Render_Mode  mode = m ? FT_RENDER_MODE_LCD_V
+                                 : FT_RENDER_MODE_LCD;
+
+
+        printf( "%dpx %s\n", size, m ? "LCD_V" : "LCD" );
+
+        FT_Library_SetLcdFilter( library, FT_LCD_FILTER_NONE );
+        profile_filter( face, mode, "none", REPEAT );
+
+        FT_Library_SetLcdFilter( library, FT_LCD_FILTER_DEFAULT );
+        profile_filter( face, mode, "default", REPEAT );
+
+        FT_Library_SetLcdFilter( library, FT_LCD_FILTER_LIGHT );
+        profile_filter( face, mode, "light", REPEAT );
+
+        FT_Library_SetLcdFilterWeights( library, heavy_weights );
+        profile_filter( face, mode, "heavy", REPEAT );
+      }
+    }
+
+    FT_Done_Face( face );
+    FT_Done_FreeType( library );
+    free( glyphs );
+
+    return 0;
+  }
@@ -828,6 +828,59 @@ static int _XPutPixel1 (
  *
  */
 
+/*
+ * Copies a width by height block of pixels from (sx, sy) in one ZPixmap
+ * image to (dx, dy) in another a scanline at a time, when both images
+ * have the same byte order, depth and whole-byte pixel size, so that the
+ * result is the same as going through XGetPixel and XPutPixel.  Returns
+ * 0 without touching anything if the images don't qualify.
+ */
+static int
+_XCopyZRows (
+    XImage *srcimg,
+    int sx,
+    int sy,
+    XImage *dstimg,
+    int dx,
+    int dy,
+    int width,
+    int height)
+{
+	int bpp = srcimg->bits_per_pixel;
+	int row, nbytes;
+	register unsigned char *src, *dst;
+
+	if ((srcimg->format != ZPixmap) || (dstimg->format != ZPixmap) ||
+	    (dstimg->bits_per_pixel != bpp) || (bpp & 7) ||
+	    (srcimg->byte_order != dstimg->byte_order) ||
+	    (srcimg->depth != dstimg->depth))
+	    return 0;
+	/*
+	 * XGetPixel masks off the unused bits of a pixel; the only such
+	 * format common enough to bother with is depth 24 in 32 bits.
+	 */
+	if ((srcimg->depth != bpp) && !((bpp == 32) && (srcimg->depth == 24)))
+	    return 0;
+	if ((width <= 0) || (height <= 0))
+	    return 1;
+
+	nbytes = width * (bpp >> 3);
+	for (row = 0; row < height; row++) {
+	    src = (unsigned char *)&srcimg->data[ZINDEX(sx, sy + row, srcimg)];
+	    dst = (unsigned char *)&dstimg->data[ZINDEX(dx, dy + row, dstimg)];
+	    memcpy(dst, src, nbytes);
+	    if (srcimg->depth != bpp) {
+		register int n;
+
+		if (dstimg->byte_order == LSBFirst)
+		    dst += 3;
+		for (n = width; --n >= 0; dst += 4)
+		    *dst = 0;
+	    }
+	}
+	return 1;
+}
+
 static XImage *_XSubImage (
     XImage *ximage,
     register int x,	/* starting x coordinate in existing image */
@@ -883,6 +936,9 @@ static XImage *_XSubImage (
 	if (height > ximage->height - y ) height = ximage->height - y;
 	if (width > ximage->width - x ) width = ximage->width - x;
 
+	if (_XCopyZRows(ximage, x, y, subimage, 0, 0, width, height))
+	    return subimage;
+
 	for (row = y; row < (y + height); row++) {
 	    for (col = x; col < (x + width); col++) {
 		pixel = XGetPixel(ximage, col, row);
@@ -942,6 +998,11 @@ int _XSetImage(
 	if (srcimg->height < height)
 	    height = srcimg->height;
 
+	if (_XCopyZRows(srcimg, startcol, startrow, dstimg,
+			x + startcol, y + startrow,
+			width - startcol, height - startrow))
+	    return 1;
+
 	/* this is slow, will do better later */
 	for (row = startrow; row < height; row++) {
 	    for (col = startcol; col < width; col++) {
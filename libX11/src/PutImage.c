@@ -47,6 +47,81 @@ in this Software without prior written authorization from The Open Group.
 /* assumes pad is a power of 2 */
 #define ROUNDUP(nbytes, pad) (((nbytes) + ((pad) - 1)) & ~(long)((pad) - 1))
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define USE_SSE2
+
+/*
+ * Vector versions of the inner loops of SwapTwoBytes, SwapFourBytes and
+ * SwapBits, i.e. 16bpp, 32bpp and 1bpp images of the other byte or bit
+ * order.  They convert as many whole 16 byte blocks of a scanline as
+ * there are and return the number of bytes done; the scalar loops
+ * finish the rest.
+ */
+static long
+SwapTwoBytesSSE2(
+    const unsigned char *src,
+    unsigned char *dest,
+    long length)
+{
+    long n;
+
+    for (n = 0; n + 16 <= length; n += 16) {
+	__m128i v = _mm_loadu_si128((const __m128i *)(src + n));
+
+	v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	_mm_storeu_si128((__m128i *)(dest + n), v);
+    }
+    return n;
+}
+
+static long
+SwapFourBytesSSE2(
+    const unsigned char *src,
+    unsigned char *dest,
+    long length)
+{
+    long n;
+
+    for (n = 0; n + 16 <= length; n += 16) {
+	__m128i v = _mm_loadu_si128((const __m128i *)(src + n));
+
+	/* swap the 16-bit halves of each unit, then the bytes of each half */
+	v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+	v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+	v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	_mm_storeu_si128((__m128i *)(dest + n), v);
+    }
+    return n;
+}
+
+static long
+SwapBitsSSE2(
+    const unsigned char *src,
+    unsigned char *dest,
+    long length)
+{
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0f);
+    long n;
+
+    /* the masks drop whatever the 16-bit shifts carry across bytes */
+    for (n = 0; n + 16 <= length; n += 16) {
+	__m128i v = _mm_loadu_si128((const __m128i *)(src + n));
+
+	v = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 1), m1),
+			 _mm_slli_epi16(_mm_and_si128(v, m1), 1));
+	v = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 2), m2),
+			 _mm_slli_epi16(_mm_and_si128(v, m2), 2));
+	v = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 4), m4),
+			 _mm_slli_epi16(_mm_and_si128(v, m4), 4));
+	_mm_storeu_si128((__m128i *)(dest + n), v);
+    }
+    return n;
+}
+#endif
+
 static unsigned char const _reverse_byte[0x100] = {
 	0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0,
 	0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0,
@@ -176,7 +251,15 @@ SwapTwoBytes (
 	    else
 		*(dest + length + 1) = *(src + length);
 	}
-	for (n = length; n > 0; n -= 2, src += 2) {
+#ifdef USE_SSE2
+	n = SwapTwoBytesSSE2(src, dest, length);
+	src += n;
+	dest += n;
+	n = length - n;
+#else
+	n = length;
+#endif
+	for (; n > 0; n -= 2, src += 2) {
 	    *dest++ = *(src + 1);
 	    *dest++ = *src;
 	}
@@ -241,7 +324,15 @@ SwapFourBytes (
 	    if (half_order == LSBFirst)
 		*(dest + length + 3) = *(src + length);
 	}
-	for (n = length; n > 0; n -= 4, src += 4) {
+#ifdef USE_SSE2
+	n = SwapFourBytesSSE2(src, dest, length);
+	src += n;
+	dest += n;
+	n = length - n;
+#else
+	n = length;
+#endif
+	for (; n > 0; n -= 4, src += 4) {
 	    *dest++ = *(src + 3);
 	    *dest++ = *(src + 2);
 	    *dest++ = *(src + 1);
@@ -347,9 +438,18 @@ SwapBits(
 
     srcinc -= srclen;
     destinc -= srclen;
-    for (h = height; --h >= 0; src += srcinc, dest += destinc)
-	for (n = srclen; --n >= 0; )
+    for (h = height; --h >= 0; src += srcinc, dest += destinc) {
+#ifdef USE_SSE2
+	n = SwapBitsSSE2(src, dest, srclen);
+	src += n;
+	dest += n;
+	n = srclen - n;
+#else
+	n = srclen;
+#endif
+	while (--n >= 0)
 	    *dest++ = rev[*src++];
+    }
 }
 
 static void
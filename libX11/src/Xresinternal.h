@@ -14,5 +14,9 @@ extern XrmQuark _XrmInternalStringToQuark(
     register _Xconst char *name, register int len, register Signature sig,
     Bool permstring);
 
+/* for the toolkits: changes whenever the database does */
+extern unsigned int _XrmDatabaseSerial(
+    XrmDatabase database);
+
 #endif /* _XRESOURCEINTERNAL_H_ */
 /* DON'T ADD STUFF AFTER THIS #endif */
@@ -175,6 +175,44 @@ typedef struct _LTable {
 
 #define LeafHash(le,q) (le)->buckets[(q) & (le)->table.mask]
 
+/* Widget sets ask for the same resources over and over: every instance
+ * of a class with the same name repeats the same queries.  Each database
+ * remembers recent XrmQGetResource and XrmQGetSearchList results, keyed
+ * by the name and class lists, in small direct-mapped caches.  Any change
+ * to the database bumps its serial, which invalidates all of them.
+ * Lookups deeper than CACHE_DEPTH, and search lists longer than
+ * CACHE_LIST, are simply not cached.
+ */
+#define CACHE_SIZE	64		/* entries, power of 2 */
+#define CACHE_DEPTH	8		/* names per lookup */
+#define CACHE_LIST	24		/* tables per search list */
+
+typedef struct _CacheKey {
+    unsigned int	hash;
+    int			depth;
+    XrmQuark		quarks[2 * CACHE_DEPTH];	/* names, classes */
+} CacheKeyRec, *CacheKey;
+
+typedef struct _ResCacheEntry {
+    unsigned int	serial;		/* database serial when filled */
+    Bool		found;
+    CacheKeyRec		key;
+    XrmRepresentation	type;
+    XrmValue		value;
+} ResCacheEntry;
+
+typedef struct _ListCacheEntry {
+    unsigned int	serial;		/* database serial when filled */
+    int			length;		/* tables in list */
+    CacheKeyRec		key;
+    LTable		list[CACHE_LIST];
+} ListCacheEntry;
+
+typedef struct _XrmCache {
+    ResCacheEntry	res[CACHE_SIZE];
+    ListCacheEntry	lists[CACHE_SIZE];
+} XrmCacheRec, *XrmCache;
+
 /* An XrmDatabase just holds a pointer to the first top-level table.
  * The type name is no longer descriptive, but better to not change
  * the Xresource.h header file.  This type also gets used to define
@@ -185,6 +223,8 @@ typedef struct _XrmHashBucketRec {
     NTable table;
     XPointer mbstate;
     XrmMethods methods;
+    XrmCache cache;		/* allocated on first lookup */
+    unsigned int serial;	/* bumped on every change */
 #ifdef XTHREADS
     LockInfoRec linfo;
 #endif
@@ -493,6 +533,7 @@ static const XrmMethodsRec mb_methods = {
 
 static XrmDatabase NewDatabase(void)
 {
+    static unsigned int next_serial;
     register XrmDatabase db;
 
     db = Xmalloc(sizeof(XrmHashBucketRec));
@@ -500,6 +541,15 @@ static XrmDatabase NewDatabase(void)
 	_XCreateMutex(&db->linfo);
 	db->table = (NTable)NULL;
 	db->mbstate = (XPointer)NULL;
+	db->cache = (XrmCache)NULL;
+	/* spread the serials out, so that a database allocated where
+	 * a destroyed one used to be doesn't pick up where it left off */
+	_XLockMutex(_Xglobal_lock);
+	next_serial += 0x10000;
+	if (!next_serial)
+	    next_serial = 0x10000;
+	db->serial = next_serial;
+	_XUnlockMutex(_Xglobal_lock);
 	db->methods = _XrmInitParseInfo(&db->mbstate);
 	if (!db->methods)
 	    db->methods = &mb_methods;
@@ -507,6 +557,18 @@ static XrmDatabase NewDatabase(void)
     return db;
 }
 
+/* forget all cached lookups, the database is about to change */
+static void FlushCache(
+    XrmDatabase db)
+{
+    if (!++db->serial) {
+	/* wrapped around, so old entries could look current */
+	if (db->cache)
+	    memset(db->cache, 0, sizeof(XrmCacheRec));
+	db->serial = 1;
+    }
+}
+
 /* move all values from ftable to ttable, and free ftable's buckets.
  * ttable is guaranteed empty to start with.
  */
@@ -768,6 +830,7 @@ void XrmCombineDatabase(
     } else if (from) {
 	_XLockMutex(&from->linfo);
 	_XLockMutex(&(*into)->linfo);
+	FlushCache(*into);
 	if ((ftable = from->table)) {
 	    prev = &(*into)->table;
 	    ttable = *prev;
@@ -801,6 +864,7 @@ void XrmCombineDatabase(
 	(from->methods->destroy)(from->mbstate);
 	_XUnlockMutex(&from->linfo);
 	_XFreeMutex(&from->linfo);
+	Xfree(from->cache);
 	Xfree(from);
 	_XUnlockMutex(&(*into)->linfo);
     }
@@ -853,6 +917,7 @@ static void PutEntry(
 
     if (!db || !*quarks)
 	return;
+    FlushCache(db);
     table = *(prev = &db->table);
     /* if already at leaf, bump to the leaf table */
     if (!quarks[1] && table && !table->leaf)
@@ -2252,6 +2317,59 @@ static Bool SearchNEntry(
     return False;
 }
 
+/* build the cache key for a lookup, False if it is too deep to cache */
+static Bool MakeCacheKey(
+    XrmNameList		names,
+    XrmClassList	classes,
+    CacheKey		key)
+{
+    register unsigned int hash = 0;
+    register int i;
+
+    for (i = 0; names[i]; i++) {
+	if (i == CACHE_DEPTH)
+	    return False;
+	key->quarks[2 * i] = names[i];
+	key->quarks[2 * i + 1] = classes[i];
+	hash = (hash * 31 + names[i]) * 31 + classes[i];
+    }
+    key->hash = hash;
+    key->depth = i;
+    return True;
+}
+
+static Bool SameCacheKey(
+    CacheKey	a,
+    CacheKey	b)
+{
+    return a->hash == b->hash && a->depth == b->depth &&
+	   !memcmp(a->quarks, b->quarks, 2 * a->depth * sizeof(XrmQuark));
+}
+
+/* the database's cache, allocating it if need be */
+static XrmCache GetCache(
+    XrmDatabase db)
+{
+    if (!db->cache)
+	db->cache = Xcalloc(1, sizeof(XrmCacheRec));
+    return db->cache;
+}
+
+/* lets callers that keep lookup results of their own notice changes */
+unsigned int
+_XrmDatabaseSerial(
+    XrmDatabase db)
+{
+    unsigned int serial = 0;
+
+    if (db) {
+	_XLockMutex(&db->linfo);
+	serial = db->serial;
+	_XUnlockMutex(&db->linfo);
+    }
+    return serial;
+}
+
 Bool XrmQGetSearchList(
     XrmDatabase     db,
     XrmNameList	    names,
@@ -2261,6 +2379,9 @@ Bool XrmQGetSearchList(
 {
     register NTable	table;
     SClosureRec		closure;
+    CacheKeyRec		key;
+    ListCacheEntry	*ce = NULL;
+    XrmCache		cache;
 
     if (listLength <= 0)
 	return False;
@@ -2269,6 +2390,17 @@ Bool XrmQGetSearchList(
     closure.limit = listLength - 2;
     if (db) {
 	_XLockMutex(&db->linfo);
+	if (MakeCacheKey(names, classes, &key) && (cache = GetCache(db))) {
+	    ce = &cache->lists[key.hash & (CACHE_SIZE - 1)];
+	    if (ce->serial == db->serial && SameCacheKey(&ce->key, &key) &&
+		ce->length < listLength) {
+		memcpy(searchList, ce->list, ce->length * sizeof(LTable));
+		closure.idx = ce->length - 1;
+		_XUnlockMutex(&db->linfo);
+		closure.list[closure.idx + 1] = (LTable)NULL;
+		return True;
+	    }
+	}
 	table = db->table;
 	if (*names) {
 	    if (table && !table->leaf) {
@@ -2291,6 +2423,12 @@ Bool XrmQGetSearchList(
 		return False;
 	    }
 	}
+	if (ce && closure.idx < CACHE_LIST) {
+	    ce->serial = db->serial;
+	    ce->key = key;
+	    ce->length = closure.idx + 1;
+	    memcpy(ce->list, closure.list, ce->length * sizeof(LTable));
+	}
 	_XUnlockMutex(&db->linfo);
     }
     closure.list[closure.idx + 1] = (LTable)NULL;
@@ -2544,32 +2682,51 @@ Bool XrmQGetResource(
 {
     register NTable table;
     VClosureRec closure;
+    CacheKeyRec key;
+    ResCacheEntry *ce = NULL;
+    XrmCache cache;
+    Bool found = False;
 
     if (db && *names) {
 	_XLockMutex(&db->linfo);
+	if (MakeCacheKey(names, classes, &key) && (cache = GetCache(db))) {
+	    ce = &cache->res[key.hash & (CACHE_SIZE - 1)];
+	    if (ce->serial == db->serial && SameCacheKey(&ce->key, &key)) {
+		*pType = ce->type;
+		*pValue = ce->value;
+		found = ce->found;
+		_XUnlockMutex(&db->linfo);
+		return found;
+	    }
+	}
 	closure.type = pType;
 	closure.value = pValue;
 	table = db->table;
 	if (names[1]) {
-	    if (table && !table->leaf) {
-		if (GetNEntry(table, names, classes, &closure)) {
-		    _XUnlockMutex(&db->linfo);
-		    return True;
-		}
-	    } else if (table && table->hasloose &&
-		    GetLooseVEntry((LTable)table, names, classes, &closure)) {
-		_XUnlockMutex (&db->linfo);
-		return True;
-	    }
+	    if (table && !table->leaf)
+		found = GetNEntry(table, names, classes, &closure);
+	    else if (table && table->hasloose)
+		found = GetLooseVEntry((LTable)table, names, classes, &closure);
 	} else {
 	    if (table && !table->leaf)
 		table = table->next;
-	    if (table && GetVEntry((LTable)table, names, classes, &closure)) {
-		_XUnlockMutex(&db->linfo);
-		return True;
-	    }
+	    if (table)
+		found = GetVEntry((LTable)table, names, classes, &closure);
+	}
+	if (!found) {
+	    *pType = NULLQUARK;
+	    pValue->addr = (XPointer)NULL;
+	    pValue->size = 0;
+	}
+	if (ce) {
+	    ce->serial = db->serial;
+	    ce->key = key;
+	    ce->found = found;
+	    ce->type = *pType;
+	    ce->value = *pValue;
 	}
 	_XUnlockMutex(&db->linfo);
+	return found;
     }
     *pType = NULLQUARK;
     pValue->addr = (XPointer)NULL;
@@ -2661,6 +2818,7 @@ void XrmDestroyDatabase(
 	_XUnlockMutex(&db->linfo);
 	_XFreeMutex(&db->linfo);
 	(*db->methods->destroy)(db->mbstate);
+	Xfree(db->cache);
 	Xfree(db);
     }
 }
@@ -17,15 +17,18 @@
 
 typedef struct PendingRequest PendingRequest;
 struct PendingRequest {
-	PendingRequest *next;
 	uint64_t sequence;
 	unsigned reply_waiter;
 };
 
 typedef struct _X11XCBPrivate {
 	xcb_connection_t *connection;
+	/* ring of pending_requests_size entries, a power of two; entries
+	 * move when it grows, so don't keep pointers across unlocks */
 	PendingRequest *pending_requests;
-	PendingRequest *pending_requests_tail;
+	unsigned pending_requests_size;
+	unsigned pending_requests_head;
+	unsigned pending_requests_count;
 	xcb_generic_event_t *next_event;
 	char *real_bufmax;
 	char *reply_data;
@@ -96,12 +96,7 @@ void _XFreeX11XCBStructure(Display *dpy)
 {
 	/* reply_data was allocated by system malloc, not Xmalloc */
 	free(dpy->xcb->reply_data);
-	while(dpy->xcb->pending_requests)
-	{
-		PendingRequest *tmp = dpy->xcb->pending_requests;
-		dpy->xcb->pending_requests = tmp->next;
-		free(tmp);
-	}
+	free(dpy->xcb->pending_requests);
 	xcondition_free(dpy->xcb->event_notify);
 	xcondition_free(dpy->xcb->reply_notify);
 	Xfree(dpy->xcb);
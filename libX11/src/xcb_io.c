@@ -134,55 +134,78 @@ static void check_internal_connections(Display *dpy)
 		}
 }
 
+/* The pending requests are kept in a ring, oldest first, so that
+ * queueing one costs no allocation once the ring is big enough. */
+static PendingRequest *first_pending_request(Display *dpy)
+{
+	if(!dpy->xcb->pending_requests_count)
+		return NULL;
+	return &dpy->xcb->pending_requests[dpy->xcb->pending_requests_head];
+}
+
+static PendingRequest *last_pending_request(Display *dpy)
+{
+	unsigned last;
+	if(!dpy->xcb->pending_requests_count)
+		return NULL;
+	last = dpy->xcb->pending_requests_head + dpy->xcb->pending_requests_count - 1;
+	return &dpy->xcb->pending_requests[last & (dpy->xcb->pending_requests_size - 1)];
+}
+
+static void grow_pending_requests(Display *dpy)
+{
+	unsigned size = dpy->xcb->pending_requests_size;
+	unsigned head = dpy->xcb->pending_requests_head;
+	unsigned new_size = size ? size * 2 : 64;
+	PendingRequest *ring = malloc(new_size * sizeof(PendingRequest));
+	assert(ring!=NULL);
+	if(size)
+	{
+		/* unwrap, oldest first */
+		memcpy(ring, dpy->xcb->pending_requests + head,
+		       (size - head) * sizeof(PendingRequest));
+		memcpy(ring + size - head, dpy->xcb->pending_requests,
+		       head * sizeof(PendingRequest));
+	}
+	free(dpy->xcb->pending_requests);
+	dpy->xcb->pending_requests = ring;
+	dpy->xcb->pending_requests_size = new_size;
+	dpy->xcb->pending_requests_head = 0;
+}
+
 static PendingRequest *append_pending_request(Display *dpy, uint64_t sequence)
 {
-	PendingRequest *node = malloc(sizeof(PendingRequest));
-	assert(node!=NULL);
-	node->next = NULL;
+	PendingRequest *tail = last_pending_request(dpy);
+	PendingRequest *node;
+	if(tail && XLIB_SEQUENCE_COMPARE(tail->sequence, >=, sequence))
+		throw_thread_fail_assert("Unknown sequence number "
+		                         "while appending request",
+		                         xcb_xlib_unknown_seq_number);
+	if(dpy->xcb->pending_requests_count == dpy->xcb->pending_requests_size)
+		grow_pending_requests(dpy);
+	++dpy->xcb->pending_requests_count;
+	node = last_pending_request(dpy);
 	node->sequence = sequence;
 	node->reply_waiter = 0;
-	if(dpy->xcb->pending_requests_tail)
-	{
-		if (XLIB_SEQUENCE_COMPARE(dpy->xcb->pending_requests_tail->sequence,
-		                          >=, node->sequence))
-			throw_thread_fail_assert("Unknown sequence number "
-			                         "while appending request",
-			                         xcb_xlib_unknown_seq_number);
-		if (dpy->xcb->pending_requests_tail->next != NULL)
-			throw_thread_fail_assert("Unknown request in queue "
-			                         "while appending request",
-			                         xcb_xlib_unknown_req_pending);
-		dpy->xcb->pending_requests_tail->next = node;
-	}
-	else
-		dpy->xcb->pending_requests = node;
-	dpy->xcb->pending_requests_tail = node;
 	return node;
 }
 
 static void dequeue_pending_request(Display *dpy, PendingRequest *req)
 {
-	if (req != dpy->xcb->pending_requests)
+	PendingRequest *next;
+	if (req != first_pending_request(dpy))
 		throw_thread_fail_assert("Unknown request in queue while "
 		                         "dequeuing",
 		                         xcb_xlib_unknown_req_in_deq);
 
-	dpy->xcb->pending_requests = req->next;
-	if(!dpy->xcb->pending_requests)
-	{
-		if (req != dpy->xcb->pending_requests_tail)
-			throw_thread_fail_assert("Unknown request in queue "
-			                         "while dequeuing",
-			                         xcb_xlib_unknown_req_in_deq);
-		dpy->xcb->pending_requests_tail = NULL;
-	}
-	else if (XLIB_SEQUENCE_COMPARE(req->sequence, >=,
-	                               dpy->xcb->pending_requests->sequence))
+	dpy->xcb->pending_requests_head = (dpy->xcb->pending_requests_head + 1) &
+	                                  (dpy->xcb->pending_requests_size - 1);
+	--dpy->xcb->pending_requests_count;
+	next = first_pending_request(dpy);
+	if (next && XLIB_SEQUENCE_COMPARE(req->sequence, >=, next->sequence))
 		throw_thread_fail_assert("Unknown sequence number while "
 		                         "dequeuing request",
 		                         xcb_xlib_threads_sequence_lost);
-
-	free(req);
 }
 
 static int handle_error(Display *dpy, xError *err, Bool in_XReply)
@@ -250,7 +273,7 @@ static xcb_generic_reply_t *poll_for_event(Display *dpy, Bool queued_only)
 
 	if(dpy->xcb->next_event)
 	{
-		PendingRequest *req = dpy->xcb->pending_requests;
+		PendingRequest *req = first_pending_request(dpy);
 		xcb_generic_event_t *event = dpy->xcb->next_event;
 		uint64_t event_sequence = X_DPY_GET_LAST_REQUEST_READ(dpy);
 		widen(&event_sequence, event->full_sequence);
@@ -279,7 +302,7 @@ static xcb_generic_reply_t *poll_for_response(Display *dpy)
 	xcb_generic_error_t *error;
 	PendingRequest *req;
 	while(!(response = poll_for_event(dpy, False)) &&
-	      (req = dpy->xcb->pending_requests) &&
+	      (req = first_pending_request(dpy)) &&
 	      !req->reply_waiter)
 	{
 		uint64_t request;
@@ -426,7 +449,7 @@ void _XReadEvents(Display *dpy)
 		response = poll_for_response(dpy);
 		if(response)
 			handle_response(dpy, response, False);
-		else if(dpy->xcb->pending_requests->reply_waiter)
+		else if(first_pending_request(dpy)->reply_waiter)
 		{ /* need braces around ConditionWait */
 			ConditionWait(dpy, dpy->xcb->reply_notify);
 		}
@@ -577,6 +600,7 @@ Status _XReply(Display *dpy, xReply *rep, int extra, Bool discard)
 	xcb_connection_t *c = dpy->xcb->connection;
 	char *reply;
 	PendingRequest *current;
+	uint64_t reply_sequence;
 	uint64_t dpy_request;
 
 	if (dpy->xcb->reply_data)
@@ -587,21 +611,20 @@ Status _XReply(Display *dpy, xReply *rep, int extra, Bool discard)
 		return 0;
 
 	_XSend(dpy, NULL, 0);
-	dpy_request = X_DPY_GET_REQUEST(dpy);
-	if(dpy->xcb->pending_requests_tail
-	   && dpy->xcb->pending_requests_tail->sequence == dpy_request)
-		current = dpy->xcb->pending_requests_tail;
-	else
-		current = append_pending_request(dpy, dpy_request);
+	reply_sequence = X_DPY_GET_REQUEST(dpy);
+	current = last_pending_request(dpy);
+	if(!current || current->sequence != reply_sequence)
+		current = append_pending_request(dpy, reply_sequence);
 	/* Don't let any other thread get this reply. */
 	current->reply_waiter = 1;
 
 	while(1)
 	{
-		PendingRequest *req = dpy->xcb->pending_requests;
+		PendingRequest *req = first_pending_request(dpy);
+		uint64_t sequence = req->sequence;
 		xcb_generic_reply_t *response;
 
-		if(req != current && req->reply_waiter)
+		if(sequence != reply_sequence && req->reply_waiter)
 		{
 			ConditionWait(dpy, dpy->xcb->reply_notify);
 			/* Another thread got this reply. */
@@ -609,7 +632,7 @@ Status _XReply(Display *dpy, xReply *rep, int extra, Bool discard)
 		}
 		req->reply_waiter = 1;
 		UnlockDisplay(dpy);
-		response = xcb_wait_for_reply64(c, req->sequence, &error);
+		response = xcb_wait_for_reply64(c, sequence, &error);
 		/* Any user locks on another thread must have been taken
 		 * while we slept in xcb_wait_for_reply64. Classic Xlib
 		 * ignored those user locks in this case, so we do too. */
@@ -637,19 +660,23 @@ Status _XReply(Display *dpy, xReply *rep, int extra, Bool discard)
 				handle_response(dpy, event, True);
 		}
 
+		/* The ring may have grown while the display was unlocked,
+		 * but nobody else takes a request with a reply_waiter off
+		 * it: this one is still first. */
+		req = first_pending_request(dpy);
 		req->reply_waiter = 0;
 		ConditionBroadcast(dpy, dpy->xcb->reply_notify);
 		dpy_request = X_DPY_GET_REQUEST(dpy);
-		if(XLIB_SEQUENCE_COMPARE(req->sequence, >, dpy_request)) {
+		if(XLIB_SEQUENCE_COMPARE(sequence, >, dpy_request)) {
 			throw_thread_fail_assert("Unknown sequence number "
 			                         "while processing reply",
 			                        xcb_xlib_threads_sequence_lost);
 		}
-		X_DPY_SET_LAST_REQUEST_READ(dpy, req->sequence);
+		X_DPY_SET_LAST_REQUEST_READ(dpy, sequence);
 		if(!response)
 			dequeue_pending_request(dpy, req);
 
-		if(req == current)
+		if(sequence == reply_sequence)
 		{
 			reply = (char *) response;
 			break;
@@ -108,6 +108,42 @@ close_converter(
 #define BAD_WCHAR ((ucs4_t) 0xfffd)
 #define BAD_CHAR '?'
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+/*
+ * Most text is ASCII, which reads the same in UTF-8, ISO 8859-1 and
+ * UCS-4.  The converters below copy runs of it without decoding; this
+ * returns how many of the n bytes at src are ASCII, up to the first
+ * byte that isn't.
+ */
+static int
+ascii_run(
+    unsigned char const *src,
+    int n)
+{
+    int i = 0;
+
+#ifdef USE_SSE2
+    for (; i + 16 <= n; i += 16) {
+	int mask = _mm_movemask_epi8(
+	    _mm_loadu_si128((const __m128i *) (src + i)));
+	if (mask) {
+	    while (!(mask & 1)) {
+		mask >>= 1;
+		i++;
+	    }
+	    return i;
+	}
+    }
+#endif
+    while (i < n && src[i] < 0x80)
+	i++;
+    return i;
+}
+
 /***************************************************************************/
 /* Part I: Conversion routines CompoundText/CharSet <--> Unicode/UTF-8.
  *
@@ -622,7 +658,11 @@ utf8tocs(
 	int consumed;
 	int count;
 
-	consumed = utf8_mbtowc(NULL, &wc, src, srcend-src);
+	if (*src < 0x80) {
+	    wc = *src;
+	    consumed = 1;
+	} else
+	    consumed = utf8_mbtowc(NULL, &wc, src, srcend-src);
 	if (consumed == RET_TOOFEW(0))
 	    break;
 	if (consumed == RET_ILSEQ) {
@@ -725,7 +765,11 @@ utf8tocs1(
 	int consumed;
 	int count;
 
-	consumed = utf8_mbtowc(NULL, &wc, src, srcend-src);
+	if (*src < 0x80) {
+	    wc = *src;
+	    consumed = 1;
+	} else
+	    consumed = utf8_mbtowc(NULL, &wc, src, srcend-src);
 	if (consumed == RET_TOOFEW(0))
 	    break;
 	if (consumed == RET_ILSEQ) {
@@ -824,6 +868,28 @@ utf8tostr(
 	ucs4_t wc;
 	int consumed;
 
+	if (*src < 0x80) {
+	    int n = ascii_run(src, srcend - src);
+
+	    if (n > dstend - dst)
+		n = dstend - dst;
+	    if (n == 0)
+		break;
+	    memcpy(dst, src, n);
+	    src += n;
+	    dst += n;
+	    continue;
+	}
+	/* the rest of ISO 8859-1 */
+	if ((src[0] & 0xfe) == 0xc2 && srcend - src >= 2 &&
+	    (src[1] ^ 0x80) < 0x40) {
+	    if (dst == dstend)
+		break;
+	    *dst++ = (unsigned char) ((src[0] << 6) | (src[1] & 0x3f));
+	    src += 2;
+	    continue;
+	}
+
 	consumed = utf8_mbtowc(NULL, &wc, src, srcend-src);
 	if (consumed == RET_TOOFEW(0))
 	    break;
@@ -894,11 +960,23 @@ strtoutf8(
     dstend = dst + *to_left;
 
     while (src < srcend) {
-	int count = utf8_wctomb(NULL, dst, *src, dstend-dst);
-	if (count == RET_TOOSMALL)
-	    break;
-	dst += count;
-	src++;
+	if (*src < 0x80) {
+	    int n = ascii_run(src, srcend - src);
+
+	    if (n > dstend - dst)
+		n = dstend - dst;
+	    if (n == 0)
+		break;
+	    memcpy(dst, src, n);
+	    src += n;
+	    dst += n;
+	} else {
+	    if (dstend - dst < 2)
+		break;
+	    *dst++ = 0xc0 | (*src >> 6);
+	    *dst++ = 0x80 | (*src & 0x3f);
+	    src++;
+	}
     }
 
     *from = (XPointer) src;
@@ -1178,7 +1256,18 @@ utf8towcs(
 
     while (src < srcend && dst < dstend) {
 	ucs4_t wc;
-	int consumed = utf8_mbtowc(NULL, &wc, src, srcend-src);
+	int consumed;
+
+	if (*src < 0x80) {
+	    int n = ascii_run(src, srcend - src);
+
+	    if (n > dstend - dst)
+		n = dstend - dst;
+	    for (; n > 0; n--)
+		*dst++ = *src++;
+	    continue;
+	}
+	consumed = utf8_mbtowc(NULL, &wc, src, srcend-src);
 	if (consumed == RET_TOOFEW(0))
 	    break;
 	if (consumed == RET_ILSEQ) {
@@ -1244,7 +1333,15 @@ wcstoutf8(
     unconv_num = 0;
 
     while (src < srcend) {
-	int count = utf8_wctomb(NULL, dst, *src, dstend-dst);
+	int count;
+
+	if ((unsigned long) *src < 0x80) {
+	    if (dst == dstend)
+		break;
+	    *dst++ = (unsigned char) *src++;
+	    continue;
+	}
+	count = utf8_wctomb(NULL, dst, *src, dstend-dst);
 	if (count == RET_TOOSMALL)
 	    break;
 	if (count == RET_ILSEQ) {
@@ -0,0 +1,69 @@
+/*
+ * Times a burst of requests that get no reply, ended by one XSync.  With
+ * XCB owning the event queue Xlib records every request it sends as
+ * pending until the sync reply retires it; with Xlib owning the queue
+ * and no async handlers it records none, which gives the baseline.
+ *
+ * Needs an X server.
+ *
+ * usage: bench_requests [count]
+ */
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xlib-xcb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double run(Display *dpy, Window w, int count)
+{
+    struct timespec t0, t1;
+    unsigned long value;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < count; i++) {
+	value = i;
+	XChangeProperty(dpy, w, XA_CARDINAL, XA_CARDINAL, 32,
+			PropModeReplace, (unsigned char *) &value, 1);
+    }
+    XSync(dpy, False);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    int count = 100000;
+    Display *dpy;
+    Window w;
+    double t;
+
+    if (argc > 1)
+	count = atoi(argv[1]);
+    dpy = XOpenDisplay(NULL);
+    if (!dpy) {
+	fprintf(stderr, "cannot open display\n");
+	return 1;
+    }
+    w = XCreateSimpleWindow(dpy, DefaultRootWindow(dpy),
+			    0, 0, 1, 1, 0, 0, 0);
+
+    /* warm up the connection and the pending request ring */
+    run(dpy, w, 1000);
+
+    t = run(dpy, w, count);
+    printf("%-8s %d requests in %.3f s, %.0f requests/s\n",
+	   "xlib", count, t, count / t);
+
+    XSetEventQueueOwner(dpy, XCBOwnsEventQueue);
+    run(dpy, w, 1000);
+    t = run(dpy, w, count);
+    printf("%-8s %d requests in %.3f s, %.0f requests/s\n",
+	   "xcb", count, t, count / t);
+
+    XDestroyWindow(dpy, w);
+    XCloseDisplay(dpy);
+    return 0;
+}
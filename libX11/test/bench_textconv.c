@@ -0,0 +1,122 @@
+/*
+ * Times XmbTextListToTextProperty on a large buffer in a UTF-8 locale,
+ * for each target encoding, and XmbTextPropertyToTextList back from it.
+ * The text is ASCII with, in the second run, one Latin-1 letter every
+ * 64 bytes, which is where the converters' ASCII runs get cut short.
+ *
+ * Needs an X server, for the encoding atoms.
+ *
+ * usage: bench_textconv [kilobytes [rounds]]
+ */
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const struct {
+    const char *name;
+    XICCEncodingStyle style;
+} styles[] = {
+    { "STRING", XStringStyle },
+    { "COMPOUND", XCompoundTextStyle },
+    { "UTF8", XUTF8StringStyle },
+};
+
+static double elapsed(struct timespec *t0)
+{
+    struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+static void run(Display *dpy, char *text, int rounds, const char *kind)
+{
+    size_t len = strlen(text);
+    struct timespec t0;
+    XTextProperty prop;
+    char **list;
+    int count, i, r;
+    double t;
+
+    for (i = 0; i < (int) (sizeof(styles) / sizeof(styles[0])); i++) {
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (r = 0; r < rounds; r++) {
+	    if (XmbTextListToTextProperty(dpy, &text, 1, styles[i].style,
+					  &prop) < Success) {
+		fprintf(stderr, "%s: conversion failed\n", styles[i].name);
+		exit(1);
+	    }
+	    XFree(prop.value);
+	}
+	t = elapsed(&t0);
+	printf("%-6s to   %-8s %.1f MB/s\n", kind, styles[i].name,
+	       len * rounds / t / 1e6);
+
+	XmbTextListToTextProperty(dpy, &text, 1, styles[i].style, &prop);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (r = 0; r < rounds; r++) {
+	    if (XmbTextPropertyToTextList(dpy, &prop, &list, &count) < Success) {
+		fprintf(stderr, "%s: conversion failed\n", styles[i].name);
+		exit(1);
+	    }
+	    XFreeStringList(list);
+	}
+	t = elapsed(&t0);
+	printf("%-6s from %-8s %.1f MB/s\n", kind, styles[i].name,
+	       prop.nitems * rounds / t / 1e6);
+	XFree(prop.value);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int kbytes = 1024, rounds = 20;
+    Display *dpy;
+    size_t i, len;
+    char *text;
+
+    if (argc > 1)
+	kbytes = atoi(argv[1]);
+    if (argc > 2)
+	rounds = atoi(argv[2]);
+    if (!setlocale(LC_ALL, "C.UTF-8") && !setlocale(LC_ALL, "en_US.UTF-8")) {
+	fprintf(stderr, "no UTF-8 locale\n");
+	return 1;
+    }
+    if (!XSupportsLocale()) {
+	fprintf(stderr, "locale not supported by Xlib\n");
+	return 1;
+    }
+    dpy = XOpenDisplay(NULL);
+    if (!dpy) {
+	fprintf(stderr, "cannot open display\n");
+	return 1;
+    }
+
+    len = (size_t) kbytes * 1024;
+    text = malloc(len + 1);
+    if (!text) {
+	fprintf(stderr, "not enough memory\n");
+	return 1;
+    }
+    for (i = 0; i < len; i++)
+	text[i] = ' ' + i % 95;
+    text[len] = '\0';
+    run(dpy, text, rounds, "ascii");
+
+    /* U+00E9, two bytes in UTF-8 */
+    for (i = 62; i + 1 < len; i += 64) {
+	text[i] = (char) 0xc3;
+	text[i + 1] = (char) 0xa9;
+    }
+    run(dpy, text, rounds, "latin1");
+
+    free(text);
+    XCloseDisplay(dpy);
+    return 0;
+}
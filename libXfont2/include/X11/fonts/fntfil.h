@@ -71,6 +71,7 @@ typedef struct _FontRenderer	    *FontRendererPtr;
 #define FontDirFile	    "fonts.dir"
 #define FontAliasFile	    "fonts.alias"
 #define FontScalableFile    "fonts.scale"
+#define FontDirIndexFile    "fonts.dir.idx"
 
 extern int FontFileNameCheck ( const char *name );
 extern int FontFileInitFPE ( FontPathElementPtr fpe );
@@ -174,6 +175,8 @@ extern int FontFileMatchBitmapSource ( FontPathElementPtr fpe,
 				       Bool noSpecificSize );
 
 extern int FontFileReadDirectory ( const char *directory, FontDirectoryPtr *pdir );
+extern int FontFileReadDirIndex ( const char *directory, const char *dir_path,
+				  FontDirectoryPtr *pdir );
 extern Bool FontFileDirectoryChanged ( FontDirectoryPtr dir );
 
 #endif /* _FONTFILE_H_ */
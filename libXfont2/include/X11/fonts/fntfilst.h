@@ -106,6 +106,9 @@ typedef struct _FontTable {
     int		    size;
     FontEntryPtr    entries;
     Bool	    sorted;
+    int		    *familyIndex;	/* entry indices, see fontdir.c */
+    int		    familyIndexed;	/* leading XLFD entries in it */
+    int		    familyIndexSize;
 } FontTableRec;
 
 typedef struct _FontDirectory {
@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
+#include <sys/stat.h>
 
 #include <X11/fonts/fntfilst.h>
 #include <X11/fonts/fontutil.h>
@@ -168,6 +169,7 @@ FreeTypeOpenFace(FTFacePtr *facep, char *FTFileName, char *realFileName, int fac
     FT_Error ftrc;
     int bucket;
     FTFacePtr face, otherFace;
+    struct stat st;
 
     if (!ftypeInitP) {
         ftrc = FT_Init_FreeType(&ftypeLibrary);
@@ -203,6 +205,11 @@ FreeTypeOpenFace(FTFacePtr *facep, char *FTFileName, char *realFileName, int fac
         return AllocError;
     }
 
+    if (stat(realFileName, &st) == 0) {
+        face->mtime = st.st_mtime;
+        face->size = st.st_size;
+    }
+
     ftrc = FT_New_Face(ftypeLibrary, realFileName, faceNumber, &face->face);
     if(ftrc != 0) {
         ErrorF("FreeType: couldn't open face %s: %d\n", FTFileName, ftrc);
@@ -258,8 +265,8 @@ FreeTypeFreeFace(FTFacePtr face)
     }
 }
 
-static int
-TransEqual(FTNormalisedTransformationPtr t1, FTNormalisedTransformationPtr t2)
+int
+FTTransEqual(FTNormalisedTransformationPtr t1, FTNormalisedTransformationPtr t2)
 {
     if(t1->scale != t2->scale)
         return 0;
@@ -277,8 +284,8 @@ TransEqual(FTNormalisedTransformationPtr t1, FTNormalisedTransformationPtr t2)
         return 1;
 }
 
-static int
-BitmapFormatEqual(FontBitmapFormatPtr f1, FontBitmapFormatPtr f2)
+int
+FTBitmapFormatEqual(FontBitmapFormatPtr f1, FontBitmapFormatPtr f2)
 {
     return
         f1->bit == f2->bit &&
@@ -286,8 +293,8 @@ BitmapFormatEqual(FontBitmapFormatPtr f1, FontBitmapFormatPtr f2)
         f1->glyph == f2->glyph;
 }
 
-static int
-TTCapEqual(struct TTCapInfo *t1, struct TTCapInfo *t2)
+int
+FTTTCapEqual(struct TTCapInfo *t1, struct TTCapInfo *t2)
 {
     return
 	t1->autoItalic == t2->autoItalic &&
@@ -316,15 +323,15 @@ FTInstanceMatch(FTInstancePtr instance,
 {
     if(strcmp(instance->face->filename, FTFileName) != 0) {
         return 0;
-    } else if(!TransEqual(&instance->transformation, trans)) {
+    } else if(!FTTransEqual(&instance->transformation, trans)) {
         return 0;
     } else if( spacing != instance->spacing ) {
         return 0;
     } else if( load_flags != instance->load_flags ) {
         return 0;
-    } else if(!BitmapFormatEqual(&instance->bmfmt, bmfmt)) {
+    } else if(!FTBitmapFormatEqual(&instance->bmfmt, bmfmt)) {
         return 0;
-    } else if(!TTCapEqual(&instance->ttcap, tmp_ttcap)) {
+    } else if(!FTTTCapEqual(&instance->ttcap, tmp_ttcap)) {
         return 0;
     } else {
         return 1;
@@ -435,6 +442,7 @@ FreeTypeOpenInstance(FTInstancePtr *instance_return, FTFacePtr face,
     instance->bmfmt = *bmfmt;
     instance->glyphs = NULL;
     instance->available = NULL;
+    instance->glyphset = NULL;
 
     if( 0 <= tmp_ttcap->forceConstantSpacingEnd )
 	instance->nglyphs = 2 * instance->face->face->num_glyphs;
@@ -528,6 +536,12 @@ FreeTypeOpenInstance(FTInstancePtr *instance_return, FTFacePtr face,
 #endif
     }
 
+    /* Glyphs rasterised with forced constant spacing are looked up at
+       shifted indices, don't bother caching them across instances. */
+    if( tmp_ttcap->forceConstantSpacingEnd < 0 )
+	instance->glyphset = FTGlyphCacheOpenSet(face, trans, spacing,
+						 bmfmt, tmp_ttcap, load_flags);
+
     /* maintain a linked list of instances */
     instance->next = instance->face->instances;
     instance->face->instances = instance;
@@ -563,6 +577,7 @@ FreeTypeFreeInstance(FTInstancePtr instance)
 
         FT_Done_Size(instance->size);
         FreeTypeFreeFace(instance->face);
+        FTGlyphCacheCloseSet(instance->glyphset);
 
         if(instance->charcellMetrics) {
             free(instance->charcellMetrics);
@@ -673,11 +688,22 @@ FreeTypeInstanceGetGlyph(unsigned idx, int flags, CharInfoPtr *g, FTInstancePtr
 	return Successful;
     }
 
+    if(!(flags & FT_FORCE_CONSTANT_SPACING) &&
+       FTGlyphCacheLookup(instance->glyphset, idx,
+			  &(*glyphs)[segment][offset])) {
+	(*available)[segment][offset] = FT_AVAILABLE_RASTERISED;
+	*g = &(*glyphs)[segment][offset];
+	return Successful;
+    }
+
     flags |= FT_GET_GLYPH_BOTH;
 
     xrc = FreeTypeRasteriseGlyph(idx, flags,
 				 &(*glyphs)[segment][offset], instance,
 				 (*available)[segment][offset] >= FT_AVAILABLE_METRICS);
+    if(xrc == Successful && !(flags & FT_FORCE_CONSTANT_SPACING))
+	FTGlyphCacheInsert(instance->glyphset, idx,
+			   &(*glyphs)[segment][offset]);
     if(xrc != Successful && (*available)[segment][offset] >= FT_AVAILABLE_METRICS) {
 	ErrorF("Warning: FreeTypeRasteriseGlyph() returns an error,\n");
 	ErrorF("\tso the backend tries to set a white space.\n");
@@ -732,6 +758,15 @@ FreeTypeInstanceGetGlyphMetrics(unsigned idx, int flags,
 	return Successful;
     }
 
+    /* A cached glyph gives us the bits as well */
+    if( instance->available[segment][offset] == FT_AVAILABLE_UNKNOWN &&
+	FTGlyphCacheLookup(instance->glyphset, idx,
+			   &instance->glyphs[segment][offset]) ) {
+	instance->available[segment][offset] = FT_AVAILABLE_RASTERISED;
+	*metrics = &instance->glyphs[segment][offset].metrics;
+	return Successful;
+    }
+
     flags |= FT_GET_GLYPH_METRICS_ONLY;
 
     xrc = FreeTypeRasteriseGlyph(idx, flags,
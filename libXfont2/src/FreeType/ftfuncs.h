@@ -47,6 +47,8 @@ typedef struct _FTFace {
     FT_Face face;
     int bitmap;
     FT_UInt num_hmetrics;
+    time_t mtime;               /* of the file when it was opened */
+    off_t size;
     struct _FTInstance *instances;
     struct _FTInstance *active_instance;
     struct _FTFace *next;       /* link to next face in bucket */
@@ -112,6 +114,24 @@ struct TTCapInfo {
     int rsbShiftOfBitmapAutoItalic;
 };
 
+/* A glyph set holds the rasterisation parameters of an instance for
+   the process-wide glyph cache (ftgcache.c).  It outlives the instances
+   using it for as long as the cache holds glyphs rasterised with it. */
+
+typedef struct _FTGlyphSet {
+    char *filename;
+    time_t mtime;		/* of the file, so that a replaced */
+    off_t size;			/* file gets a set of its own */
+    FTNormalisedTransformationRec transformation;
+    int spacing;
+    FT_Int32 load_flags;
+    FontBitmapFormatRec bmfmt;
+    struct TTCapInfo ttcap;
+    int refcount;		/* instances using this set */
+    int nentries;		/* glyphs cached for this set */
+    struct _FTGlyphSet *next;
+} FTGlyphSetRec, *FTGlyphSetPtr;
+
 /* An instance builds on a face by specifying the transformation
    matrix.  Multiple fonts may share the same instance. */
 
@@ -136,6 +156,7 @@ typedef struct _FTInstance {
     CharInfoPtr *glyphs;        /* glyphs and available are used in parallel */
     int **available;
     struct TTCapInfo ttcap;
+    FTGlyphSetPtr glyphset;	/* NULL if not using the glyph cache */
     int refcount;
     struct _FTInstance *next;   /* link to next instance */
 } FTInstanceRec, *FTInstancePtr;
@@ -152,6 +173,21 @@ typedef struct _FTFont{
     fsRange *ranges;
 } FTFontRec, *FTFontPtr;
 
+/* Shared between ftfuncs.c and ftgcache.c */
+
+int FTTransEqual(FTNormalisedTransformationPtr t1,
+		 FTNormalisedTransformationPtr t2);
+int FTBitmapFormatEqual(FontBitmapFormatPtr f1, FontBitmapFormatPtr f2);
+int FTTTCapEqual(struct TTCapInfo *t1, struct TTCapInfo *t2);
+
+FTGlyphSetPtr
+FTGlyphCacheOpenSet(FTFacePtr face, FTNormalisedTransformationPtr trans,
+		    int spacing, FontBitmapFormatPtr bmfmt,
+		    struct TTCapInfo *ttcap, FT_Int32 load_flags);
+void FTGlyphCacheCloseSet(FTGlyphSetPtr set);
+int FTGlyphCacheLookup(FTGlyphSetPtr set, unsigned idx, CharInfoPtr tgp);
+void FTGlyphCacheInsert(FTGlyphSetPtr set, unsigned idx, CharInfoPtr tgp);
+
 #ifndef NOT_IN_FTFUNCS
 
 /* Prototypes for some local functions */
@@ -0,0 +1,363 @@
+/*
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * ftgcache.c
+ *
+ * A process-wide cache of rasterised glyphs.
+ *
+ * Fonts opened at the same time already share an instance, but the
+ * instance and its glyphs go away with the last font using it, so a font
+ * that is opened and closed over and over (a terminal per client, say)
+ * has every glyph rasterised again each time.  This cache keeps a copy
+ * of each rasterised glyph, keyed by the rasterisation parameters (a
+ * glyph set) and the glyph index, and hands it to later instances with
+ * the same parameters.  It is bounded by a byte budget and drops the
+ * least recently used glyphs first.
+ *
+ * Instances always get their own copy of the bits: the server may hold
+ * on to glyph pointers for as long as the font is open, and the cache
+ * must stay free to evict.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include "libxfontint.h"
+#include <X11/fonts/fontmisc.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <X11/fonts/fntfilst.h>
+#include <X11/fonts/fontutil.h>
+#include <X11/fonts/libxfont2.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <X11/fonts/fontenc.h>
+#include "ft.h"
+#define NOT_IN_FTFUNCS
+#include "ftfuncs.h"
+
+#define FT_GLYPH_CACHE_DEFAULT_LIMIT	(4 * 1024 * 1024)
+#define FT_GLYPH_CACHE_MIN_BUCKETS	256
+
+typedef struct _FTGlyphCacheEntry {
+    FTGlyphSetPtr set;
+    unsigned idx;
+    CharInfoRec glyph;
+    unsigned long size;		/* accounted against the limit */
+    struct _FTGlyphCacheEntry *hnext;	/* hash chain */
+    struct _FTGlyphCacheEntry *prev;	/* LRU list, most recent first */
+    struct _FTGlyphCacheEntry *next;
+} FTGlyphCacheEntryRec, *FTGlyphCacheEntryPtr;
+
+static FTGlyphSetPtr glyphSets;
+static FTGlyphCacheEntryPtr *cacheBuckets;
+static unsigned cacheNumBuckets;
+static FTGlyphCacheEntryRec cacheLRU = { NULL, 0, { { 0 } }, 0, NULL,
+					 &cacheLRU, &cacheLRU };
+static unsigned long cacheLimit = FT_GLYPH_CACHE_DEFAULT_LIMIT;
+static xfont2_glyph_cache_stats_rec cacheStats;
+
+static unsigned
+FTGlyphCacheHash(FTGlyphSetPtr set, unsigned idx)
+{
+    unsigned long s = (unsigned long) set;
+
+    return (unsigned) (s >> 4) * 31 + idx * 2654435761U;
+}
+
+/* Size of the bits FreeTypeRasteriseGlyph allocates for these metrics */
+static unsigned long
+FTGlyphBitsSize(FTGlyphSetPtr set, xCharInfo *metrics)
+{
+    int wd = metrics->rightSideBearing - metrics->leftSideBearing;
+    int ht = metrics->ascent + metrics->descent;
+    int bpr;
+
+    if (wd <= 0)
+	wd = 1;
+    if (ht <= 0)
+	ht = 1;
+    bpr = (((wd + (set->bmfmt.glyph << 3) - 1) >> 3) & -set->bmfmt.glyph);
+    return (unsigned long) ht * bpr;
+}
+
+static void
+FTGlyphCacheUnlink(FTGlyphCacheEntryPtr entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+}
+
+static void
+FTGlyphCacheLinkFront(FTGlyphCacheEntryPtr entry)
+{
+    entry->prev = &cacheLRU;
+    entry->next = cacheLRU.next;
+    cacheLRU.next->prev = entry;
+    cacheLRU.next = entry;
+}
+
+static void
+FTGlyphSetFree(FTGlyphSetPtr set)
+{
+    FTGlyphSetPtr *prev;
+
+    for (prev = &glyphSets; *prev; prev = &(*prev)->next)
+	if (*prev == set) {
+	    *prev = set->next;
+	    break;
+	}
+    free(set->filename);
+    free(set);
+}
+
+static void
+FTGlyphCacheRemove(FTGlyphCacheEntryPtr entry)
+{
+    FTGlyphCacheEntryPtr *prev;
+    FTGlyphSetPtr set = entry->set;
+
+    prev = &cacheBuckets[FTGlyphCacheHash(set, entry->idx) % cacheNumBuckets];
+    while (*prev != entry)
+	prev = &(*prev)->hnext;
+    *prev = entry->hnext;
+    FTGlyphCacheUnlink(entry);
+
+    cacheStats.entries--;
+    cacheStats.bytes -= entry->size;
+    free(entry->glyph.bits);
+    free(entry);
+
+    if (--set->nentries == 0 && set->refcount == 0)
+	FTGlyphSetFree(set);
+}
+
+static void
+FTGlyphCacheTrim(unsigned long limit)
+{
+    while (cacheStats.bytes > limit && cacheLRU.prev != &cacheLRU) {
+	FTGlyphCacheRemove(cacheLRU.prev);
+	cacheStats.evictions++;
+    }
+}
+
+static int
+FTGlyphCacheResize(unsigned num_buckets)
+{
+    FTGlyphCacheEntryPtr *buckets, entry, next;
+    unsigned i, bucket;
+
+    buckets = calloc(num_buckets, sizeof(FTGlyphCacheEntryPtr));
+    if (!buckets)
+	return FALSE;
+    for (i = 0; i < cacheNumBuckets; i++) {
+	for (entry = cacheBuckets[i]; entry; entry = next) {
+	    next = entry->hnext;
+	    bucket = FTGlyphCacheHash(entry->set, entry->idx) % num_buckets;
+	    entry->hnext = buckets[bucket];
+	    buckets[bucket] = entry;
+	}
+    }
+    free(cacheBuckets);
+    cacheBuckets = buckets;
+    cacheNumBuckets = num_buckets;
+    return TRUE;
+}
+
+/*
+ * Find or create the glyph set for these rasterisation parameters and
+ * take a reference to it.  Sets are told apart by the size and mtime of
+ * the font file too, so that a file replaced under the same name doesn't
+ * get the glyphs of the old one.  Returns NULL if the cache is disabled
+ * or out of memory; instances then simply don't use it.
+ */
+FTGlyphSetPtr
+FTGlyphCacheOpenSet(FTFacePtr face, FTNormalisedTransformationPtr trans,
+		    int spacing, FontBitmapFormatPtr bmfmt,
+		    struct TTCapInfo *ttcap, FT_Int32 load_flags)
+{
+    FTGlyphSetPtr set;
+
+    if (cacheLimit == 0)
+	return NULL;
+
+    for (set = glyphSets; set; set = set->next) {
+	if (strcmp(set->filename, face->filename) == 0 &&
+	    set->mtime == face->mtime && set->size == face->size &&
+	    FTTransEqual(&set->transformation, trans) &&
+	    set->spacing == spacing &&
+	    set->load_flags == load_flags &&
+	    FTBitmapFormatEqual(&set->bmfmt, bmfmt) &&
+	    FTTTCapEqual(&set->ttcap, ttcap)) {
+	    set->refcount++;
+	    return set;
+	}
+    }
+
+    set = calloc(1, sizeof(FTGlyphSetRec));
+    if (!set)
+	return NULL;
+    set->filename = strdup(face->filename);
+    if (!set->filename) {
+	free(set);
+	return NULL;
+    }
+    set->mtime = face->mtime;
+    set->size = face->size;
+    set->transformation = *trans;
+    set->spacing = spacing;
+    set->load_flags = load_flags;
+    set->bmfmt = *bmfmt;
+    set->ttcap = *ttcap;
+    set->refcount = 1;
+    set->next = glyphSets;
+    glyphSets = set;
+    return set;
+}
+
+void
+FTGlyphCacheCloseSet(FTGlyphSetPtr set)
+{
+    if (!set)
+	return;
+    if (--set->refcount == 0 && set->nentries == 0)
+	FTGlyphSetFree(set);
+}
+
+/*
+ * Fill in tgp from the cache.  Returns TRUE if the glyph was found, with
+ * tgp->bits pointing to a fresh copy owned by the caller.
+ */
+int
+FTGlyphCacheLookup(FTGlyphSetPtr set, unsigned idx, CharInfoPtr tgp)
+{
+    FTGlyphCacheEntryPtr entry;
+    unsigned long size;
+    char *bits;
+
+    if (!set || !cacheNumBuckets)
+	return FALSE;
+
+    cacheStats.lookups++;
+    for (entry = cacheBuckets[FTGlyphCacheHash(set, idx) % cacheNumBuckets];
+	 entry; entry = entry->hnext) {
+	if (entry->set == set && entry->idx == idx)
+	    break;
+    }
+    if (!entry) {
+	cacheStats.misses++;
+	return FALSE;
+    }
+
+    size = FTGlyphBitsSize(set, &entry->glyph.metrics);
+    bits = malloc(size);
+    if (!bits) {
+	cacheStats.misses++;
+	return FALSE;
+    }
+    memcpy(bits, entry->glyph.bits, size);
+    tgp->metrics = entry->glyph.metrics;
+    tgp->bits = bits;
+
+    FTGlyphCacheUnlink(entry);
+    FTGlyphCacheLinkFront(entry);
+    cacheStats.hits++;
+    return TRUE;
+}
+
+/*
+ * Remember a copy of a freshly rasterised glyph.  Failure to allocate
+ * is not an error, the glyph just isn't cached.
+ */
+void
+FTGlyphCacheInsert(FTGlyphSetPtr set, unsigned idx, CharInfoPtr tgp)
+{
+    FTGlyphCacheEntryPtr entry;
+    unsigned long size;
+    unsigned bucket;
+
+    if (!set || !tgp->bits)
+	return;
+
+    size = FTGlyphBitsSize(set, &tgp->metrics);
+    if (size + sizeof(FTGlyphCacheEntryRec) > cacheLimit)
+	return;
+
+    if (cacheNumBuckets == 0 ||
+	cacheStats.entries >= 2 * (unsigned long) cacheNumBuckets) {
+	if (!FTGlyphCacheResize(cacheNumBuckets ? cacheNumBuckets * 2 :
+				FT_GLYPH_CACHE_MIN_BUCKETS) &&
+	    cacheNumBuckets == 0)
+	    return;
+    }
+
+    bucket = FTGlyphCacheHash(set, idx) % cacheNumBuckets;
+    for (entry = cacheBuckets[bucket]; entry; entry = entry->hnext)
+	if (entry->set == set && entry->idx == idx)
+	    return;
+
+    entry = malloc(sizeof(FTGlyphCacheEntryRec));
+    if (!entry)
+	return;
+    entry->glyph.bits = malloc(size);
+    if (!entry->glyph.bits) {
+	free(entry);
+	return;
+    }
+    memcpy(entry->glyph.bits, tgp->bits, size);
+    entry->glyph.metrics = tgp->metrics;
+    entry->set = set;
+    entry->idx = idx;
+    entry->size = size + sizeof(FTGlyphCacheEntryRec);
+
+    entry->hnext = cacheBuckets[bucket];
+    cacheBuckets[bucket] = entry;
+    FTGlyphCacheLinkFront(entry);
+    set->nentries++;
+
+    cacheStats.insertions++;
+    cacheStats.entries++;
+    cacheStats.bytes += entry->size;
+    FTGlyphCacheTrim(cacheLimit);
+}
+
+/*
+ * Set the memory budget of the glyph cache in bytes; 0 disables it.
+ * Fonts already open keep using it until they are closed.
+ */
+void
+xfont2_set_glyph_cache_limit(unsigned long limit)
+{
+    cacheLimit = limit;
+    FTGlyphCacheTrim(limit);
+}
+
+void
+xfont2_get_glyph_cache_stats(xfont2_glyph_cache_stats_rec *stats)
+{
+    *stats = cacheStats;
+    stats->limit = cacheLimit;
+}
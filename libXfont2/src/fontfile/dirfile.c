@@ -94,6 +94,11 @@ FontFileReadDirectory (const char *directory, FontDirectoryPtr *pdir)
     if (dir_file[strlen(dir_file) - 1] != '/')
 	strcat(dir_file, "/");
     strcat(dir_file, FontDirFile);
+
+    /* Use the prebuilt index when it matches fonts.dir */
+    if (FontFileReadDirIndex(directory, dir_path, &dir) == Successful)
+	goto aliases;
+
 #ifndef WIN32
     file_fd = open(dir_file, O_RDONLY | O_NOFOLLOW);
     if (file_fd >= 0) {
@@ -152,6 +157,7 @@ FontFileReadDirectory (const char *directory, FontDirectoryPtr *pdir)
     } else if (errno != ENOENT) {
 	return BadFontPath;
     }
+aliases:
     status = ReadFontAlias(dir_path, FALSE, &dir);
     if (status != Successful) {
 	if (dir)
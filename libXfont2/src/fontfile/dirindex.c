@@ -0,0 +1,367 @@
+/*
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * dirindex.c
+ *
+ * Read and write fonts.dir.idx, a prebuilt binary form of fonts.dir.
+ *
+ * The index holds the fonts.dir entries in their original order with the
+ * font names already lowercased, and the size, mtime and a hash of the
+ * contents of the fonts.dir it was built from.  It is only used while those
+ * still match, so a stale index just means falling back to parsing
+ * fonts.dir; the hash catches a fonts.dir rewritten with the same size
+ * within the same second.  It is mapped read only where mmap is available,
+ * so servers sharing a font path share the pages.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include "libxfontint.h"
+#include <X11/fonts/fntfilst.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef WIN32
+#include <io.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define FONT_DIR_INDEX_MAGIC	0x49444658	/* "XFDI" in native order */
+#define FONT_DIR_INDEX_VERSION	2
+
+typedef struct _FontDirIndexHeader {
+    uint32_t	magic;
+    uint32_t	version;
+    uint32_t	count;		/* number of entries */
+    uint32_t	strings;	/* size of the string pool */
+    uint64_t	dir_size;	/* fonts.dir this index was built from */
+    int64_t	dir_mtime;
+    uint64_t	dir_hash;	/* FNV-1a of its contents */
+} FontDirIndexHeaderRec;
+
+typedef struct _FontDirIndexEntry {
+    uint32_t	name;		/* offsets into the string pool */
+    uint32_t	file;
+} FontDirIndexEntryRec;
+
+static int
+FontDirIndexPath(const char *dir_path, const char *file, char *path)
+{
+    size_t len = strlen(dir_path);
+
+    if (len + 1 + strlen(file) + 1 > MAXFONTFILENAMELEN)
+	return FALSE;
+    strcpy(path, dir_path);
+    if (len == 0 || path[len - 1] != '/')
+	strcat(path, "/");
+    strcat(path, file);
+    return TRUE;
+}
+
+/*
+ * Hash the contents of the file at path, which should be size bytes long
+ */
+static int
+FontDirIndexHash(const char *path, uint64_t size, uint64_t *hash)
+{
+    unsigned char   buf[8192];
+    uint64_t	    h = 14695981039346656037ULL;
+    uint64_t	    done = 0;
+    int		    fd, n, i;
+
+    fd = open(path, O_RDONLY | O_BINARY);
+    if (fd < 0)
+	return FALSE;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+	for (i = 0; i < n; i++)
+	    h = (h ^ buf[i]) * 1099511628211ULL;
+	done += n;
+    }
+    close(fd);
+    if (n < 0 || done != size)
+	return FALSE;
+    *hash = h;
+    return TRUE;
+}
+
+static void *
+FontDirIndexMap(int fd, size_t size)
+{
+    void *data;
+
+#ifdef HAVE_MMAP
+    data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+	return NULL;
+#else
+    size_t done = 0;
+
+    data = malloc(size);
+    if (!data)
+	return NULL;
+    while (done < size) {
+	int n = read(fd, (char *) data + done, size - done);
+
+	if (n <= 0) {
+	    free(data);
+	    return NULL;
+	}
+	done += n;
+    }
+#endif
+    return data;
+}
+
+static void
+FontDirIndexUnmap(void *data, size_t size)
+{
+#ifdef HAVE_MMAP
+    munmap(data, size);
+#else
+    free(data);
+#endif
+}
+
+/*
+ * Fill *pdir from the index in dir_path, if there is an index matching the
+ * current fonts.dir.  Returns Successful if it was used and BadFontPath
+ * otherwise, in which case the caller parses fonts.dir as usual.
+ */
+int
+FontFileReadDirIndex(const char *directory, const char *dir_path,
+		     FontDirectoryPtr *pdir)
+{
+    char		    path[MAXFONTFILENAMELEN];
+    char		    file_name[MAXFONTFILENAMELEN];
+    char		    font_name[MAXFONTNAMELEN];
+    struct stat		    dirb, idxb;
+    FontDirIndexHeaderRec   *header;
+    FontDirIndexEntryRec    *entries;
+    const char		    *strings;
+    FontDirectoryPtr	    dir;
+    void		    *data;
+    size_t		    size;
+    uint64_t		    hash;
+    uint32_t		    i;
+    int			    fd;
+
+    if (!FontDirIndexPath(dir_path, FontDirFile, path) ||
+	stat(path, &dirb) == -1 ||
+	!FontDirIndexHash(path, dirb.st_size, &hash))
+	return BadFontPath;
+    if (!FontDirIndexPath(dir_path, FontDirIndexFile, path))
+	return BadFontPath;
+
+    fd = open(path, O_RDONLY | O_BINARY);
+    if (fd < 0)
+	return BadFontPath;
+    if (fstat(fd, &idxb) == -1 || idxb.st_size < sizeof(*header)) {
+	close(fd);
+	return BadFontPath;
+    }
+    size = idxb.st_size;
+    data = FontDirIndexMap(fd, size);
+    close(fd);
+    if (!data)
+	return BadFontPath;
+
+    header = data;
+    entries = (FontDirIndexEntryRec *) (header + 1);
+    strings = (const char *) (entries + header->count);
+    if (header->magic != FONT_DIR_INDEX_MAGIC ||
+	header->version != FONT_DIR_INDEX_VERSION ||
+	header->dir_size != (uint64_t) dirb.st_size ||
+	header->dir_mtime != (int64_t) dirb.st_mtime ||
+	header->dir_hash != hash ||
+	header->count > (size - sizeof(*header)) / sizeof(*entries) ||
+	size - sizeof(*header) - header->count * sizeof(*entries) !=
+	    header->strings ||
+	(header->strings && strings[header->strings - 1] != '\0')) {
+	FontDirIndexUnmap(data, size);
+	return BadFontPath;
+    }
+
+    dir = FontFileMakeDir(directory, header->count);
+    if (!dir) {
+	FontDirIndexUnmap(data, size);
+	return BadFontPath;
+    }
+    dir->dir_mtime = dirb.st_mtime;
+
+    for (i = 0; i < header->count; i++) {
+	if (entries[i].name >= header->strings ||
+	    entries[i].file >= header->strings ||
+	    strlen(strings + entries[i].name) >= sizeof(font_name) ||
+	    strlen(strings + entries[i].file) >= sizeof(file_name)) {
+	    FontFileFreeDir(dir);
+	    FontDirIndexUnmap(data, size);
+	    return BadFontPath;
+	}
+	/* FontFileAddFontFile rewrites the name in place */
+	strcpy(font_name, strings + entries[i].name);
+	strcpy(file_name, strings + entries[i].file);
+	FontFileAddFontFile(dir, font_name, file_name);
+    }
+
+    FontDirIndexUnmap(data, size);
+    *pdir = dir;
+    return Successful;
+}
+
+/*
+ * Build the index for the fonts.dir in directory.  Intended to be run
+ * right after writing fonts.dir, e.g. by mkfontdir.
+ */
+int
+xfont2_write_font_dir_index(const char *directory)
+{
+    char		    dir_file[MAXFONTFILENAMELEN];
+    char		    idx_file[MAXFONTFILENAMELEN];
+    char		    tmp_file[MAXFONTFILENAMELEN];
+    char		    file_name[MAXFONTFILENAMELEN];
+    char		    font_name[MAXFONTNAMELEN];
+    char		    format[24];
+    FontDirIndexHeaderRec   header;
+    FontDirIndexEntryRec    *entries = NULL;
+    char		    *strings = NULL;
+    size_t		    strings_size = 0, strings_used = 0;
+    struct stat		    statb;
+    FILE		    *file, *out;
+    int			    num_fonts, count, n = 0, entries_size = 0;
+    int			    status = BadFontPath;
+
+    if (!FontDirIndexPath(directory, FontDirFile, dir_file) ||
+	!FontDirIndexPath(directory, FontDirIndexFile, idx_file) ||
+	strlen(idx_file) + 4 >= sizeof(tmp_file))
+	return BadFontPath;
+    sprintf(tmp_file, "%s.new", idx_file);
+
+    file = fopen(dir_file, "rt");
+    if (!file)
+	return BadFontPath;
+    if (fstat(fileno(file), &statb) == -1 ||
+	!FontDirIndexHash(dir_file, statb.st_size, &header.dir_hash) ||
+	fscanf(file, "%d\n", &num_fonts) != 1) {
+	fclose(file);
+	return BadFontPath;
+    }
+
+    sprintf(format, "%%%ds %%%d[^\n]\n",
+	    MAXFONTFILENAMELEN - 1, MAXFONTNAMELEN - 1);
+    while ((count = fscanf(file, format, file_name, font_name)) != EOF) {
+	size_t name_len, file_len;
+	char *t;
+
+	if (count != 2)
+	    goto bail;
+#if defined(WIN32)
+	if ((t = strchr(font_name, '\r')))
+	    *t = '\0';
+#endif
+	if (n == entries_size) {
+	    FontDirIndexEntryRec *e;
+	    int newsize = entries_size + 100;
+
+	    if (newsize > INT32_MAX / (int) sizeof(*entries))
+		goto bail;
+	    e = realloc(entries, newsize * sizeof(*entries));
+	    if (!e) {
+		status = AllocError;
+		goto bail;
+	    }
+	    entries = e;
+	    entries_size = newsize;
+	}
+	name_len = strlen(font_name) + 1;
+	file_len = strlen(file_name) + 1;
+	if (strings_used + name_len + file_len > strings_size) {
+	    size_t newsize = strings_size ? strings_size * 2 : 4096;
+
+	    while (newsize < strings_used + name_len + file_len)
+		newsize *= 2;
+	    if (newsize > INT32_MAX)
+		goto bail;
+	    t = realloc(strings, newsize);
+	    if (!t) {
+		status = AllocError;
+		goto bail;
+	    }
+	    strings = t;
+	    strings_size = newsize;
+	}
+	entries[n].name = strings_used;
+	CopyISOLatin1Lowered(strings + strings_used, font_name, name_len - 1);
+	strings[strings_used + name_len - 1] = '\0';
+	strings_used += name_len;
+	entries[n].file = strings_used;
+	memcpy(strings + strings_used, file_name, file_len);
+	strings_used += file_len;
+	n++;
+    }
+
+    header.magic = FONT_DIR_INDEX_MAGIC;
+    header.version = FONT_DIR_INDEX_VERSION;
+    header.count = n;
+    header.strings = strings_used;
+    header.dir_size = statb.st_size;
+    header.dir_mtime = statb.st_mtime;
+
+    out = fopen(tmp_file, "wb");
+    if (!out)
+	goto bail;
+    if (fwrite(&header, sizeof(header), 1, out) != 1 ||
+	(n && fwrite(entries, sizeof(*entries), n, out) != n) ||
+	(strings_used && fwrite(strings, 1, strings_used, out) != strings_used)) {
+	fclose(out);
+	unlink(tmp_file);
+	goto bail;
+    }
+    if (fclose(out) != 0) {
+	unlink(tmp_file);
+	goto bail;
+    }
+#ifdef WIN32
+    unlink(idx_file);
+#endif
+    if (rename(tmp_file, idx_file) != 0) {
+	unlink(tmp_file);
+	goto bail;
+    }
+    status = Successful;
+
+  bail:
+    fclose(file);
+    free(entries);
+    free(strings);
+    return status;
+}
@@ -57,6 +57,9 @@ FontFileInitTable (FontTablePtr table, int size)
     table->used = 0;
     table->size = size;
     table->sorted = FALSE;
+    table->familyIndex = NULL;
+    table->familyIndexed = 0;
+    table->familyIndexSize = 0;
     return TRUE;
 }
 
@@ -100,6 +103,7 @@ FontFileFreeTable (FontTablePtr table)
     for (i = 0; i < table->used; i++)
 	FontFileFreeEntry (&table->entries[i]);
     free (table->entries);
+    free (table->familyIndex);
 }
 
 FontDirectoryPtr
@@ -249,6 +253,195 @@ FontFileNameCompare(const void* a, const void* b)
     return strcmpn(a_name->name.name, b_name->name.name);
 }
 
+/*
+ * Wildcard patterns usually start with a wildcard ("-*-fixed-..."), which
+ * leaves SetupWildMatch nothing to narrow the search with.  A sorted table
+ * therefore also gets an index of its entries by XLFD FAMILY_NAME.
+ *
+ * When a pattern and a name both have exactly 14 dashes, PatternMatch
+ * can't let a wildcard match a dash, so the fields line up one to one and
+ * only entries with the same family need to be looked at.  Names with
+ * more dashes may still match in other ways and are always checked.
+ */
+
+#define XLFD_NDASHES		14
+#define XLFD_FAMILY_FIELD	2
+#define FAMILY_INDEX_MIN	64	/* don't bother for small ranges */
+
+typedef struct _FontFamilyKey {
+    const char	*family;
+    int		length;
+    int		index;
+} FontFamilyKeyRec, *FontFamilyKeyPtr;
+
+static Bool
+FontFileFamilyField(const char *name, int length,
+		    const char **family, int *familylen)
+{
+    const char	*end = name + length;
+    const char	*t;
+    int		dashes = 0;
+
+    for (t = name; t < end && dashes < XLFD_FAMILY_FIELD; t++)
+	if (*t == '-')
+	    dashes++;
+    if (dashes < XLFD_FAMILY_FIELD)
+	return FALSE;
+    *family = t;
+    while (t < end && *t != '-')
+	t++;
+    *familylen = t - *family;
+    return TRUE;
+}
+
+static int
+FontFamilyCompare(const char *a, int alen, const char *b, int blen)
+{
+    int	result;
+
+    result = memcmp(a, b, alen < blen ? alen : blen);
+    if (result == 0)
+	result = alen - blen;
+    return result;
+}
+
+static int
+FontFamilyKeyCompare(const void *a, const void *b)
+{
+    FontFamilyKeyPtr	a_key = (FontFamilyKeyPtr) a,
+			b_key = (FontFamilyKeyPtr) b;
+    int			result;
+
+    result = FontFamilyCompare(a_key->family, a_key->length,
+			       b_key->family, b_key->length);
+    if (result == 0)
+	result = a_key->index - b_key->index;
+    return result;
+}
+
+static void
+FontFileIndexFamilies (FontTablePtr table)
+{
+    FontFamilyKeyPtr	keys;
+    int			i, nkeys = 0, nother = 0;
+
+    for (i = 0; i < table->used; i++) {
+	if (table->entries[i].name.ndashes == XLFD_NDASHES)
+	    nkeys++;
+	else if (table->entries[i].name.ndashes > XLFD_NDASHES)
+	    nother++;
+    }
+    if (nkeys < FAMILY_INDEX_MIN)
+	return;
+
+    keys = malloc(nkeys * sizeof(FontFamilyKeyRec));
+    table->familyIndex = malloc((nkeys + nother) * sizeof(int));
+    if (!keys || !table->familyIndex) {
+	free(keys);
+	free(table->familyIndex);
+	table->familyIndex = NULL;
+	return;
+    }
+
+    nkeys = 0;
+    nother = 0;
+    for (i = 0; i < table->used; i++) {
+	FontNamePtr name = &table->entries[i].name;
+
+	if (name->ndashes == XLFD_NDASHES) {
+	    FontFileFamilyField(name->name, name->length,
+				&keys[nkeys].family, &keys[nkeys].length);
+	    keys[nkeys++].index = i;
+	}
+    }
+    qsort(keys, nkeys, sizeof(FontFamilyKeyRec), FontFamilyKeyCompare);
+    for (i = 0; i < nkeys; i++)
+	table->familyIndex[i] = keys[i].index;
+    for (i = 0; i < table->used; i++)
+	if (table->entries[i].name.ndashes > XLFD_NDASHES)
+	    table->familyIndex[nkeys + nother++] = i;
+    table->familyIndexed = nkeys;
+    table->familyIndexSize = nkeys + nother;
+    free(keys);
+}
+
+/*
+ * Return the indices within [start, stop) which may match pat, in
+ * ascending order, or NULL if the whole range has to be searched.
+ */
+static int *
+FontFileFamilyCandidates(FontTablePtr table, FontNamePtr pat,
+			 int start, int stop, int *ncand)
+{
+    const char	*family;
+    int		familylen;
+    int		lo, hi, mid, first, last, other, i, n;
+    int		*cand;
+
+    if (!table->familyIndex || pat->ndashes != XLFD_NDASHES ||
+	stop - start < FAMILY_INDEX_MIN)
+	return NULL;
+    if (!FontFileFamilyField(pat->name, pat->length, &family, &familylen))
+	return NULL;
+    for (i = 0; i < familylen; i++)
+	if (family[i] == '*' || family[i] == '?')
+	    return NULL;
+
+    /* find the run of entries with this family */
+    lo = 0;
+    hi = table->familyIndexed;
+    while (lo < hi) {
+	FontNamePtr name;
+	const char *f;
+	int flen;
+
+	mid = (lo + hi) / 2;
+	name = &table->entries[table->familyIndex[mid]].name;
+	FontFileFamilyField(name->name, name->length, &f, &flen);
+	if (FontFamilyCompare(f, flen, family, familylen) < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    first = lo;
+    hi = table->familyIndexed;
+    while (lo < hi) {
+	FontNamePtr name;
+	const char *f;
+	int flen;
+
+	mid = (lo + hi) / 2;
+	name = &table->entries[table->familyIndex[mid]].name;
+	FontFileFamilyField(name->name, name->length, &f, &flen);
+	if (FontFamilyCompare(f, flen, family, familylen) <= 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    last = lo;
+
+    cand = malloc((last - first + table->familyIndexSize -
+		   table->familyIndexed + 1) * sizeof(int));
+    if (!cand)
+	return NULL;
+
+    /* both runs are in ascending order; merge them */
+    n = 0;
+    other = table->familyIndexed;
+    while (first < last || other < table->familyIndexSize) {
+	if (other == table->familyIndexSize ||
+	    (first < last &&
+	     table->familyIndex[first] < table->familyIndex[other]))
+	    i = table->familyIndex[first++];
+	else
+	    i = table->familyIndex[other++];
+	if (i >= start && i < stop)
+	    cand[n++] = i;
+    }
+    *ncand = n;
+    return cand;
+}
+
 void
 FontFileSortTable (FontTablePtr table)
 {
@@ -256,6 +449,7 @@ FontFileSortTable (FontTablePtr table)
 	qsort((char *) table->entries, table->used, sizeof(FontEntryRec),
 	      FontFileNameCompare);
 	table->sorted = TRUE;
+	FontFileIndexFamilies(table);
     }
 }
 
@@ -446,17 +640,23 @@ FontFileFindNameInScalableDir(FontTablePtr table, FontNamePtr pat,
 			      FontScalablePtr vals)
 {
     int         i,
+                k,
                 start,
                 stop,
                 res,
                 private;
+    int		*cand;
     FontNamePtr	name;
+    FontEntryPtr found = (FontEntryPtr)0;
 
     if (!table->entries)
 	return NULL;
     if ((i = SetupWildMatch(table, pat, &start, &stop, &private)) >= 0)
 	return &table->entries[i];
-    for (i = start; i < stop; i++) {
+    if ((cand = FontFileFamilyCandidates(table, pat, start, stop, &stop)))
+	start = 0;
+    for (k = start; k < stop; k++) {
+	i = cand ? cand[k] : k;
 	name = &table->entries[i].name;
 	res = PatternMatch(pat->name, private, name->name, name->ndashes);
 	if (res > 0)
@@ -480,12 +680,14 @@ FontFileFindNameInScalableDir(FontTablePtr table, FontNamePtr pat,
 		     !(cap & CAP_CHARSUBSETTING)))
 		    continue;
 	    }
-	    return &table->entries[i];
+	    found = &table->entries[i];
+	    break;
 	}
 	if (res < 0)
 	    break;
     }
-    return (FontEntryPtr)0;
+    free(cand);
+    return found;
 }
 
 FontEntryPtr
@@ -500,10 +702,12 @@ FontFileFindNamesInScalableDir(FontTablePtr table, FontNamePtr pat, int max,
 			       int alias_behavior, int *newmax)
 {
     int		    i,
+		    k,
 		    start,
 		    stop,
 		    res,
 		    private;
+    int		    *cand = NULL;
     int		    ret = Successful;
     FontEntryPtr    fname;
     FontNamePtr	    name;
@@ -521,7 +725,11 @@ FontFileFindNamesInScalableDir(FontTablePtr table, FontNamePtr pat, int max,
 	start = i;
 	stop = i + 1;
     }
-    for (i = start, fname = &table->entries[start]; i < stop; i++, fname++) {
+    else if ((cand = FontFileFamilyCandidates(table, pat, start, stop, &stop)))
+	start = 0;
+    for (k = start; k < stop; k++) {
+	i = cand ? cand[k] : k;
+	fname = &table->entries[i];
 	res = PatternMatch(pat->name, private, fname->name.name, fname->name.ndashes);
 	if (res > 0) {
 	    if (vals)
@@ -577,6 +785,7 @@ FontFileFindNamesInScalableDir(FontTablePtr table, FontNamePtr pat, int max,
 	    break;
     }
   bail: ;
+    free(cand);
     if (newmax) *newmax = max;
     return ret;
 }
@@ -602,6 +811,7 @@ FontFileMatchName(char *name, int length, FontNamePtr pat)
     table.size = 1;
     table.sorted = TRUE;
     table.entries = entries;
+    table.familyIndex = NULL;
     entries[0].name.name = name;
     entries[0].name.length = length;
     entries[0].name.ndashes = FontFileCountDashes(name, length);
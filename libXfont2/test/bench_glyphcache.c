@@ -0,0 +1,270 @@
+/*
+ * Times many clients opening the same scalable font one after the other,
+ * each loading the metrics and glyphs of the ISO 8859-1 characters before
+ * closing it again, once with the shared glyph cache disabled and once
+ * with its default budget.  FreeType instances are only shared while a
+ * font is open, so without the cache every client rasterises every glyph
+ * again.
+ *
+ * usage: bench_glyphcache fontdir [xlfd [clients]]
+ *
+ * fontdir has to hold a fonts.dir (as written by mkfontdir) listing a
+ * FreeType font that matches xlfd.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <X11/fonts/fontmisc.h>
+#include <X11/fonts/fontstruct.h>
+#include <X11/fonts/libxfont2.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_FPE_FUNCS 8
+
+static const xfont2_fpe_funcs_rec *fpe_funcs[MAX_FPE_FUNCS];
+static int num_fpe_funcs;
+static FontResolutionRec resolution = { 75, 75, 120 };
+
+static int
+bench_client_auth_generation(ClientPtr client)
+{
+    return 0;
+}
+
+static Bool
+bench_client_signal(ClientPtr client)
+{
+    return TRUE;
+}
+
+static void
+bench_delete_font_client_id(Font id)
+{
+}
+
+static void
+bench_verrorf(const char *f, va_list ap)
+{
+    vfprintf(stderr, f, ap);
+}
+
+static FontPtr
+bench_find_old_font(FSID id)
+{
+    return NULL;
+}
+
+static FontResolutionPtr
+bench_get_client_resolutions(int *num)
+{
+    *num = 1;
+    return &resolution;
+}
+
+static int
+bench_get_default_point_size(void)
+{
+    return 120;
+}
+
+static Font
+bench_get_new_font_client_id(void)
+{
+    return 0;
+}
+
+static uint32_t
+bench_get_time_in_millis(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+static int
+bench_init_fs_handlers(FontPathElementPtr fpe, FontBlockHandlerProcPtr handler)
+{
+    return Successful;
+}
+
+static int
+bench_register_fpe_funcs(const xfont2_fpe_funcs_rec *funcs)
+{
+    if (num_fpe_funcs == MAX_FPE_FUNCS)
+	return -1;
+    fpe_funcs[num_fpe_funcs] = funcs;
+    return num_fpe_funcs++;
+}
+
+static void
+bench_remove_fs_handlers(FontPathElementPtr fpe,
+			 FontBlockHandlerProcPtr handler, Bool all)
+{
+}
+
+static void *
+bench_get_server_client(void)
+{
+    return NULL;
+}
+
+static int
+bench_set_font_authorizations(char **authorizations, int *authlen,
+			      void *client)
+{
+    return 0;
+}
+
+static int
+bench_store_font_client_font(FontPtr pfont, Font id)
+{
+    return 0;
+}
+
+static unsigned long
+bench_get_server_generation(void)
+{
+    return 1;
+}
+
+static int
+bench_add_fs_fd(int fd, FontFdHandlerProcPtr handler, void *data)
+{
+    return 0;
+}
+
+static void
+bench_remove_fs_fd(int fd)
+{
+}
+
+static void
+bench_adjust_fs_wait_for_delay(void *wt, unsigned long newdelay)
+{
+}
+
+/* Atoms are left to libXfont2's own table */
+static const xfont2_client_funcs_rec client_funcs = {
+    .version = XFONT2_CLIENT_FUNCS_VERSION,
+    .client_auth_generation = bench_client_auth_generation,
+    .client_signal = bench_client_signal,
+    .delete_font_client_id = bench_delete_font_client_id,
+    .verrorf = bench_verrorf,
+    .find_old_font = bench_find_old_font,
+    .get_client_resolutions = bench_get_client_resolutions,
+    .get_default_point_size = bench_get_default_point_size,
+    .get_new_font_client_id = bench_get_new_font_client_id,
+    .get_time_in_millis = bench_get_time_in_millis,
+    .init_fs_handlers = bench_init_fs_handlers,
+    .register_fpe_funcs = bench_register_fpe_funcs,
+    .remove_fs_handlers = bench_remove_fs_handlers,
+    .get_server_client = bench_get_server_client,
+    .set_font_authorizations = bench_set_font_authorizations,
+    .store_font_client_font = bench_store_font_client_font,
+    .get_server_generation = bench_get_server_generation,
+    .add_fs_fd = bench_add_fs_fd,
+    .remove_fs_fd = bench_remove_fs_fd,
+    .adjust_fs_wait_for_delay = bench_adjust_fs_wait_for_delay,
+};
+
+static double
+now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static double
+run(const xfont2_fpe_funcs_rec *funcs, FontPathElementPtr fpe,
+    const char *xlfd, int clients)
+{
+    unsigned char chars[2 * 224];
+    CharInfoPtr glyphs[224];
+    unsigned long count;
+    double t0;
+    int i, c;
+
+    for (c = 0; c < 224; c++) {
+	chars[2 * c] = 0;
+	chars[2 * c + 1] = c < 95 ? 32 + c : 160 + c - 95;
+    }
+
+    t0 = now();
+    for (i = 0; i < clients; i++) {
+	FontPtr font = NULL;
+	char *alias = NULL;
+	int rc;
+
+	rc = funcs->open_font(NULL, fpe, FontLoadAll, xlfd, strlen(xlfd),
+			      BitmapFormatByteOrderMSB | BitmapFormatBitOrderMSB |
+			      BitmapFormatImageRectMin |
+			      BitmapFormatScanlinePad32 | BitmapFormatScanlineUnit8,
+			      BitmapFormatMaskByte | BitmapFormatMaskBit |
+			      BitmapFormatMaskImageRectangle |
+			      BitmapFormatMaskScanLinePad |
+			      BitmapFormatMaskScanLineUnit,
+			      0, &font, &alias, NULL);
+	if (rc != Successful || !font) {
+	    fprintf(stderr, "Failed to open %s\n", xlfd);
+	    exit(1);
+	}
+	font->fpe = fpe;
+	(*font->get_metrics) (font, 224, chars, TwoD16Bit, &count, glyphs);
+	(*font->get_glyphs) (font, 224, chars, TwoD16Bit, &count, glyphs);
+	funcs->close_font(fpe, font);
+    }
+    return now() - t0;
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *xlfd = argc > 2 ? argv[2] :
+	"-*-dejavu sans-medium-r-normal--16-*-*-*-p-*-iso8859-1";
+    int clients = argc > 3 ? atoi(argv[3]) : 1000;
+    const xfont2_fpe_funcs_rec *funcs = NULL;
+    xfont2_glyph_cache_stats_rec stats;
+    FontPathElementRec fpe = { 0 };
+    double uncached, cached;
+    int i;
+
+    if (argc < 2) {
+	fprintf(stderr, "usage: %s fontdir [xlfd [clients]]\n", argv[0]);
+	return 1;
+    }
+
+    xfont2_init(&client_funcs);
+    for (i = 0; i < num_fpe_funcs && !funcs; i++)
+	if (fpe_funcs[i]->name_check(argv[1]))
+	    funcs = fpe_funcs[i];
+    fpe.name = argv[1];
+    fpe.name_length = strlen(argv[1]);
+    if (!funcs || funcs->init_fpe(&fpe) != Successful) {
+	fprintf(stderr, "Failed to read fonts from %s\n", argv[1]);
+	return 1;
+    }
+
+    xfont2_set_glyph_cache_limit(0);
+    uncached = run(funcs, &fpe, xlfd, clients);
+    xfont2_set_glyph_cache_limit(4 * 1024 * 1024);
+    cached = run(funcs, &fpe, xlfd, clients);
+    xfont2_get_glyph_cache_stats(&stats);
+
+    printf("%d clients: uncached %.1f us, cached %.1f us per client\n",
+	   clients, uncached / clients * 1e6, cached / clients * 1e6);
+    printf("cache: %lu lookups, %lu hits, %lu misses, %lu entries, "
+	   "%lu bytes\n", stats.lookups, stats.hits, stats.misses,
+	   stats.entries, stats.bytes);
+
+    funcs->free_fpe(&fpe);
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * Checks that the family index of sorted font tables doesn't change what
+ * the lookups used by ListFonts and OpenFont find: every pattern is looked
+ * up in a table with the index and in an identical one without, and the
+ * names found, in order, must be the same.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <X11/fonts/fntfilst.h>
+#include <X11/fonts/libxfont2.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *families[] = {
+    "fixed", "courier", "helvetica", "times", "lucida", "terminal",
+    "clean", "charter", "utopia", "new century schoolbook",
+};
+
+static const char *extra_names[] = {
+    /* more than 14 dashes, the family has one */
+    "-misc-fixed-wide-medium-r-normal--13-120-75-75-c-70-iso8859-1",
+    "-misc-fixed-wide-bold-r-normal--13-120-75-75-c-70-iso8859-1",
+    "-adobe-times-new-medium-r-normal--0-0-0-0-p-0-iso8859-1",
+    /* fewer than 14 */
+    "fixed",
+    "variable",
+    "6x13",
+    "-misc-fixed",
+};
+
+static const char *patterns[] = {
+    /* 14 dashes, literal family */
+    "-misc-fixed-medium-r-normal--13-120-75-75-c-70-iso8859-1",
+    "-*-fixed-medium-r-*-*-*-*-*-*-*-*-*-*",
+    "-*-fixed-*-*-*-*-*-*-*-*-*-*-*-*",
+    "-*-times-bold-i-normal--*-*-*-*-*-*-iso8859-1",
+    "-*-new century schoolbook-*-*-*-*-*-*-*-*-*-*-*-*",
+    "-*-nosuchfamily-*-*-*-*-*-*-*-*-*-*-*-*",
+    "-*-fix?d-*-*-*-*-*-*-*-*-*-*-*-*",
+    /* wildcard family */
+    "-*-*-medium-r-normal--13-*-*-*-*-*-iso8859-1",
+    "-*-fix*-*-*-*-*-*-*-*-*-*-*-*-*",
+    "-misc-*-*-*-*-*-*-*-*-*-*-*-*-*",
+    /* more than 14 dashes */
+    "-misc-fixed-wide-*-*-*-*-*-*-*-*-*-*-*-*",
+    "-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*",
+    /* fewer */
+    "*",
+    "fixed",
+    "6x*",
+    "-*-fixed-*",
+};
+
+static void
+make_name(FontNamePtr name, char *buf, const char *s)
+{
+    CopyISOLatin1Lowered(buf, s, strlen(s));
+    name->name = buf;
+    name->length = strlen(buf);
+    name->ndashes = FontFileCountDashes(buf, name->length);
+}
+
+static void
+add_name(FontTablePtr table, const char *s)
+{
+    char buf[MAXFONTNAMELEN];
+    FontEntryRec entry;
+
+    memset(&entry, 0, sizeof(entry));
+    make_name(&entry.name, buf, s);
+    entry.type = FONT_ENTRY_ALIAS;
+    entry.u.alias.resolved = strdup("fixed");
+    if (!FontFileAddEntry(table, &entry)) {
+        fprintf(stderr, "cannot add %s\n", s);
+        exit(1);
+    }
+}
+
+static void
+fill_table(FontTablePtr table)
+{
+    static const char *weights[] = { "medium", "bold" };
+    static const char *slants[] = { "r", "i", "o" };
+    static const int sizes[] = { 10, 13, 18 };
+    char name[MAXFONTNAMELEN];
+    unsigned f, w, s, z;
+
+    FontFileInitTable(table, 0);
+    for (f = 0; f < sizeof(families) / sizeof(families[0]); f++)
+        for (w = 0; w < 2; w++)
+            for (s = 0; s < 3; s++)
+                for (z = 0; z < 3; z++) {
+                    snprintf(name, sizeof(name),
+                             "-%s-%s-%s-%s-normal--%d-%d-75-75-p-70-iso8859-1",
+                             f % 2 ? "adobe" : "misc", families[f],
+                             weights[w], slants[s], sizes[z], sizes[z] * 10);
+                    add_name(table, name);
+                }
+    for (f = 0; f < sizeof(extra_names) / sizeof(extra_names[0]); f++)
+        add_name(table, extra_names[f]);
+    FontFileSortTable(table);
+}
+
+static int
+compare_names(const char *pattern, int max, FontNamesPtr a, FontNamesPtr b)
+{
+    int i;
+
+    if (a->nnames != b->nnames) {
+        fprintf(stderr, "%s (max %d): %d names with the index, %d without\n",
+                pattern, max, a->nnames, b->nnames);
+        return 1;
+    }
+    for (i = 0; i < a->nnames; i++) {
+        if (a->length[i] != b->length[i] ||
+            memcmp(a->names[i], b->names[i], a->length[i]) != 0) {
+            fprintf(stderr, "%s (max %d): name %d differs\n",
+                    pattern, max, i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int
+main(void)
+{
+    static const int maxes[] = { 1000, 5, 1 };
+    FontTableRec indexed, plain;
+    char buf[MAXFONTNAMELEN];
+    FontNameRec pat;
+    FontEntryPtr ea, eb;
+    FontNamesPtr a, b;
+    unsigned p, m;
+    int failed = 0;
+
+    fill_table(&indexed);
+    fill_table(&plain);
+    if (!indexed.familyIndex) {
+        fprintf(stderr, "no family index was built\n");
+        return 1;
+    }
+    free(plain.familyIndex);
+    plain.familyIndex = NULL;
+
+    for (p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        for (m = 0; m < sizeof(maxes) / sizeof(maxes[0]); m++) {
+            a = xfont2_make_font_names_record(0);
+            b = xfont2_make_font_names_record(0);
+            make_name(&pat, buf, patterns[p]);
+            FontFileFindNamesInDir(&indexed, &pat, maxes[m], a);
+            make_name(&pat, buf, patterns[p]);
+            FontFileFindNamesInDir(&plain, &pat, maxes[m], b);
+            failed |= compare_names(patterns[p], maxes[m], a, b);
+            xfont2_free_font_names(a);
+            xfont2_free_font_names(b);
+        }
+
+        make_name(&pat, buf, patterns[p]);
+        ea = FontFileFindNameInDir(&indexed, &pat);
+        make_name(&pat, buf, patterns[p]);
+        eb = FontFileFindNameInDir(&plain, &pat);
+        if (!ea != !eb || (ea && strcmp(ea->name.name, eb->name.name) != 0)) {
+            fprintf(stderr, "%s: OpenFont lookup differs\n", patterns[p]);
+            failed = 1;
+        }
+    }
+
+    FontFileFreeTable(&indexed);
+    FontFileFreeTable(&plain);
+    return failed;
+}
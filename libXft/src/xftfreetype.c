@@ -24,6 +24,13 @@
 
 _X_HIDDEN FT_Library  _XftFTlibrary;
 
+/*
+ * Small glyph bitmaps are shared through the FreeType cache, which
+ * opens its own faces from the files; XftFtFile pointers are the ids
+ */
+static FTC_Manager    _XftFTCManager;
+static FTC_SBitCache  _XftSBitCache;
+
 #define FT_Matrix_Equal(a,b)	((a)->xx == (b)->xx && \
 				 (a)->yy == (b)->yy && \
 				 (a)->xy == (b)->xy && \
@@ -274,6 +281,8 @@ _XftReleaseFile (XftFtFile *f)
 	}
 	if (f->face)
 	    FT_Done_Face (f->face);
+	if (_XftFTCManager)
+	    FTC_Manager_RemoveFaceID (_XftFTCManager, f);
     }
     XftMemFree (XFT_MEM_FILE,
 		sizeof (XftFtFile) + (f->file ? strlen (f->file) + 1 : 0));
@@ -1157,3 +1166,31 @@ XftInitFtLibrary (void)
 	return FcFalse;
     return FcTrue;
 }
+
+static FT_Error
+_XftRequestFace (FTC_FaceID face_id, FT_Library library,
+		 FT_Pointer request_data, FT_Face *aface)
+{
+    XftFtFile	*f = face_id;
+
+    return FT_New_Face (library, f->file, f->id, aface);
+}
+
+_X_HIDDEN FTC_SBitCache
+_XftGetSBitCache (void)
+{
+    if (_XftSBitCache)
+	return _XftSBitCache;
+    if (!XftInitFtLibrary ())
+	return NULL;
+    if (FTC_Manager_New (_XftFTlibrary, XftMaxFreeTypeFiles, 0, 0,
+			 _XftRequestFace, NULL, &_XftFTCManager))
+	return NULL;
+    if (FTC_SBitCache_New (_XftFTCManager, &_XftSBitCache))
+    {
+	FTC_Manager_Done (_XftFTCManager);
+	_XftFTCManager = NULL;
+	return NULL;
+    }
+    return _XftSBitCache;
+}
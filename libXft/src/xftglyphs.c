@@ -52,7 +52,7 @@ _XftFontValidateMemory (Display *dpy, XftFont *public)
 		font->glyph_memory, glyph_memory);
 }
 
-/* we sometimes need to convert the glyph bitmap in a FT_GlyphSlot
+/* we sometimes need to convert a glyph bitmap
  * into a different format. For example, we want to convert a
  * FT_PIXEL_MODE_LCD or FT_PIXEL_MODE_LCD_V bitmap into a 32-bit
  * ARGB or ABGR bitmap.
@@ -62,8 +62,7 @@ _XftFontValidateMemory (Display *dpy, XftFont *public)
  * input :: target bitmap descriptor. The function will set its
  *          'width', 'rows' and 'pitch' fields, and only these
  *
- * slot  :: the glyph slot containing the source bitmap. this
- *          function assumes that slot->format == FT_GLYPH_FORMAT_BITMAP
+ * ftbit :: the source bitmap, of a glyph slot or a cached sbit
  *
  * mode  :: the requested final rendering mode. supported values are
  *          MONO, NORMAL (i.e. gray), LCD and LCD_V
@@ -77,18 +76,12 @@ _XftFontValidateMemory (Display *dpy, XftFont *public)
  */
 static int
 _compute_xrender_bitmap_size( FT_Bitmap*	target,
-			      FT_GlyphSlot	slot,
+			      FT_Bitmap*	ftbit,
 			      FT_Render_Mode	mode )
 {
-    FT_Bitmap*	ftbit;
     int		width, height, pitch;
 
-    if ( slot->format != FT_GLYPH_FORMAT_BITMAP )
-	return -1;
-
     // compute the size of the final bitmap
-    ftbit = &slot->bitmap;
-
     width = ftbit->width;
     height = ftbit->rows;
     pitch = (width+3) & ~3;
@@ -142,7 +135,7 @@ _compute_xrender_bitmap_size( FT_Bitmap*	target,
     return pitch * height;
 }
 
-/* this functions converts the glyph bitmap found in a FT_GlyphSlot
+/* this functions converts a glyph bitmap
  * into a different format (see _compute_xrender_bitmap_size)
  *
  * you should call this function after _compute_xrender_bitmap_size
@@ -150,7 +143,7 @@ _compute_xrender_bitmap_size( FT_Bitmap*	target,
  * target :: target bitmap descriptor. Note that its 'buffer' pointer
  *           must point to memory allocated by the caller
  *
- * slot   :: the glyph slot containing the source bitmap
+ * ftbit  :: the source bitmap
  *
  * mode   :: the requested final rendering mode
  *
@@ -158,12 +151,10 @@ _compute_xrender_bitmap_size( FT_Bitmap*	target,
  */
 static void
 _fill_xrender_bitmap( FT_Bitmap*	target,
-		      FT_GlyphSlot	slot,
+		      FT_Bitmap*	ftbit,
 		      FT_Render_Mode	mode,
 		      int		bgr )
 {
-    FT_Bitmap*   ftbit = &slot->bitmap;
-
     {
 	unsigned char*	srcLine	= ftbit->buffer;
         unsigned char*	dstLine	= target->buffer;
@@ -339,6 +330,19 @@ _fill_xrender_bitmap( FT_Bitmap*	target,
     }
 }
 
+/*
+ * The sbit cache marks glyphs it failed to load, or which are too large
+ * for it, with a width of 255 and no buffer
+ */
+static FcBool
+_XftSBitUsable (FTC_SBit sbit)
+{
+    if (!sbit->buffer && sbit->width == 255)
+	return FcFalse;
+    return (sbit->format == FT_PIXEL_MODE_MONO ||
+	    (sbit->format == FT_PIXEL_MODE_GRAY && sbit->max_grays == 255));
+}
+
 _X_EXPORT void
 XftFontLoadGlyphs (Display	    *dpy,
 		   XftFont	    *pub,
@@ -365,6 +369,14 @@ XftFontLoadGlyphs (Display	    *dpy,
     FT_Vector	    vector;
     FT_Face	    face;
     FT_Render_Mode  mode = FT_RENDER_MODE_MONO;
+    FT_Int	    bitmap_left, bitmap_top;
+    FT_Vector	    advance;
+    FTC_SBitCache   sbitcache;
+    FTC_ScalerRec   scaler;
+    FTC_SBitRun	    run = NULL;
+    FTC_SBit	    sbit;
+    FT_Bitmap	    sbitmap;
+    int		    i;
 
     if (!info)
 	return;
@@ -390,9 +402,33 @@ XftFontLoadGlyphs (Display	    *dpy,
 	}
     }
 
-    while (nglyph--)
+    /*
+     * Unless they are transformed, emboldened or for subpixel rendering,
+     * the bitmaps of small glyphs come from the FreeType sbit cache, all
+     * of the run with one lookup.  The cache shares them between the
+     * fonts with the same file, size and load flags, so each is only
+     * rendered once.  Glyphs the cache can't hold are loaded below.
+     */
+    if (nglyph > 0 && font->info.file->file &&
+	(face->face_flags & FT_FACE_FLAG_SCALABLE) &&
+	!font->info.transform && !font->info.embolden &&
+	(mode == FT_RENDER_MODE_NORMAL || mode == FT_RENDER_MODE_MONO) &&
+	(sbitcache = _XftGetSBitCache ()))
     {
-	glyphindex = *glyphs++;
+	scaler.face_id = font->info.file;
+	scaler.width = (FT_UInt) font->info.xsize;
+	scaler.height = (FT_UInt) font->info.ysize;
+	scaler.pixel = 0;
+	scaler.x_res = 0;
+	scaler.y_res = 0;
+	if (FTC_SBitCache_LookupRun (sbitcache, &scaler, font->info.load_flags,
+				     glyphs, (FT_UInt) nglyph, 0, &run))
+	    run = NULL;
+    }
+
+    for (i = 0; i < nglyph; i++)
+    {
+	glyphindex = glyphs[i];
 	xftg = font->glyphs[glyphindex];
 	if (!xftg)
 	    continue;
@@ -407,127 +443,200 @@ XftFontLoadGlyphs (Display	    *dpy,
 	if (xftg->glyph_memory)
 	    continue;
 
-	FT_Library_SetLcdFilter( _XftFTlibrary, font->info.lcd_filter);
-
-	error = FT_Load_Glyph (face, glyphindex, font->info.load_flags);
-	if (error)
+	sbit = run ? &run->sbits[i] : NULL;
+	if (sbit && !_XftSBitUsable (sbit))
+	    sbit = NULL;
+	if (sbit)
 	{
 	    /*
-	     * If anti-aliasing or transforming glyphs and
-	     * no outline version exists, fallback to the
-	     * bitmap and let things look bad instead of
-	     * missing the glyph
+	     * Rendered by the cache just as below, with FT_LOAD_RENDER
+	     * doing the FT_Render_Glyph
 	     */
-	    if (font->info.load_flags & FT_LOAD_NO_BITMAP)
-		error = FT_Load_Glyph (face, glyphindex,
-				       font->info.load_flags & ~FT_LOAD_NO_BITMAP);
-	    if (error)
-		continue;
+	    sbitmap.rows = sbit->height;
+	    sbitmap.width = sbit->width;
+	    sbitmap.pitch = sbit->pitch;
+	    sbitmap.buffer = sbit->buffer;
+	    sbitmap.num_grays = sbit->max_grays + 1;
+	    sbitmap.pixel_mode = sbit->format;
+	    ftbit = &sbitmap;
+	    bitmap_left = sbit->left;
+	    bitmap_top = sbit->top;
+	    advance.x = sbit->xadvance * 64;
+	    advance.y = sbit->yadvance * 64;
 	}
+	else
+	{
+	    FT_Library_SetLcdFilter( _XftFTlibrary, font->info.lcd_filter);
+
+	    error = FT_Load_Glyph (face, glyphindex, font->info.load_flags);
+	    if (error)
+	    {
+		/*
+		 * If anti-aliasing or transforming glyphs and
+		 * no outline version exists, fallback to the
+		 * bitmap and let things look bad instead of
+		 * missing the glyph
+		 */
+		if (font->info.load_flags & FT_LOAD_NO_BITMAP)
+		    error = FT_Load_Glyph (face, glyphindex,
+					   font->info.load_flags & ~FT_LOAD_NO_BITMAP);
+		if (error)
+		    continue;
+	    }
 
 #define FLOOR(x)    ((x) & -64)
 #define CEIL(x)	    (((x)+63) & -64)
 #define TRUNC(x)    ((x) >> 6)
 #define ROUND(x)    (((x)+32) & -64)
 
-	glyphslot = face->glyph;
+	    glyphslot = face->glyph;
 
-	/*
-	 * Embolden if required
-	 */
-	if (font->info.embolden) FT_GlyphSlot_Embolden(glyphslot);
+	    /*
+	     * Embolden if required
+	     */
+	    if (font->info.embolden) FT_GlyphSlot_Embolden(glyphslot);
 
-	/*
-	 * Compute glyph metrics from FreeType information
-	 */
-	if(font->info.transform && glyphslot->format != FT_GLYPH_FORMAT_BITMAP)
-	{
 	    /*
-	     * calculate the true width by transforming all four corners.
+	     * Compute glyph metrics from FreeType information
 	     */
-	    int xc, yc;
-	    left = right = top = bottom = 0;
-	    for(xc = 0; xc <= 1; xc ++) {
-		for(yc = 0; yc <= 1; yc++) {
-		    vector.x = glyphslot->metrics.horiBearingX + xc * glyphslot->metrics.width;
-		    vector.y = glyphslot->metrics.horiBearingY - yc * glyphslot->metrics.height;
-		    FT_Vector_Transform(&vector, &font->info.matrix);
-		    if (XftDebug() & XFT_DBG_GLYPH)
-			printf("Trans %d %d: %d %d\n", (int) xc, (int) yc,
-			       (int) vector.x, (int) vector.y);
-		    if(xc == 0 && yc == 0) {
-			left = right = vector.x;
-			top = bottom = vector.y;
-		    } else {
-			if(left > vector.x) left = vector.x;
-			if(right < vector.x) right = vector.x;
-			if(bottom > vector.y) bottom = vector.y;
-			if(top < vector.y) top = vector.y;
-		    }
+	    if(font->info.transform && glyphslot->format != FT_GLYPH_FORMAT_BITMAP)
+	    {
+		/*
+		 * calculate the true width by transforming all four corners.
+		 */
+		int xc, yc;
+		left = right = top = bottom = 0;
+		for(xc = 0; xc <= 1; xc ++) {
+		    for(yc = 0; yc <= 1; yc++) {
+			vector.x = glyphslot->metrics.horiBearingX + xc * glyphslot->metrics.width;
+			vector.y = glyphslot->metrics.horiBearingY - yc * glyphslot->metrics.height;
+			FT_Vector_Transform(&vector, &font->info.matrix);
+			if (XftDebug() & XFT_DBG_GLYPH)
+			    printf("Trans %d %d: %d %d\n", (int) xc, (int) yc,
+				   (int) vector.x, (int) vector.y);
+			if(xc == 0 && yc == 0) {
+			    left = right = vector.x;
+			    top = bottom = vector.y;
+			} else {
+			    if(left > vector.x) left = vector.x;
+			    if(right < vector.x) right = vector.x;
+			    if(bottom > vector.y) bottom = vector.y;
+			    if(top < vector.y) top = vector.y;
+			}
 
+		    }
 		}
-	    }
-	    left = FLOOR(left);
-	    right = CEIL(right);
-	    bottom = FLOOR(bottom);
-	    top = CEIL(top);
+		left = FLOOR(left);
+		right = CEIL(right);
+		bottom = FLOOR(bottom);
+		top = CEIL(top);
 
-	} else {
-	    left  = FLOOR( glyphslot->metrics.horiBearingX );
-	    right = CEIL( glyphslot->metrics.horiBearingX + glyphslot->metrics.width );
+	    } else {
+		left  = FLOOR( glyphslot->metrics.horiBearingX );
+		right = CEIL( glyphslot->metrics.horiBearingX + glyphslot->metrics.width );
 
-	    top    = CEIL( glyphslot->metrics.horiBearingY );
-	    bottom = FLOOR( glyphslot->metrics.horiBearingY - glyphslot->metrics.height );
-	}
+		top    = CEIL( glyphslot->metrics.horiBearingY );
+		bottom = FLOOR( glyphslot->metrics.horiBearingY - glyphslot->metrics.height );
+	    }
 
-	width = TRUNC(right - left);
-	height = TRUNC( top - bottom );
+	    width = TRUNC(right - left);
+	    height = TRUNC( top - bottom );
 
-	/*
-	 * Clip charcell glyphs to the bounding box
-	 * XXX transformed?
-	 */
-	if (font->info.spacing >= FC_CHARCELL && !font->info.transform)
-	{
-	    if (font->info.load_flags & FT_LOAD_VERTICAL_LAYOUT)
+	    /*
+	     * Clip charcell glyphs to the bounding box
+	     * XXX transformed?
+	     */
+	    if (font->info.spacing >= FC_CHARCELL && !font->info.transform)
 	    {
-		if (TRUNC(bottom) > font->public.max_advance_width)
+		if (font->info.load_flags & FT_LOAD_VERTICAL_LAYOUT)
+		{
+		    if (TRUNC(bottom) > font->public.max_advance_width)
+		    {
+			int adjust;
+
+			adjust = bottom - (font->public.max_advance_width << 6);
+			if (adjust > top)
+			    adjust = top;
+			top -= adjust;
+			bottom -= adjust;
+			height = font->public.max_advance_width;
+		    }
+		}
+		else
 		{
-		    int adjust;
-
-		    adjust = bottom - (font->public.max_advance_width << 6);
-		    if (adjust > top)
-			adjust = top;
-		    top -= adjust;
-		    bottom -= adjust;
-		    height = font->public.max_advance_width;
+		    if (TRUNC(right) > font->public.max_advance_width)
+		    {
+			int adjust;
+
+			adjust = right - (font->public.max_advance_width << 6);
+			if (adjust > left)
+			    adjust = left;
+			left -= adjust;
+			right -= adjust;
+			width = font->public.max_advance_width;
+		    }
 		}
 	    }
-	    else
+
+	    if ( glyphslot->format != FT_GLYPH_FORMAT_BITMAP )
 	    {
-		if (TRUNC(right) > font->public.max_advance_width)
+		error = FT_Render_Glyph( face->glyph, mode );
+		if (error)
+		    continue;
+	    }
+
+	    FT_Library_SetLcdFilter( _XftFTlibrary, FT_LCD_FILTER_NONE );
+
+	    ftbit = &glyphslot->bitmap;
+	    bitmap_left = glyphslot->bitmap_left;
+	    bitmap_top = glyphslot->bitmap_top;
+	    advance = glyphslot->advance;
+
+	    width = ftbit->width;
+	    height = ftbit->rows;
+
+	    if (XftDebug() & XFT_DBG_GLYPH)
+	    {
+		printf ("glyph %d:\n", (int) glyphindex);
+		printf (" xywh (%d %d %d %d), trans (%d %d %d %d) wh (%d %d)\n",
+			(int) glyphslot->metrics.horiBearingX,
+			(int) glyphslot->metrics.horiBearingY,
+			(int) glyphslot->metrics.width,
+			(int) glyphslot->metrics.height,
+			left, right, top, bottom,
+			width, height);
+		if (XftDebug() & XFT_DBG_GLYPHV)
 		{
-		    int adjust;
-
-		    adjust = right - (font->public.max_advance_width << 6);
-		    if (adjust > left)
-			adjust = left;
-		    left -= adjust;
-		    right -= adjust;
-		    width = font->public.max_advance_width;
+		    int		    x, y;
+		    unsigned char   *line;
+
+		    line = ftbit->buffer;
+		    if (ftbit->pitch < 0)
+			line -= ftbit->pitch*(height-1);
+
+		    for (y = 0; y < height; y++)
+		    {
+			if (font->info.antialias)
+			{
+			    static const char    den[] = { " .:;=+*#" };
+			    for (x = 0; x < width; x++)
+				printf ("%c", den[line[x] >> 5]);
+			}
+			else
+			{
+			    for (x = 0; x < width * 8; x++)
+			    {
+				printf ("%c", line[x>>3] & (1 << (x & 7)) ? '#' : ' ');
+			    }
+			}
+			printf ("|\n");
+			line += ftbit->pitch;
+		    }
+		    printf ("\n");
 		}
 	    }
 	}
 
-	if ( glyphslot->format != FT_GLYPH_FORMAT_BITMAP )
-	{
-	    error = FT_Render_Glyph( face->glyph, mode );
-	    if (error)
-		continue;
-	}
-
-	FT_Library_SetLcdFilter( _XftFTlibrary, FT_LCD_FILTER_NONE );
-
 	if (font->info.spacing >= FC_MONO)
 	{
 	    if (font->info.transform)
@@ -562,65 +671,18 @@ XftFontLoadGlyphs (Display	    *dpy,
 	}
 	else
 	{
-	    xftg->metrics.xOff = TRUNC(ROUND(glyphslot->advance.x));
-	    xftg->metrics.yOff = -TRUNC(ROUND(glyphslot->advance.y));
-	}
-
-	// compute the size of the final bitmap
-	ftbit = &glyphslot->bitmap;
-
-	width = ftbit->width;
-	height = ftbit->rows;
-
-	if (XftDebug() & XFT_DBG_GLYPH)
-	{
-	    printf ("glyph %d:\n", (int) glyphindex);
-	    printf (" xywh (%d %d %d %d), trans (%d %d %d %d) wh (%d %d)\n",
-		    (int) glyphslot->metrics.horiBearingX,
-		    (int) glyphslot->metrics.horiBearingY,
-		    (int) glyphslot->metrics.width,
-		    (int) glyphslot->metrics.height,
-		    left, right, top, bottom,
-		    width, height);
-	    if (XftDebug() & XFT_DBG_GLYPHV)
-	    {
-		int		x, y;
-		unsigned char	*line;
-
-		line = ftbit->buffer;
-		if (ftbit->pitch < 0)
-		    line -= ftbit->pitch*(height-1);
-
-		for (y = 0; y < height; y++)
-		{
-		    if (font->info.antialias)
-		    {
-			static const char    den[] = { " .:;=+*#" };
-			for (x = 0; x < width; x++)
-			    printf ("%c", den[line[x] >> 5]);
-		    }
-		    else
-		    {
-			for (x = 0; x < width * 8; x++)
-			{
-			    printf ("%c", line[x>>3] & (1 << (x & 7)) ? '#' : ' ');
-			}
-		    }
-		    printf ("|\n");
-		    line += ftbit->pitch;
-		}
-		printf ("\n");
-	    }
+	    xftg->metrics.xOff = TRUNC(ROUND(advance.x));
+	    xftg->metrics.yOff = -TRUNC(ROUND(advance.y));
 	}
 
-	size = _compute_xrender_bitmap_size( &local, glyphslot, mode );
+	size = _compute_xrender_bitmap_size( &local, ftbit, mode );
 	if ( size < 0 )
 	    continue;
 
 	xftg->metrics.width  = local.width;
 	xftg->metrics.height = local.rows;
-	xftg->metrics.x      = - glyphslot->bitmap_left;
-	xftg->metrics.y      =   glyphslot->bitmap_top;
+	xftg->metrics.x      = - bitmap_left;
+	xftg->metrics.y      =   bitmap_top;
 
 	/*
 	 * If the glyph is relatively large (> 1% of server memory),
@@ -645,7 +707,7 @@ XftFontLoadGlyphs (Display	    *dpy,
 
 	local.buffer = bufBitmap;
 
-	_fill_xrender_bitmap( &local, glyphslot, mode,
+	_fill_xrender_bitmap( &local, ftbit, mode,
 			      (font->info.rgba == FC_RGBA_BGR ||
 			       font->info.rgba == FC_RGBA_VBGR ) );
 
@@ -717,6 +779,7 @@ XftFontLoadGlyphs (Display	    *dpy,
     }
     if (bufBitmap != bufLocal)
 	free (bufBitmap);
+    FTC_SBitRun_Done (run);
     XftUnlockFace (&font->public);
 }
 
@@ -59,6 +59,7 @@
 #include "Xft.h"
 #include <fontconfig/fcprivate.h>
 #include <fontconfig/fcfreetype.h>
+#include FT_CACHE_H
 
 /* Added to <X11/Xfuncproto.h> in X11R6.9 and later */
 #ifndef _X_HIDDEN
@@ -400,6 +401,9 @@ XftDrawRenderPrepare (XftDraw	*draw);
 FcBool
 _XftSetFace (XftFtFile *f, FT_F26Dot6 xsize, FT_F26Dot6 ysize, FT_Matrix *matrix);
 
+FTC_SBitCache
+_XftGetSBitCache (void);
+
 void
 XftFontManageMemory (Display *dpy);
 
@@ -33,6 +33,9 @@
 /* Define to 1 if you have the <unistd.h> header file. */
 #define HAVE_UNISTD_H 1
 
+/* Define to 1 if you have the `_XrmDatabaseSerial' function. */
+#define HAVE__XRMDATABASESERIAL 1
+
 /* Define to 1 if Xalloca.h should include <alloca.h> */
 #undef INCLUDE_ALLOCA_H
 
@@ -222,6 +222,7 @@ static XtPerDisplay InitPerDisplay(
 						sizeof(XrmDatabase));
     pd->cmd_db = (XrmDatabase)NULL;
     pd->server_db = (XrmDatabase)NULL;
+    pd->resource_cache = NULL;
     pd->dispatcher_list = NULL;
     pd->ext_select_list = NULL;
     pd->ext_select_count = 0;
@@ -640,6 +641,7 @@ static void CloseDisplay(Display *dpy)
 	    XtFree((char*)xtpd->pdi.trace);
 	    _XtHeapFree(&xtpd->heap);
 	    _XtFreeWWTable(xtpd);
+	    _XtFreeResourceCache(xtpd);
 	    xtpd->per_screen_db[DefaultScreen(dpy)] = (XrmDatabase)NULL;
 	    for (i = ScreenCount(dpy); --i >= 0; ) {
 		db = xtpd->per_screen_db[i];
@@ -442,6 +442,184 @@ void _XtConstraintResDependencies(
     }
 } /* _XtConstraintResDependencies */
 
+/*
+ * Sibling widgets of one class under the same parent (list entries, menu
+ * items) look up exactly the same resources in the same database.  Each
+ * display keeps the outcome of those lookups, keyed by the database, the
+ * resource table and the full name and class lists; a change to the
+ * database, as reported by its serial, empties the entry again.  Values
+ * are still converted per widget, which the converter cache makes cheap.
+ * Only the resource lists of widget classes are cached: the ones
+ * passed to XtGetSubresources and XtGetApplicationResources may be
+ * temporary, and their addresses reused.  Xlib keeps the serial to
+ * itself, so without it nothing is cached.
+ */
+#define RESOURCE_CACHE_SIZE 64	/* entries per display, power of 2 */
+#define SEARCHLISTLEN 100
+
+typedef struct _ResourceValueRec {
+    Boolean		searched;	/* looked up in the database */
+    Boolean		found;		/* and it was there */
+    XrmRepresentation	type;
+    XrmValue		value;
+} ResourceValueRec, *ResourceValue;
+
+typedef struct _ResourceCacheRec {
+    XrmDatabase		db;
+    unsigned int	serial;		/* database serial when filled */
+    XrmResourceList	*table;
+    Cardinal		num_resources;
+    Cardinal		depth;
+    unsigned int	hash;
+    XrmQuark		*quarks;	/* depth names, then depth classes */
+    ResourceValueRec	*values;	/* the table's resources, then
+					   initialResourcesPersistent and
+					   baseTranslations */
+} ResourceCacheRec, *ResourceCache;
+
+/* the database search state of one GetResources call */
+typedef struct _SearchRec {
+    XrmDatabase		db;
+    XrmNameList		names;
+    XrmClassList	classes;
+    XrmHashTable	*list;		/* NULL until needed */
+    unsigned int	size;
+    XrmHashTable	*stack_list;	/* SEARCHLISTLEN entries */
+    ResourceCache	cache;		/* NULL if not caching */
+} SearchRec;
+
+#ifdef HAVE__XRMDATABASESERIAL
+/* private to Xlib, so not in any of its headers */
+extern unsigned int _XrmDatabaseSerial(XrmDatabase);
+
+static ResourceCache GetResourceCache(
+    Widget	    widget,
+    XrmDatabase	    db,
+    XrmNameList	    names,
+    XrmClassList    classes,
+    XrmResourceList* table,
+    Cardinal	    num_resources)
+{
+    XtPerDisplay pd = _XtGetPerDisplay(XtDisplayOfObject(widget));
+    unsigned int serial = _XrmDatabaseSerial(db);
+    unsigned int hash = (unsigned int)(uintptr_t)db ^ (unsigned int)(uintptr_t)table;
+    Cardinal depth, nvalues = num_resources + 2;
+    ResourceCache *slot, rc;
+
+    for (depth = 0; names[depth] != NULLQUARK; depth++)
+	hash = (hash * 31 + names[depth]) * 31 + classes[depth];
+
+    if (pd->resource_cache == NULL)
+	pd->resource_cache = (ResourceCache *)
+	    __XtCalloc(RESOURCE_CACHE_SIZE, sizeof(ResourceCache));
+    slot = &pd->resource_cache[hash & (RESOURCE_CACHE_SIZE - 1)];
+    rc = *slot;
+    if (rc != NULL && rc->hash == hash && rc->db == db &&
+	rc->table == table && rc->num_resources == num_resources &&
+	rc->depth == depth &&
+	memcmp(rc->quarks, names, depth * sizeof(XrmQuark)) == 0 &&
+	memcmp(rc->quarks + depth, classes, depth * sizeof(XrmQuark)) == 0) {
+	if (rc->serial != serial) {
+	    rc->serial = serial;
+	    XtBZero((char *) rc->values, nvalues * sizeof(ResourceValueRec));
+	}
+	return rc;
+    }
+
+    /* replace whatever was there */
+    XtFree((char *) rc);
+    rc = (ResourceCache) __XtMalloc(sizeof(ResourceCacheRec) +
+				    nvalues * sizeof(ResourceValueRec) +
+				    2 * depth * sizeof(XrmQuark));
+    rc->db = db;
+    rc->serial = serial;
+    rc->table = table;
+    rc->num_resources = num_resources;
+    rc->depth = depth;
+    rc->hash = hash;
+    rc->values = (ResourceValueRec *) (rc + 1);
+    rc->quarks = (XrmQuark *) (rc->values + nvalues);
+    XtBZero((char *) rc->values, nvalues * sizeof(ResourceValueRec));
+    (void) memmove(rc->quarks, names, depth * sizeof(XrmQuark));
+    (void) memmove(rc->quarks + depth, classes, depth * sizeof(XrmQuark));
+    *slot = rc;
+    return rc;
+}
+#endif /* HAVE__XRMDATABASESERIAL */
+
+void _XtFreeResourceCache(
+    XtPerDisplay pd)
+{
+    int i;
+
+    if (pd->resource_cache == NULL)
+	return;
+    for (i = 0; i < RESOURCE_CACHE_SIZE; i++)
+	XtFree((char *) pd->resource_cache[i]);
+    XtFree((char *) pd->resource_cache);
+    pd->resource_cache = NULL;
+}
+
+static XrmHashTable *GetSearchList(
+    SearchRec *search)
+{
+    if (search->list == NULL) {
+	search->list = search->stack_list;
+	search->size = SEARCHLISTLEN;
+	while (!XrmQGetSearchList(search->db, search->names, search->classes,
+				  search->list, search->size)) {
+	    if (search->list == search->stack_list)
+		search->list = NULL;
+	    search->list = (XrmHashTable*)XtRealloc((char*)search->list,
+						    sizeof(XrmHashTable) *
+						    (search->size *= 2));
+	}
+    }
+    return search->list;
+}
+
+static void FreeSearchList(
+    SearchRec *search)
+{
+    if (search->list != search->stack_list)
+	XtFree((char*)search->list);
+    search->list = NULL;
+}
+
+/* XrmQGetSearchResource, going through the cache slot if there is one */
+static Boolean SearchResource(
+    SearchRec	    *search,
+    Cardinal	    slot,
+    XrmName	    name,
+    XrmClass	    class,
+    XrmRepresentation* pType,
+    XrmValue*	    pValue)
+{
+    ResourceValue rv = NULL;
+    Boolean found;
+
+    if (search->cache != NULL) {
+	rv = &search->cache->values[slot];
+	if (rv->searched) {
+	    if (rv->found) {
+		*pType = rv->type;
+		*pValue = rv->value;
+	    }
+	    return rv->found;
+	}
+    }
+    found = XrmQGetSearchResource(GetSearchList(search), name, class,
+				  pType, pValue);
+    if (rv != NULL) {
+	rv->searched = True;
+	rv->found = found;
+	if (found) {
+	    rv->type = *pType;
+	    rv->value = *pValue;
+	}
+    }
+    return found;
+}
 
 
 
@@ -470,21 +648,20 @@ static XtCacheRef *GetResources(
     unsigned	    num_args,       /* number of items in arg list	    */
     XtTypedArgList  typed_args,	    /* Typed arg list to override resources */
     Cardinal*	    pNumTypedArgs,  /* number of items in typed arg list    */
-    Boolean	    tm_hack)	    /* do baseTranslations		    */
+    Boolean	    tm_hack,	    /* do baseTranslations		    */
+    Boolean	    cacheable)	    /* table belongs to a widget class	    */
 {
 /*
  * assert: *pNumTypedArgs == 0 if num_args > 0
  * assert: num_args == 0 if *pNumTypedArgs > 0
  */
-#define SEARCHLISTLEN 100
 #define MAXRESOURCES  400
 
     XrmValue	    value;
     XrmQuark	    rawType;
     XrmValue	    convValue;
     XrmHashTable    stackSearchList[SEARCHLISTLEN];
-    XrmHashTable    *searchList = stackSearchList;
-    unsigned int    searchListSize = SEARCHLISTLEN;
+    SearchRec	    search;
     Boolean	    found[MAXRESOURCES];
     int		    typed[MAXRESOURCES];
     XtCacheRef	    cache_ref[MAXRESOURCES];
@@ -583,14 +760,19 @@ static XtCacheRef *GetResources(
        do a single-level search on each resource */
 
     db = XtScreenDatabase(XtScreenOfObject(widget));
-    while (!XrmQGetSearchList(db, names, classes,
-			      searchList, searchListSize)) {
-	if (searchList == stackSearchList)
-	    searchList = NULL;
-	searchList = (XrmHashTable*)XtRealloc((char*)searchList,
-					      sizeof(XrmHashTable) *
-					      (searchListSize *= 2));
-    }
+    search.db = db;
+    search.names = names;
+    search.classes = classes;
+    search.list = NULL;
+    search.stack_list = stackSearchList;
+#ifdef HAVE__XRMDATABASESERIAL
+    /* shells can switch screens, and so databases, below */
+    if (cacheable && !XtIsShell(widget))
+	search.cache = GetResourceCache(widget, db, names, classes,
+					table, num_resources);
+    else
+#endif
+	search.cache = NULL;
 
     if (persistent_resources)
 	cache_base = NULL;
@@ -625,8 +807,8 @@ static XtCacheRef *GetResources(
 		    cache_base++;
 	    }
 	    if (!found[j]) {
-		if (XrmQGetSearchResource(searchList, Qscreen, QScreen,
-				      &rawType, &value)) {
+		if (SearchResource(&search, j, Qscreen, QScreen,
+				   &rawType, &value)) {
 		    if (rawType != QScreen) {
 			convValue.size = sizeof(Screen*);
 			convValue.addr = (XPointer)&widget->core.screen;
@@ -644,14 +826,8 @@ static XtCacheRef *GetResources(
 	/* now get the database to use for the rest of the resources */
 	if (widget->core.screen != oldscreen) {
 	    db = XtScreenDatabase(widget->core.screen);
-	    while (!XrmQGetSearchList(db, names, classes,
-				      searchList, searchListSize)) {
-		if (searchList == stackSearchList)
-		    searchList = NULL;
-		searchList = (XrmHashTable*)XtRealloc((char*)searchList,
-						      sizeof(XrmHashTable) *
-						      (searchListSize *= 2));
-	    }
+	    FreeSearchList(&search);
+	    search.db = db;
 	}
     }
 
@@ -671,7 +847,8 @@ static XtCacheRef *GetResources(
 	char*	char_ptr;
 
 	if (!found_persistence) {
-	    if (XrmQGetSearchResource(searchList, QinitialResourcesPersistent,
+	    if (SearchResource(&search, num_resources,
+			QinitialResourcesPersistent,
 			QInitialResourcesPersistent, &rawType, &value)) {
 		if (rawType != QBoolean) {
 		    convValue.size = sizeof(Boolean);
@@ -754,7 +931,7 @@ static XtCacheRef *GetResources(
 		Boolean	already_copied = False;
 		Boolean have_value = False;
 
-		if (XrmQGetSearchResource(searchList,
+		if (SearchResource(&search, j,
 			rx->xrm_name, rx->xrm_class, &rawType, &value)) {
 		    if (rawType != xrm_type) {
 			convValue.size = rx->xrm_size;
@@ -859,8 +1036,8 @@ static XtCacheRef *GetResources(
 	    (!widget->core.tm.translations ||
 	     (do_tm_hack &&
 	      widget->core.tm.translations->operation != XtTableReplace)) &&
-	    XrmQGetSearchResource(searchList, QbaseTranslations,
-				  QTranslations, &rawType, &value)) {
+	    SearchResource(&search, num_resources + 1, QbaseTranslations,
+			   QTranslations, &rawType, &value)) {
 	    if (rawType != QTranslationTable) {
 		convValue.size = sizeof(XtTranslations);
 		convValue.addr = (XPointer)&widget->core.tm.current_state;
@@ -877,7 +1054,7 @@ static XtCacheRef *GetResources(
 	}
     }
     if ((Cardinal)num_typed_args != *pNumTypedArgs) *pNumTypedArgs = num_typed_args;
-    if (searchList != stackSearchList) XtFree((char*)searchList);
+    FreeSearchList(&search);
     if (!cache_ptr)
 	cache_ptr = cache_base;
     if (cache_ptr && cache_ptr != cache_ref) {
@@ -964,7 +1141,7 @@ XtCacheRef *_XtGetResources(
     cache_refs = GetResources(w, (char*)w, names, classes,
 	(XrmResourceList *) wc->core_class.resources,
 	wc->core_class.num_resources, quark_args, args, num_args,
-	typed_args, num_typed_args, XtIsWidget(w));
+	typed_args, num_typed_args, XtIsWidget(w), True);
 
     if (w->core.constraints != NULL) {
 	cwc = (ConstraintWidgetClass) XtClass(w->core.parent);
@@ -972,7 +1149,8 @@ XtCacheRef *_XtGetResources(
 	    GetResources(w, (char*)w->core.constraints, names, classes,
 	    (XrmResourceList *) cwc->constraint_class.resources,
 	    cwc->constraint_class.num_resources,
-	    quark_args, args, num_args, typed_args, num_typed_args, False);
+	    quark_args, args, num_args, typed_args, num_typed_args, False,
+	    True);
 	if (cache_refs_core) {
 	    XtFree((char *)cache_refs_core);
 	}
@@ -1035,7 +1213,7 @@ void _XtGetSubresources (
     table = _XtCreateIndirectionTable(resources, num_resources);
     Resrc = GetResources(w, (char*)base, names, classes, table, num_resources,
 			quark_args, args, num_args,
-			typed_args, &ntyped_args, False);
+			typed_args, &ntyped_args, False, False);
     FreeCache(quark_cache, quark_args);
     XtFree((char *)table);
     XtFree((char *)Resrc);
@@ -1117,7 +1295,7 @@ void _XtGetApplicationResources (
 
     Resrc = GetResources(w, (char*)base, names, classes, table, num_resources,
 			quark_args, args, num_args,
-			typed_args, &ntyped_args, False);
+			typed_args, &ntyped_args, False, False);
     FreeCache(quark_cache, quark_args);
     XtFree((char *)table);
     XtFree((char *)Resrc);
@@ -0,0 +1,73 @@
+/*
+ * Times the creation of many sibling widgets of one class and name, the
+ * case where GetResources repeats the same database lookups per widget.
+ * The second run changes the database before each widget, so that no
+ * lookup result can be reused.
+ *
+ * Needs an X server; Core and Composite stand in for Xaw widgets so that
+ * libXt does not need libXaw to build it.
+ *
+ * usage: bench_resources [count]
+ */
+
+#include <X11/Intrinsic.h>
+#include <X11/StringDefs.h>
+#include <X11/Shell.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static String fallback[] = {
+    "*background: gray75",
+    "*borderColor: black",
+    "*box.item.borderWidth: 2",
+    "*box*Core.width: 40",
+    "*box*Core.height: 20",
+    NULL
+};
+
+static double run(Widget toplevel, const char *name, int count, Boolean cold)
+{
+    XrmDatabase db = XtDatabase(XtDisplay(toplevel));
+    struct timespec t0, t1;
+    Widget box;
+    int i;
+
+    box = XtCreateWidget(name, compositeWidgetClass, toplevel, NULL, 0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < count; i++) {
+	if (cold)
+	    XrmPutStringResource(&db, "*box.other.x", "1");
+	XtCreateWidget("item", coreWidgetClass, box, NULL, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    XtDestroyWidget(box);
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    int count = 10000;
+    XtAppContext app;
+    Widget toplevel;
+    double t;
+
+    toplevel = XtOpenApplication(&app, "BenchResources", NULL, 0,
+				 &argc, argv, fallback,
+				 applicationShellWidgetClass, NULL, 0);
+    if (argc > 1)
+	count = atoi(argv[1]);
+
+    /* fill the converter cache first */
+    run(toplevel, "box", 100, False);
+
+    t = run(toplevel, "box", count, False);
+    printf("%-8s %d widgets in %.3f s, %.0f widgets/s\n",
+	   "cached", count, t, count / t);
+    t = run(toplevel, "box", count, True);
+    printf("%-8s %d widgets in %.3f s, %.0f widgets/s\n",
+	   "uncached", count, t, count / t);
+
+    XtDestroyApplicationContext(app);
+    return 0;
+}
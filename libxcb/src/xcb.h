@@ -329,6 +329,20 @@ xcb_generic_event_t *xcb_poll_for_event(xcb_connection_t *c);
  */
 xcb_generic_event_t *xcb_poll_for_queued_event(xcb_connection_t *c);
 
+/**
+ * @brief Frees an event, keeping its memory for the next events.
+ * @param c The connection the event was read from.
+ * @param event The event or error to free, or @c NULL.
+ *
+ * Does the same as free(), but lets the connection reuse the buffers of
+ * ordinary 32-byte events and errors instead of allocating new ones,
+ * which helps applications that process many events. The event must
+ * have been returned by one of the event functions above, by
+ * xcb_request_check or as the error of a reply function for @p c, and
+ * must not be used afterwards. It is fine to mix this with free().
+ */
+void xcb_free_event(xcb_connection_t *c, xcb_generic_event_t *event);
+
 typedef struct xcb_special_event xcb_special_event_t;
 
 /**
@@ -64,6 +64,11 @@
 #define SHUT_RDWR 2
 #endif
 
+#ifdef _WIN32
+/* the most buffers handed to one WSASend */
+#define XCB_WSABUF_MAX 16
+#endif
+
 typedef struct {
     uint8_t  status;
     uint8_t  pad0[5];
@@ -220,44 +225,29 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
     int n;
 
 #ifdef _WIN32
-    int i = 0;
-    int cnt=*count;
-    struct iovec *vec;
-    n = 0;
+    /* One gathering WSASend rather than a send per iovec: the queue and
+     * the pieces of a big request go out in a single call. */
+    WSABUF bufs[XCB_WSABUF_MAX];
+    DWORD sent;
+    int i;
     assert(!c->out.queue_len);
-
-    /* Could use the WSASend win32 function for scatter/gather i/o but setting up the WSABUF struct from
-       an iovec would require more work and I'm not sure of the benefit....works for now */
-    vec = *vector;
-    while(i < cnt)
+    n = *count;
+    if (n > XCB_WSABUF_MAX)
+        n = XCB_WSABUF_MAX;
+    for (i = 0; i < n; ++i)
     {
-      char *p= vec->iov_base;
-      size_t l= vec->iov_len;
-      while (l > 0)
-      {
-         int ret = send(c->fd, p, l, 0); 
-         if(ret == SOCKET_ERROR)
-         {
-             int err  = WSAGetLastError();
-             if(err == WSAEWOULDBLOCK)
-             {
-                 if (n)
-                 {
-                   /* already return the data */
-                   i=cnt;
-                   break;
-                 }
-                 else
-                   return 1;
-             }
-         }
-         p += ret;
-         l -= ret;
-         n += ret;
-      }
-      vec++;
-      i++;
+        bufs[i].buf = (*vector)[i].iov_base;
+        bufs[i].len = (*vector)[i].iov_len;
     }
+    ++c->out.write_calls;
+    if (WSASend(c->fd, bufs, n, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+    {
+        if (WSAGetLastError() == WSAEWOULDBLOCK)
+            return 1;
+        n = -1;
+    }
+    else
+        n = sent;
 #else
     assert(!c->out.queue_len);
     n = *count;
@@ -286,6 +276,7 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
         hdr->cmsg_type = SCM_RIGHTS;
         memcpy(CMSG_DATA(hdr), c->out.out_fd.fd, c->out.out_fd.nfd * sizeof (int));
 
+        ++c->out.write_calls;
         n = sendmsg(c->fd, &msg, 0);
         if(n < 0 && errno == EAGAIN)
             return 1;
@@ -295,6 +286,7 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
     } else
 #endif
     {
+        ++c->out.write_calls;
         n = writev(c->fd, *vector, n);
         if(n < 0 && errno == EAGAIN)
             return 1;
@@ -307,6 +299,7 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
         _xcb_conn_shutdown(c, XCB_CONN_ERROR);
         return 0;
     }
+    c->out.bytes_written += n;
 
     for(; *count; --*count, ++*vector)
     {
@@ -478,6 +471,7 @@ int _xcb_conn_wait(xcb_connection_t *c, pthread_cond_t *cond, struct iovec **vec
     FD_SET(c->fd, &rfds);
 #endif
     ++c->in.reading;
+    _xcb_in_update_poll_state(c);
 
 #if USE_POLL
     if(count)
@@ -553,6 +547,7 @@ int _xcb_conn_wait(xcb_connection_t *c, pthread_cond_t *cond, struct iovec **vec
     if(count)
         --c->out.writing;
     --c->in.reading;
+    _xcb_in_update_poll_state(c);
 
     return ret;
 }
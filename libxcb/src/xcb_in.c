@@ -91,9 +91,13 @@ typedef struct pending_reply {
     struct pending_reply *next;
 } pending_reply;
 
+/* A thread waiting in xcb_wait_for_reply. The thread reading the
+ * socket hands the first reply straight to the waiting thread through
+ * the reply slot, which is then all it has to look at when it wakes. */
 typedef struct reader_list {
     uint64_t request;
     pthread_cond_t *data;
+    void *reply;
     struct reader_list *next;
 } reader_list;
 
@@ -102,6 +106,100 @@ typedef struct special_list {
     struct special_list *next;
 } special_list;
 
+/* Events, the list nodes holding events and replies, and the
+ * pending_reply records come and go at the rate of the server traffic,
+ * so keep the freed ones on per-connection free lists instead of going
+ * to malloc for each of them. List nodes and pending_reply records never
+ * leave libxcb: they are carved out of chunks, which are only released
+ * with the connection. Events are handed to the application, which may
+ * free() them, so they are malloc()ed one at a time and only recycled
+ * when they come back through xcb_free_event. */
+
+#define SLAB_CHUNK_OBJECTS 64
+#define MAX_FREE_EVENTS 256
+
+typedef union list_node {
+    struct event_list event;
+    struct reply_list reply;
+} list_node;
+
+typedef union slab_chunk {
+    union slab_chunk *next;
+    uint64_t align;
+} slab_chunk;
+
+static void slab_init(_xcb_slab *slab, size_t object_size)
+{
+    slab->free_list = 0;
+    slab->chunks = 0;
+    slab->object_size = object_size;
+}
+
+static void *slab_alloc(_xcb_slab *slab)
+{
+    void **obj = slab->free_list;
+    if(!obj)
+    {
+        slab_chunk *chunk = malloc(sizeof(slab_chunk) + SLAB_CHUNK_OBJECTS * slab->object_size);
+        char *p;
+        int i;
+        if(!chunk)
+            return 0;
+        chunk->next = slab->chunks;
+        slab->chunks = chunk;
+        p = (char *) (chunk + 1);
+        for(i = 0; i < SLAB_CHUNK_OBJECTS; ++i, p += slab->object_size)
+        {
+            *(void **) p = slab->free_list;
+            slab->free_list = p;
+        }
+        obj = slab->free_list;
+    }
+    slab->free_list = *obj;
+    return obj;
+}
+
+static void slab_free(_xcb_slab *slab, void *obj)
+{
+    *(void **) obj = slab->free_list;
+    slab->free_list = obj;
+}
+
+static void slab_destroy(_xcb_slab *slab)
+{
+    while(slab->chunks)
+    {
+        slab_chunk *chunk = slab->chunks;
+        slab->chunks = chunk->next;
+        free(chunk);
+    }
+    slab->free_list = 0;
+}
+
+/* Only for buffers of sizeof(xcb_generic_event_t) bytes: plain events
+ * and errors. */
+static void *alloc_event(_xcb_in *in)
+{
+    void **buf = in->free_events;
+    if(!buf)
+        return malloc(sizeof(xcb_generic_event_t));
+    in->free_events = *buf;
+    --in->free_events_len;
+    return buf;
+}
+
+static void recycle_event(_xcb_in *in, void *buf)
+{
+    if(in->free_events_len >= MAX_FREE_EVENTS)
+    {
+        free(buf);
+        return;
+    }
+    *(void **) buf = in->free_events;
+    in->free_events = buf;
+    ++in->free_events_len;
+}
+
 static void remove_finished_readers(reader_list **prev_reader, uint64_t completed)
 {
     while(*prev_reader && XCB_SEQUENCE_COMPARE((*prev_reader)->request, <=, completed))
@@ -214,7 +312,7 @@ static int read_packet(xcb_connection_t *c)
             c->in.pending_replies = oldpend->next;
             if(!oldpend->next)
                 c->in.pending_replies_tail = &c->in.pending_replies;
-            free(oldpend);
+            slab_free(&c->in.pending_nodes, oldpend);
         }
 
         if(genrep.response_type == XCB_ERROR)
@@ -255,7 +353,9 @@ static int read_packet(xcb_connection_t *c)
 
     bufsize = length + eventlength + nfd * sizeof(int)  +
         (genrep.response_type == XCB_REPLY ? 0 : sizeof(uint32_t));
-    if (bufsize < INT32_MAX)
+    if (bufsize == sizeof(xcb_generic_event_t))
+        buf = alloc_event(&c->in);
+    else if (bufsize < INT32_MAX)
         buf = malloc((size_t) bufsize);
     else
         buf = NULL;
@@ -294,7 +394,10 @@ static int read_packet(xcb_connection_t *c)
 
     if(pend && (pend->flags & XCB_REQUEST_DISCARD_REPLY))
     {
-        free(buf);
+        if(bufsize == sizeof(xcb_generic_event_t))
+            recycle_event(&c->in, buf);
+        else
+            free(buf);
         return 1;
     }
 
@@ -305,7 +408,22 @@ static int read_packet(xcb_connection_t *c)
     if( genrep.response_type == XCB_REPLY ||
        (genrep.response_type == XCB_ERROR && pend && (pend->flags & XCB_REQUEST_CHECKED)))
     {
-        struct reply_list *cur = malloc(sizeof(struct reply_list));
+        struct reply_list *cur;
+        reader_list *reader = c->in.readers;
+        if(reader && reader->request == c->in.request_read)
+        {
+            /* Later replies to the same request queue up behind this one. */
+            if(!reader->reply && !c->in.current_reply)
+            {
+                reader->reply = buf;
+                pthread_cond_signal(reader->data);
+                return 1;
+            }
+        }
+        else
+            reader = 0;
+
+        cur = slab_alloc(&c->in.list_nodes);
         if(!cur)
         {
             _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
@@ -316,13 +434,13 @@ static int read_packet(xcb_connection_t *c)
         cur->next = 0;
         *c->in.current_reply_tail = cur;
         c->in.current_reply_tail = &cur->next;
-        if(c->in.readers && c->in.readers->request == c->in.request_read)
-            pthread_cond_signal(c->in.readers->data);
+        if(reader)
+            pthread_cond_signal(reader->data);
         return 1;
     }
 
     /* event, or unchecked error */
-    event = malloc(sizeof(struct event_list));
+    event = slab_alloc(&c->in.list_nodes);
     if(!event)
     {
         _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
@@ -335,6 +453,7 @@ static int read_packet(xcb_connection_t *c)
     if (!event_special(c, event)) {
         *c->in.events_tail = event;
         c->in.events_tail = &event->next;
+        _xcb_in_update_poll_state(c);
         pthread_cond_signal(&c->in.event_cond);
     }
     return 1; /* I have something for you... */
@@ -349,20 +468,19 @@ static xcb_generic_event_t *get_event(xcb_connection_t *c)
     ret = cur->event;
     c->in.events = cur->next;
     if(!cur->next)
+    {
         c->in.events_tail = &c->in.events;
-    free(cur);
+        _xcb_in_update_poll_state(c);
+    }
+    slab_free(&c->in.list_nodes, cur);
     return ret;
 }
 
+/* The nodes themselves go with the connection's slab. */
 static void free_reply_list(struct reply_list *head)
 {
-    while(head)
-    {
-        struct reply_list *cur = head;
-        head = cur->next;
-        free(cur->reply);
-        free(cur);
-    }
+    for(; head; head = head->next)
+        free(head->reply);
 }
 
 static int read_block(const int fd, void *buf, const ssize_t len)
@@ -405,6 +523,19 @@ static int read_block(const int fd, void *buf, const ssize_t len)
     return len;
 }
 
+static void split_reply(xcb_connection_t *c, void *buf, void **reply, xcb_generic_error_t **error)
+{
+    if(((xcb_generic_reply_t *) buf)->response_type == XCB_ERROR)
+    {
+        if(error)
+            *error = buf;
+        else
+            recycle_event(&c->in, buf);
+    }
+    else
+        *reply = buf;
+}
+
 static int poll_for_reply(xcb_connection_t *c, uint64_t request, void **reply, xcb_generic_error_t **error)
 {
     struct reply_list *head;
@@ -444,17 +575,8 @@ static int poll_for_reply(xcb_connection_t *c, uint64_t request, void **reply, x
 
     if(head)
     {
-        if(((xcb_generic_reply_t *) head->reply)->response_type == XCB_ERROR)
-        {
-            if(error)
-                *error = head->reply;
-            else
-                free(head->reply);
-        }
-        else
-            *reply = head->reply;
-
-        free(head);
+        split_reply(c, head->reply, reply, error);
+        slab_free(&c->in.list_nodes, head);
     }
 
     return 1;
@@ -466,6 +588,7 @@ static void insert_reader(reader_list **prev_reader, reader_list *reader, uint64
         prev_reader = &(*prev_reader)->next;
     reader->request = request;
     reader->data = cond;
+    reader->reply = 0;
     reader->next = *prev_reader;
     *prev_reader = reader;
 }
@@ -473,11 +596,14 @@ static void insert_reader(reader_list **prev_reader, reader_list *reader, uint64
 static void remove_reader(reader_list **prev_reader, reader_list *reader)
 {
     while(*prev_reader && XCB_SEQUENCE_COMPARE((*prev_reader)->request, <=, reader->request))
+    {
         if(*prev_reader == reader)
         {
             *prev_reader = (*prev_reader)->next;
             break;
         }
+        prev_reader = &(*prev_reader)->next;
+    }
 }
 
 static void insert_special(special_list **prev_special, special_list *special, xcb_special_event_t *se)
@@ -512,10 +638,14 @@ static void *wait_for_reply(xcb_connection_t *c, uint64_t request, xcb_generic_e
 
         insert_reader(&c->in.readers, &reader, request, &cond);
 
-        while(!poll_for_reply(c, request, &ret, e))
+        while(!reader.reply && !poll_for_reply(c, request, &ret, e))
             if(!_xcb_conn_wait(c, &cond, 0, 0))
                 break;
 
+        /* The slot holds the oldest reply, if any. */
+        if(reader.reply)
+            split_reply(c, reader.reply, &ret, e);
+
         remove_reader(&c->in.readers, &reader);
         pthread_cond_destroy(&cond);
     }
@@ -570,7 +700,7 @@ int *xcb_get_reply_fds(xcb_connection_t *c, void *reply, size_t reply_size)
 static void insert_pending_discard(xcb_connection_t *c, pending_reply **prev_next, uint64_t seq)
 {
     pending_reply *pend;
-    pend = malloc(sizeof(*pend));
+    pend = slab_alloc(&c->in.pending_nodes);
     if(!pend)
     {
         _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
@@ -703,6 +833,16 @@ static xcb_generic_event_t *poll_for_next_event(xcb_connection_t *c, int queued)
     xcb_generic_event_t *ret = 0;
     if(!c->has_error)
     {
+        /* Don't take the lock just to find nothing: with no queued
+         * events, and the socket either not to be read or being read by
+         * another thread, the locked path would return NULL too. Losing
+         * a race here is no different from having polled a moment
+         * earlier. */
+#ifdef XCB_HAVE_ATOMICS
+        long state = XCB_ATOMIC_LOAD(&c->in.poll_state);
+        if(!(state & XCB_POLL_EVENTS) && (queued || (state & XCB_POLL_READING)))
+            return 0;
+#endif
         pthread_mutex_lock(&c->iolock);
         /* FIXME: follow X meets Z architecture changes. */
         ret = get_event(c);
@@ -723,6 +863,22 @@ xcb_generic_event_t *xcb_poll_for_queued_event(xcb_connection_t *c)
     return poll_for_next_event(c, 1);
 }
 
+void xcb_free_event(xcb_connection_t *c, xcb_generic_event_t *event)
+{
+    if(!event)
+        return;
+    /* XGE events may be longer than the buffers we keep. */
+    if(c->has_error ||
+       ((event->response_type & 0x7f) == XCB_XGE_EVENT && ((xcb_ge_event_t *) event)->length))
+    {
+        free(event);
+        return;
+    }
+    pthread_mutex_lock(&c->iolock);
+    recycle_event(&c->in, event);
+    pthread_mutex_unlock(&c->iolock);
+}
+
 xcb_generic_error_t *xcb_request_check(xcb_connection_t *c, xcb_void_cookie_t cookie)
 {
     uint64_t request;
@@ -754,7 +910,7 @@ static xcb_generic_event_t *get_special_event(xcb_connection_t *c,
         event = events->event;
         if (!(se->events = events->next))
             se->events_tail = &se->events;
-        free (events);
+        slab_free(&c->in.list_nodes, events);
     }
     return event;
 }
@@ -860,7 +1016,7 @@ xcb_unregister_for_special_event(xcb_connection_t *c,
             for (events = se->events; events; events = next) {
                 next = events->next;
                 free (events->event);
-                free (events);
+                slab_free(&c->in.list_nodes, events);
             }
             pthread_cond_destroy(&se->special_event_cond);
             free (se);
@@ -891,6 +1047,11 @@ int _xcb_in_init(_xcb_in *in)
     in->events_tail = &in->events;
     in->pending_replies_tail = &in->pending_replies;
 
+    slab_init(&in->list_nodes, sizeof(list_node));
+    slab_init(&in->pending_nodes, sizeof(pending_reply));
+    in->free_events = 0;
+    in->free_events_len = 0;
+
     return 1;
 }
 
@@ -899,18 +1060,16 @@ void _xcb_in_destroy(_xcb_in *in)
     pthread_cond_destroy(&in->event_cond);
     free_reply_list(in->current_reply);
     _xcb_map_delete(in->replies, (void (*)(void *)) free_reply_list);
-    while(in->events)
-    {
-        struct event_list *e = in->events;
-        in->events = e->next;
-        free(e->event);
-        free(e);
-    }
-    while(in->pending_replies)
+    for(; in->events; in->events = in->events->next)
+        free(in->events->event);
+    in->pending_replies = 0;
+    slab_destroy(&in->list_nodes);
+    slab_destroy(&in->pending_nodes);
+    while(in->free_events)
     {
-        pending_reply *pend = in->pending_replies;
-        in->pending_replies = pend->next;
-        free(pend);
+        void **buf = in->free_events;
+        in->free_events = *buf;
+        free(buf);
     }
 }
 
@@ -926,9 +1085,22 @@ void _xcb_in_wake_up_next_reader(xcb_connection_t *c)
     assert(pthreadret == 0);
 }
 
+/* Called with iolock held whenever events or reading change. */
+void _xcb_in_update_poll_state(xcb_connection_t *c)
+{
+#ifdef XCB_HAVE_ATOMICS
+    long state = 0;
+    if(c->in.events)
+        state |= XCB_POLL_EVENTS;
+    if(c->in.reading)
+        state |= XCB_POLL_READING;
+    XCB_ATOMIC_STORE(&c->in.poll_state, state);
+#endif
+}
+
 int _xcb_in_expect_reply(xcb_connection_t *c, uint64_t request, enum workarounds workaround, int flags)
 {
-    pending_reply *pend = malloc(sizeof(pending_reply));
+    pending_reply *pend = slab_alloc(&c->in.pending_nodes);
     assert(workaround != WORKAROUND_NONE || flags != 0);
     if(!pend)
     {
@@ -409,6 +409,20 @@ int xcb_writev(xcb_connection_t *c, struct iovec *vector, int count, uint64_t re
     return ret;
 }
 
+void xcb_get_output_stats(xcb_connection_t *c, uint64_t *requests, uint64_t *writes, uint64_t *bytes)
+{
+    if(c->has_error)
+        return;
+    pthread_mutex_lock(&c->iolock);
+    if(requests)
+        *requests = c->out.request;
+    if(writes)
+        *writes = c->out.write_calls;
+    if(bytes)
+        *bytes = c->out.bytes_written;
+    pthread_mutex_unlock(&c->iolock);
+}
+
 int xcb_flush(xcb_connection_t *c)
 {
     int ret;
@@ -439,6 +453,9 @@ int _xcb_out_init(_xcb_out *out)
     out->request = 0;
     out->request_written = 0;
 
+    out->write_calls = 0;
+    out->bytes_written = 0;
+
     if(pthread_mutex_init(&out->reqlenlock, 0))
         return 0;
     out->maximum_request_length_tag = LAZY_NONE;
@@ -233,6 +233,19 @@ int xcb_take_socket(xcb_connection_t *c, void (*return_socket)(void *closure), v
  */
 int xcb_writev(xcb_connection_t *c, struct iovec *vector, int count, uint64_t requests);
 
+/**
+ * @brief Returns counters of the data sent to the X server.
+ * @param c The connection to the X server.
+ * @param requests Where to store the number of requests sent, or NULL.
+ * @param writes Where to store the number of write system calls made, or NULL.
+ * @param bytes Where to store the number of bytes written, or NULL.
+ *
+ * Meant for tuning how a client batches its requests: the fewer writes
+ * per request, the better the output queue does its job. Nothing is
+ * stored if the connection has shut down.
+ */
+void xcb_get_output_stats(xcb_connection_t *c, uint64_t *requests, uint64_t *writes, uint64_t *bytes);
+
 
 /* xcb_in.c */
 
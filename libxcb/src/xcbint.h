@@ -65,6 +65,20 @@ enum lazy_reply_tag
 
 #define container_of(pointer,type,member) ((type *)(((char *)(pointer)) - offsetof(type, member)))
 
+/* Atomic access to the few fields read without holding iolock. They are
+ * still only written with iolock held. Without atomics, the readers take
+ * the lock. */
+#if defined(__GNUC__)
+#define XCB_HAVE_ATOMICS 1
+#define XCB_ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define XCB_ATOMIC_STORE(p,v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define XCB_HAVE_ATOMICS 1
+#define XCB_ATOMIC_LOAD(p) _InterlockedOr((p), 0)
+#define XCB_ATOMIC_STORE(p,v) ((void) _InterlockedExchange((p), (v)))
+#endif
+
 /* xcb_list.c */
 
 typedef void (*xcb_list_free_func_t)(void *);
@@ -104,6 +118,9 @@ typedef struct _xcb_out {
     uint64_t request;
     uint64_t request_written;
 
+    uint64_t write_calls;
+    uint64_t bytes_written;
+
     pthread_mutex_t reqlenlock;
     enum lazy_reply_tag maximum_request_length_tag;
     union {
@@ -125,9 +142,17 @@ int _xcb_out_flush_to(xcb_connection_t *c, uint64_t request);
 
 /* xcb_in.c */
 
+typedef struct _xcb_slab {
+    void *free_list;
+    void *chunks;
+    size_t object_size;
+} _xcb_slab;
+
 typedef struct _xcb_in {
     pthread_cond_t event_cond;
     int reading;
+    /* XCB_POLL_* flags mirroring events and reading, for unlocked polls */
+    long poll_state;
 
     char queue[4096];
     int queue_len;
@@ -150,6 +175,11 @@ typedef struct _xcb_in {
     _xcb_fd in_fd;
 #endif
     struct xcb_special_event *special_events;
+
+    _xcb_slab list_nodes;
+    _xcb_slab pending_nodes;
+    void *free_events;
+    int free_events_len;
 } _xcb_in;
 
 int _xcb_in_init(_xcb_in *in);
@@ -157,6 +187,10 @@ void _xcb_in_destroy(_xcb_in *in);
 
 void _xcb_in_wake_up_next_reader(xcb_connection_t *c);
 
+#define XCB_POLL_EVENTS  1
+#define XCB_POLL_READING 2
+void _xcb_in_update_poll_state(xcb_connection_t *c);
+
 int _xcb_in_expect_reply(xcb_connection_t *c, uint64_t request, enum workarounds workaround, int flags);
 void _xcb_in_replies_done(xcb_connection_t *c);
 
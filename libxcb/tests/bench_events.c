@@ -0,0 +1,151 @@
+/* Streams events from a fake server through xcb_poll_for_event, once
+ * releasing them with free() and once with xcb_free_event.
+ *
+ * usage: bench_events [count]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "xcb.h"
+
+#define CHUNK_EVENTS 2048
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	while(len)
+	{
+		ssize_t n = write(fd, p, len);
+		if(n <= 0)
+			return 0;
+		p += n;
+		len -= n;
+	}
+	return 1;
+}
+
+/* Answer the connection setup, then send count MotionNotify events. */
+static void fake_server(int fd, long count)
+{
+	static uint32_t chunk[CHUNK_EVENTS * 8];
+	char setup_request[12];
+	char setup[40];
+	size_t got = 0;
+	long sent;
+	int i;
+
+	while(got < sizeof(setup_request))
+	{
+		ssize_t n = read(fd, setup_request + got, sizeof(setup_request) - got);
+		if(n <= 0)
+			_exit(1);
+		got += n;
+	}
+
+	/* a successful xcb_setup_t without vendor, formats or screens */
+	memset(setup, 0, sizeof(setup));
+	setup[0] = 1;
+	setup[2] = 11;
+	setup[6] = (sizeof(setup) - 8) / 4;
+	if(!write_all(fd, setup, sizeof(setup)))
+		_exit(1);
+
+	memset(chunk, 0, sizeof(chunk));
+	for(i = 0; i < CHUNK_EVENTS; ++i)
+		((xcb_generic_event_t *) &chunk[i * 8])->response_type = XCB_MOTION_NOTIFY;
+	for(sent = 0; sent < count; sent += CHUNK_EVENTS)
+	{
+		long n = count - sent < CHUNK_EVENTS ? count - sent : CHUNK_EVENTS;
+		if(!write_all(fd, chunk, n * 32))
+			_exit(1);
+	}
+	_exit(0);
+}
+
+static double run(long count, int recycle)
+{
+	xcb_connection_t *c;
+	struct timespec t0, t1;
+	int fds[2];
+	pid_t pid;
+	long n = 0;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+	{
+		perror("socketpair");
+		exit(1);
+	}
+	pid = fork();
+	if(pid < 0)
+	{
+		perror("fork");
+		exit(1);
+	}
+	if(pid == 0)
+	{
+		close(fds[0]);
+		fake_server(fds[1], count);
+	}
+	close(fds[1]);
+
+	c = xcb_connect_to_fd(fds[0], 0);
+	if(xcb_connection_has_error(c))
+	{
+		fprintf(stderr, "connection setup failed\n");
+		exit(1);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while(n < count)
+	{
+		xcb_generic_event_t *ev = xcb_poll_for_event(c);
+		if(!ev)
+		{
+			struct pollfd pfd;
+			if(xcb_connection_has_error(c))
+				break;
+			pfd.fd = xcb_get_file_descriptor(c);
+			pfd.events = POLLIN;
+			poll(&pfd, 1, -1);
+			continue;
+		}
+		if(ev->response_type == XCB_MOTION_NOTIFY)
+			++n;
+		if(recycle)
+			xcb_free_event(c, ev);
+		else
+			free(ev);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	xcb_disconnect(c);
+	waitpid(pid, 0, 0);
+	if(n != count)
+	{
+		fprintf(stderr, "got %ld of %ld events\n", n, count);
+		exit(1);
+	}
+	return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	long count = argc > 1 ? atol(argv[1]) : 1000000;
+	int recycle;
+
+	signal(SIGPIPE, SIG_IGN);
+	for(recycle = 0; recycle < 2; ++recycle)
+	{
+		double t = run(count, recycle);
+		printf("%-14s %ld events in %.3f s, %.0f events/s\n",
+		       recycle ? "xcb_free_event" : "free", count, t, count / t);
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+/* Streams PutImage requests interleaved with small GC changes and
+ * points to a fake server, and reports how many writes that took.
+ *
+ * usage: bench_output [iterations [image bytes]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "xcb.h"
+#include "xcbext.h"
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	while(len)
+	{
+		ssize_t n = write(fd, p, len);
+		if(n <= 0)
+			return 0;
+		p += n;
+		len -= n;
+	}
+	return 1;
+}
+
+/* Answer the connection setup, then swallow everything. */
+static void fake_server(int fd)
+{
+	static char buf[65536];
+	char setup_request[12];
+	char setup[40];
+	size_t got = 0;
+
+	while(got < sizeof(setup_request))
+	{
+		ssize_t n = read(fd, setup_request + got, sizeof(setup_request) - got);
+		if(n <= 0)
+			_exit(1);
+		got += n;
+	}
+
+	/* a successful xcb_setup_t without vendor, formats or screens */
+	memset(setup, 0, sizeof(setup));
+	setup[0] = 1;
+	setup[2] = 11;
+	setup[6] = (sizeof(setup) - 8) / 4;
+	setup[26] = setup[27] = 0xff; /* maximum_request_length */
+	if(!write_all(fd, setup, sizeof(setup)))
+		_exit(1);
+
+	while(read(fd, buf, sizeof(buf)) > 0)
+		;
+	_exit(0);
+}
+
+int main(int argc, char **argv)
+{
+	long iterations = argc > 1 ? atol(argv[1]) : 20000;
+	long image_bytes = argc > 2 ? atol(argv[2]) : 16384;
+	uint64_t requests = 0, writes = 0, bytes = 0;
+	xcb_connection_t *c;
+	struct timespec t0, t1;
+	uint8_t *image;
+	uint16_t width;
+	int fds[2];
+	pid_t pid;
+	long i;
+	double t;
+
+	signal(SIGPIPE, SIG_IGN);
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+	{
+		perror("socketpair");
+		return 1;
+	}
+	pid = fork();
+	if(pid < 0)
+	{
+		perror("fork");
+		return 1;
+	}
+	if(pid == 0)
+	{
+		close(fds[0]);
+		fake_server(fds[1]);
+	}
+	close(fds[1]);
+
+	c = xcb_connect_to_fd(fds[0], 0);
+	if(xcb_connection_has_error(c))
+	{
+		fprintf(stderr, "connection setup failed\n");
+		return 1;
+	}
+
+	/* one row of a 32 bpp ZPixmap image */
+	width = image_bytes / 4;
+	image = calloc(width, 4);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < iterations; ++i)
+	{
+		uint32_t foreground = i;
+		xcb_point_t point = { i & 0xff, i >> 8 & 0xff };
+
+		xcb_change_gc(c, 2, XCB_GC_FOREGROUND, &foreground);
+		xcb_put_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, 1, 2, width, 1, 0, i & 0xff,
+		              0, 24, width * 4, image);
+		xcb_poly_point(c, XCB_COORD_MODE_ORIGIN, 1, 2, 1, &point);
+	}
+	xcb_flush(c);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	xcb_get_output_stats(c, &requests, &writes, &bytes);
+	xcb_disconnect(c);
+	waitpid(pid, 0, 0);
+	free(image);
+
+	t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("%llu requests, %llu writes (%.3f per request), %.1f MB in %.3f s, %.1f MB/s\n",
+	       (unsigned long long) requests, (unsigned long long) writes,
+	       requests ? (double) writes / requests : 0.0,
+	       bytes / 1e6, t, t ? bytes / 1e6 / t : 0.0);
+	return 0;
+}
@@ -0,0 +1,196 @@
+/* Measures round trips through one connection shared by several
+ * threads, against a fake server answering GetInputFocus requests,
+ * while one more thread polls for events.
+ *
+ * usage: bench_roundtrip [round trips per thread [max threads]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "xcb.h"
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	while(len)
+	{
+		ssize_t n = write(fd, p, len);
+		if(n <= 0)
+			return 0;
+		p += n;
+		len -= n;
+	}
+	return 1;
+}
+
+/* Answer the connection setup, then reply to every GetInputFocus
+ * until the client goes away. */
+static void fake_server(int fd)
+{
+	static unsigned char in[65536], out[65536];
+	char setup_request[12];
+	char setup[40];
+	size_t got = 0, have = 0;
+	unsigned int seq = 0;
+
+	while(got < sizeof(setup_request))
+	{
+		ssize_t n = read(fd, setup_request + got, sizeof(setup_request) - got);
+		if(n <= 0)
+			_exit(1);
+		got += n;
+	}
+
+	/* a successful xcb_setup_t without vendor, formats or screens */
+	memset(setup, 0, sizeof(setup));
+	setup[0] = 1;
+	setup[2] = 11;
+	setup[6] = (sizeof(setup) - 8) / 4;
+	setup[26] = setup[27] = 0xff; /* maximum_request_length */
+	if(!write_all(fd, setup, sizeof(setup)))
+		_exit(1);
+
+	for(;;)
+	{
+		size_t pos = 0, nout = 0;
+		ssize_t n = read(fd, in + have, sizeof(in) - have);
+		if(n <= 0)
+			_exit(0);
+		have += n;
+		while(have - pos >= 4)
+		{
+			size_t len = (in[pos + 2] | in[pos + 3] << 8) * 4;
+			if(len < 4)
+				_exit(1);
+			if(have - pos < len)
+				break;
+			++seq;
+			if(in[pos] == XCB_GET_INPUT_FOCUS)
+			{
+				xcb_get_input_focus_reply_t *r = (xcb_get_input_focus_reply_t *) (out + nout);
+				memset(r, 0, 32);
+				r->response_type = 1;
+				r->sequence = seq;
+				r->focus = seq;
+				nout += 32;
+			}
+			pos += len;
+		}
+		memmove(in, in + pos, have - pos);
+		have -= pos;
+		if(nout && !write_all(fd, out, nout))
+			_exit(0);
+	}
+}
+
+static xcb_connection_t *c;
+static long round_trips;
+static volatile int done;
+
+static void *worker(void *arg)
+{
+	long i;
+	(void) arg;
+	for(i = 0; i < round_trips; ++i)
+	{
+		xcb_get_input_focus_cookie_t cookie = xcb_get_input_focus(c);
+		xcb_get_input_focus_reply_t *r = xcb_get_input_focus_reply(c, cookie, 0);
+		if(!r || r->focus != cookie.sequence)
+		{
+			fprintf(stderr, "bad reply\n");
+			exit(1);
+		}
+		free(r);
+	}
+	return 0;
+}
+
+static void *event_poller(void *arg)
+{
+	(void) arg;
+	while(!done)
+	{
+		xcb_generic_event_t *ev = xcb_poll_for_event(c);
+		if(ev)
+			free(ev);
+		else
+			sched_yield();
+	}
+	return 0;
+}
+
+static double run(int threads)
+{
+	pthread_t tid[64], poller;
+	struct timespec t0, t1;
+	int fds[2];
+	pid_t pid;
+	int i;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+	{
+		perror("socketpair");
+		exit(1);
+	}
+	pid = fork();
+	if(pid < 0)
+	{
+		perror("fork");
+		exit(1);
+	}
+	if(pid == 0)
+	{
+		close(fds[0]);
+		fake_server(fds[1]);
+	}
+	close(fds[1]);
+
+	c = xcb_connect_to_fd(fds[0], 0);
+	if(xcb_connection_has_error(c))
+	{
+		fprintf(stderr, "connection setup failed\n");
+		exit(1);
+	}
+
+	done = 0;
+	pthread_create(&poller, 0, event_poller, 0);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < threads; ++i)
+		pthread_create(&tid[i], 0, worker, 0);
+	for(i = 0; i < threads; ++i)
+		pthread_join(tid[i], 0);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	done = 1;
+	pthread_join(poller, 0);
+
+	xcb_disconnect(c);
+	waitpid(pid, 0, 0);
+	return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+	int threads;
+
+	round_trips = argc > 1 ? atol(argv[1]) : 20000;
+	if(max_threads > 64)
+		max_threads = 64;
+	signal(SIGPIPE, SIG_IGN);
+	for(threads = 1; threads <= max_threads; threads *= 2)
+	{
+		double t = run(threads);
+		printf("%2d threads: %ld round trips in %.3f s, %.0f/s\n",
+		       threads, threads * round_trips, t, threads * round_trips / t);
+	}
+	return 0;
+}
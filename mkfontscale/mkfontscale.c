@@ -42,6 +42,8 @@
 #include <X11/Xos.h>
 #include <X11/Xfuncproto.h>
 #include <X11/fonts/fontenc.h>
+#include <X11/fonts/fontstruct.h>
+#include <X11/fonts/libxfont2.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_SFNT_NAMES_H
@@ -1013,6 +1015,9 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
     entries = NULL;
     if(fontscale_name) {
         fclose(fontscale);
+        /* Let the server skip parsing fonts.dir */
+        if(strcmp(outfilename, "fonts.dir") == 0)
+            xfont2_write_font_dir_index(dirname);
         free(fontscale_name);
     }
 
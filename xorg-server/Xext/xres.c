@@ -298,6 +298,10 @@ ProcXResQueryClientResources(ClientPtr client)
     REQUEST(xXResQueryClientResourcesReq);
     xXResQueryClientResourcesReply rep;
     int i, clientID, num_types;
+#ifdef COMPOSITE
+    CompPixmapPoolStats pool = { 0 };
+#endif
+    CARD64 cpu_time;
     int *counts;
 
     REQUEST_SIZE_MATCH(xXResQueryClientResourcesReq);
@@ -320,6 +324,21 @@ ProcXResQueryClientResources(ClientPtr client)
             num_types++;
     }
 
+#ifdef COMPOSITE
+    /* pooled backing pixmaps belong to nobody but the server */
+    if (clientID == 0)
+        compGetPixmapPoolStats(&pool);
+    if (pool.pixmaps)
+        num_types++;
+#endif
+
+    /* the time spent running its requests, as a count of milliseconds */
+    cpu_time = clients[clientID]->smart_cpu_time / 1000;
+    if (cpu_time > 0xffffffff)
+        cpu_time = 0xffffffff;
+    if (cpu_time)
+        num_types++;
+
     rep = (xXResQueryClientResourcesReply) {
         .type = X_Reply,
         .sequenceNumber = client->sequence,
@@ -344,6 +363,31 @@ ProcXResQueryClientResources(ClientPtr client)
             scratch.resource_type = resourceTypeAtom(i + 1);
             scratch.count = counts[i];
 
+            if (client->swapped) {
+                swapl(&scratch.resource_type);
+                swapl(&scratch.count);
+            }
+            WriteToClient(client, sz_xXResType, &scratch);
+        }
+
+#ifdef COMPOSITE
+        if (pool.pixmaps) {
+            scratch.resource_type = MakeAtom("COMPOSITE_POOLED_PIXMAP", 23,
+                                             TRUE);
+            scratch.count = pool.pixmaps;
+
+            if (client->swapped) {
+                swapl(&scratch.resource_type);
+                swapl(&scratch.count);
+            }
+            WriteToClient(client, sz_xXResType, &scratch);
+        }
+#endif
+
+        if (cpu_time) {
+            scratch.resource_type = MakeAtom("CLIENT_CPU_TIME_MS", 18, TRUE);
+            scratch.count = cpu_time;
+
             if (client->swapped) {
                 swapl(&scratch.resource_type);
                 swapl(&scratch.count);
@@ -390,6 +434,16 @@ ProcXResQueryClientPixmapBytes(ClientPtr client)
     FindAllClientResources(clients[clientID], ResFindResourcePixmaps,
                            (void *) (&bytes));
 
+#ifdef COMPOSITE
+    /* pooled backing pixmaps belong to nobody but the server */
+    if (clientID == 0) {
+        CompPixmapPoolStats stats;
+
+        compGetPixmapPoolStats(&stats);
+        bytes += stats.bytes;
+    }
+#endif
+
     rep = (xXResQueryClientPixmapBytesReply) {
         .type = X_Reply,
         .sequenceNumber = client->sequence,
@@ -310,7 +310,7 @@ compFreeClientWindow(WindowPtr pWin, XID id)
 
     if (pPixmap) {
         compRestoreWindow(pWin, pPixmap);
-        (*pScreen->DestroyPixmap) (pPixmap);
+        compDestroyPixmap(pScreen, pPixmap);
     }
 }
 
@@ -527,15 +527,195 @@ compUnredirectOneSubwindow(WindowPtr pParent, WindowPtr pWin)
     return Success;
 }
 
+/*
+ * Backing pixmaps freed when windows are unmapped or resized are kept in a
+ * small per-screen pool.  A window's first backing pixmap has its exact
+ * size; those allocated when it is resized are a little larger, rounding
+ * each dimension up to a multiple of 64, or of 1/16 to 1/8 of it from 1024
+ * on, so while a window is interactively resized the pixmap given up by the
+ * last step can usually be reused for the next one.  Only the drawable size changes; the
+ * stride and the bits stay where they are.
+ *
+ * Pooled pixmaps are freed when the pool has not been used for a while.
+ * Pixmaps which were named by a client or whose bits aren't in memory
+ * (devPrivate.ptr is NULL, so ModifyPixmapHeader can't be trusted to keep
+ * them) are never pooled.
+ */
+#define COMP_PIXMAP_POOL_BYTES	    (128 << 20)
+#define COMP_PIXMAP_POOL_TIMEOUT    2000
+
+static int
+compPoolDimension(int n)
+{
+    int step = 64;
+
+    while (step * 16 <= n)
+        step <<= 1;
+    return (n + step - 1) & ~(step - 1);
+}
+
+static unsigned long
+compPooledBytes(PixmapPtr pPixmap)
+{
+    return (unsigned long) pPixmap->devKind * GetCompPixmap(pPixmap)->allocHeight;
+}
+
+static Bool
+compSetPixmapSize(PixmapPtr pPixmap, int w, int h)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+
+    return (*pScreen->ModifyPixmapHeader) (pPixmap, w, h,
+                                           pPixmap->drawable.depth,
+                                           pPixmap->drawable.bitsPerPixel,
+                                           pPixmap->devKind,
+                                           pPixmap->devPrivate.ptr);
+}
+
+void
+compFlushPixmapPool(ScreenPtr pScreen)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+
+    while (cs->numPooledPixmaps)
+        (*pScreen->DestroyPixmap) (cs->pixmapPool[--cs->numPooledPixmaps]);
+    TimerCancel(cs->pixmapPoolTimer);
+}
+
+static CARD32
+compPixmapPoolTimeout(OsTimerPtr timer, CARD32 time, void *arg)
+{
+    compFlushPixmapPool(arg);
+    return 0;
+}
+
+/*
+ * Take the smallest pooled pixmap which is large enough, but not more than
+ * twice the size it would be allocated with
+ */
+static PixmapPtr
+compGetPooledPixmap(ScreenPtr pScreen, int w, int h, int depth)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+    CARD64 limit = 2 * (CARD64) compPoolDimension(w) * compPoolDimension(h);
+    CARD64 area, bestArea = 0;
+    PixmapPtr pPixmap;
+    int i, best = -1;
+
+    for (i = 0; i < cs->numPooledPixmaps; i++) {
+        CompPixmapPtr cp = GetCompPixmap(cs->pixmapPool[i]);
+
+        if (cs->pixmapPool[i]->drawable.depth != depth ||
+            cp->allocWidth < w || cp->allocHeight < h)
+            continue;
+        area = (CARD64) cp->allocWidth * cp->allocHeight;
+        if (area <= limit && (best < 0 || area < bestArea)) {
+            best = i;
+            bestArea = area;
+        }
+    }
+    if (best < 0)
+        return NULL;
+
+    pPixmap = cs->pixmapPool[best];
+    cs->pixmapPool[best] = cs->pixmapPool[--cs->numPooledPixmaps];
+    if (!compSetPixmapSize(pPixmap, w, h)) {
+        (*pScreen->DestroyPixmap) (pPixmap);
+        return NULL;
+    }
+    return pPixmap;
+}
+
+static PixmapPtr
+compCreateBackingPixmap(ScreenPtr pScreen, int w, int h, int depth,
+                        Bool resize)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+    PixmapPtr pPixmap;
+    int allocWidth, allocHeight;
+
+    if (cs->noPixmapPool)
+        return (*pScreen->CreatePixmap) (pScreen, w, h, depth,
+                                         CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+
+    pPixmap = compGetPooledPixmap(pScreen, w, h, depth);
+    if (pPixmap)
+        return pPixmap;
+
+    allocWidth = resize ? compPoolDimension(w) : w;
+    allocHeight = resize ? compPoolDimension(h) : h;
+    pPixmap = (*pScreen->CreatePixmap) (pScreen, allocWidth, allocHeight, depth,
+                                        CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    if (!pPixmap)
+        return NULL;
+
+    if (!pPixmap->devPrivate.ptr || !compSetPixmapSize(pPixmap, w, h)) {
+        /* Not memory we can resize ourselves, stop trying */
+        (*pScreen->DestroyPixmap) (pPixmap);
+        cs->noPixmapPool = TRUE;
+        return (*pScreen->CreatePixmap) (pScreen, w, h, depth,
+                                         CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    }
+
+    GetCompPixmap(pPixmap)->allocWidth = allocWidth;
+    GetCompPixmap(pPixmap)->allocHeight = allocHeight;
+    return pPixmap;
+}
+
+/*
+ * Give up a backing pixmap, keeping it for reuse if possible
+ */
+void
+compDestroyPixmap(ScreenPtr pScreen, PixmapPtr pPixmap)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+    unsigned long bytes = 0;
+    int i;
+
+    if (pPixmap->refcnt == 1 && GetCompPixmap(pPixmap)->allocWidth &&
+        cs->numPooledPixmaps < COMP_PIXMAP_POOL_SIZE) {
+        for (i = 0; i < cs->numPooledPixmaps; i++)
+            bytes += compPooledBytes(cs->pixmapPool[i]);
+        if (bytes + compPooledBytes(pPixmap) <= COMP_PIXMAP_POOL_BYTES) {
+            cs->pixmapPool[cs->numPooledPixmaps++] = pPixmap;
+            cs->pixmapPoolTimer = TimerSet(cs->pixmapPoolTimer, 0,
+                                           COMP_PIXMAP_POOL_TIMEOUT,
+                                           compPixmapPoolTimeout, pScreen);
+            return;
+        }
+    }
+    (*pScreen->DestroyPixmap) (pPixmap);
+}
+
+void
+compGetPixmapPoolStats(CompPixmapPoolStats *stats)
+{
+    int s, i;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!dixPrivateKeyRegistered(CompScreenPrivateKey))
+        return;
+
+    for (s = 0; s < screenInfo.numScreens; s++) {
+        CompScreenPtr cs = GetCompScreen(screenInfo.screens[s]);
+
+        if (!cs)
+            continue;
+        for (i = 0; i < cs->numPooledPixmaps; i++)
+            stats->bytes += compPooledBytes(cs->pixmapPool[i]);
+        stats->pixmaps += cs->numPooledPixmaps;
+    }
+}
+
 static PixmapPtr
-compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
+compNewPixmap(WindowPtr pWin, int x, int y, int w, int h, Bool resize)
 {
     ScreenPtr pScreen = pWin->drawable.pScreen;
     WindowPtr pParent = pWin->parent;
     PixmapPtr pPixmap;
 
-    pPixmap = (*pScreen->CreatePixmap) (pScreen, w, h, pWin->drawable.depth,
-                                        CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    pPixmap = compCreateBackingPixmap(pScreen, w, h, pWin->drawable.depth,
+                                      resize);
 
     if (!pPixmap)
         return 0;
@@ -603,7 +783,7 @@ compAllocPixmap(WindowPtr pWin)
     int y = pWin->drawable.y - bw;
     int w = pWin->drawable.width + (bw << 1);
     int h = pWin->drawable.height + (bw << 1);
-    PixmapPtr pPixmap = compNewPixmap(pWin, x, y, w, h);
+    PixmapPtr pPixmap = compNewPixmap(pWin, x, y, w, h, FALSE);
     CompWindowPtr cw = GetCompWindow(pWin);
 
     if (!pPixmap)
@@ -680,7 +860,7 @@ compReallocPixmap(WindowPtr pWin, int draw_x, int draw_y,
     pix_w = w + (bw << 1);
     pix_h = h + (bw << 1);
     if (pix_w != pOld->drawable.width || pix_h != pOld->drawable.height) {
-        pNew = compNewPixmap(pWin, pix_x, pix_y, pix_w, pix_h);
+        pNew = compNewPixmap(pWin, pix_x, pix_y, pix_w, pix_h, TRUE);
         if (!pNew)
             return FALSE;
         cw->pOldPixmap = pOld;
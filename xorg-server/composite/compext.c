@@ -257,6 +257,8 @@ ProcCompositeNameWindowPixmap(ClientPtr client)
         return rc;
 
     ++pPixmap->refcnt;
+    /* clients may hold on to it in ways the pool can't see */
+    GetCompPixmap(pPixmap)->allocWidth = 0;
 
     if (!AddResource(stuff->pixmap, RT_PIXMAP, (void *) pPixmap))
         return BadAlloc;
@@ -753,6 +755,7 @@ PanoramiXCompositeNameWindowPixmap(ClientPtr client)
             return BadAlloc;
 
         ++pPixmap->refcnt;
+        GetCompPixmap(pPixmap)->allocWidth = 0;
     }
 
     if (!AddResource(stuff->pixmap, XRT_PIXMAP, (void *) newPix))
@@ -51,6 +51,7 @@
 DevPrivateKeyRec CompScreenPrivateKeyRec;
 DevPrivateKeyRec CompWindowPrivateKeyRec;
 DevPrivateKeyRec CompSubwindowsPrivateKeyRec;
+DevPrivateKeyRec CompPixmapPrivateKeyRec;
 
 static Bool
 compCloseScreen(ScreenPtr pScreen)
@@ -59,6 +60,8 @@ compCloseScreen(ScreenPtr pScreen)
     Bool ret;
 
     free(cs->alternateVisuals);
+    compFlushPixmapPool(pScreen);
+    TimerFree(cs->pixmapPoolTimer);
 
     pScreen->CloseScreen = cs->CloseScreen;
     pScreen->InstallColormap = cs->InstallColormap;
@@ -338,6 +341,9 @@ compScreenInit(ScreenPtr pScreen)
         return FALSE;
     if (!dixRegisterPrivateKey(&CompSubwindowsPrivateKeyRec, PRIVATE_WINDOW, 0))
         return FALSE;
+    if (!dixRegisterPrivateKey(&CompPixmapPrivateKeyRec, PRIVATE_PIXMAP,
+                               sizeof(CompPixmapRec)))
+        return FALSE;
 
     if (GetCompScreen(pScreen))
         return TRUE;
@@ -356,6 +362,10 @@ compScreenInit(ScreenPtr pScreen)
     cs->numImplicitRedirectExceptions = 0;
     cs->implicitRedirectExceptions = NULL;
 
+    cs->numPooledPixmaps = 0;
+    cs->pixmapPoolTimer = NULL;
+    cs->noPixmapPool = FALSE;
+
     if (!compAddAlternateVisuals(pScreen, cs)) {
         free(cs);
         return FALSE;
@@ -101,6 +101,23 @@ typedef struct _CompWindow {
 
 #define COMP_ORIGIN_INVALID	    0x80000000
 
+/*
+ * Backing pixmaps are allocated larger than the window, so that they can
+ * be reused for other sizes; this is the size actually allocated, or 0
+ * when the pixmap must not be reused
+ */
+typedef struct _CompPixmap {
+    int allocWidth;
+    int allocHeight;
+} CompPixmapRec, *CompPixmapPtr;
+
+#define COMP_PIXMAP_POOL_SIZE	    4
+
+typedef struct _CompPixmapPoolStats {
+    unsigned long pixmaps;      /* pixmaps waiting for reuse */
+    unsigned long bytes;        /* memory they hold */
+} CompPixmapPoolStats;
+
 typedef struct _CompSubwindows {
     int update;
     CompClientWindowPtr clients;
@@ -169,6 +186,14 @@ typedef struct _CompScreen {
     CompOverlayClientPtr pOverlayClients;
 
     SourceValidateProcPtr SourceValidate;
+
+    /*
+     * Backing pixmaps of unmapped or resized windows kept for reuse
+     */
+    PixmapPtr pixmapPool[COMP_PIXMAP_POOL_SIZE];
+    int numPooledPixmaps;
+    OsTimerPtr pixmapPoolTimer;
+    Bool noPixmapPool;
 } CompScreenRec, *CompScreenPtr;
 
 extern DevPrivateKeyRec CompScreenPrivateKeyRec;
@@ -183,12 +208,18 @@ extern DevPrivateKeyRec CompSubwindowsPrivateKeyRec;
 
 #define CompSubwindowsPrivateKey (&CompSubwindowsPrivateKeyRec)
 
+extern DevPrivateKeyRec CompPixmapPrivateKeyRec;
+
+#define CompPixmapPrivateKey (&CompPixmapPrivateKeyRec)
+
 #define GetCompScreen(s) ((CompScreenPtr) \
     dixLookupPrivate(&(s)->devPrivates, CompScreenPrivateKey))
 #define GetCompWindow(w) ((CompWindowPtr) \
     dixLookupPrivate(&(w)->devPrivates, CompWindowPrivateKey))
 #define GetCompSubwindows(w) ((CompSubwindowsPtr) \
     dixLookupPrivate(&(w)->devPrivates, CompSubwindowsPrivateKey))
+#define GetCompPixmap(p) ((CompPixmapPtr) \
+    dixLookupPrivate(&(p)->devPrivates, CompPixmapPrivateKey))
 
 extern RESTYPE CompositeClientSubwindowsType;
 extern RESTYPE CompositeClientOverlayType;
@@ -224,6 +255,15 @@ int
 Bool
  compAllocPixmap(WindowPtr pWin);
 
+void
+ compDestroyPixmap(ScreenPtr pScreen, PixmapPtr pPixmap);
+
+void
+ compFlushPixmapPool(ScreenPtr pScreen);
+
+void
+ compGetPixmapPoolStats(CompPixmapPoolStats *stats);
+
 void
  compSetParentPixmap(WindowPtr pWin);
 
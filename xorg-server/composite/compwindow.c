@@ -178,7 +178,7 @@ compCheckRedirect(WindowPtr pWin)
 
             compSetParentPixmap(pWin);
             compRestoreWindow(pWin, pPixmap);
-            (*pScreen->DestroyPixmap) (pPixmap);
+            compDestroyPixmap(pScreen, pPixmap);
         }
     }
     else if (should) {
@@ -382,7 +382,7 @@ compFreeOldPixmap(WindowPtr pWin)
         CompWindowPtr cw = GetCompWindow(pWin);
 
         if (cw->pOldPixmap) {
-            (*pScreen->DestroyPixmap) (cw->pOldPixmap);
+            compDestroyPixmap(pScreen, cw->pOldPixmap);
             cw->pOldPixmap = NullPixmap;
         }
     }
@@ -615,7 +615,7 @@ compDestroyWindow(WindowPtr pWin)
         PixmapPtr pPixmap = (*pScreen->GetWindowPixmap) (pWin);
 
         compSetParentPixmap(pWin);
-        (*pScreen->DestroyPixmap) (pPixmap);
+        compDestroyPixmap(pScreen, pPixmap);
     }
     ret = (*pScreen->DestroyWindow) (pWin);
     cs->DestroyWindow = pScreen->DestroyWindow;
@@ -662,29 +662,23 @@ compGetRedirectBorderClip(WindowPtr pWin)
     return &cw->borderClip;
 }
 
+/*
+ * Copy the damaged part of an automatically redirected window to its
+ * parent.  The destination picture is shared by all the children of the
+ * parent painted in one pass, and only created when the first of them has
+ * something visible to paint.
+ */
 static void
-compWindowUpdateAutomatic(WindowPtr pWin)
+compWindowUpdateAutomatic(WindowPtr pWin, PicturePtr *ppDstPicture)
 {
     CompWindowPtr cw = GetCompWindow(pWin);
     ScreenPtr pScreen = pWin->drawable.pScreen;
     WindowPtr pParent = pWin->parent;
-    PixmapPtr pSrcPixmap = (*pScreen->GetWindowPixmap) (pWin);
-    PictFormatPtr pSrcFormat = PictureWindowFormat(pWin);
-    PictFormatPtr pDstFormat = PictureWindowFormat(pWin->parent);
+    PixmapPtr pSrcPixmap;
+    PictFormatPtr pSrcFormat;
     int error;
     RegionPtr pRegion = DamageRegion(cw->damage);
-    PicturePtr pSrcPicture = CreatePicture(0, &pSrcPixmap->drawable,
-                                           pSrcFormat,
-                                           0, 0,
-                                           serverClient,
-                                           &error);
-    XID subwindowMode = IncludeInferiors;
-    PicturePtr pDstPicture = CreatePicture(0, &pParent->drawable,
-                                           pDstFormat,
-                                           CPSubwindowMode,
-                                           &subwindowMode,
-                                           serverClient,
-                                           &error);
+    PicturePtr pSrcPicture;
 
     /*
      * First move the region from window to screen coordinates
@@ -696,6 +690,36 @@ compWindowUpdateAutomatic(WindowPtr pWin)
      */
     RegionIntersect(pRegion, pRegion, &cw->borderClip);
 
+    /*
+     * Nothing visible was damaged, the parts which become visible later
+     * are damaged again by compSetRedirectBorderClip
+     */
+    if (!RegionNotEmpty(pRegion))
+        goto bail;
+
+    if (!*ppDstPicture) {
+        XID subwindowMode = IncludeInferiors;
+
+        *ppDstPicture = CreatePicture(0, &pParent->drawable,
+                                      PictureWindowFormat(pParent),
+                                      CPSubwindowMode,
+                                      &subwindowMode,
+                                      serverClient,
+                                      &error);
+        if (!*ppDstPicture)
+            goto bail;
+    }
+
+    pSrcPixmap = (*pScreen->GetWindowPixmap) (pWin);
+    pSrcFormat = PictureWindowFormat(pWin);
+    pSrcPicture = CreatePicture(0, &pSrcPixmap->drawable,
+                                pSrcFormat,
+                                0, 0,
+                                serverClient,
+                                &error);
+    if (!pSrcPicture)
+        goto bail;
+
     /*
      * Now translate from screen to dest coordinates
      */
@@ -704,19 +728,19 @@ compWindowUpdateAutomatic(WindowPtr pWin)
     /*
      * Clip the picture
      */
-    SetPictureClipRegion(pDstPicture, 0, 0, pRegion);
+    SetPictureClipRegion(*ppDstPicture, 0, 0, pRegion);
 
     /*
      * And paint
      */
-    CompositePicture(PictOpSrc, pSrcPicture, 0, pDstPicture,
+    CompositePicture(PictOpSrc, pSrcPicture, 0, *ppDstPicture,
                      0, 0,      /* src_x, src_y */
                      0, 0,      /* msk_x, msk_y */
                      pSrcPixmap->screen_x - pParent->drawable.x,
                      pSrcPixmap->screen_y - pParent->drawable.y,
                      pSrcPixmap->drawable.width, pSrcPixmap->drawable.height);
     FreePicture(pSrcPicture, 0);
-    FreePicture(pDstPicture, 0);
+ bail:
     /*
      * Empty the damage region.  This has the nice effect of
      * rendering the translations above harmless
@@ -725,7 +749,7 @@ compWindowUpdateAutomatic(WindowPtr pWin)
 }
 
 static void
-compPaintWindowToParent(WindowPtr pWin)
+compPaintWindowToParent(WindowPtr pWin, PicturePtr *ppDstPicture)
 {
     compPaintChildrenToWindow(pWin);
 
@@ -733,7 +757,7 @@ compPaintWindowToParent(WindowPtr pWin)
         CompWindowPtr cw = GetCompWindow(pWin);
 
         if (cw->damaged) {
-            compWindowUpdateAutomatic(pWin);
+            compWindowUpdateAutomatic(pWin, ppDstPicture);
             cw->damaged = FALSE;
         }
     }
@@ -743,12 +767,16 @@ void
 compPaintChildrenToWindow(WindowPtr pWin)
 {
     WindowPtr pChild;
+    PicturePtr pDstPicture = NULL;
 
     if (!pWin->damagedDescendants)
         return;
 
     for (pChild = pWin->lastChild; pChild; pChild = pChild->prevSib)
-        compPaintWindowToParent(pChild);
+        compPaintWindowToParent(pChild, &pDstPicture);
+
+    if (pDstPicture)
+        FreePicture(pDstPicture, 0);
 
     pWin->damagedDescendants = FALSE;
 }
@@ -252,7 +252,6 @@ long SmartScheduleMaxSlice = SMART_SCHEDULE_MAX_SLICE;
 long SmartScheduleTime;
 int SmartScheduleLatencyLimited = 0;
 static ClientPtr SmartLastClient;
-static int SmartLastIndex[SMART_MAX_PRIORITY - SMART_MIN_PRIORITY + 1];
 
 #ifdef SMART_DEBUG
 long SmartLastPrint;
@@ -260,30 +259,90 @@ long SmartLastPrint;
 
 void Dispatch(void);
 
-static struct xorg_list ready_clients;
+/*
+ * Ready clients are queued by smart_priority, one FIFO list per level, so
+ * picking the next client looks at the head of the highest non-empty queue
+ * instead of at every ready client.  A client is moved to the tail of its
+ * queue each time it is picked, which gives round robin within a level.
+ *
+ * Clients which were just sent input (see SmartScheduleBoostClient) go on
+ * the boost queue and run before any other client with the default sync
+ * priority.  The few clients with a sync priority (SyncSetPriority) are
+ * kept on a list of their own and searched the slow way.
+ */
+#define SMART_QUEUES        (SMART_MAX_PRIORITY - SMART_MIN_PRIORITY + 1)
+#define SMART_QUEUE_SAVED   -1
+#define SMART_QUEUE_BOOST   -2
+#define SMART_QUEUE_PRIORITY -3
+
+static struct xorg_list ready_queues[SMART_QUEUES];
+static struct xorg_list boosted_clients;
+static struct xorg_list priority_clients;
 static struct xorg_list saved_ready_clients;
+static int ready_top;           /* no queue above this one is used */
+static int nready;              /* clients on any queue but the saved one */
 struct xorg_list output_pending_clients;
 
 static void
 init_client_ready(void)
 {
-    xorg_list_init(&ready_clients);
+    int i;
+
+    for (i = 0; i < SMART_QUEUES; i++)
+        xorg_list_init(&ready_queues[i]);
+    xorg_list_init(&boosted_clients);
+    xorg_list_init(&priority_clients);
     xorg_list_init(&saved_ready_clients);
     xorg_list_init(&output_pending_clients);
+    ready_top = 0;
+    nready = 0;
 }
 
 Bool
 clients_are_ready(void)
 {
-    return !xorg_list_is_empty(&ready_clients);
+    return nready != 0;
+}
+
+/* Queue a client which is on no list at the tail of the queue it belongs to */
+static void
+enqueue_client(ClientPtr client)
+{
+    if (client->priority) {
+        client->smart_queue = SMART_QUEUE_PRIORITY;
+        xorg_list_append(&client->ready, &priority_clients);
+    }
+    else if (client->smart_boost) {
+        client->smart_queue = SMART_QUEUE_BOOST;
+        xorg_list_append(&client->ready, &boosted_clients);
+    }
+    else {
+        client->smart_queue = client->smart_priority - SMART_MIN_PRIORITY;
+        xorg_list_append(&client->ready, &ready_queues[client->smart_queue]);
+        if (client->smart_queue > ready_top)
+            ready_top = client->smart_queue;
+    }
+    nready++;
+}
+
+static void
+dequeue_client(ClientPtr client)
+{
+    xorg_list_del(&client->ready);
+    nready--;
 }
 
 /* Client has requests queued or data on the network */
 void
 mark_client_ready(ClientPtr client)
 {
-    if (xorg_list_is_empty(&client->ready))
-        xorg_list_append(&client->ready, &ready_clients);
+    if (xorg_list_is_empty(&client->ready)) {
+        /* Praise clients which haven't run in a while */
+        if (SmartScheduleTime - client->smart_stop_tick >= 2 * SmartScheduleSlice &&
+            client->smart_priority < 0)
+            client->smart_priority++;
+        enqueue_client(client);
+    }
 }
 
 /*
@@ -292,30 +351,58 @@ mark_client_ready(ClientPtr client)
  */
 void mark_client_saved_ready(ClientPtr client)
 {
-    if (xorg_list_is_empty(&client->ready))
+    if (xorg_list_is_empty(&client->ready)) {
+        client->smart_queue = SMART_QUEUE_SAVED;
         xorg_list_append(&client->ready, &saved_ready_clients);
+    }
 }
 
 /* Client has no requests queued and no data on network */
 void
 mark_client_not_ready(ClientPtr client)
 {
-    xorg_list_del(&client->ready);
+    if (xorg_list_is_empty(&client->ready))
+        return;
+    if (client->smart_queue == SMART_QUEUE_SAVED)
+        xorg_list_del(&client->ready);
+    else
+        dequeue_client(client);
 }
 
+/* Put a ready client on the queue matching its current priorities */
 static void
-mark_client_grab(ClientPtr grab)
+requeue_client(ClientPtr client)
+{
+    if (client_is_ready(client) && client->smart_queue != SMART_QUEUE_SAVED) {
+        dequeue_client(client);
+        enqueue_client(client);
+    }
+}
+
+static void
+move_ready_clients(struct xorg_list *from, ClientPtr grab)
 {
     ClientPtr   client, tmp;
 
-    xorg_list_for_each_entry_safe(client, tmp, &ready_clients, ready) {
+    xorg_list_for_each_entry_safe(client, tmp, from, ready) {
         if (client != grab) {
-            xorg_list_del(&client->ready);
-            xorg_list_append(&client->ready, &saved_ready_clients);
+            dequeue_client(client);
+            mark_client_saved_ready(client);
         }
     }
 }
 
+static void
+mark_client_grab(ClientPtr grab)
+{
+    int i;
+
+    for (i = 0; i < SMART_QUEUES; i++)
+        move_ready_clients(&ready_queues[i], grab);
+    move_ready_clients(&boosted_clients, grab);
+    move_ready_clients(&priority_clients, grab);
+}
+
 static void
 mark_client_ungrab(void)
 {
@@ -323,59 +410,125 @@ mark_client_ungrab(void)
 
     xorg_list_for_each_entry_safe(client, tmp, &saved_ready_clients, ready) {
         xorg_list_del(&client->ready);
-        xorg_list_append(&client->ready, &ready_clients);
+        enqueue_client(client);
     }
 }
 
-static ClientPtr
-SmartScheduleClient(void)
+static void
+requeue_priority_changes(struct xorg_list *queue)
 {
-    ClientPtr pClient, best = NULL;
-    int bestRobin, robin;
-    long now = SmartScheduleTime;
-    long idle;
-    int nready = 0;
+    ClientPtr client, tmp;
 
-    bestRobin = 0;
-    idle = 2 * SmartScheduleSlice;
+    xorg_list_for_each_entry_safe(client, tmp, queue, ready) {
+        Bool prioritized = client->priority != 0;
 
-    xorg_list_for_each_entry(pClient, &ready_clients, ready) {
-        nready++;
+        if (prioritized != (client->smart_queue == SMART_QUEUE_PRIORITY))
+            requeue_client(client);
+    }
+}
 
-        /* Praise clients which haven't run in a while */
-        if ((now - pClient->smart_stop_tick) >= idle) {
-            if (pClient->smart_priority < 0)
-                pClient->smart_priority++;
+/* Move ready clients whose sync priority changed to the right queue */
+static void
+requeue_ready_clients(void)
+{
+    int i;
+
+    for (i = 0; i < SMART_QUEUES; i++)
+        requeue_priority_changes(&ready_queues[i]);
+    requeue_priority_changes(&boosted_clients);
+    requeue_priority_changes(&priority_clients);
+}
+
+/*
+ * Client was sent input: bump its priority, and run it before other clients
+ * the next time it has requests, so that its reaction to the input isn't
+ * stuck behind busy clients.
+ */
+void
+SmartScheduleBoostClient(ClientPtr client)
+{
+    if (client->smart_priority < SMART_MAX_PRIORITY)
+        client->smart_priority++;
+    client->smart_boost = TRUE;
+    requeue_client(client);
+}
+
+/* Praise clients which have been waiting in a queue below 0 for a while */
+static void
+SmartScheduleAge(long now, long idle)
+{
+    ClientPtr client;
+    int i;
+
+    for (i = -SMART_MIN_PRIORITY - 1; i >= 0; i--) {
+        while (!xorg_list_is_empty(&ready_queues[i])) {
+            client = xorg_list_first_entry(&ready_queues[i], ClientRec, ready);
+            if ((now - client->smart_stop_tick) < idle)
+                break;
+            client->smart_priority++;
+            requeue_client(client);
         }
+    }
+}
 
-        /* check priority to select best client */
-        robin =
-            (pClient->index -
-             SmartLastIndex[pClient->smart_priority -
-                            SMART_MIN_PRIORITY]) & 0xff;
+/* Searches the clients with a sync priority */
+static ClientPtr
+SmartSchedulePriorityClient(void)
+{
+    ClientPtr pClient, best = NULL;
 
-        /* pick the best client */
+    xorg_list_for_each_entry(pClient, &priority_clients, ready) {
         if (!best ||
             pClient->priority > best->priority ||
             (pClient->priority == best->priority &&
-             (pClient->smart_priority > best->smart_priority ||
-              (pClient->smart_priority == best->smart_priority && robin > bestRobin))))
-        {
+             pClient->smart_priority > best->smart_priority))
             best = pClient;
-            bestRobin = robin;
-        }
-#ifdef SMART_DEBUG
-        if ((now - SmartLastPrint) >= 5000)
-            fprintf(stderr, " %2d: %3d", pClient->index, pClient->smart_priority);
-#endif
     }
+    return best;
+}
+
+/* The first boosted client, or else the first of the highest queue */
+static ClientPtr
+SmartScheduleQueuedClient(void)
+{
+    if (!xorg_list_is_empty(&boosted_clients))
+        return xorg_list_first_entry(&boosted_clients, ClientRec, ready);
+
+    while (ready_top > 0 && xorg_list_is_empty(&ready_queues[ready_top]))
+        ready_top--;
+    if (!xorg_list_is_empty(&ready_queues[ready_top]))
+        return xorg_list_first_entry(&ready_queues[ready_top], ClientRec, ready);
+    return NULL;
+}
+
+static ClientPtr
+SmartScheduleClient(void)
+{
+    ClientPtr best = NULL, queued;
+    long now = SmartScheduleTime;
+
+    SmartScheduleAge(now, 2 * SmartScheduleSlice);
+
+    if (!xorg_list_is_empty(&priority_clients))
+        best = SmartSchedulePriorityClient();
+    if (!best || best->priority < 0) {
+        queued = SmartScheduleQueuedClient();
+        if (queued)
+            best = queued;
+    }
+
+    /* a boost is good for one slice */
+    best->smart_boost = FALSE;
+    /* round robin: others of the same level go first next time */
+    requeue_client(best);
+
 #ifdef SMART_DEBUG
     if ((now - SmartLastPrint) >= 5000) {
-        fprintf(stderr, " use %2d\n", best->index);
+        fprintf(stderr, "%d ready, use %2d: %3d\n", nready, best->index,
+                best->smart_priority);
         SmartLastPrint = now;
     }
 #endif
-    SmartLastIndex[best->smart_priority - SMART_MIN_PRIORITY] = best->index;
     /*
      * Set current client pointer
      */
@@ -471,12 +624,14 @@ void DispatchQueuedEvents(Bool wait)
         if (!dispatchException && clients_are_ready())
         {
             long start_tick;
+            CARD64 start_time, run_time;
             ClientPtr client;
             client = SmartScheduleClient();
 
             isItTimeToYield = FALSE;
 
             start_tick = SmartScheduleTime;
+            start_time = GetTimeInMicros();
             while (!isItTimeToYield)
             {
                 int result;
@@ -576,10 +731,17 @@ void DispatchQueuedEvents(Bool wait)
                     break;
                 }
             }
+            run_time = GetTimeInMicros() - start_time;
             FlushAllOutput();
-            if (client == SmartLastClient)
+            if (client == SmartLastClient) {
                 client->smart_stop_tick = SmartScheduleTime;
+                client->smart_cpu_time += run_time;
+                /* it may have been penalized */
+                requeue_client(client);
+            }
         }
+        if (dispatchException & DE_PRIORITYCHANGE)
+            requeue_ready_clients();
         dispatchException &= ~DE_PRIORITYCHANGE;
     }
     if (!wait)
@@ -3611,6 +3773,8 @@ InitClient(ClientPtr client, int i, void *ospriv)
     QueryMinMaxKeyCodes(&client->minKC, &client->maxKC);
     client->smart_start_tick = SmartScheduleTime;
     client->smart_stop_tick = SmartScheduleTime;
+    client->smart_boost = FALSE;
+    client->smart_cpu_time = 0;
     client->clientIds = NULL;
 }
 
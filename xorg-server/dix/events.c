@@ -2022,8 +2022,7 @@ TryClientEvents(ClientPtr client, DeviceIntPtr dev, xEvent *pEvents,
     }
 
     if (BitIsOn(criticalEvents, type)) {
-        if (client->smart_priority < SMART_MAX_PRIORITY)
-            client->smart_priority++;
+        SmartScheduleBoostClient(client);
         SetCriticalOutputPending();
     }
 
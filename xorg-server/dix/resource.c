@@ -105,8 +105,9 @@ Equipment Corporation.
  *      A resource ID is a 32 bit quantity, the upper 2 bits of which are
  *	off-limits for client-visible resources.  The next 8 bits are
  *      used as client ID, and the low 22 bits come from the client.
- *	A resource ID is "hashed" by extracting and xoring subfields
- *      (varying with the size of the hash table).
+ *	Each client's resources are kept in a hash table of their own,
+ *	indexed by a hash of the resource ID that keeps consecutive IDs
+ *	close together.
  *
  *      It is sometimes necessary for the server to create an ID that looks
  *      like it belongs to a client.  This ID, however,  must not be one
@@ -149,31 +150,73 @@ Equipment Corporation.
 #define TypeNameString(t) LookupResourceName(t)
 #endif
 
-static void RebuildTable(int    /*client */
-    );
-
 #define SERVER_MINID 32
 
-#define INITBUCKETS 64
+#define INITSLOTS 64
 #define INITHASHSIZE 6
-#define MAXHASHSIZE 16
+#define REHASH_STEP 8
+#define RESOURCE_BLOCK 256
 
 typedef struct _Resource {
-    struct _Resource *next;
     XID id;
     RESTYPE type;
     void *value;
 } ResourceRec, *ResourcePtr;
 
+/*
+ * The resources of a client are kept in blocks of RESOURCE_BLOCK, where
+ * they stay until the client goes away; freed ones are handed out again
+ * first.  They are found through an open addressed table with linear
+ * probing, whose slots hold the number of a resource, counting from one,
+ * in their low 24 bits and the low 8 bits of its ID in the others, so
+ * that probes can pass most slots of other IDs without looking at their
+ * resources.  An unused slot is 0, a freed one SLOT_FREED, so that probes
+ * go on past it.  A new resource is put in front of the others with its
+ * ID, pushing each of them one back and the last into the first freed or
+ * unused slot after it, so probes find the most recently added resource
+ * of an ID first, as they did with the old hash chains.
+ *
+ * When the table gets half full, a new one is allocated and the old
+ * slots are moved over REHASH_STEP at a time by AddResource and
+ * FreeResource.  Until that is done lookups search both tables, the new
+ * one first.  Slots are moved in probe order and put behind those of
+ * their ID already in the new table, which are either moved before them
+ * or added since, so whatever is left of an ID in the old table is older
+ * than what is in the new one.  Only the slots move, never the resources.
+ */
 typedef struct _ClientResource {
-    ResourcePtr *resources;
-    int elements;
-    int buckets;
-    int hashsize;               /* log(2)(buckets) */
+    CARD32 *table;
+    int slots;                  /* 0 if the client is not in use */
+    int hashsize;               /* log(2)(slots) */
+    int used;                   /* live and freed slots of table */
+    int elements;               /* live resources */
+    CARD32 *oldTable;           /* being moved into table */
+    int oldSlots;
+    int oldHashsize;
+    int rehashPos;              /* next slot of oldTable to move */
+    int rehashLeft;             /* slots of oldTable left to move */
+    ResourcePtr *blocks;        /* of RESOURCE_BLOCK resources each */
+    int numBlocks;
+    int numResources;           /* handed out of the blocks so far */
+    CARD32 freeResource;        /* number of the first freed one, or 0 */
+    ResourcePtr lastLookup;     /* result of the last successful lookup */
+    RESTYPE lastLookupClass;    /* its class, RT_NONE if looked up by type */
     XID fakeID;
     XID endFakeID;
 } ClientResourceRec;
 
+#define SLOT_FREED ((CARD32) ~0)
+#define SLOT_NUMBER 0x00ffffff  /* the bits holding the resource number */
+#define MAXRESOURCES (SLOT_NUMBER - 1)  /* so no slot is SLOT_FREED */
+
+/* the tag bits of the slots for an ID */
+#define SlotTag(id) ((CARD32) (id) << 24)
+
+/* the resource with a number, and the one a slot refers to */
+#define NumberResource(rrec, n) \
+    (&(rrec)->blocks[((n) - 1) / RESOURCE_BLOCK][((n) - 1) % RESOURCE_BLOCK])
+#define SlotResource(rrec, slot) NumberResource(rrec, (slot) & SLOT_NUMBER)
+
 RESTYPE lastResourceType;
 static RESTYPE lastResourceClass;
 RESTYPE TypeMask;
@@ -637,7 +680,7 @@ ResourceClientBits(void)
 Bool
 InitClientResources(ClientPtr client)
 {
-    int i, j;
+    int i;
 
     if (client == serverClient) {
         lastResourceType = RT_LASTPREDEF;
@@ -649,13 +692,20 @@ InitClientResources(ClientPtr client)
             return FALSE;
         memcpy(resourceTypes, predefTypes, sizeof(predefTypes));
     }
-    clientTable[i = client->index].resources =
-        malloc(INITBUCKETS * sizeof(ResourcePtr));
-    if (!clientTable[i].resources)
+    clientTable[i = client->index].table = calloc(INITSLOTS, sizeof(CARD32));
+    if (!clientTable[i].table)
         return FALSE;
-    clientTable[i].buckets = INITBUCKETS;
-    clientTable[i].elements = 0;
+    clientTable[i].slots = INITSLOTS;
     clientTable[i].hashsize = INITHASHSIZE;
+    clientTable[i].used = 0;
+    clientTable[i].elements = 0;
+    clientTable[i].oldTable = NULL;
+    clientTable[i].rehashLeft = 0;
+    clientTable[i].blocks = NULL;
+    clientTable[i].numBlocks = 0;
+    clientTable[i].numResources = 0;
+    clientTable[i].freeResource = 0;
+    clientTable[i].lastLookup = NULL;
     /* Many IDs allocated from the server client are visible to clients,
      * so we don't use the SERVER_BIT for them, but we have to start
      * past the magic value constants used in the protocol.  For normal
@@ -664,9 +714,6 @@ InitClientResources(ClientPtr client)
     clientTable[i].fakeID = client->clientAsMask |
         (client->index ? SERVER_BIT : SERVER_MINID);
     clientTable[i].endFakeID = (clientTable[i].fakeID | RESOURCE_ID_MASK) + 1;
-    for (j = 0; j < INITBUCKETS; j++) {
-        clientTable[i].resources[j] = NULL;
-    }
     return TRUE;
 }
 
@@ -683,18 +730,284 @@ HashResourceID(XID id, unsigned int numBits)
     return (id ^ (id >> numBits)) & ~((~0) << numBits);
 }
 
-static XID
-AvailableID(int client, XID id, XID maxid, XID goodid)
+/*
+ * IDs are mostly handed out sequentially by the clients.  Runs of 256
+ * consecutive IDs go to every other slot of a block of 512, so that a
+ * run shares cache lines and pages and probes mostly stop at the next
+ * slot.  The blocks of successive runs are spread over the table by a
+ * multiplication with an odd number, which only permutes them.
+ */
+#define RUNBITS 8
+
+static _X_INLINE unsigned int
+ResourceSlot(XID id, int hashsize)
+{
+    int bits = hashsize - RUNBITS - 1;  /* of the block number */
+    CARD32 run = id >> RUNBITS;
+    CARD32 slot = (id & ((1 << RUNBITS) - 1)) << 1;
+
+    if (bits > 0)
+        slot |= ((run ^ (run >> bits)) * 0x9e3779b1U) << (RUNBITS + 1);
+    return slot & ((1U << hashsize) - 1);
+}
+
+/*
+ * Find the slot of the most recently added resource with this ID in one
+ * table, of type rtype or, if rtype is RT_NONE, of any type in class
+ * rclass.
+ */
+static CARD32 *
+ProbeTable(ClientResourceRec *rrec, CARD32 *table, int hashsize, XID id,
+           RESTYPE rtype, RESTYPE rclass)
+{
+    unsigned int mask = (1U << hashsize) - 1;
+    unsigned int i = ResourceSlot(id, hashsize);
+    CARD32 tag = SlotTag(id);
+    ResourcePtr res;
+    CARD32 *slot;
+
+    for (slot = &table[i]; *slot; slot = &table[i = (i + 1) & mask]) {
+        /* skips freed slots as well, SLOT_NUMBER being no number */
+        if ((*slot ^ tag) >= SLOT_NUMBER)
+            continue;
+        res = SlotResource(rrec, *slot);
+        if (res->id == id &&
+            (rtype != RT_NONE ? res->type == rtype : (res->type & rclass)))
+            return slot;
+    }
+    return NULL;
+}
+
+static CARD32 *
+FindSlot(ClientResourceRec *rrec, XID id, RESTYPE rtype, RESTYPE rclass)
+{
+    CARD32 *slot;
+
+    slot = ProbeTable(rrec, rrec->table, rrec->hashsize, id, rtype, rclass);
+    if (!slot && rrec->oldTable)
+        slot = ProbeTable(rrec, rrec->oldTable, rrec->oldHashsize,
+                          id, rtype, rclass);
+    return slot;
+}
+
+static ResourcePtr
+FindResource(ClientResourceRec *rrec, XID id, RESTYPE rtype, RESTYPE rclass)
+{
+    CARD32 *slot = FindSlot(rrec, id, rtype, rclass);
+
+    return slot ? SlotResource(rrec, *slot) : NULL;
+}
+
+/*
+ * Put the slot of a resource in the new table, either in front of the
+ * others with its ID or, when moving it from the old table, behind them.
+ */
+static void
+InsertSlot(ClientResourceRec *rrec, CARD32 carry, Bool newest)
+{
+    unsigned int mask = rrec->slots - 1;
+    XID id = SlotResource(rrec, carry)->id;
+    unsigned int i = ResourceSlot(id, rrec->hashsize);
+    CARD32 tag = SlotTag(id);
+    CARD32 *slot, *freed = NULL, tmp;
+
+    for (slot = &rrec->table[i]; *slot;
+         slot = &rrec->table[i = (i + 1) & mask]) {
+        if (*slot == SLOT_FREED) {
+            /* the ones of this ID further on are older anyway */
+            if (newest)
+                break;
+            if (!freed)
+                freed = slot;
+        }
+        else if ((*slot ^ tag) < SLOT_NUMBER &&
+                 SlotResource(rrec, *slot)->id == id) {
+            if (newest) {
+                /* shift the older ones back */
+                tmp = *slot;
+                *slot = carry;
+                carry = tmp;
+            }
+            else
+                freed = NULL;
+        }
+    }
+    if (freed)
+        slot = freed;
+    else if (!*slot)
+        rrec->used++;
+    *slot = carry;
+}
+
+/*
+ * Hand out a resource, a freed one if there is any.  Returns its number,
+ * or 0 if out of memory or numbers.
+ */
+static CARD32
+AllocResource(ClientResourceRec *rrec)
+{
+    CARD32 n = rrec->freeResource;
+    ResourcePtr *blocks;
+
+    if (n) {
+        rrec->freeResource = NumberResource(rrec, n)->id;
+        return n;
+    }
+    if (rrec->numResources == MAXRESOURCES)
+        return 0;
+    if (rrec->numResources == rrec->numBlocks * RESOURCE_BLOCK) {
+        /* the array of blocks doubles whenever it is full */
+        if (!(rrec->numBlocks & (rrec->numBlocks - 1))) {
+            blocks = reallocarray(rrec->blocks, max(2 * rrec->numBlocks, 1),
+                                  sizeof(ResourcePtr));
+            if (!blocks)
+                return 0;
+            rrec->blocks = blocks;
+        }
+        rrec->blocks[rrec->numBlocks] =
+            xallocarray(RESOURCE_BLOCK, sizeof(ResourceRec));
+        if (!rrec->blocks[rrec->numBlocks])
+            return 0;
+        rrec->numBlocks++;
+    }
+    return ++rrec->numResources;
+}
+
+/* Free a resource and its slot, putting it on the list of freed ones. */
+static void
+DeleteSlot(ClientResourceRec *rrec, CARD32 *slot)
 {
+    ResourcePtr res = SlotResource(rrec, *slot);
+
+    if (rrec->lastLookup == res)
+        rrec->lastLookup = NULL;
+    res->type = RT_NONE;
+    res->value = NULL;
+    res->id = rrec->freeResource;
+    rrec->freeResource = *slot & SLOT_NUMBER;
+    *slot = SLOT_FREED;
+    rrec->elements--;
+}
+
+/*
+ * Move count slots of the old table over to the new one, and free it
+ * once it is empty.
+ */
+static void
+RehashStep(ClientResourceRec *rrec, int count)
+{
+    CARD32 *table = rrec->oldTable;
+    unsigned int mask = rrec->oldSlots - 1;
+    unsigned int i = rrec->rehashPos;
+    CARD32 carry;
+
+    /* the table stores could alias rrec, hence the locals */
+    if (count > rrec->rehashLeft)
+        count = rrec->rehashLeft;
+    rrec->rehashLeft -= count;
+    while (count--) {
+        carry = table[i];
+        if (carry && carry != SLOT_FREED) {
+            table[i] = SLOT_FREED;
+            InsertSlot(rrec, carry, FALSE);
+        }
+        i = (i + 1) & mask;
+    }
+    rrec->rehashPos = i;
+    if (rrec->oldTable && !rrec->rehashLeft) {
+        free(rrec->oldTable);
+        rrec->oldTable = NULL;
+    }
+}
+
+/*
+ * Allocate a table of at least four times the live resources, so twice
+ * the size of a table without freed slots, and start moving them over.
+ * It is made big enough for the adds that fill it half to move all of
+ * the old table REHASH_STEP slots at a time, so finishing a previous move
+ * first is only needed if allocating the table failed before.
+ */
+static Bool
+RebuildTable(ClientResourceRec *rrec)
+{
+    CARD32 *table;
+    int hashsize;
+    int i;
+
+    RehashStep(rrec, rrec->rehashLeft);
+
+    for (hashsize = INITHASHSIZE;
+         (1 << hashsize) < 4 * rrec->elements ||
+         (1 << hashsize) < 2 * rrec->elements + 2 * rrec->slots / REHASH_STEP;
+         hashsize++)
+        ;
+    /* cleared here rather than by calloc, as probing the pages of a
+     * fresh mapping would fault each of them in twice */
+    table = xallocarray(1 << hashsize, sizeof(CARD32));
+    if (!table)
+        return FALSE;
+    memset(table, 0, (1 << hashsize) * sizeof(CARD32));
+
+    rrec->oldTable = rrec->table;
+    rrec->oldSlots = rrec->slots;
+    rrec->oldHashsize = rrec->hashsize;
+    rrec->table = table;
+    rrec->slots = 1 << hashsize;
+    rrec->hashsize = hashsize;
+    rrec->used = 0;
+
+    /*
+     * Start right after an unused slot, so that each run of used slots
+     * is moved in probe order.  There always is one, as the table is
+     * never filled completely.
+     */
+    for (i = 0; rrec->oldTable[i]; i++)
+        ;
+    rrec->rehashPos = i;
+    rrec->rehashLeft = rrec->oldSlots;
+    return TRUE;
+}
+
+typedef struct {
+    ClientResourceRec *rrec;
+    int next;                   /* number of the next resource */
+} ResourceIterRec;
+
+static void
+FirstResource(ResourceIterRec *iter, ClientResourceRec *rrec)
+{
+    iter->rrec = rrec;
+    iter->next = 1;
+}
+
+/*
+ * Return the next resource of the walk, in the order they were first
+ * handed out.  The caller may add and free resources in between: freed
+ * ones are skipped, and added ones are returned only if they come after
+ * the current one.
+ */
+static ResourcePtr
+NextResource(ResourceIterRec *iter)
+{
+    ClientResourceRec *rrec = iter->rrec;
     ResourcePtr res;
 
+    while (iter->next <= rrec->numResources) {
+        res = NumberResource(rrec, iter->next);
+        iter->next++;
+        if (res->type != RT_NONE)
+            return res;
+    }
+    return NULL;
+}
+
+static XID
+AvailableID(int client, XID id, XID maxid, XID goodid)
+{
     if ((goodid >= id) && (goodid <= maxid))
         return goodid;
     for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
-        while (res && (res->id != id))
-            res = res->next;
-        if (!res)
+        if (!FindResource(&clientTable[client], id, RT_NONE, RC_ANY))
             return id;
     }
     return 0;
@@ -704,9 +1017,8 @@ void
 GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
 {
     XID id, maxid;
-    ResourcePtr *resp;
+    ResourceIterRec iter;
     ResourcePtr res;
-    int i;
     XID goodid;
 
     id = (Mask) client << CLIENTOFFSET;
@@ -714,18 +1026,16 @@ GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
         id |= client ? SERVER_BIT : SERVER_MINID;
     maxid = id | RESOURCE_ID_MASK;
     goodid = 0;
-    for (resp = clientTable[client].resources, i = clientTable[client].buckets;
-         --i >= 0;) {
-        for (res = *resp++; res; res = res->next) {
-            if ((res->id < id) || (res->id > maxid))
-                continue;
-            if (((res->id - id) >= (maxid - res->id)) ?
-                (goodid = AvailableID(client, id, res->id - 1, goodid)) :
-                !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
-                maxid = res->id - 1;
-            else
-                id = res->id + 1;
-        }
+    FirstResource(&iter, &clientTable[client]);
+    while ((res = NextResource(&iter))) {
+        if ((res->id < id) || (res->id > maxid))
+            continue;
+        if (((res->id - id) >= (maxid - res->id)) ?
+            (goodid = AvailableID(client, id, res->id - 1, goodid)) :
+            !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
+            maxid = res->id - 1;
+        else
+            id = res->id + 1;
     }
     if (id > maxid)
         id = maxid = 0;
@@ -803,79 +1113,38 @@ AddResource(XID id, RESTYPE type, void *value)
 {
     int client;
     ClientResourceRec *rrec;
-    ResourcePtr res, *head;
+    ResourcePtr res;
+    CARD32 n;
 
 #ifdef XSERVER_DTRACE
     XSERVER_RESOURCE_ALLOC(id, type, value, TypeNameString(type));
 #endif
     client = CLIENT_ID(id);
     rrec = &clientTable[client];
-    if (!rrec->buckets) {
+    if (!rrec->slots) {
         ErrorF("[dix] AddResource(%lx, %x, %lx), client=%d \n",
                (unsigned long) id, type, (unsigned long)(uintptr_t) value, client);
         FatalError("client not in use\n");
     }
-    if ((rrec->elements >= 4 * rrec->buckets) && (rrec->hashsize < MAXHASHSIZE))
-        RebuildTable(client);
-    head = &rrec->resources[HashResourceID(id, clientTable[client].hashsize)];
-    res = malloc(sizeof(ResourceRec));
-    if (!res) {
+    /* keep at least one slot unused, or probes would never end */
+    if (((2 * (rrec->used + 1) > rrec->slots) && !RebuildTable(rrec) &&
+         (rrec->used + 2 > rrec->slots)) || !(n = AllocResource(rrec))) {
         (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
         return FALSE;
     }
-    res->next = *head;
+    if (rrec->oldTable)
+        RehashStep(rrec, REHASH_STEP);
+    res = NumberResource(rrec, n);
     res->id = id;
     res->type = type;
     res->value = value;
-    *head = res;
+    InsertSlot(rrec, SlotTag(id) | n, TRUE);
     rrec->elements++;
+    rrec->lastLookup = NULL;
     CallResourceStateCallback(ResourceStateAdding, res);
     return TRUE;
 }
 
-static void
-RebuildTable(int client)
-{
-    int j;
-    ResourcePtr res, next;
-    ResourcePtr **tails, *resources;
-    ResourcePtr **tptr, *rptr;
-
-    /*
-     * For now, preserve insertion order, since some ddx layers depend
-     * on resources being free in the opposite order they are added.
-     */
-
-    j = 2 * clientTable[client].buckets;
-    tails =  xallocarray(j, sizeof(ResourcePtr *));
-    if (!tails)
-        return;
-    resources =  xallocarray(j, sizeof(ResourcePtr));
-    if (!resources) {
-        free(tails);
-        return;
-    }
-    for (rptr = resources, tptr = tails; --j >= 0; rptr++, tptr++) {
-        *rptr = NULL;
-        *tptr = rptr;
-    }
-    clientTable[client].hashsize++;
-    for (j = clientTable[client].buckets,
-         rptr = clientTable[client].resources; --j >= 0; rptr++) {
-        for (res = *rptr; res; res = next) {
-            next = res->next;
-            res->next = NULL;
-            tptr = &tails[HashResourceID(res->id, clientTable[client].hashsize)];
-            **tptr = res;
-            *tptr = &res->next;
-        }
-    }
-    free(tails);
-    clientTable[client].buckets *= 2;
-    free(clientTable[client].resources);
-    clientTable[client].resources = resources;
-}
-
 static void
 doFreeResource(ResourcePtr res, Bool skip)
 {
@@ -883,74 +1152,56 @@ doFreeResource(ResourcePtr res, Bool skip)
 
     if (!skip)
         resourceTypes[res->type & TypeMask].deleteFunc(res->value, res->id);
-
-    free(res);
 }
 
-void
-FreeResource(XID id, RESTYPE skipDeleteFuncType)
+/*
+ * Free the resources with this ID matching rtype (or rclass, see
+ * ProbeTable), most recently added first.  The delete functions may add
+ * and free other resources, so each one is looked up afresh.
+ */
+static void
+FreeMatchingResources(ClientResourceRec *rrec, XID id, RESTYPE rtype,
+                      RESTYPE rclass, RESTYPE skipDeleteFuncType, Bool all)
 {
-    int cid;
-    ResourcePtr res;
-    ResourcePtr *prev, *head;
-    int *eltptr;
-    int elements;
-
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-        eltptr = &clientTable[cid].elements;
-
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id) {
-                RESTYPE rtype = res->type;
+    CARD32 *slot;
+    ResourceRec rec;
 
+    while ((slot = FindSlot(rrec, id, rtype, rclass))) {
+        rec = *SlotResource(rrec, *slot);
 #ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
+        XSERVER_RESOURCE_FREE(rec.id, rec.type,
+                              rec.value, TypeNameString(rec.type));
 #endif
-                *prev = res->next;
-                elements = --*eltptr;
+        DeleteSlot(rrec, slot);
 
-                doFreeResource(res, rtype == skipDeleteFuncType);
+        doFreeResource(&rec, rec.type == skipDeleteFuncType);
 
-                if (*eltptr != elements)
-                    prev = head;        /* prev may no longer be valid */
-            }
-            else
-                prev = &res->next;
-        }
+        if (!all)
+            break;
     }
 }
 
 void
-FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
+FreeResource(XID id, RESTYPE skipDeleteFuncType)
 {
     int cid;
-    ResourcePtr res;
-    ResourcePtr *prev, *head;
 
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id && res->type == type) {
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
-#endif
-                *prev = res->next;
-                clientTable[cid].elements--;
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].slots) {
+        if (clientTable[cid].oldTable)
+            RehashStep(&clientTable[cid], REHASH_STEP);
+        FreeMatchingResources(&clientTable[cid], id, RT_NONE, RC_ANY,
+                              skipDeleteFuncType, TRUE);
+    }
+}
 
-                doFreeResource(res, skipFree);
+void
+FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
+{
+    int cid;
 
-                break;
-            }
-            else
-                prev = &res->next;
-        }
-    }
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].slots)
+        FreeMatchingResources(&clientTable[cid], id, type, RT_NONE,
+                              skipFree ? type : RT_NONE, FALSE);
 }
 
 /*
@@ -965,14 +1216,13 @@ ChangeResourceValue(XID id, RESTYPE rtype, void *value)
     int cid;
     ResourcePtr res;
 
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if ((res->id == id) && (res->type == rtype)) {
-                res->value = value;
-                return TRUE;
-            }
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].slots &&
+        rtype != RT_NONE) {
+        res = FindResource(&clientTable[cid], id, rtype, RT_NONE);
+        if (res) {
+            res->value = value;
+            return TRUE;
+        }
     }
     return FALSE;
 }
@@ -987,26 +1237,16 @@ void
 FindClientResourcesByType(ClientPtr client,
                           RESTYPE type, FindResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    ResourceIterRec iter;
+    ResourcePtr this;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                elements = *eltptr;
-                (*func) (this->value, this->id, cdata);
-                if (*eltptr != elements)
-                    next = resources[i];        /* start over */
-            }
-        }
+    FirstResource(&iter, &clientTable[client->index]);
+    while ((this = NextResource(&iter))) {
+        if (!type || this->type == type)
+            (*func) (this->value, this->id, cdata);
     }
 }
 
@@ -1022,25 +1262,15 @@ void FindSubResources(void *resource,
 void
 FindAllClientResources(ClientPtr client, FindAllRes func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    ResourceIterRec iter;
+    ResourcePtr this;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            elements = *eltptr;
-            (*func) (this->value, this->id, this->type, cdata);
-            if (*eltptr != elements)
-                next = resources[i];    /* start over */
-        }
-    }
+    FirstResource(&iter, &clientTable[client->index]);
+    while ((this = NextResource(&iter)))
+        (*func) (this->value, this->id, this->type, cdata);
 }
 
 void *
@@ -1048,24 +1278,20 @@ LookupClientResourceComplex(ClientPtr client,
                             RESTYPE type,
                             FindComplexResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
+    ResourceIterRec iter;
+    ResourcePtr this;
     void *value;
-    int i;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                /* workaround func freeing the type as DRI1 does */
-                value = this->value;
-                if ((*func) (value, this->id, cdata))
-                    return value;
-            }
+    FirstResource(&iter, &clientTable[client->index]);
+    while ((this = NextResource(&iter))) {
+        if (!type || this->type == type) {
+            /* workaround func freeing the type as DRI1 does */
+            value = this->value;
+            if ((*func) (value, this->id, cdata))
+                return value;
         }
     }
     return NULL;
@@ -1074,48 +1300,27 @@ LookupClientResourceComplex(ClientPtr client,
 void
 FreeClientNeverRetainResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ResourceIterRec iter;
     ResourcePtr this;
-    ResourcePtr *prev;
-    int j, elements;
-    int *eltptr;
 
     if (!client)
         return;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        prev = &resources[j];
-        while ((this = *prev)) {
-            RESTYPE rtype = this->type;
-
-            if (rtype & RC_NEVERRETAIN) {
-#ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(this->id, this->type,
-                                      this->value, TypeNameString(this->type));
-#endif
-                *prev = this->next;
-                clientTable[client->index].elements--;
-                elements = *eltptr;
-
-                doFreeResource(this, FALSE);
-
-                if (*eltptr != elements)
-                    prev = &resources[j];       /* prev may no longer be valid */
-            }
-            else
-                prev = &this->next;
-        }
+    FirstResource(&iter, &clientTable[client->index]);
+    while ((this = NextResource(&iter))) {
+        if (this->type & RC_NEVERRETAIN)
+            FreeMatchingResources(&clientTable[client->index], this->id,
+                                  RT_NONE, RC_NEVERRETAIN, RT_NONE, TRUE);
     }
 }
 
 void
 FreeClientResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
     ResourcePtr this;
-    int j;
+    int i;
 
     /* This routine shouldn't be called with a null client, but just in
        case ... */
@@ -1125,35 +1330,34 @@ FreeClientResources(ClientPtr client)
 
     HandleSaveSet(client);
 
-    resources = clientTable[client->index].resources;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        /* It may seem silly to update the head of this resource list as
-           we delete the members, since the entire list will be deleted any way,
-           but there are some resource deletion functions "FreeClientPixels" for
-           one which do a LookupID on another resource id (a Colormap id in this
-           case), so the resource list must be kept valid up to the point that
-           it is deleted, so every time we delete a resource, we must update the
-           head, just like in FreeResource. I hope that this doesn't slow down
-           mass deletion appreciably. PRH */
-
-        ResourcePtr *head;
-
-        head = &resources[j];
-
-        for (this = *head; this; this = *head) {
-#ifdef XSERVER_DTRACE
-            XSERVER_RESOURCE_FREE(this->id, this->type,
-                                  this->value, TypeNameString(this->type));
-#endif
-            *head = this->next;
-            clientTable[client->index].elements--;
-
-            doFreeResource(this, FALSE);
-        }
-    }
-    free(clientTable[client->index].resources);
-    clientTable[client->index].resources = NULL;
-    clientTable[client->index].buckets = 0;
+    rrec = &clientTable[client->index];
+    do {
+        /* Resources are freed one ID at a time and the table is kept
+           valid up to the point that it is deleted, as there are some
+           resource deletion functions "FreeClientPixels" for one which
+           do a LookupID on another resource id (a Colormap id in this
+           case). */
+        FirstResource(&iter, rrec);
+        while ((this = NextResource(&iter)))
+            FreeMatchingResources(rrec, this->id, RT_NONE, RC_ANY,
+                                  RT_NONE, TRUE);
+    } while (rrec->elements);
+
+    free(rrec->oldTable);
+    rrec->oldTable = NULL;
+    rrec->rehashLeft = 0;
+    free(rrec->table);
+    rrec->table = NULL;
+    rrec->slots = 0;
+    rrec->used = 0;
+    for (i = 0; i < rrec->numBlocks; i++)
+        free(rrec->blocks[i]);
+    free(rrec->blocks);
+    rrec->blocks = NULL;
+    rrec->numBlocks = 0;
+    rrec->numResources = 0;
+    rrec->freeResource = 0;
+    rrec->lastLookup = NULL;
 }
 
 void
@@ -1162,7 +1366,7 @@ FreeAllResources(void)
     int i;
 
     for (i = currentMaxClients; --i >= 0;) {
-        if (clientTable[i].buckets)
+        if (clientTable[i].slots)
             FreeClientResources(clients[i]);
     }
 }
@@ -1197,18 +1401,24 @@ dixLookupResourceByType(void **result, XID id, RESTYPE rtype,
                         ClientPtr client, Mask mode)
 {
     int cid = CLIENT_ID(id);
+    ClientResourceRec *rrec;
     ResourcePtr res = NULL;
 
     *result = NULL;
     if ((rtype & TypeMask) > lastResourceType)
         return BadImplementation;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && res->type == rtype)
-                break;
+    if ((cid < LimitClients) && clientTable[cid].slots) {
+        rrec = &clientTable[cid];
+        /* a result found by class is also the newest one of its type */
+        res = rrec->lastLookup;
+        if (!res || res->id != id || res->type != rtype) {
+            res = FindResource(rrec, id, rtype, RT_NONE);
+            if (res) {
+                rrec->lastLookup = res;
+                rrec->lastLookupClass = RT_NONE;
+            }
+        }
     }
     if (client) {
         client->errorValue = id;
@@ -1234,16 +1444,22 @@ dixLookupResourceByClass(void **result, XID id, RESTYPE rclass,
                          ClientPtr client, Mask mode)
 {
     int cid = CLIENT_ID(id);
+    ClientResourceRec *rrec;
     ResourcePtr res = NULL;
 
     *result = NULL;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && (res->type & rclass))
-                break;
+    if ((cid < LimitClients) && clientTable[cid].slots) {
+        rrec = &clientTable[cid];
+        res = rrec->lastLookup;
+        if (!res || res->id != id || !(res->type & rclass) ||
+            rrec->lastLookupClass != rclass) {
+            res = FindResource(rrec, id, RT_NONE, rclass);
+            if (res) {
+                rrec->lastLookup = res;
+                rrec->lastLookupClass = rclass;
+            }
+        }
     }
     if (client) {
         client->errorValue = id;
@@ -115,17 +115,55 @@ FreeAllTSD(void)
 PUBLIC struct _glapi_table *_glapi_Dispatch = NULL;
 PUBLIC void *_glapi_Context = NULL;
 
+#if !defined(THREADS)
+
+/*
+ * With GLX threads indirect rendering also runs on worker threads.  The
+ * current dispatch and context are always kept per thread as well; once
+ * _glapi_set_multithread was called \c _glapi_Dispatch and
+ * \c _glapi_Context stay \c NULL, so that GET_DISPATCH and
+ * GET_CURRENT_CONTEXT, here and in the driver, ask for the per thread
+ * ones.
+ */
+#ifdef _MSC_VER
+#define GLAPI_THREAD_LOCAL __declspec(thread)
+#else
+#define GLAPI_THREAD_LOCAL __thread
+#endif
+
+static GLAPI_THREAD_LOCAL struct _glapi_table *CurrentDispatch;
+static GLAPI_THREAD_LOCAL void *CurrentContext;
+static GLboolean ThreadSafe = GL_FALSE;
+
+#endif                          /* !defined(THREADS) */
+
 #endif                          /* defined(GLX_USE_TLS) */
 /*@}*/
 
 /*
- * xserver's gl is not multithreaded, we promise.
+ * Nothing to detect, the dispatcher calls _glapi_set_multithread before
+ * GL is used on any other thread.
  */
 PUBLIC void
 _glapi_check_multithread(void)
 {
 }
 
+/**
+ * Switch to per thread dispatch and context pointers for good.  Must be
+ * called on the dispatch thread, before any other thread makes a context
+ * current.
+ */
+void
+_glapi_set_multithread(void)
+{
+#if !defined(GLX_USE_TLS) && !defined(THREADS)
+    ThreadSafe = GL_TRUE;
+    _glapi_Dispatch = NULL;
+    _glapi_Context = NULL;
+#endif
+}
+
 /**
  * Set the current context pointer for this thread.
  * The context pointer is an opaque type which should be cast to
@@ -140,7 +178,9 @@ _glapi_set_context(void *context)
     _glthread_SetTSD(&ContextTSD, context);
     _glapi_Context = context;
 #else
-    _glapi_Context = context;
+    CurrentContext = context;
+    if (!ThreadSafe)
+        _glapi_Context = context;
 #endif
 }
 
@@ -154,8 +194,10 @@ _glapi_get_context(void)
 {
 #if defined(GLX_USE_TLS)
     return _glapi_tls_Context;
-#else
+#elif defined(THREADS)
     return _glapi_Context;
+#else
+    return CurrentContext;
 #endif
 }
 
@@ -177,6 +219,8 @@ _glapi_set_dispatch(struct _glapi_table *dispatch)
     _glthread_SetTSD(&_gl_DispatchTSD, (void *) dispatch);
     _glapi_Dispatch = dispatch;
 #else /*THREADS*/
+    CurrentDispatch = dispatch;
+    if (!ThreadSafe)
         _glapi_Dispatch = dispatch;
 #endif /*THREADS*/
    _mesa_init_remap_table();
@@ -192,8 +236,10 @@ _glapi_get_dispatch(void)
 
 #if defined(GLX_USE_TLS)
     api = _glapi_tls_Dispatch;
-#else
+#elif defined(THREADS)
     api = _glapi_Dispatch;
+#else
+    api = CurrentDispatch;
 #endif
     return api;
 }
@@ -129,6 +129,10 @@ SERVEXTERN void
 _glapi_check_multithread(void);
 
 
+SERVEXTERN void
+_glapi_set_multithread(void);
+
+
 SERVEXTERN void
 _glapi_set_context(void *context);
 
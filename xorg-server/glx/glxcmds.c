@@ -2076,7 +2076,7 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
         __GLX_SWAP_INT(&req->contextTag);
     }
 
-    glxc = __glXForceCurrent(cl, req->contextTag, &error);
+    glxc = __glXLookupCurrent(cl, req->contextTag, &error);
     if (!glxc) {
         return error;
     }
@@ -2084,6 +2084,14 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
     commandsDone = 0;
     pc += sz_xGLXRenderReq;
     left = (req->length << 2) - sz_xGLXRenderReq;
+
+    if (glxThreadQueueRender(cl, glxc, pc, left, &error))
+        return error;
+
+    glxc = __glXForceCurrent(cl, req->contextTag, &error);
+    if (!glxc) {
+        return error;
+    }
     while (left > 0) {
         __GLXrenderSizeData entry;
         int extra = 0;
@@ -2355,6 +2363,13 @@ __glXDisp_RenderLarge(__GLXclientState * cl, GLbyte * pc)
                 return __glXError(GLXBadLargeRequest);
             }
 
+            glxThreadCheckCommand(glxc, opcode,
+                                  glxc->largeCmdBuf +
+                                  __GLX_RENDER_LARGE_HDR_SIZE,
+                                  glxc->largeCmdBytesTotal -
+                                  __GLX_RENDER_LARGE_HDR_SIZE,
+                                  client->swapped);
+
             /*
              ** Skip over the header and execute the command.
              */
@@ -127,6 +127,13 @@ struct __GLXcontext {
      */
     __GLXdrawable *drawPriv;
     __GLXdrawable *readPriv;
+
+    /*
+     ** Whether glXRender commands may be executed on a worker thread
+     ** (+glxthreads), and that worker if one has been started.
+     */
+    GLboolean threadedDispatch;
+    struct __GLXcontextThread *thread;
 };
 
 void __glXContextDestroy(__GLXcontext * context);
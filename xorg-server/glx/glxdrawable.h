@@ -73,6 +73,12 @@ struct __GLXdrawable {
      */
     unsigned long eventMask;
 
+    /*
+    ** Geometry as of the last rendering queued for a worker thread, for
+    ** the loader callbacks running there (glxthread.c)
+    */
+    int threadX, threadY, threadWidth, threadHeight;
+
 #ifdef PANORAMIX
     struct __GLXdrawable ** pAll;  /* Points the array containing the drawables for all screens */
 #endif
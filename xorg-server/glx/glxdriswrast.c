@@ -240,6 +240,9 @@ __glXDRIscreenCreateContext(__GLXscreen * baseScreen,
     context->base.copy = __glXDRIcontextCopy;
     context->base.bindTexImage = __glXDRIbindTexImage;
     context->base.releaseTexImage = __glXDRIreleaseTexImage;
+    /* Rendering only reaches the loader when the front buffer is used */
+    context->base.threadedDispatch =
+        glxConfig != NULL && glxConfig->doubleBufferMode;
 
     context->driContext =
         (*core->createNewContext) (screen->driScreen, driConfig, driShare,
@@ -291,12 +294,9 @@ swrastGetDrawableInfo(__DRIdrawable * draw,
                       int *x, int *y, int *w, int *h, void *loaderPrivate)
 {
     __GLXDRIdrawable *drawable = loaderPrivate;
-    DrawablePtr pDraw = drawable->base.pDraw;
 
-    *x = pDraw->x;
-    *y = pDraw->y;
-    *w = pDraw->width;
-    *h = pDraw->height;
+    /* May be called on a worker, see glxthread.c */
+    glxThreadGetGeometry(&drawable->base, x, y, w, h);
 }
 
 static void
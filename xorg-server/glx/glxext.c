@@ -102,6 +102,9 @@ DrawableGone(__GLXdrawable * glxPriv, XID xid)
 {
     __GLXcontext *c, *next;
 
+    /* Workers may still be rendering into this drawable */
+    glxThreadSyncAll();
+
     if (glxPriv->type == GLX_DRAWABLE_WINDOW) {
         /* If this was created by glXCreateWindow, free the matching resource */
         if (glxPriv->drawId != glxPriv->pDraw->id) {
@@ -179,6 +182,7 @@ __glXFreeContext(__GLXcontext * cx)
         return GL_FALSE;
 
     __glXRemoveFromContextList(cx);
+    glxThreadDestroyContext(cx);
 
     free(cx->feedbackBuf);
     free(cx->selectBuf);
@@ -264,6 +268,7 @@ glxClientCallback(CallbackListPtr *list, void *closure, void *data)
 
     switch (pClient->clientState) {
     case ClientStateGone:
+        glxThreadSyncClient(pClient);
         free(cl->returnBuf);
         free(cl->GLClientextensions);
         cl->returnBuf = NULL;
@@ -584,9 +589,11 @@ xorgGlxCreateVendor(void)
 ** is only one instance of the GL, and we use it to serve all GL clients by
 ** switching it between different contexts).  While we are at it, look up
 ** a context by its tag and return its (__GLXcontext *).
+**
+** __glXLookupCurrent only does the lookup and the checks, without binding.
 */
 __GLXcontext *
-__glXForceCurrent(__GLXclientState * cl, GLXContextTag tag, int *error)
+__glXLookupCurrent(__GLXclientState * cl, GLXContextTag tag, int *error)
 {
     ClientPtr client = cl->client;
     REQUEST(xGLXSingleReq);
@@ -623,6 +630,25 @@ __glXForceCurrent(__GLXclientState * cl, GLXContextTag tag, int *error)
         }
     }
 
+    return cx;
+}
+
+/*
+** Like __glXLookupCurrent, but also bind the context, after waiting for
+** any rendering still queued on its worker thread.
+*/
+__GLXcontext *
+__glXForceCurrent(__GLXclientState * cl, GLXContextTag tag, int *error)
+{
+    __GLXcontext *cx;
+
+    cx = __glXLookupCurrent(cl, tag, error);
+    if (!cx)
+        return 0;
+
+    /* The GL state has to be up to date before we touch it here. */
+    glxThreadSyncContext(cx);
+
     if (cx->wait && (*cx->wait) (cx, cl, error))
         return NULL;
 
@@ -730,6 +756,10 @@ __glXDispatch(ClientPtr client)
         return Success;
     }
 
+    /* Only glXRender may run ahead of the client's other requests. */
+    if (opcode != X_GLXRender)
+        glxThreadSyncClient(client);
+
     /*
      ** Use the opcode to index into the procedure table.
      */
@@ -41,6 +41,7 @@
 #include <windowstr.h>
 #include <os.h>
 #include <colormapst.h>
+#include <opaque.h>
 
 #include "extinit.h"
 #include "privates.h"
@@ -163,12 +164,59 @@ static const char GLServerExtensions[] =
     "GL_SGIX_shadow_ambient "
     "GL_SUN_slice_accum ";
 
+/*
+** With +glxthreads, rendering to a drawable may still be in flight on a
+** worker.  Core requests that read a drawable (GetImage, CopyArea, ...) go
+** through SourceValidate, and ConfigureWindow calls ConfigNotify before
+** moving or resizing the window, so both wait for the workers first.
+** They are only wrapped when GLX threads are enabled.
+*/
+static void
+glxSourceValidate(DrawablePtr pDraw, int x, int y, int width, int height,
+                  unsigned int subWindowMode)
+{
+    ScreenPtr pScreen = pDraw->pScreen;
+    __GLXscreen *pGlxScreen = glxGetScreen(pScreen);
+
+    glxThreadSyncDrawable(pDraw);
+
+    pScreen->SourceValidate = pGlxScreen->SourceValidate;
+    if (pScreen->SourceValidate)
+        (*pScreen->SourceValidate) (pDraw, x, y, width, height,
+                                    subWindowMode);
+    pGlxScreen->SourceValidate = pScreen->SourceValidate;
+    pScreen->SourceValidate = glxSourceValidate;
+}
+
+static int
+glxConfigNotify(WindowPtr pWin, int x, int y, int w, int h, int bw,
+                WindowPtr pSib)
+{
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+    __GLXscreen *pGlxScreen = glxGetScreen(pScreen);
+    int ret = Success;
+
+    glxThreadSyncDrawable(&pWin->drawable);
+
+    pScreen->ConfigNotify = pGlxScreen->ConfigNotify;
+    if (pScreen->ConfigNotify)
+        ret = (*pScreen->ConfigNotify) (pWin, x, y, w, h, bw, pSib);
+    pGlxScreen->ConfigNotify = pScreen->ConfigNotify;
+    pScreen->ConfigNotify = glxConfigNotify;
+
+    return ret;
+}
+
 static Bool
 glxCloseScreen(ScreenPtr pScreen)
 {
     __GLXscreen *pGlxScreen = glxGetScreen(pScreen);
 
     pScreen->CloseScreen = pGlxScreen->CloseScreen;
+    if (enableGLXThreads) {
+        pScreen->SourceValidate = pGlxScreen->SourceValidate;
+        pScreen->ConfigNotify = pGlxScreen->ConfigNotify;
+    }
 
     pGlxScreen->destroy(pGlxScreen);
 
@@ -335,6 +383,12 @@ __glXScreenInit(__GLXscreen * pGlxScreen, ScreenPtr pScreen)
 
     pGlxScreen->CloseScreen = pScreen->CloseScreen;
     pScreen->CloseScreen = glxCloseScreen;
+    if (enableGLXThreads) {
+        pGlxScreen->SourceValidate = pScreen->SourceValidate;
+        pScreen->SourceValidate = glxSourceValidate;
+        pGlxScreen->ConfigNotify = pScreen->ConfigNotify;
+        pScreen->ConfigNotify = glxConfigNotify;
+    }
 
     i = 0;
     for (m = pGlxScreen->fbconfigs; m != NULL; m = m->next) {
@@ -151,6 +151,8 @@ struct __GLXscreen {
     unsigned char glx_enable_bits[__GLX_EXT_BYTES];
 
     Bool (*CloseScreen) (ScreenPtr pScreen);
+    SourceValidateProcPtr SourceValidate;
+    ConfigNotifyProcPtr ConfigNotify;
 };
 
 void __glXScreenInit(__GLXscreen * screen, ScreenPtr pScreen);
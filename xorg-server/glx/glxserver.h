@@ -81,6 +81,8 @@ void __glXScreenInitVisuals(__GLXscreen * screen);
 */
 extern __GLXcontext *__glXForceCurrent(__GLXclientState *, GLXContextTag,
                                        int *);
+extern __GLXcontext *__glXLookupCurrent(__GLXclientState *, GLXContextTag,
+                                        int *);
 
 int __glXError(int error);
 
@@ -95,6 +97,21 @@ enum {
 void glxSuspendClients(void);
 void glxResumeClients(void);
 
+/*
+** Worker threads for indirect rendering (glxthread.c).
+*/
+Bool glxThreadQueueRender(__GLXclientState * cl, __GLXcontext * cx,
+                          GLbyte * pc, int left, int *error);
+void glxThreadSyncContext(__GLXcontext * cx);
+void glxThreadSyncClient(ClientPtr client);
+void glxThreadSyncDrawable(DrawablePtr pDraw);
+void glxThreadSyncAll(void);
+void glxThreadDestroyContext(__GLXcontext * cx);
+void glxThreadCheckCommand(__GLXcontext * cx, CARD16 opcode,
+                           const GLbyte * args, int len, Bool swapped);
+void glxThreadGetGeometry(__GLXdrawable * draw, int *x, int *y,
+                          int *w, int *h);
+
 typedef void (*glx_func_ptr)(void);
 typedef glx_func_ptr (*glx_gpa_proc)(const char *);
 void __glXsetGetProcAddress(glx_gpa_proc get_proc_address);
@@ -0,0 +1,579 @@
+/*
+ * Copyright © 2026 VcXsrv contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Threaded execution of indirect rendering commands.
+ *
+ * With +glxthreads every eligible indirect context gets a worker thread
+ * and a queue of validated glXRender command buffers.  The dispatcher only
+ * checks the protocol (so errors are still generated in request order)
+ * and hands the buffer over; the GL work itself happens on the worker,
+ * which binds the context for as long as its queue is non-empty.
+ *
+ * Anything that needs the GL state to be up to date - replies, swaps,
+ * MakeCurrent, destroying a drawable, ... - calls one of the sync
+ * functions below first, which block until the relevant queues drain.
+ * Core requests that read or reshape a GLX drawable sync through the
+ * SourceValidate and ConfigNotify wrappers in glxscreens.c.
+ *
+ * Only contexts whose provider sets threadedDispatch are eligible.  The
+ * loader callbacks that touch server state (putImage/getImage) are only
+ * reached when flushing or reading the front buffer, so contexts that
+ * select a front buffer are moved back to the dispatcher for good.  The
+ * drawable geometry the driver asks for on a worker is the one saved when
+ * the rendering was queued; it can only change after the SourceValidate
+ * or ConfigNotify sync drained the queue.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <pthread.h>
+#include <string.h>
+
+#include "glxserver.h"
+#include "glxutil.h"
+#include "windowstr.h"
+#include "list.h"
+#include "opaque.h"
+#include "indirect_table.h"
+#include "indirect_util.h"
+#include "glapi.h"
+
+#ifndef X_GLrop_DrawBuffers
+#define X_GLrop_DrawBuffers 233
+#endif
+
+/* Stop queueing and wait for the worker above this many pending bytes. */
+#define GLX_THREAD_MAX_QUEUED   (8 * 1024 * 1024)
+
+typedef struct __GLXrenderBatch __GLXrenderBatch;
+
+struct __GLXrenderBatch {
+    __GLXrenderBatch *next;
+    Bool swapped;
+    int length;
+    GLbyte data[];
+};
+
+struct __GLXcontextThread {
+    struct xorg_list entry;
+    __GLXcontext *cx;
+    ClientPtr client;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;        /* signalled when a batch is queued */
+    pthread_cond_t idle;        /* signalled when the queue drains */
+
+    __GLXrenderBatch *head;
+    __GLXrenderBatch *tail;
+    size_t queued;
+    Bool busy;
+    Bool quit;
+};
+
+static struct xorg_list glxThreads = { &glxThreads, &glxThreads };
+
+/* Set before the first worker starts, constant after that. */
+static Bool glxThreadsStarted;
+static pthread_t glxDispatchThread;
+
+static pthread_mutex_t glxGeometryLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+glxThreadExecute(__GLXrenderBatch *batch)
+{
+    GLbyte *pc = batch->data;
+    int left = batch->length;
+
+    while (left > 0) {
+        __GLXrenderHeader *hdr = (__GLXrenderHeader *) pc;
+        __GLXdispatchRenderProcPtr proc;
+        CARD16 cmdlen = hdr->length;
+        CARD16 opcode = hdr->opcode;
+
+        if (batch->swapped) {
+            cmdlen = bswap_16(cmdlen);
+            opcode = bswap_16(opcode);
+        }
+
+        /* The dispatcher validated the whole buffer already. */
+        proc = (__GLXdispatchRenderProcPtr)
+            __glXGetProtocolDecodeFunction(&Render_dispatch_info,
+                                           opcode, batch->swapped);
+        (*proc) (pc + __GLX_RENDER_HDR_SIZE);
+        pc += cmdlen;
+        left -= cmdlen;
+    }
+}
+
+static void *
+glxThreadMain(void *arg)
+{
+    struct __GLXcontextThread *t = arg;
+    __GLXcontext *cx = t->cx;
+    Bool bound = FALSE;
+
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+        __GLXrenderBatch *batch;
+
+        while (!t->head && !t->quit)
+            pthread_cond_wait(&t->work, &t->lock);
+        if (!t->head)
+            break;
+
+        batch = t->head;
+        t->busy = TRUE;
+        pthread_mutex_unlock(&t->lock);
+
+        if (!bound)
+            bound = (*cx->makeCurrent) (cx);
+        /* A failed bind is reported by the next synchronous request. */
+        if (bound)
+            glxThreadExecute(batch);
+
+        pthread_mutex_lock(&t->lock);
+        t->head = batch->next;
+        if (!t->head)
+            t->tail = NULL;
+        t->queued -= batch->length;
+        free(batch);
+
+        if (!t->head) {
+            /* Release the context so the dispatcher can bind it. */
+            if (bound)
+                (*cx->loseCurrent) (cx);
+            bound = FALSE;
+            t->busy = FALSE;
+            pthread_cond_broadcast(&t->idle);
+        }
+    }
+    pthread_mutex_unlock(&t->lock);
+
+    return NULL;
+}
+
+static void
+glxThreadWait(struct __GLXcontextThread *t)
+{
+    pthread_mutex_lock(&t->lock);
+    while (t->head || t->busy)
+        pthread_cond_wait(&t->idle, &t->lock);
+    pthread_mutex_unlock(&t->lock);
+}
+
+static struct __GLXcontextThread *
+glxThreadCreate(__GLXcontext * cx, ClientPtr client)
+{
+    struct __GLXcontextThread *t;
+
+    t = calloc(1, sizeof(*t));
+    if (!t)
+        return NULL;
+
+    /* From now on the current context and dispatch are per thread. */
+    _glapi_set_multithread();
+    if (!glxThreadsStarted) {
+        glxDispatchThread = pthread_self();
+        glxThreadsStarted = TRUE;
+    }
+
+    t->cx = cx;
+    t->client = client;
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->work, NULL);
+    pthread_cond_init(&t->idle, NULL);
+
+    if (pthread_create(&t->thread, NULL, glxThreadMain, t) != 0) {
+        pthread_cond_destroy(&t->idle);
+        pthread_cond_destroy(&t->work);
+        pthread_mutex_destroy(&t->lock);
+        free(t);
+        return NULL;
+    }
+
+    xorg_list_append(&t->entry, &glxThreads);
+    return t;
+}
+
+/*
+** Decide whether a rendering command may run off the dispatch thread.
+** Selecting a front buffer means later flushes and reads go through the
+** loader's putImage/getImage, which must run on the dispatcher.
+*/
+static Bool
+glxThreadBufferIsSafe(CARD32 mode, Bool swapped)
+{
+    if (swapped)
+        mode = bswap_32(mode);
+
+    switch (mode) {
+    case GL_FRONT:
+    case GL_FRONT_LEFT:
+    case GL_FRONT_RIGHT:
+    case GL_FRONT_AND_BACK:
+    case GL_LEFT:
+    case GL_RIGHT:
+        return FALSE;
+    default:
+        return TRUE;
+    }
+}
+
+/*
+** args points at the len bytes of parameters following the command header.
+*/
+static Bool
+glxThreadCommandIsSafe(CARD16 opcode, const GLbyte *pc, int len,
+                       Bool swapped)
+{
+    const CARD32 *args = (const CARD32 *) pc;
+    CARD32 n, i;
+
+    switch (opcode) {
+    case X_GLrop_DrawBuffer:
+    case X_GLrop_ReadBuffer:
+        return glxThreadBufferIsSafe(args[0], swapped);
+    case X_GLrop_DrawBuffers:
+        n = swapped ? bswap_32(args[0]) : args[0];
+        if (n > (len - 4) / 4)
+            return FALSE;
+        for (i = 0; i < n; i++) {
+            if (!glxThreadBufferIsSafe(args[1 + i], swapped))
+                return FALSE;
+        }
+        return TRUE;
+    default:
+        return TRUE;
+    }
+}
+
+/*
+** Validate a glXRender command buffer without executing or modifying it.
+** Returns the protocol status and stores the number of bytes preceding the
+** first bad command in *valid, so that the commands before it still get
+** executed, exactly as in the synchronous path.  *unsafe is set if any
+** command must run on the dispatcher.
+*/
+static int
+glxThreadValidate(ClientPtr client, GLbyte * pc, int left, int *valid,
+                  Bool *unsafe)
+{
+    GLbyte *start = pc;
+    int commandsDone = 0;
+    int status = Success;
+
+    *unsafe = FALSE;
+
+    while (left > 0) {
+        __GLXrenderSizeData entry;
+        __GLXrenderHeader *hdr;
+        int extra = 0;
+        int cmdlen;
+        CARD16 opcode;
+
+        if (left < sizeof(__GLXrenderHeader)) {
+            status = BadLength;
+            break;
+        }
+
+        hdr = (__GLXrenderHeader *) pc;
+        cmdlen = client->swapped ? bswap_16(hdr->length) : hdr->length;
+        opcode = client->swapped ? bswap_16(hdr->opcode) : hdr->opcode;
+
+        if (left < cmdlen) {
+            status = BadLength;
+            break;
+        }
+
+        if (__glXGetProtocolSizeData(&Render_dispatch_info, opcode,
+                                     &entry) < 0 ||
+            __glXGetProtocolDecodeFunction(&Render_dispatch_info, opcode,
+                                           client->swapped) == NULL) {
+            client->errorValue = commandsDone;
+            status = __glXError(GLXBadRenderRequest);
+            break;
+        }
+
+        if (cmdlen < entry.bytes) {
+            status = BadLength;
+            break;
+        }
+
+        if (entry.varsize) {
+            extra = (*entry.varsize) (pc + __GLX_RENDER_HDR_SIZE,
+                                      client->swapped,
+                                      left - __GLX_RENDER_HDR_SIZE);
+            if (extra < 0) {
+                status = BadLength;
+                break;
+            }
+        }
+
+        if (cmdlen != safe_pad(safe_add(entry.bytes, extra))) {
+            status = BadLength;
+            break;
+        }
+
+        if (!glxThreadCommandIsSafe(opcode, pc + __GLX_RENDER_HDR_SIZE,
+                                    cmdlen - __GLX_RENDER_HDR_SIZE,
+                                    client->swapped))
+            *unsafe = TRUE;
+
+        pc += cmdlen;
+        left -= cmdlen;
+        commandsDone++;
+    }
+
+    *valid = pc - start;
+    return status;
+}
+
+static void
+glxThreadDemote(__GLXcontext * cx)
+{
+    glxThreadDestroyContext(cx);
+    cx->threadedDispatch = GL_FALSE;
+}
+
+/*
+** Called with every command the dispatcher executes itself outside of
+** glXRender, that is glXRenderLarge: a command selecting a front buffer
+** moves the context back to the dispatcher for good, as when queued.
+*/
+void
+glxThreadCheckCommand(__GLXcontext * cx, CARD16 opcode, const GLbyte * args,
+                      int len, Bool swapped)
+{
+    if (cx->threadedDispatch &&
+        !glxThreadCommandIsSafe(opcode, args, len, swapped))
+        glxThreadDemote(cx);
+}
+
+static void
+glxThreadSaveGeometry(__GLXdrawable * draw)
+{
+    DrawablePtr pDraw = draw ? draw->pDraw : NULL;
+
+    if (pDraw) {
+        draw->threadX = pDraw->x;
+        draw->threadY = pDraw->y;
+        draw->threadWidth = pDraw->width;
+        draw->threadHeight = pDraw->height;
+    }
+}
+
+/*
+** The geometry of a drawable for the driver.  On a worker this is the one
+** saved when the rendering was queued, pDraw belongs to the dispatcher.
+*/
+void
+glxThreadGetGeometry(__GLXdrawable * draw, int *x, int *y, int *w, int *h)
+{
+    DrawablePtr pDraw = draw->pDraw;
+
+    if (!glxThreadsStarted || pthread_equal(pthread_self(), glxDispatchThread)) {
+        *x = pDraw->x;
+        *y = pDraw->y;
+        *w = pDraw->width;
+        *h = pDraw->height;
+        return;
+    }
+
+    pthread_mutex_lock(&glxGeometryLock);
+    *x = draw->threadX;
+    *y = draw->threadY;
+    *w = draw->threadWidth;
+    *h = draw->threadHeight;
+    pthread_mutex_unlock(&glxGeometryLock);
+}
+
+/*
+** Queue the commands of a glXRender request on the context's worker.
+** Returns FALSE if the caller has to execute the request itself, in which
+** case the request buffer has not been touched.
+*/
+Bool
+glxThreadQueueRender(__GLXclientState * cl, __GLXcontext * cx,
+                     GLbyte * pc, int left, int *error)
+{
+    struct __GLXcontextThread *t = cx->thread;
+    __GLXrenderBatch *batch;
+    Bool unsafe, full;
+    int valid;
+
+    if (!enableGLXThreads || cx->isDirect || !cx->threadedDispatch)
+        return FALSE;
+
+    *error = glxThreadValidate(cl->client, pc, left, &valid, &unsafe);
+    if (unsafe) {
+        glxThreadDemote(cx);
+        return FALSE;
+    }
+    if (valid == 0)
+        return TRUE;
+
+    if (!t) {
+        t = cx->thread = glxThreadCreate(cx, cl->client);
+        if (!t) {
+            glxThreadDemote(cx);
+            return FALSE;
+        }
+    }
+    t->client = cl->client;
+
+    batch = malloc(sizeof(*batch) + valid);
+    if (!batch) {
+        /* Keep the commands in order rather than dropping them. */
+        glxThreadWait(t);
+        return FALSE;
+    }
+    batch->next = NULL;
+    batch->swapped = cl->client->swapped;
+    batch->length = valid;
+    memcpy(batch->data, pc, valid);
+
+    /* A context can only be current in one thread at a time. */
+    if (lastGLContext == cx) {
+        (*cx->loseCurrent) (cx);
+        lastGLContext = NULL;
+    }
+
+    pthread_mutex_lock(&glxGeometryLock);
+    glxThreadSaveGeometry(cx->drawPriv);
+    glxThreadSaveGeometry(cx->readPriv);
+    pthread_mutex_unlock(&glxGeometryLock);
+
+    pthread_mutex_lock(&t->lock);
+    if (t->tail)
+        t->tail->next = batch;
+    else
+        t->head = batch;
+    t->tail = batch;
+    t->queued += valid;
+    full = t->queued > GLX_THREAD_MAX_QUEUED;
+    pthread_cond_signal(&t->work);
+    pthread_mutex_unlock(&t->lock);
+
+    if (full)
+        glxThreadWait(t);
+
+    return TRUE;
+}
+
+/*
+** Wait until all rendering queued for a context has been executed.
+*/
+void
+glxThreadSyncContext(__GLXcontext * cx)
+{
+    if (cx->thread)
+        glxThreadWait(cx->thread);
+}
+
+/*
+** Wait for the workers of all contexts a client has rendered through.
+*/
+void
+glxThreadSyncClient(ClientPtr client)
+{
+    struct __GLXcontextThread *t;
+
+    xorg_list_for_each_entry(t, &glxThreads, entry) {
+        if (t->client == client)
+            glxThreadWait(t);
+    }
+}
+
+/*
+** Wait for the workers of all contexts rendering to a drawable, or for a
+** window, to any of its inferiors.  Core requests reading or reshaping the
+** drawable must not run while the driver is still working on it.
+*/
+void
+glxThreadSyncDrawable(DrawablePtr pDraw)
+{
+    struct __GLXcontextThread *t;
+
+    xorg_list_for_each_entry(t, &glxThreads, entry) {
+        __GLXcontext *cx = t->cx;
+        __GLXdrawable *draw[2] = { cx->drawPriv, cx->readPriv };
+        int i;
+
+        for (i = 0; i < 2; i++) {
+            DrawablePtr d = draw[i] ? draw[i]->pDraw : NULL;
+            WindowPtr pWin;
+
+            if (d == pDraw)
+                break;
+            if (!d || d->type != DRAWABLE_WINDOW ||
+                pDraw->type != DRAWABLE_WINDOW)
+                continue;
+            for (pWin = ((WindowPtr) d)->parent; pWin; pWin = pWin->parent)
+                if (&pWin->drawable == pDraw)
+                    break;
+            if (pWin)
+                break;
+        }
+        if (i < 2)
+            glxThreadWait(t);
+    }
+}
+
+void
+glxThreadSyncAll(void)
+{
+    struct __GLXcontextThread *t;
+
+    xorg_list_for_each_entry(t, &glxThreads, entry)
+        glxThreadWait(t);
+}
+
+/*
+** Drain and stop a context's worker.  The context falls back to the
+** dispatcher if it is used again.
+*/
+void
+glxThreadDestroyContext(__GLXcontext * cx)
+{
+    struct __GLXcontextThread *t = cx->thread;
+
+    if (!t)
+        return;
+
+    pthread_mutex_lock(&t->lock);
+    t->quit = TRUE;
+    pthread_cond_signal(&t->work);
+    pthread_mutex_unlock(&t->lock);
+    pthread_join(t->thread, NULL);
+
+    xorg_list_del(&t->entry);
+    pthread_cond_destroy(&t->idle);
+    pthread_cond_destroy(&t->work);
+    pthread_mutex_destroy(&t->lock);
+    free(t);
+    cx->thread = NULL;
+}
@@ -67,6 +67,7 @@ from The Open Group.
 #include "miline.h"
 #include "glx_extinit.h"
 #include "randrstr.h"
+#include "shadow.h"
 
 #define VFB_DEFAULT_WIDTH      1280
 #define VFB_DEFAULT_HEIGHT     1024
@@ -91,7 +92,10 @@ typedef struct {
     Pixel blackPixel;
     Pixel whitePixel;
     unsigned int lineBias;
+    int rotate;
+    char *pShadow;
     CloseScreenProcPtr closeScreen;
+    CreateScreenResourcesProcPtr createScreenResources;
 
 #ifdef HAVE_MMAP
     int mmap_fd;
@@ -113,6 +117,7 @@ static vfbScreenInfo defaultScreenInfo = {
     .blackPixel = VFB_DEFAULT_BLACKPIXEL,
     .whitePixel = VFB_DEFAULT_WHITEPIXEL,
     .lineBias = VFB_DEFAULT_LINEBIAS,
+    .rotate = -1,
 };
 
 static Bool vfbPixmapDepths[33];
@@ -124,6 +129,7 @@ typedef enum { NORMAL_MEMORY_FB, SHARED_MEMORY_FB, MMAPPED_FILE_FB } fbMemType;
 static fbMemType fbmemtype = NORMAL_MEMORY_FB;
 static char needswap = 0;
 static Bool Render = TRUE;
+static int shadowThreads = 1;
 
 #define swapcopy16(_dst, _src) \
     if (needswap) { CARD16 _s = _src; cpswaps(_s, _dst); } \
@@ -246,6 +252,8 @@ ddxUseMsg(void)
     ErrorF("-linebias n            adjust thin line pixelization\n");
     ErrorF("-blackpixel n          pixel value for black\n");
     ErrorF("-whitepixel n          pixel value for white\n");
+    ErrorF("-rotate 0|90|180|270   draw to a shadow, rotated in the framebuffer\n");
+    ErrorF("-shadowthreads n       update the framebuffer with n threads\n");
 
 #ifdef HAVE_MMAP
     ErrorF
@@ -359,6 +367,24 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 2;
     }
 
+    if (strcmp(argv[i], "-rotate") == 0) {      /* -rotate degrees */
+        CHECK_FOR_REQUIRED_ARGUMENTS(1);
+        currentScreen->rotate = atoi(argv[++i]);
+        if (currentScreen->rotate % 90 || currentScreen->rotate < 0 ||
+            currentScreen->rotate > 270) {
+            ErrorF("Invalid rotation %s\n", argv[i]);
+            UseMsg();
+            FatalError("Invalid rotation %s passed to -rotate\n", argv[i]);
+        }
+        return 2;
+    }
+
+    if (strcmp(argv[i], "-shadowthreads") == 0) {       /* -shadowthreads n */
+        CHECK_FOR_REQUIRED_ARGUMENTS(1);
+        shadowThreads = atoi(argv[++i]);
+        return 2;
+    }
+
 #ifdef HAVE_MMAP
     if (strcmp(argv[i], "-fbdir") == 0) {       /* -fbdir directory */
         CHECK_FOR_REQUIRED_ARGUMENTS(1);
@@ -713,13 +739,83 @@ static miPointerScreenFuncRec vfbPointerCursorFuncs = {
     miPointerWarpCursor
 };
 
+/*
+ * With -rotate, the screen is drawn to a shadow which the shadow layer
+ * copies to the framebuffer, rotated.  -screen still gives the size of the
+ * framebuffer, so the screen is that size turned by the rotation.
+ */
+static void *
+vfbShadowWindow(ScreenPtr pScreen, CARD32 row, CARD32 offset, int mode,
+                CARD32 *size, void *closure)
+{
+    vfbScreenInfoPtr pvfb = &vfbScreens[pScreen->myNum];
+
+    *size = pvfb->paddedBytesWidth - offset;
+    return pvfb->pfbMemory + row * pvfb->paddedBytesWidth + offset;
+}
+
+static ShadowUpdateProc
+vfbShadowUpdateProc(vfbScreenInfoPtr pvfb)
+{
+    switch (pvfb->rotate) {
+    case 0:
+        return shadowUpdatePacked;
+    case 90:
+        switch (pvfb->bitsPerPixel) {
+        case 8: return shadowUpdateRotate8_90;
+        case 16: return shadowUpdateRotate16_90;
+        case 32: return shadowUpdateRotate32_90;
+        }
+        break;
+    case 180:
+        switch (pvfb->bitsPerPixel) {
+        case 8: return shadowUpdateRotate8_180;
+        case 16: return shadowUpdateRotate16_180;
+        case 32: return shadowUpdateRotate32_180;
+        }
+        break;
+    case 270:
+        switch (pvfb->bitsPerPixel) {
+        case 8: return shadowUpdateRotate8_270;
+        case 16: return shadowUpdateRotate16_270;
+        case 32: return shadowUpdateRotate32_270;
+        }
+        break;
+    }
+    return shadowUpdateRotatePacked;
+}
+
+static Bool
+vfbCreateScreenResources(ScreenPtr pScreen)
+{
+    vfbScreenInfoPtr pvfb = &vfbScreens[pScreen->myNum];
+    Bool ret;
+
+    pScreen->CreateScreenResources = pvfb->createScreenResources;
+    ret = pScreen->CreateScreenResources(pScreen);
+    pScreen->CreateScreenResources = vfbCreateScreenResources;
+    if (!ret)
+        return FALSE;
+
+    if (!shadowAdd(pScreen, pScreen->GetScreenPixmap(pScreen),
+                   vfbShadowUpdateProc(pvfb), vfbShadowWindow,
+                   pvfb->rotate, NULL))
+        return FALSE;
+    shadowSetThreads(pScreen, shadowThreads);
+    return TRUE;
+}
+
 static Bool
 vfbCloseScreen(ScreenPtr pScreen)
 {
     vfbScreenInfoPtr pvfb = &vfbScreens[pScreen->myNum];
+    Bool ret;
 
     pScreen->CloseScreen = pvfb->closeScreen;
 
+    if (pvfb->pShadow)
+        shadowRemove(pScreen, pScreen->devPrivate);
+
     /*
      * fb overwrites miCloseScreen, so do this here
      */
@@ -727,7 +823,11 @@ vfbCloseScreen(ScreenPtr pScreen)
         (*pScreen->DestroyPixmap) (pScreen->devPrivate);
     pScreen->devPrivate = NULL;
 
-    return pScreen->CloseScreen(pScreen);
+    ret = pScreen->CloseScreen(pScreen);
+
+    free(pvfb->pShadow);
+    pvfb->pShadow = NULL;
+    return ret;
 }
 
 static Bool
@@ -818,9 +918,15 @@ vfbRandRInit(ScreenPtr pScreen)
     pScrPriv->rrOutputValidateMode = vfbRROutputValidateMode;
     pScrPriv->rrModeDestroy = NULL;
 
-    RRScreenSetSizeRange (pScreen,
-                         1, 1,
-                         pScreen->width, pScreen->height);
+    /* The shadow can't follow size changes */
+    if (vfbScreens[pScreen->myNum].pShadow)
+        RRScreenSetSizeRange (pScreen,
+                             pScreen->width, pScreen->height,
+                             pScreen->width, pScreen->height);
+    else
+        RRScreenSetSizeRange (pScreen,
+                             1, 1,
+                             pScreen->width, pScreen->height);
 
     sprintf (name, "%dx%d", pScreen->width, pScreen->height);
     memset (&modeInfo, '\0', sizeof (modeInfo));
@@ -860,6 +966,8 @@ vfbScreenInit(ScreenPtr pScreen, int argc, char **argv)
 {
     vfbScreenInfoPtr pvfb = &vfbScreens[pScreen->myNum];
     int dpix = monitorResolution, dpiy = monitorResolution;
+    int width = pvfb->width, height = pvfb->height;
+    int paddedWidth;
     int ret;
     char *pbits;
 
@@ -879,6 +987,20 @@ vfbScreenInit(ScreenPtr pScreen, int argc, char **argv)
     if (!pbits)
         return FALSE;
 
+    paddedWidth = pvfb->paddedWidth;
+    if (pvfb->rotate >= 0) {
+        if (pvfb->rotate == 90 || pvfb->rotate == 270) {
+            width = pvfb->height;
+            height = pvfb->width;
+        }
+        paddedWidth = PixmapBytePad(width, pvfb->depth) * 8 /
+            pvfb->bitsPerPixel;
+        pvfb->pShadow = calloc(height, PixmapBytePad(width, pvfb->depth));
+        if (!pvfb->pShadow)
+            return FALSE;
+        pbits = pvfb->pShadow;
+    }
+
     switch (pvfb->depth) {
     case 8:
         miSetVisualTypesAndMasks(8,
@@ -920,14 +1042,21 @@ vfbScreenInit(ScreenPtr pScreen, int argc, char **argv)
 
     miSetPixmapDepths();
 
-    ret = fbScreenInit(pScreen, pbits, pvfb->width, pvfb->height,
-                       dpix, dpiy, pvfb->paddedWidth, pvfb->bitsPerPixel);
+    ret = fbScreenInit(pScreen, pbits, width, height,
+                       dpix, dpiy, paddedWidth, pvfb->bitsPerPixel);
     if (ret && Render)
         fbPictureInit(pScreen, 0, 0);
 
     if (!ret)
         return FALSE;
 
+    if (pvfb->pShadow) {
+        if (!shadowSetup(pScreen))
+            return FALSE;
+        pvfb->createScreenResources = pScreen->CreateScreenResources;
+        pScreen->CreateScreenResources = vfbCreateScreenResources;
+    }
+
     if (!vfbRandRInit(pScreen))
        return FALSE;
 
@@ -107,6 +107,9 @@ typedef struct _Client {
 
     int smart_start_tick;
     int smart_stop_tick;
+    int smart_queue;            /* ready queue the client is on */
+    Bool smart_boost;           /* was sent input since it last ran */
+    CARD64 smart_cpu_time;      /* microseconds spent on its requests */
 
     DeviceIntPtr clientPtr;
     ClientIdPtr clientIds;
@@ -134,6 +137,7 @@ extern Bool SmartScheduleSignalEnable;
 #endif
 extern void SmartScheduleStartTimer(void);
 extern void SmartScheduleStopTimer(void);
+extern void SmartScheduleBoostClient(ClientPtr client);
 
 /* Client has requests queued or data on the network */
 void mark_client_ready(ClientPtr client);
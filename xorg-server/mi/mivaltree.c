@@ -177,6 +177,62 @@ miShapedWindowIn(RegionPtr universe, RegionPtr bounding,
 				    HasBorder(w) && \
 				    (w)->backgroundState == ParentRelative)
 
+#ifdef COMPOSITE
+#define IsRedirected(w)		((w)->redirectDraw != RedirectDrawNone)
+#else
+#define IsRedirected(w)		FALSE
+#endif
+
+/*
+ * Restacking, mapping or unmapping siblings never changes the geometry
+ * inside a window, so when such an operation leaves its borderClip as it
+ * was, the clips of the whole subtree are still valid.
+ */
+static Bool
+miClipsUnchanged(WindowPtr pWin, RegionPtr universe, VTKind kind,
+                 int oldVis, int dx, int dy)
+{
+    if (kind != VTStack && kind != VTMap && kind != VTUnmap)
+        return FALSE;
+    if (dx || dy || oldVis != pWin->visibility ||
+        oldVis == VisibilityNotViewable)
+        return FALSE;
+    if (pWin->valdata->before.borderVisible || IsRedirected(pWin))
+        return FALSE;
+    if (RegionBroken(&pWin->borderClip) || RegionBroken(&pWin->clipList))
+        return FALSE;
+    return RegionEqual(universe, &pWin->borderClip);
+}
+
+/*
+ * Clear the exposures of the marked windows in a subtree whose clips
+ * did not change.
+ */
+static void
+miTreeUnexposed(WindowPtr pParent)
+{
+    WindowPtr pChild;
+
+    pChild = pParent;
+    while (1) {
+        if (pChild->viewable) {
+            if (pChild->valdata && pChild->valdata != UnmapValData) {
+                RegionNull(&pChild->valdata->after.borderExposed);
+                RegionNull(&pChild->valdata->after.exposed);
+            }
+            if (pChild->firstChild) {
+                pChild = pChild->firstChild;
+                continue;
+            }
+        }
+        while (!pChild->nextSib && (pChild != pParent))
+            pChild = pChild->parent;
+        if (pChild == pParent)
+            break;
+        pChild = pChild->nextSib;
+    }
+}
+
 /*
  *-----------------------------------------------------------------------
  * miComputeClips --
@@ -281,6 +337,15 @@ miComputeClips(WindowPtr pParent,
     dx = pParent->drawable.x - pParent->valdata->before.oldAbsCorner.x;
     dy = pParent->drawable.y - pParent->valdata->before.oldAbsCorner.y;
 
+    /*
+     * skip subtrees whose clips provably stay the same; with deep
+     * hierarchies this is most of the windows marked by a restack
+     */
+    if (miClipsUnchanged(pParent, universe, kind, oldVis, dx, dy)) {
+        miTreeUnexposed(pParent);
+        return;
+    }
+
     /*
      * avoid computations when dealing with simple operations
      */
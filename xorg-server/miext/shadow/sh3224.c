@@ -25,6 +25,7 @@
 #endif
 
 #include "shadow.h"
+#include "shtile.h"
 #include "fb.h"
 
 #define Get8(a)	((CARD32) READ(a))
@@ -61,6 +62,29 @@ sh24_32BltLine(CARD8 *srcLine,
 	Put24(dst, pixel);
 	dst += 3;
     }
+#if defined(SHADOW_SSE2) && !defined(FB_ACCESS_WRAPPER) && \
+    BITMAP_BIT_ORDER == LSBFirst
+    /*
+     * Pack pixels pairwise into the low 6 bytes of each 64-bit half, then
+     * the two halves next to each other
+     */
+    while (w >= 4) {
+	__m128i v, t;
+
+	v = _mm_and_si128(_mm_loadu_si128((__m128i *) src),
+			  _mm_set1_epi32(0xffffff));
+	t = _mm_or_si128(_mm_and_si128(v, _mm_set_epi32(0, -1, 0, -1)),
+			 _mm_srli_epi64(_mm_andnot_si128(_mm_set_epi32(0, -1, 0, -1),
+							 v), 8));
+	t = _mm_or_si128(_mm_move_epi64(t),
+			 _mm_slli_si128(_mm_srli_si128(t, 8), 6));
+	_mm_storel_epi64((__m128i *) dst, t);
+	*(CARD32 *) (dst + 8) = _mm_cvtsi128_si32(_mm_srli_si128(t, 8));
+	src += 4;
+	dst += 12;
+	w -= 4;
+    }
+#endif
     /* Do four aligned pixels at a time */
     while (w >= 4) {
 	CARD32 s0, s1;
@@ -97,13 +121,11 @@ sh24_32BltLine(CARD8 *srcLine,
     }
 }
 
-void
-shadowUpdate32to24(ScreenPtr pScreen, shadowBufPtr pBuf)
+static void
+shadowUpdate32to24Boxes(ScreenPtr pScreen, shadowBufPtr pBuf,
+                        BoxPtr pbox, int nbox)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
-    int nbox = RegionNumRects(damage);
-    BoxPtr pbox = RegionRects(damage);
     FbStride shaStride;
     int shaBpp;
     _X_UNUSED int shaXoff, shaYoff;
@@ -136,3 +158,9 @@ shadowUpdate32to24(ScreenPtr pScreen, shadowBufPtr pBuf)
         pbox++;
     }
 }
+
+void
+shadowUpdate32to24(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateBoxes(pScreen, pBuf, shadowUpdate32to24Boxes);
+}
@@ -141,6 +141,7 @@ shadowSetup(ScreenPtr pScreen)
     pBuf->pPixmap = 0;
     pBuf->closure = 0;
     pBuf->randr = 0;
+    pBuf->threads = 1;
 
     dixSetPrivate(&pScreen->devPrivates, shadowScrPrivateKey, pBuf);
     return TRUE;
@@ -179,6 +180,14 @@ shadowAdd(ScreenPtr pScreen, PixmapPtr pPixmap, ShadowUpdateProc update,
     return TRUE;
 }
 
+void
+shadowSetThreads(ScreenPtr pScreen, int threads)
+{
+    shadowBuf(pScreen);
+
+    pBuf->threads = threads;
+}
+
 void
 shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap)
 {
@@ -55,6 +55,8 @@ typedef struct _shadowBuf {
     GetImageProcPtr GetImage;
     CloseScreenProcPtr CloseScreen;
     ScreenBlockHandlerProcPtr BlockHandler;
+
+    int threads;
 } shadowBufRec;
 
 /* Match defines from randr extension */
@@ -81,6 +83,13 @@ shadowAdd(ScreenPtr pScreen,
 extern _X_EXPORT void
  shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap);
 
+/*
+ * Let the update functions use up to threads threads, 0 meaning one per
+ * CPU.  The window procedure will be called from all of them at once.
+ */
+extern _X_EXPORT void
+ shadowSetThreads(ScreenPtr pScreen, int threads);
+
 extern _X_EXPORT void
  shadowUpdateAfb4(ScreenPtr pScreen, shadowBufPtr pBuf);
 
@@ -38,15 +38,14 @@
 #include    "globals.h"
 #include    "gcstruct.h"
 #include    "shadow.h"
+#include    "shtile.h"
 #include    "fb.h"
 
-void
-shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
+static void
+shadowUpdatePackedBoxes(ScreenPtr pScreen, shadowBufPtr pBuf,
+                        BoxPtr pbox, int nbox)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
-    int nbox = RegionNumRects(damage);
-    BoxPtr pbox = RegionRects(damage);
     FbBits *shaBase, *shaLine, *sha;
     FbStride shaStride;
     int scrBase, scrLine, scr;
@@ -107,3 +106,9 @@ shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
         pbox++;
     }
 }
+
+void
+shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateBoxes(pScreen, pBuf, shadowUpdatePackedBoxes);
+}
@@ -36,6 +36,7 @@
 #include    "globals.h"
 #include    "gcstruct.h"
 #include    "shadow.h"
+#include    "shtile.h"
 #include    "fb.h"
 
 /*
@@ -48,13 +49,11 @@
 #define TOP_TO_BOTTOM	2
 #define BOTTOM_TO_TOP	-2
 
-void
-shadowUpdateRotatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
+static void
+shadowUpdateRotatePackedBoxes(ScreenPtr pScreen, shadowBufPtr pBuf,
+                              BoxPtr pbox, int nbox)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
-    int nbox = RegionNumRects(damage);
-    BoxPtr pbox = RegionRects(damage);
     FbBits *shaBits;
     FbStride shaStride;
     int shaBpp;
@@ -296,3 +295,9 @@ shadowUpdateRotatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
         }
     }
 }
+
+void
+shadowUpdateRotatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateBoxes(pScreen, pBuf, shadowUpdateRotatePackedBoxes);
+}
@@ -43,6 +43,7 @@
 #include    "globals.h"
 #include    "gcstruct.h"
 #include    "shadow.h"
+#include    "shtile.h"
 #include    "fb.h"
 
 #define DANDEBUG         0
@@ -93,13 +94,147 @@
 
 #endif
 
-void
-FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
+#ifdef SHADOW_SSE2
+#if ROTATE == 90 || ROTATE == 270
+#define SHADOW_COLUMN_RUN   1024
+
+/*
+ * Write n pixels to a screen row starting at offset, mapping as many
+ * windows as that takes
+ */
+static Bool
+shadowWriteRun(ScreenPtr pScreen, shadowBufPtr pBuf, CARD32 row,
+               CARD32 offset, Data *src, int n)
+{
+    Data *win;
+    CARD32 winSize;
+    int i;
+
+    while (n) {
+        win = (Data *) (*pBuf->window) (pScreen, row, offset * sizeof(Data),
+                                        SHADOW_WINDOW_WRITE, &winSize,
+                                        pBuf->closure);
+        if (!win)
+            return FALSE;
+        i = min(n, (int) (winSize / sizeof(Data)));
+        if (!i)
+            return FALSE;
+        memcpy(win, src, i * sizeof(Data));
+        offset += i;
+        src += i;
+        n -= i;
+    }
+    return TRUE;
+}
+
+/*
+ * Rotate the leftmost columns of a box four at a time by transposing
+ * 4x4 blocks of 32bpp pixels and return how many columns were done.
+ * Runs of up to SHADOW_COLUMN_RUN pixels of the four screen rows are
+ * transposed into a buffer and then written one row at a time; the
+ * scalar loop does whatever is left.
+ */
+static int
+shadowRotateColumns(ScreenPtr pScreen, shadowBufPtr pBuf, Data *shaBase,
+                    FbStride shaStride, int x, int y, int w, int h)
+{
+    Data run[4][SHADOW_COLUMN_RUN], *sha;
+    CARD32 row, offset;
+    __m128i a0, a1, a2, a3, t0, t1, t2, t3, o[4];
+    int done, j, k, k0, n;
+
+    if (sizeof(Data) != 4)
+        return 0;
+
+    for (done = 0; done + 4 <= w; done += 4) {
+        for (k0 = 0; k0 < h; k0 += n) {
+            n = min(h - k0, SHADOW_COLUMN_RUN);
+            sha = shaBase + (y + k0) * shaStride + x + done;
+            for (k = 0; k + 4 <= n; k += 4, sha += 4 * shaStride) {
+                a0 = _mm_loadu_si128((__m128i *) sha);
+                a1 = _mm_loadu_si128((__m128i *) (sha + shaStride));
+                a2 = _mm_loadu_si128((__m128i *) (sha + 2 * shaStride));
+                a3 = _mm_loadu_si128((__m128i *) (sha + 3 * shaStride));
+                t0 = _mm_unpacklo_epi32(a0, a1);
+                t1 = _mm_unpacklo_epi32(a2, a3);
+                t2 = _mm_unpackhi_epi32(a0, a1);
+                t3 = _mm_unpackhi_epi32(a2, a3);
+                o[0] = _mm_unpacklo_epi64(t0, t1);
+                o[1] = _mm_unpackhi_epi64(t0, t1);
+                o[2] = _mm_unpacklo_epi64(t2, t3);
+                o[3] = _mm_unpackhi_epi64(t2, t3);
+                for (j = 0; j < 4; j++) {
+#if ROTATE == 90
+                    _mm_storeu_si128((__m128i *) (run[j] + k), o[j]);
+#else
+                    _mm_storeu_si128((__m128i *) (run[j] + n - 4 - k),
+                                     _mm_shuffle_epi32(o[j],
+                                                       _MM_SHUFFLE(0, 1, 2,
+                                                                   3)));
+#endif
+                }
+            }
+            for (; k < n; k++, sha += shaStride) {
+                for (j = 0; j < 4; j++) {
+#if ROTATE == 90
+                    run[j][k] = sha[j];
+#else
+                    run[j][n - 1 - k] = sha[j];
+#endif
+                }
+            }
+
+            for (j = 0; j < 4; j++) {
+#if ROTATE == 90
+                row = pScreen->width - (x + done + j) - 1;
+                offset = y + k0;
+#else
+                row = x + done + j;
+                offset = pScreen->height - (y + k0 + n);
+#endif
+                if (!shadowWriteRun(pScreen, pBuf, row, offset, run[j], n))
+                    return done;
+            }
+        }
+    }
+    return done;
+}
+#endif
+
+#if ROTATE == 180
+/*
+ * Copy n pixels ending at sha to win in reverse order, 16 bytes at a
+ * time, and return how many were done
+ */
+static int
+shadowCopyReversed(Data *win, Data *sha, int n)
+{
+    const int step = 16 / sizeof(Data);
+    __m128i v;
+    int done;
+
+    for (done = 0; done + step <= n; done += step) {
+        v = _mm_loadu_si128((__m128i *) (sha - done - (step - 1)));
+        if (sizeof(Data) == 1)
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        if (sizeof(Data) <= 2) {
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+        }
+        else
+            v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+        _mm_storeu_si128((__m128i *) (win + done), v);
+    }
+    return done;
+}
+#endif
+#endif                          /* SHADOW_SSE2 */
+
+static void
+shadowRotateBoxes(ScreenPtr pScreen, shadowBufPtr pBuf, BoxPtr pbox, int nbox)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
-    int nbox = RegionNumRects(damage);
-    BoxPtr pbox = RegionRects(damage);
     FbBits *shaBits;
     Data *shaBase, *shaLine, *sha;
     FbStride shaStride;
@@ -108,6 +243,9 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
     _X_UNUSED int shaXoff, shaYoff;
     int x, y, w, h, width;
     int i;
+#if ROTATE == 180 && defined(SHADOW_SSE2)
+    int n;
+#endif
     Data *winBase = NULL, *win;
     CARD32 winSize;
 
@@ -117,8 +255,8 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
     shaStride = shaStride * sizeof(FbBits) / sizeof(Data);
 #if (DANDEBUG > 1)
     ErrorF
-        ("-> Entering Shadow Update:\r\n   |- Origins: pShadow=%x, pScreen=%x, damage=%x\r\n   |- Metrics: shaStride=%d, shaBase=%x, shaBpp=%d\r\n   |                                                     \n",
-         pShadow, pScreen, damage, shaStride, shaBase, shaBpp);
+        ("-> Entering Shadow Update:\r\n   |- Origins: pShadow=%x, pScreen=%x\r\n   |- Metrics: shaStride=%d, shaBase=%x, shaBpp=%d\r\n   |                                                     \n",
+         pShadow, pScreen, shaStride, shaBase, shaBpp);
 #endif
     while (nbox--) {
         x = pbox->x1;
@@ -130,6 +268,11 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
         ErrorF
             ("   |-> Redrawing box - Metrics: X=%d, Y=%d, Width=%d, Height=%d\n",
              x, y, w, h);
+#endif
+#if defined(SHADOW_SSE2) && (ROTATE == 90 || ROTATE == 270)
+        i = shadowRotateColumns(pScreen, pBuf, shaBase, shaStride, x, y, w, h);
+        x += i;
+        w -= i;
 #endif
         scrLine = SCRLEFT(x, y, w, h);
         shaLine = shaBase + FIRSTSHA(x, y, w, h);
@@ -175,6 +318,17 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
                 ErrorF
                     ("   |   |   |-> Writing Line - Metrics: win=%x, sha=%x\n",
                      win, sha);
+#endif
+#if ROTATE == 0
+                memcpy(win, sha, i * sizeof(Data));
+                win += i;
+                sha += i;
+                i = 0;
+#elif ROTATE == 180 && defined(SHADOW_SSE2)
+                n = shadowCopyReversed(win, sha, i);
+                win += n;
+                sha -= n;
+                i -= n;
 #endif
                 while (i--) {
 #if(DANDEBUG > 6)
@@ -192,3 +346,9 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
         pbox++;
     }                           /*  nbox */
 }
+
+void
+FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateBoxes(pScreen, pBuf, shadowRotateBoxes);
+}
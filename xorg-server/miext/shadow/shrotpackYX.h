@@ -29,6 +29,7 @@
 #include    "globals.h"
 #include    "gcstruct.h"
 #include    "shadow.h"
+#include    "shtile.h"
 #include    "fb.h"
 
 #if ROTATE == 270
@@ -53,13 +54,10 @@
 #define PREFETCH
 #endif
 
-void
-FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
+static void
+shadowRotateBoxes(ScreenPtr pScreen, shadowBufPtr pBuf, BoxPtr pbox, int nbox)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
-    int nbox = RegionNumRects(damage);
-    BoxPtr pbox = RegionRects(damage);
     FbBits *shaBits;
     Data *shaBase, *shaLine, *sha;
     FbStride shaStride, winStride;
@@ -150,3 +148,9 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
         pbox++;
     }                           /*  nbox */
 }
+
+void
+FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateBoxes(pScreen, pBuf, shadowRotateBoxes);
+}
@@ -0,0 +1,226 @@
+/*
+ * Threaded shadow updates.
+ *
+ * On screens set up with shadowSetThreads, large damage is split into
+ * tiles which are handed to a pool of worker threads shared by all
+ * screens.  The server thread takes tiles too and returns once all of
+ * them are done, so the update is still complete when the update function
+ * returns.  The workers only ever run the update functions, which read the
+ * shadow pixmap and write through the window procedure, so that has to be
+ * safe to call from several threads at once.
+ *
+ * Tiles span the whole width of the damage: the update functions go
+ * fastest on long scanlines, and rotating a band of a few dozen scanlines
+ * still writes runs that long to the screen.  Smaller damage is updated
+ * in one go on the server thread, as before, and so is anything below
+ * 8bpp, where the screen rows written by neighbouring tiles of a rotated
+ * update can share words.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "scrnintstr.h"
+#include "pixmapstr.h"
+#include "regionstr.h"
+#include "shtile.h"
+
+/* Damage smaller than this is not worth waking the workers for */
+#define SHADOW_TILE_MIN_PIXELS	(256 * 256)
+
+/* Tiles per thread, for a chance to even out uneven damage */
+#define SHADOW_TILES_PER_THREAD	4
+#define SHADOW_TILE_MIN_HEIGHT	32
+
+#define SHADOW_MAX_THREADS	16
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;        /* signalled when tiles are posted */
+    pthread_cond_t done;        /* signalled when the last tile is done */
+    int nthreads;               /* worker threads running */
+
+    /* The current update, constant while tiles are pending */
+    ScreenPtr pScreen;
+    shadowBufPtr pBuf;
+    ShadowBoxProc proc;
+    BoxPtr pbox;
+    int nbox;
+    BoxRec extents;
+    int tileHeight;
+
+    int ntiles;
+    int next;                   /* next tile to hand out */
+    int pending;                /* tiles not finished yet */
+    int helpers;                /* workers on this update */
+    int maxHelpers;
+} ShadowPoolRec;
+
+static ShadowPoolRec shadowPool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+/* Index of the first box which ends below y */
+static int
+shadowFindBand(BoxPtr pbox, int nbox, int y)
+{
+    int lo = 0, hi = nbox;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (pbox[mid].y2 <= y)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void
+shadowUpdateTile(ShadowPoolRec *pool, int tile)
+{
+    BoxRec boxes[64];
+    BoxPtr pbox;
+    int n = 0, i, y1, y2;
+
+    y1 = pool->extents.y1 + tile * pool->tileHeight;
+    y2 = min(y1 + pool->tileHeight, pool->extents.y2);
+
+    /* Boxes are sorted in bands, so the ones in this tile are together */
+    i = shadowFindBand(pool->pbox, pool->nbox, y1);
+    for (pbox = pool->pbox + i; i < pool->nbox && pbox->y1 < y2; i++, pbox++) {
+        boxes[n].x1 = pbox->x1;
+        boxes[n].y1 = max(pbox->y1, y1);
+        boxes[n].x2 = pbox->x2;
+        boxes[n].y2 = min(pbox->y2, y2);
+        if (++n == ARRAY_SIZE(boxes)) {
+            (*pool->proc) (pool->pScreen, pool->pBuf, boxes, n);
+            n = 0;
+        }
+    }
+    if (n)
+        (*pool->proc) (pool->pScreen, pool->pBuf, boxes, n);
+}
+
+/* Called and returns with the lock held */
+static void
+shadowRunTiles(ShadowPoolRec *pool)
+{
+    while (pool->next < pool->ntiles) {
+        int tile = pool->next++;
+
+        pthread_mutex_unlock(&pool->lock);
+        shadowUpdateTile(pool, tile);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0)
+            pthread_cond_signal(&pool->done);
+    }
+}
+
+static void *
+shadowWorker(void *arg)
+{
+    ShadowPoolRec *pool = arg;
+#ifdef SIG_BLOCK
+    sigset_t set;
+
+    /* Don't handle any signals on this thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->next >= pool->ntiles || pool->helpers >= pool->maxHelpers)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        pool->helpers++;
+        shadowRunTiles(pool);
+        pool->helpers--;
+    }
+    return NULL;
+}
+
+/* Start workers so that there are threads - 1 of them, if we can */
+static int
+shadowStartThreads(int threads)
+{
+    ShadowPoolRec *pool = &shadowPool;
+    pthread_t thread;
+
+    if (threads <= 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+        threads = 1;
+#endif
+    }
+    threads = min(threads, SHADOW_MAX_THREADS);
+
+    while (pool->nthreads < threads - 1) {
+        if (pthread_create(&thread, NULL, shadowWorker, pool) != 0)
+            break;
+        pthread_detach(thread);
+        pool->nthreads++;
+    }
+    return min(threads, pool->nthreads + 1);
+}
+
+void
+shadowUpdateBoxes(ScreenPtr pScreen, shadowBufPtr pBuf, ShadowBoxProc proc)
+{
+    ShadowPoolRec *pool = &shadowPool;
+    RegionPtr damage = DamageRegion(pBuf->pDamage);
+    BoxPtr pbox = RegionRects(damage);
+    int nbox = RegionNumRects(damage);
+    BoxPtr extents = RegionExtents(damage);
+    int height = extents->y2 - extents->y1;
+    unsigned long pixels = 0;
+    int i, threads, tileHeight;
+
+    if (pBuf->threads == 1 || pBuf->pPixmap->drawable.bitsPerPixel < 8)
+        threads = 1;
+    else
+        threads = shadowStartThreads(pBuf->threads);
+    if (threads > 1) {
+        for (i = 0; i < nbox; i++)
+            pixels += (pbox[i].x2 - pbox[i].x1) * (pbox[i].y2 - pbox[i].y1);
+    }
+    if (pixels < SHADOW_TILE_MIN_PIXELS) {
+        (*proc) (pScreen, pBuf, pbox, nbox);
+        return;
+    }
+
+    tileHeight = (height + threads * SHADOW_TILES_PER_THREAD - 1) /
+        (threads * SHADOW_TILES_PER_THREAD);
+    tileHeight = max(tileHeight, SHADOW_TILE_MIN_HEIGHT);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->pScreen = pScreen;
+    pool->pBuf = pBuf;
+    pool->proc = proc;
+    pool->pbox = pbox;
+    pool->nbox = nbox;
+    pool->extents = *extents;
+    pool->tileHeight = tileHeight;
+    pool->ntiles = (height + tileHeight - 1) / tileHeight;
+    pool->next = 0;
+    pool->pending = pool->ntiles;
+    pool->maxHelpers = threads - 1;
+    if (pool->maxHelpers)
+        pthread_cond_broadcast(&pool->work);
+
+    shadowRunTiles(pool);
+    while (pool->pending)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pool->ntiles = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
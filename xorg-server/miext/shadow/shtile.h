@@ -0,0 +1,26 @@
+/*
+ * Splitting shadow updates into tiles for the worker threads, and the
+ * SSE2 switch shared by the update functions.
+ */
+
+#ifndef _SHTILE_H_
+#define _SHTILE_H_
+
+#include "shadow.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHADOW_SSE2
+#endif
+
+/*
+ * Updates the screen from part of the damage.  The boxes are clipped to
+ * one tile and may be handed to several threads at once.
+ */
+typedef void (*ShadowBoxProc) (ScreenPtr pScreen, shadowBufPtr pBuf,
+                               BoxPtr pbox, int nbox);
+
+void
+shadowUpdateBoxes(ScreenPtr pScreen, shadowBufPtr pBuf, ShadowBoxProc proc);
+
+#endif                          /* _SHTILE_H_ */
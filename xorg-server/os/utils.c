@@ -188,6 +188,8 @@ Bool CoreDump;
 
 Bool enableIndirectGLX = TRUE;
 
+Bool enableGLXThreads = FALSE;
+
 #ifdef PANORAMIX
 Bool PanoramiXExtensionDisabledHack = FALSE;
 #endif
@@ -464,11 +466,13 @@ GetTimeInMillis(void)
 {
     return GetTickCount();
 }
+#ifndef WIN32
 CARD64
 GetTimeInMicros(void)
 {
     return (CARD64) GetTickCount() * 1000;
 }
+#endif
 #else
 CARD32
 GetTimeInMillis(void)
@@ -499,6 +503,7 @@ GetTimeInMillis(void)
     return (tv.tv_sec * 1000) + (tv.tv_usec / 1000);
 }
 
+#ifndef WIN32
 CARD64
 GetTimeInMicros(void)
 {
@@ -521,6 +526,25 @@ GetTimeInMicros(void)
     return (CARD64) tv.tv_sec * (CARD64)1000000 + (CARD64) tv.tv_usec;
 }
 #endif
+#endif
+
+#ifdef WIN32
+/* GetTickCount only counts in 10 to 16 ms steps, use the performance
+   counter for anything measuring in microseconds */
+CARD64
+GetTimeInMicros(void)
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER count;
+
+    if (!frequency.QuadPart)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&count);
+    return (CARD64) (count.QuadPart / frequency.QuadPart) * 1000000 +
+        (CARD64) (count.QuadPart % frequency.QuadPart) * 1000000 /
+        frequency.QuadPart;
+}
+#endif
 
 void
 UseMsg(void)
@@ -556,6 +580,8 @@ UseMsg(void)
     ErrorF("-help                  prints message with these options\n");
     ErrorF("+iglx                  Allow creating indirect GLX contexts (default)\n");
     ErrorF("-iglx                  Prohibit creating indirect GLX contexts\n");
+    ErrorF("+glxthreads            Render indirect GLX contexts on worker threads\n");
+    ErrorF("-glxthreads            Render indirect GLX contexts on the main thread (default)\n");
     ErrorF("-I                     ignore all remaining arguments\n");
 #ifdef RLIMIT_DATA
     ErrorF("-ld int                limit data space to N Kb\n");
@@ -814,6 +840,10 @@ ProcessCommandLine(int argc, char *argv[])
             enableIndirectGLX = TRUE;
         else if (strcmp(argv[i], "-iglx") == 0)
             enableIndirectGLX = FALSE;
+        else if (strcmp(argv[i], "+glxthreads") == 0)
+            enableGLXThreads = TRUE;
+        else if (strcmp(argv[i], "-glxthreads") == 0)
+            enableGLXThreads = FALSE;
         else if ((skip = XkbProcessArguments(argc, argv, i)) != 0) {
             if (skip > 0)
                 i += skip - 1;
@@ -0,0 +1,94 @@
+/** @file
+ *
+ * Gives one client a large number of resources and reports how long adding,
+ * looking up and freeing them takes, per resource.  Random lookups miss the
+ * cache, repeated lookups of the same ID are what request dispatch mostly
+ * does.
+ *
+ * usage: bench-resource [resources [lookups]]
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "misc.h"
+#include "resource.h"
+#include "dixstruct.h"
+
+static int
+delete_resource(void *value, XID id)
+{
+    return Success;
+}
+
+static double
+now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char **argv)
+{
+    long resources = argc > 1 ? atol(argv[1]) : 1000000;
+    long lookups = argc > 2 ? atol(argv[2]) : 10000000;
+    ClientRec server_client = { 0 };
+    ClientRec client = { 0 };
+    unsigned long seed = 1;
+    double t0, t1, t2, t3, t4;
+    long i, found = 0;
+    RESTYPE type;
+    void *value;
+    XID base;
+
+    serverClient = &server_client;
+    InitClient(serverClient, 0, NULL);
+    if (!InitClientResources(serverClient))
+        FatalError("Failed to init server client resources\n");
+
+    InitClient(&client, 1, NULL);
+    clients[1] = &client;
+    if (!InitClientResources(&client))
+        FatalError("Failed to init client resources\n");
+
+    type = CreateNewResourceType(delete_resource, "Bench");
+    base = client.clientAsMask + 1;
+
+    t0 = now();
+    for (i = 0; i < resources; i++)
+        if (!AddResource(base + i, type, (void *) (i + 1)))
+            FatalError("Failed to add resource %ld\n", i);
+
+    t1 = now();
+    for (i = 0; i < lookups; i++) {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        found += dixLookupResourceByType(&value, base + (seed >> 33) % resources,
+                                         type, NULL, 0) == Success;
+    }
+
+    t2 = now();
+    for (i = 0; i < lookups; i++)
+        found += dixLookupResourceByClass(&value, base + (i >> 4) % resources,
+                                          RC_ANY, NULL, 0) == Success;
+
+    t3 = now();
+    for (i = 0; i < resources; i++)
+        FreeResource(base + i, RT_NONE);
+    t4 = now();
+
+    if (found != 2 * lookups)
+        FatalError("Lookups failed\n");
+
+    printf("%ld resources: add %.0f ns, random lookup %.1f ns, "
+           "repeated lookup %.1f ns, free %.0f ns\n", resources,
+           (t1 - t0) / resources * 1e9, (t2 - t1) / lookups * 1e9,
+           (t3 - t2) / lookups * 1e9, (t4 - t3) / resources * 1e9);
+    return 0;
+}
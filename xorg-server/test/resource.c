@@ -0,0 +1,198 @@
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdint.h>
+#include "misc.h"
+#include "resource.h"
+#include "dixstruct.h"
+
+#include "tests-common.h"
+
+#define NUM_RESOURCES 100000
+
+static RESTYPE type_a, type_b, type_free_next;
+static int deleted;
+static XID last_deleted;
+
+static int
+delete_resource(void *value, XID id)
+{
+    deleted++;
+    last_deleted = id;
+    return Success;
+}
+
+/* frees the resource with the next ID too */
+static int
+delete_resource_and_next(void *value, XID id)
+{
+    delete_resource(value, id);
+    FreeResource(id + 1, RT_NONE);
+    return Success;
+}
+
+static void
+count_resource(void *value, XID id, void *cdata)
+{
+    (*(int *) cdata)++;
+}
+
+/* frees every other resource it is called for */
+static void
+free_odd_resource(void *value, XID id, void *cdata)
+{
+    (*(int *) cdata)++;
+    if (id & 1)
+        FreeResource(id, RT_NONE);
+}
+
+static void
+resource_init(ClientPtr server_client, ClientPtr client)
+{
+    serverClient = server_client;
+    InitClient(serverClient, 0, NULL);
+    assert(InitClientResources(serverClient));
+
+    InitClient(client, 1, NULL);
+    clients[1] = client;
+    assert(InitClientResources(client));
+
+    type_a = CreateNewResourceType(delete_resource, "A");
+    type_b = CreateNewResourceType(delete_resource, "B");
+    type_free_next = CreateNewResourceType(delete_resource_and_next, "C");
+}
+
+static void
+resource_add_lookup_free(ClientPtr client)
+{
+    XID base = client->clientAsMask;
+    void *value;
+    int i, rc;
+
+    /* enough to go through several rebuilds of the table */
+    for (i = 1; i <= NUM_RESOURCES; i++)
+        assert(AddResource(base + i, type_a, (void *) (intptr_t) i));
+
+    for (i = 1; i <= NUM_RESOURCES; i++) {
+        rc = dixLookupResourceByType(&value, base + i, type_a, NULL, 0);
+        assert(rc == Success);
+        assert(value == (void *) (intptr_t) i);
+        rc = dixLookupResourceByClass(&value, base + i, RC_ANY, NULL, 0);
+        assert(rc == Success);
+        assert(value == (void *) (intptr_t) i);
+        rc = dixLookupResourceByType(&value, base + i, type_b, NULL, 0);
+        assert(rc != Success);
+        assert(value == NULL);
+    }
+    rc = dixLookupResourceByType(&value, base + NUM_RESOURCES + 1, type_a,
+                                 NULL, 0);
+    assert(rc != Success);
+
+    assert(ChangeResourceValue(base + 1, type_a, (void *) 42));
+    assert(!ChangeResourceValue(base + 1, type_b, (void *) 42));
+    rc = dixLookupResourceByType(&value, base + 1, type_a, NULL, 0);
+    assert(value == (void *) 42);
+
+    deleted = 0;
+    for (i = 1; i <= NUM_RESOURCES; i += 2)
+        FreeResource(base + i, RT_NONE);
+    assert(deleted == NUM_RESOURCES / 2);
+
+    for (i = 1; i <= NUM_RESOURCES; i++) {
+        rc = dixLookupResourceByType(&value, base + i, type_a, NULL, 0);
+        assert((rc == Success) == !(i & 1));
+    }
+
+    /* freed IDs can be used again */
+    for (i = 1; i <= NUM_RESOURCES; i += 2)
+        assert(AddResource(base + i, type_b, (void *) (intptr_t) i));
+    for (i = 1; i <= NUM_RESOURCES; i++) {
+        rc = dixLookupResourceByType(&value, base + i, (i & 1) ? type_b : type_a,
+                                     NULL, 0);
+        assert(rc == Success);
+        assert(value == (void *) (intptr_t) i);
+    }
+
+    deleted = 0;
+    FreeClientResources(client);
+    assert(deleted == NUM_RESOURCES);
+    assert(InitClientResources(client));
+}
+
+static void
+resource_same_id(ClientPtr client)
+{
+    XID id = client->clientAsMask | 0x100;
+    void *value;
+    int rc;
+
+    /* lookups find the most recently added resource of an ID... */
+    assert(AddResource(id, type_a, (void *) 1));
+    assert(AddResource(id, type_b, (void *) 2));
+    assert(AddResource(id, type_a, (void *) 3));
+
+    rc = dixLookupResourceByType(&value, id, type_a, NULL, 0);
+    assert(rc == Success && value == (void *) 3);
+    rc = dixLookupResourceByType(&value, id, type_b, NULL, 0);
+    assert(rc == Success && value == (void *) 2);
+    rc = dixLookupResourceByClass(&value, id, RC_ANY, NULL, 0);
+    assert(rc == Success && value == (void *) 3);
+
+    FreeResourceByType(id, type_a, FALSE);
+    rc = dixLookupResourceByType(&value, id, type_a, NULL, 0);
+    assert(rc == Success && value == (void *) 1);
+
+    /* ... and FreeResource frees them all, the same way round */
+    deleted = 0;
+    FreeResource(id, type_b);
+    assert(deleted == 1);
+    rc = dixLookupResourceByClass(&value, id, RC_ANY, NULL, 0);
+    assert(rc == BadValue);
+
+    /* delete functions may free other resources */
+    assert(AddResource(id, type_free_next, NULL));
+    assert(AddResource(id + 1, type_a, NULL));
+    deleted = 0;
+    FreeResource(id, RT_NONE);
+    assert(deleted == 2);
+    assert(last_deleted == id + 1);
+}
+
+static void
+resource_find(ClientPtr client)
+{
+    XID base = client->clientAsMask;
+    int i, count;
+
+    for (i = 1; i <= 1000; i++)
+        assert(AddResource(base + i, (i % 3) ? type_a : type_b, NULL));
+
+    count = 0;
+    FindClientResourcesByType(client, type_b, count_resource, &count);
+    assert(count == 333);
+
+    /* freeing resources while walking them does not skip any */
+    count = 0;
+    FindClientResourcesByType(client, 0, free_odd_resource, &count);
+    assert(count == 1000);
+    count = 0;
+    FindClientResourcesByType(client, 0, count_resource, &count);
+    assert(count == 500);
+
+    FreeClientResources(client);
+}
+
+int
+resource_test(void)
+{
+    ClientRec server_client = { 0 };
+    ClientRec client = { 0 };
+
+    resource_init(&server_client, &client);
+    resource_add_lookup_free(&client);
+    resource_same_id(&client);
+    resource_find(&client);
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/** @file
+ *
+ * Restacks the toplevels of a synthetic 2100-window tree and reports how
+ * many restacks per second the server validates.  Each of the 100
+ * overlapping toplevels holds 4 panels of 4 buttons, so most windows
+ * marked by a restack sit in subtrees whose clips do not change.
+ *
+ * usage: restack [restacks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#define TOPLEVELS 100
+#define PANELS 4
+#define BUTTONS 4
+
+static xcb_window_t
+create_window(xcb_connection_t *c, xcb_screen_t *screen, xcb_window_t parent,
+              int x, int y, int width, int height)
+{
+    xcb_window_t w = xcb_generate_id(c);
+    uint32_t values[] = { screen->white_pixel };
+
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, w, parent, x, y,
+                      width, height, 1, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      XCB_COPY_FROM_PARENT, XCB_CW_BACK_PIXEL, values);
+    return w;
+}
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+int
+main(int argc, char **argv)
+{
+    long restacks = argc > 1 ? atol(argv[1]) : 20000;
+    xcb_window_t toplevels[TOPLEVELS];
+    struct timespec t0, t1;
+    xcb_connection_t *c;
+    xcb_screen_t *screen;
+    double t;
+    long i;
+    int n, p, b;
+
+    c = xcb_connect(NULL, NULL);
+    if (!c || xcb_connection_has_error(c)) {
+        fprintf(stderr, "Failed to connect to X server\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    for (n = 0; n < TOPLEVELS; n++) {
+        toplevels[n] = create_window(c, screen, screen->root,
+                                     (n % 10) * 60, (n / 10) * 40 + (n % 10) * 8,
+                                     400, 300);
+        for (p = 0; p < PANELS; p++) {
+            xcb_window_t panel = create_window(c, screen, toplevels[n],
+                                               10, 10 + p * 72, 380, 70);
+
+            for (b = 0; b < BUTTONS; b++)
+                create_window(c, screen, panel, 5 + b * 92, 10, 88, 50);
+            xcb_map_subwindows(c, panel);
+        }
+        xcb_map_subwindows(c, toplevels[n]);
+        xcb_map_window(c, toplevels[n]);
+    }
+    sync_server(c);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < restacks; i++) {
+        uint32_t stack_mode = (i / TOPLEVELS) & 1 ? XCB_STACK_MODE_BELOW :
+                                                    XCB_STACK_MODE_ABOVE;
+
+        xcb_configure_window(c, toplevels[(i * 37) % TOPLEVELS],
+                             XCB_CONFIG_WINDOW_STACK_MODE, &stack_mode);
+        if (i % 256 == 255)
+            sync_server(c);
+    }
+    sync_server(c);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("%d windows: %ld restacks in %.3f s, %.0f restacks/s\n",
+           TOPLEVELS * (1 + PANELS * (1 + BUTTONS)), restacks, t,
+           t ? restacks / t : 0.0);
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -0,0 +1,70 @@
+/** @file
+ *
+ * Repaints the whole screen and reports how many times per second the
+ * shadow layer copies it to the framebuffer.  Run against Xvfb -rotate to
+ * measure each of the rotated update functions.  GetImage on a window
+ * makes the shadow layer update the framebuffer straight away, so every
+ * repaint is copied once.
+ *
+ * usage: shadow [updates]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+static void
+sync_server(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+int
+main(int argc, char **argv)
+{
+    long updates = argc > 1 ? atol(argv[1]) : 500;
+    struct timespec t0, t1;
+    xcb_connection_t *c;
+    xcb_screen_t *screen;
+    xcb_rectangle_t rect;
+    xcb_gcontext_t gc;
+    double t;
+    long i;
+
+    c = xcb_connect(NULL, NULL);
+    if (!c || xcb_connection_has_error(c)) {
+        fprintf(stderr, "Failed to connect to X server\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    gc = xcb_generate_id(c);
+    xcb_create_gc(c, gc, screen->root, 0, NULL);
+    rect.x = 0;
+    rect.y = 0;
+    rect.width = screen->width_in_pixels;
+    rect.height = screen->height_in_pixels;
+    sync_server(c);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < updates; i++) {
+        uint32_t foreground = (i & 1) ? screen->white_pixel :
+                                        screen->black_pixel;
+
+        xcb_change_gc(c, gc, XCB_GC_FOREGROUND, &foreground);
+        xcb_poly_fill_rectangle(c, screen->root, gc, 1, &rect);
+        free(xcb_get_image_reply(c, xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                                  screen->root, 0, 0, 1, 1,
+                                                  ~0),
+                                 NULL));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    t = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("%dx%d: %ld updates in %.3f s, %.1f updates/s\n",
+           rect.width, rect.height, updates, t, t ? updates / t : 0.0);
+
+    xcb_disconnect(c);
+    return 0;
+}
@@ -12,6 +12,7 @@ main(int argc, char **argv)
     run_test(fixes_test);
     run_test(input_test);
     run_test(misc_test);
+    run_test(resource_test);
     run_test(signal_logging_test);
     run_test(touch_test);
     run_test(xfree86_test);